@@ -1,4 +1,5 @@
 #include "d3d11_cmdlist.h"
+#include "d3d11_cmdlist_replay.h"
 #include "d3d11_device.h"
 
 namespace dxvk {
@@ -55,6 +56,9 @@ namespace dxvk {
     for (const auto& chunk : m_chunks)
       cmdList->m_chunks.push_back(chunk);
     
+    if (m_serial)
+      cmdList->MarkSerial();
+    
     MarkSubmitted();
   }
   
@@ -67,6 +71,49 @@ namespace dxvk {
   }
   
   
+  void D3D11CommandList::EmitToReplay(
+          DxvkCsThread*       CsThread,
+    const Rc<D3D11CommandListReplay>& Replay) {
+    DxvkCsChunkRef chunk = m_device->AllocCsChunk(DxvkCsChunkFlag::SingleUse);
+    
+    auto command = [
+      cReplay      = Replay,
+      cCommandList = Com<D3D11CommandList>(this)
+    ] (DxvkContext* ctx) {
+      cReplay->Dispatch(ctx, cCommandList);
+    };
+    
+    chunk->push(command);
+    CsThread->dispatchChunk(std::move(chunk));
+    
+    MarkSubmitted();
+  }
+  
+  
+  void D3D11CommandList::EmitToContext(DxvkContext* Context) {
+    for (const auto& chunk : m_chunks)
+      chunk->executeAll(Context);
+  }
+  
+  
+  bool D3D11CommandList::UsesAnyChunk(
+    const std::unordered_set<DxvkCsChunk*>& Chunks) const {
+    for (const auto& chunk : m_chunks) {
+      if (Chunks.find(chunk.ptr()) != Chunks.end())
+        return true;
+    }
+    
+    return false;
+  }
+  
+  
+  void D3D11CommandList::GetChunks(
+          std::unordered_set<DxvkCsChunk*>& Chunks) const {
+    for (const auto& chunk : m_chunks)
+      Chunks.insert(chunk.ptr());
+  }
+  
+  
   void D3D11CommandList::MarkSubmitted() {
     if (m_submitted.exchange(true) && !m_warned.exchange(true)
      && m_device->GetOptions()->dcSingleUseMode) {
@@ -1,9 +1,13 @@
 #pragma once
 
+#include <unordered_set>
+
 #include "d3d11_context.h"
 
 namespace dxvk {
   
+  class D3D11CommandListReplay;
+  
   class D3D11CommandList : public D3D11DeviceChild<ID3D11CommandList> {
     
   public:
@@ -32,6 +36,53 @@ namespace dxvk {
     void EmitToCsThread(
             DxvkCsThread*       CsThread);
     
+    void EmitToReplay(
+            DxvkCsThread*       CsThread,
+      const Rc<D3D11CommandListReplay>& Replay);
+    
+    void EmitToContext(
+            DxvkContext*        Context);
+    
+    /**
+     * \brief Marks command list as order-dependent
+     * 
+     * Must be called when recording commands that
+     * modify state shared with other contexts, such
+     * as buffer renaming or queries. These command
+     * lists are never replayed on worker threads.
+     */
+    void MarkSerial() {
+      m_serial = true;
+    }
+    
+    /**
+     * \brief Checks whether the command list is order-dependent
+     * \returns \c true if the list must be replayed serially
+     */
+    bool IsSerial() const {
+      return m_serial;
+    }
+    
+    /**
+     * \brief Checks whether any chunk is in the given set
+     * 
+     * Command lists executed on deferred contexts get
+     * inlined, so distinct command lists may share the
+     * same chunks if a command list was executed on
+     * more than one deferred context.
+     * \param [in] Chunks Set of chunks to check
+     * \returns \c true if any chunk is in the set
+     */
+    bool UsesAnyChunk(
+      const std::unordered_set<DxvkCsChunk*>& Chunks) const;
+    
+    /**
+     * \brief Adds all chunks to the given set
+     * \param [out] Chunks Set of chunks
+     */
+    void GetChunks(
+            std::unordered_set<DxvkCsChunk*>& Chunks) const;
+    
   private:
     
     D3D11Device* const m_device;
@@ -39,6 +90,8 @@ namespace dxvk {
     
     std::vector<DxvkCsChunkRef> m_chunks;
 
+    bool m_serial = false;
+
     std::atomic<bool> m_submitted = { false };
     std::atomic<bool> m_warned    = { false };
 
@@ -0,0 +1,122 @@
+#include "d3d11_cmdlist_replay.h"
+
+namespace dxvk {
+
+  D3D11CommandListReplay::D3D11CommandListReplay(
+    const Rc<DxvkDevice>&       Device,
+          uint32_t              NumThreads,
+          bool                  RelaxedBarriers)
+  : m_device(Device), m_relaxedBarriers(RelaxedBarriers) {
+    Logger::info(str::format("D3D11: Using ", NumThreads, " command list replay threads"));
+
+    for (uint32_t i = 0; i < NumThreads; i++)
+      m_threads.emplace_back([this] () { RunWorker(); });
+  }
+
+
+  D3D11CommandListReplay::~D3D11CommandListReplay() {
+    { std::lock_guard<std::mutex> lock(m_mutex);
+      m_stopped = true;
+    }
+
+    m_condOnJob.notify_all();
+
+    for (auto& thread : m_threads)
+      thread.join();
+  }
+
+
+  void D3D11CommandListReplay::Dispatch(
+          DxvkContext*          Context,
+    const Com<D3D11CommandList>& CommandList) {
+    if (!m_batchActive) {
+      // Submit everything recorded on the CS thread so far. The CS
+      // thread's context will not record any commands until the batch
+      // gets joined, so it can keep using the new command buffer.
+      Context->flushCommandList();
+      m_batchActive = true;
+    } else if (CommandList->UsesAnyChunk(m_batchChunks)) {
+      // The same chunk must not be recorded twice at the same
+      // time, since single-use chunks get destroyed as they
+      // execute. This also applies to nested command lists
+      // that were executed on more than one deferred context.
+      WaitForJobs();
+    }
+
+    CommandList->GetChunks(m_batchChunks);
+
+    { std::lock_guard<std::mutex> lock(m_mutex);
+      m_jobs.push({ CommandList, m_jobsQueued++ });
+    }
+
+    m_condOnJob.notify_one();
+  }
+
+
+  void D3D11CommandListReplay::Join() {
+    if (m_batchActive) {
+      WaitForJobs();
+      m_batchActive = false;
+    }
+  }
+
+
+  void D3D11CommandListReplay::WaitForJobs() {
+    std::unique_lock<std::mutex> lock(m_mutex);
+
+    m_condOnSubmit.wait(lock, [this] {
+      return m_jobsSubmitted == m_jobsQueued;
+    });
+
+    m_batchChunks.clear();
+  }
+
+
+  void D3D11CommandListReplay::RunWorker() {
+    env::setThreadName("dxvk-replay");
+
+    Rc<DxvkContext> context = m_device->createContext();
+
+    if (m_relaxedBarriers)
+      context->setBarrierControl(DxvkBarrierControl::IgnoreWriteAfterWrite);
+
+    while (true) {
+      Job job;
+
+      { std::unique_lock<std::mutex> lock(m_mutex);
+
+        m_condOnJob.wait(lock, [this] {
+          return m_stopped || !m_jobs.empty();
+        });
+
+        if (m_jobs.empty())
+          break;
+
+        job = std::move(m_jobs.front());
+        m_jobs.pop();
+      }
+
+      // Every command list starts by binding the full
+      // D3D11 state, so the context can be reused as-is
+      context->beginRecording(m_device->createCommandList());
+      job.commandList->EmitToContext(context.ptr());
+
+      Rc<DxvkCommandList> cmdList = context->endRecording();
+
+      { std::unique_lock<std::mutex> lock(m_mutex);
+
+        m_condOnSubmit.wait(lock, [this, &job] {
+          return m_jobsSubmitted == job.submitId;
+        });
+
+        m_device->submitCommandList(cmdList,
+          VK_NULL_HANDLE, VK_NULL_HANDLE);
+
+        m_jobsSubmitted += 1;
+      }
+
+      m_condOnSubmit.notify_all();
+    }
+  }
+
+}
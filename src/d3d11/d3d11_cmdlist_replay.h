@@ -0,0 +1,100 @@
+#pragma once
+
+#include <condition_variable>
+#include <mutex>
+#include <queue>
+#include <unordered_set>
+#include <vector>
+
+#include "d3d11_cmdlist.h"
+
+#include "../util/thread.h"
+
+namespace dxvk {
+
+  /**
+   * \brief Command list replay workers
+   *
+   * Records command lists executed on the immediate
+   * context into their own Vulkan command buffers,
+   * using one DXVK context per worker thread. This
+   * allows applications which execute a number of
+   * command lists back to back to record them in
+   * parallel rather than on the CS thread alone.
+   *
+   * All methods other than the constructor and the
+   * destructor must be called from the CS thread.
+   * Command lists dispatched after each other form
+   * a batch, and the CS thread must \ref Join the
+   * batch before recording any other command that
+   * may depend on the work done by the command lists.
+   *
+   * Command buffers get submitted in the order in
+   * which their command lists were dispatched. Since
+   * every DXVK context flushes all pending barriers
+   * when it stops recording, no additional barriers
+   * are needed between the individual submissions.
+   */
+  class D3D11CommandListReplay : public RcObject {
+
+  public:
+
+    D3D11CommandListReplay(
+      const Rc<DxvkDevice>&       Device,
+            uint32_t              NumThreads,
+            bool                  RelaxedBarriers);
+
+    ~D3D11CommandListReplay();
+
+    /**
+     * \brief Dispatches a command list to a worker
+     *
+     * Submits the CS thread's command buffer when
+     * starting a new batch, so that any commands
+     * recorded prior to this will execute first.
+     * \param [in] Context The CS thread's context
+     * \param [in] CommandList The command list
+     */
+    void Dispatch(
+            DxvkContext*          Context,
+      const Com<D3D11CommandList>& CommandList);
+
+    /**
+     * \brief Waits for the current batch
+     *
+     * Returns once all command lists dispatched
+     * so far have been recorded and submitted.
+     */
+    void Join();
+
+  private:
+
+    struct Job {
+      Com<D3D11CommandList>     commandList;
+      uint64_t                  submitId;
+    };
+
+    Rc<DxvkDevice>              m_device;
+    bool                        m_relaxedBarriers;
+
+    std::mutex                  m_mutex;
+    std::condition_variable     m_condOnJob;
+    std::condition_variable     m_condOnSubmit;
+    std::queue<Job>             m_jobs;
+    uint64_t                    m_jobsSubmitted = 0;
+    bool                        m_stopped = false;
+
+    // Only accessed on the CS thread
+    uint64_t                    m_jobsQueued = 0;
+    bool                        m_batchActive = false;
+    std::unordered_set<DxvkCsChunk*> m_batchChunks;
+
+    std::vector<dxvk::thread>   m_threads;
+
+    void WaitForJobs();
+
+    void RunWorker();
+
+  };
+
+}
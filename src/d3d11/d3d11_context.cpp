@@ -255,6 +255,8 @@ namespace dxvk {
     EmitCs([queryPtr] (DxvkContext* ctx) {
       queryPtr->Begin(ctx);
     });
+
+    RequireSerialReplay();
   }
   
   
@@ -269,6 +271,8 @@ namespace dxvk {
     EmitCs([queryPtr] (DxvkContext* ctx) {
       queryPtr->End(ctx);
     });
+
+    RequireSerialReplay();
   }
   
   
@@ -1171,6 +1175,10 @@ namespace dxvk {
             cBufferSlice.length(),
             cDataBuffer.ptr());
         });
+
+        // The buffer may get renamed if it is
+        // updated while a render pass is active
+        RequireSerialReplay();
       }
     } else {
       const D3D11CommonTexture* textureInfo = GetCommonTexture(pDstResource);
@@ -3394,6 +3402,8 @@ namespace dxvk {
     EmitCs([cBuffer = pBuffer->GetBuffer()] (DxvkContext* ctx) {
       ctx->discardBuffer(cBuffer);
     });
+
+    RequireSerialReplay();
   }
 
 
@@ -865,6 +865,8 @@ namespace dxvk {
     
     virtual void EmitCsChunk(DxvkCsChunkRef&& chunk) = 0;
     
+    virtual void RequireSerialReplay() = 0;
+    
   };
   
 }
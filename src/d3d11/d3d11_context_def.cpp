@@ -267,6 +267,8 @@ namespace dxvk {
         ctx->invalidateBuffer(cDstBuffer, slice);
       });
     }
+
+    RequireSerialReplay();
   }
   
   
@@ -328,6 +330,11 @@ namespace dxvk {
   }
 
 
+  void D3D11DeferredContext::RequireSerialReplay() {
+    m_commandList->MarkSerial();
+  }
+
+
   DxvkCsChunkFlags D3D11DeferredContext::GetCsChunkFlags(
           D3D11Device*                  pDevice) {
     return pDevice->GetOptions()->dcSingleUseMode
@@ -1,4 +1,5 @@
 #include "d3d11_cmdlist.h"
+#include "d3d11_cmdlist_replay.h"
 #include "d3d11_context_imm.h"
 #include "d3d11_device.h"
 #include "d3d11_texture.h"
@@ -24,6 +25,14 @@ namespace dxvk {
         ctx->setBarrierControl(DxvkBarrierControl::IgnoreWriteAfterWrite);
     });
     
+    int32_t numReplayThreads = pParent->GetOptions()->numReplayThreads;
+
+    if (numReplayThreads > 0) {
+      m_csReplay = new D3D11CommandListReplay(Device,
+        uint32_t(numReplayThreads),
+        pParent->GetOptions()->relaxedBarriers);
+    }
+
     ClearState();
   }
   
@@ -109,6 +118,19 @@ namespace dxvk {
     D3D10DeviceLock lock = LockContext();
     
     if (m_csIsBusy || m_csChunk->commandCount() != 0) {
+      // Relocate some buffers if the defragmenter
+      // is enabled, so that the copies get flushed.
+      // Pending initialization work was submitted above,
+      // so the buffers must be taken after that.
+      if (m_device->defragmenter()) {
+        EmitCs([
+          cBuffers = m_device->defragmenter()->takeRelocations()
+        ] (DxvkContext* ctx) {
+          for (const auto& buffer : cBuffers)
+            ctx->relocateBuffer(buffer);
+        });
+      }
+      
       // Add commands to flush the threaded
       // context, then flush the command list
       EmitCs([] (DxvkContext* ctx) {
@@ -127,27 +149,53 @@ namespace dxvk {
   void STDMETHODCALLTYPE D3D11ImmediateContext::ExecuteCommandList(
           ID3D11CommandList*  pCommandList,
           BOOL                RestoreContextState) {
-    D3D10DeviceLock lock = LockContext();
-
     auto commandList = static_cast<D3D11CommandList*>(pCommandList);
     
+    bool useReplay = m_csReplay != nullptr && !commandList->IsSerial();
+    
+    // Replay workers submit their command buffers directly,
+    // so resource initialization must be submitted first
+    if (useReplay)
+      m_parent->FlushInitContext();
+    
+    D3D10DeviceLock lock = LockContext();
+    
     // Flush any outstanding commands so that
     // we don't mess up the execution order
     FlushCsChunk();
     
-    // As an optimization, flush everything if the
-    // number of pending draw calls is high enough.
-    FlushImplicit(FALSE);
-    
-    // Dispatch command list to the CS thread and
-    // restore the immediate context's state
-    commandList->EmitToCsThread(&m_csThread);
+    if (useReplay) {
+      // Record the command list on a worker thread. The
+      // command list does not touch the immediate context's
+      // DXVK state, so subsequent state changes can run in
+      // parallel, but any other command has to wait.
+      commandList->EmitToReplay(&m_csThread, m_csReplay);
+      m_csReplayPending = true;
+    } else {
+      // As an optimization, flush everything if the
+      // number of pending draw calls is high enough.
+      FlushImplicit(FALSE);
+      
+      // Dispatch command list to the CS thread
+      if (m_csReplayPending)
+        EmitCsReplayJoin();
+      
+      commandList->EmitToCsThread(&m_csThread);
+    }
     
+    // Restore the immediate context's state
     if (RestoreContextState)
       RestoreState();
     else
       ClearState();
     
+    if (m_csReplayPending) {
+      // Don't join pending replays for state changes
+      m_csThread.dispatchChunk(std::move(m_csChunk));
+      m_csChunk = AllocCsChunk();
+      m_cmdData = nullptr;
+    }
+    
     // Mark CS thread as busy so that subsequent
     // flush operations get executed correctly.
     m_csIsBusy = true;
@@ -487,6 +535,9 @@ namespace dxvk {
     // recorded prior to this function will be run
     FlushCsChunk();
     
+    if (m_csReplayPending)
+      EmitCsReplayJoin();
+    
     m_csThread.synchronize();
   }
   
@@ -532,11 +583,34 @@ namespace dxvk {
   
   
   void D3D11ImmediateContext::EmitCsChunk(DxvkCsChunkRef&& chunk) {
+    if (unlikely(m_csReplayPending))
+      EmitCsReplayJoin();
+
     m_csThread.dispatchChunk(std::move(chunk));
     m_csIsBusy = true;
   }
 
 
+  void D3D11ImmediateContext::EmitCsReplayJoin() {
+    DxvkCsChunkRef chunk = AllocCsChunk();
+
+    auto command = [cReplay = m_csReplay] (DxvkContext* ctx) {
+      cReplay->Join();
+    };
+
+    chunk->push(command);
+    m_csThread.dispatchChunk(std::move(chunk));
+
+    m_csReplayPending = false;
+  }
+
+
+  void D3D11ImmediateContext::RequireSerialReplay() {
+    // Commands recorded on the immediate context
+    // are always executed in submission order
+  }
+
+
   void D3D11ImmediateContext::FlushImplicit(BOOL StrongHint) {
     // Flush only if the GPU is about to go idle, in
     // order to keep the number of submissions low.
@@ -549,8 +623,12 @@ namespace dxvk {
                      + IncFlushIntervalUs * pending;
 
       // Prevent flushing too often in short intervals.
-      if (now - m_lastFlush >= std::chrono::microseconds(delay))
+      if (now - m_lastFlush >= std::chrono::microseconds(delay)) {
+        if (m_csIsBusy || m_csChunk->commandCount() != 0)
+          m_device->addStatCtr(DxvkStatCounter::QueueFlushCount, 1);
+
         Flush();
+      }
     }
   }
   
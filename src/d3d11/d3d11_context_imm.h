@@ -8,6 +8,7 @@
 namespace dxvk {
   
   class D3D11Buffer;
+  class D3D11CommandListReplay;
   class D3D11CommonTexture;
   
   class D3D11ImmediateContext : public D3D11DeviceContext {
@@ -97,6 +98,9 @@ namespace dxvk {
     DxvkCsThread m_csThread;
     bool         m_csIsBusy = false;
 
+    Rc<D3D11CommandListReplay> m_csReplay;
+    bool                       m_csReplayPending = false;
+
     std::chrono::high_resolution_clock::time_point m_lastFlush
       = std::chrono::high_resolution_clock::now();
     
@@ -127,6 +131,10 @@ namespace dxvk {
     
     void EmitCsChunk(DxvkCsChunkRef&& chunk);
 
+    void EmitCsReplayJoin();
+
+    void RequireSerialReplay();
+
     void FlushImplicit(BOOL StrongHint);
     
   };
@@ -7,6 +7,7 @@ namespace dxvk {
   D3D11Options::D3D11Options(const Config& config) {
     this->allowMapFlagNoWait    = config.getOption<bool>("d3d11.allowMapFlagNoWait", false);
     this->dcSingleUseMode       = config.getOption<bool>("d3d11.dcSingleUseMode", true);
+    this->numReplayThreads      = config.getOption<int32_t>("d3d11.numReplayThreads", 0);
     this->strictDivision           = config.getOption<bool>("d3d11.strictDivision", false);
     this->constantBufferRangeCheck = config.getOption<bool>("d3d11.constantBufferRangeCheck", false);
     this->zeroInitWorkgroupMemory  = config.getOption<bool>("d3d11.zeroInitWorkgroupMemory", false);
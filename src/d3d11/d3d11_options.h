@@ -25,6 +25,12 @@ namespace dxvk {
     /// than once.
     bool dcSingleUseMode;
 
+    /// Number of threads used to replay command lists
+    ///
+    /// If non-zero, command lists executed on the immediate
+    /// context get recorded on worker threads when possible.
+    int32_t numReplayThreads;
+
     /// Enables sm4-compliant division-by-zero behaviour
     /// Windows drivers don't normally do this, but some
     /// games may expect correct behaviour.
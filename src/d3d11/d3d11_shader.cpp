@@ -36,9 +36,38 @@ namespace dxvk {
     bool passthroughShader = pDxbcModuleInfo->xfb != nullptr
       && module.programInfo().type() != DxbcProgramType::GeometryShader;
 
-    m_shader = passthroughShader
-      ? module.compilePassthroughShader(*pDxbcModuleInfo, name)
-      : module.compile                 (*pDxbcModuleInfo, name);
+    // Stream output shaders depend on the output
+    // layout, so we do not cache them on disk
+    Rc<DxvkShaderCache> shaderCache = pDxbcModuleInfo->xfb == nullptr
+      ? pDevice->GetDXVKDevice()->getShaderCache()
+      : nullptr;
+
+    DxvkShaderCacheKey cacheKey;
+    cacheKey.shader  = *pShaderKey;
+    cacheKey.options = pDxbcModuleInfo->options.hash();
+
+    if (pDxbcModuleInfo->tess != nullptr) {
+      const std::array<Sha1Data, 2> chunks = {{
+        { &cacheKey.options,        sizeof(cacheKey.options) },
+        { pDxbcModuleInfo->tess,    sizeof(DxbcTessInfo)     },
+      }};
+
+      cacheKey.options = Sha1Hash::compute(chunks.size(), chunks.data());
+    }
+
+    std::vector<char> cacheData;
+
+    if (shaderCache != nullptr)
+      m_shader = shaderCache->lookup(cacheKey, cacheData);
+
+    if (m_shader == nullptr) {
+      m_shader = passthroughShader
+        ? module.compilePassthroughShader(*pDxbcModuleInfo, name)
+        : module.compile                 (*pDxbcModuleInfo, name);
+
+      if (shaderCache != nullptr)
+        shaderCache->store(cacheKey, m_shader, cacheData);
+    }
     m_shader->setShaderKey(*pShaderKey);
     
     if (dumpPath.size() != 0) {
@@ -34,6 +34,9 @@ namespace dxvk {
 
 
   D3D9CommonTexture::~D3D9CommonTexture() {
+    for (uint32_t i = 0; i < CountSubresources(); i++)
+      DestroyBufferSubresource(i);
+
     m_device->ChangeReportedMemory(m_size);
   }
 
@@ -74,32 +77,66 @@ namespace dxvk {
     if (m_buffers[Subresource] != nullptr)
       return false;
 
-    DxvkBufferCreateInfo info;
-    info.size   = GetMipSize(Subresource);
-    info.usage  = VK_BUFFER_USAGE_TRANSFER_SRC_BIT
-                | VK_BUFFER_USAGE_TRANSFER_DST_BIT
-                | VK_BUFFER_USAGE_STORAGE_BUFFER_BIT;
-    info.stages = VK_PIPELINE_STAGE_TRANSFER_BIT;
-    info.access = VK_ACCESS_TRANSFER_READ_BIT
-                | VK_ACCESS_TRANSFER_WRITE_BIT;
-
     VkMemoryPropertyFlags memType = VK_MEMORY_PROPERTY_HOST_VISIBLE_BIT
                                   | VK_MEMORY_PROPERTY_HOST_COHERENT_BIT;
 
     if (m_mapMode == D3D9_COMMON_TEXTURE_MAP_MODE_SYSTEMMEM || m_desc.Pool == D3DPOOL_MANAGED)
       memType |= VK_MEMORY_PROPERTY_HOST_CACHED_BIT;
 
-    m_buffers[Subresource] = m_device->GetDXVKDevice()->createBuffer(info, memType);
+    m_buffers[Subresource] = m_device->AllocMappingBuffer(GetMipSize(Subresource), memType);
 
-    if (RequiresFixup()) {
-      info.size = GetMipSize(Subresource, true);
-      m_fixupBuffers[Subresource] = m_device->GetDXVKDevice()->createBuffer(info, memType);
-    }
+    if (RequiresFixup())
+      m_fixupBuffers[Subresource] = m_device->AllocMappingBuffer(GetMipSize(Subresource, true), memType);
 
     return true;
   }
 
 
+  void D3D9CommonTexture::DestroyBufferSubresource(UINT Subresource) {
+    if (m_buffers[Subresource] != nullptr)
+      m_device->FreeMappingBuffer(std::move(m_buffers[Subresource]));
+
+    if (m_fixupBuffers[Subresource] != nullptr)
+      m_device->FreeMappingBuffer(std::move(m_fixupBuffers[Subresource]));
+  }
+
+
+  void D3D9CommonTexture::AddDirtyBox(UINT Subresource, const D3DBOX* pBox) {
+    const VkExtent3D extent = GetExtentMip(Subresource);
+
+    D3DBOX box;
+    box.Left   = 0;
+    box.Top    = 0;
+    box.Front  = 0;
+    box.Right  = extent.width;
+    box.Bottom = extent.height;
+    box.Back   = extent.depth;
+
+    if (pBox != nullptr) {
+      box.Left   = std::min(pBox->Left,   box.Right);
+      box.Top    = std::min(pBox->Top,    box.Bottom);
+      box.Front  = std::min(pBox->Front,  box.Back);
+      box.Right  = std::min(pBox->Right,  box.Right);
+      box.Bottom = std::min(pBox->Bottom, box.Bottom);
+      box.Back   = std::min(pBox->Back,   box.Back);
+    }
+
+    D3DBOX& dirty = m_dirtyBoxes[Subresource];
+
+    if (dirty.Left >= dirty.Right) {
+      dirty = box;
+      return;
+    }
+
+    dirty.Left   = std::min(dirty.Left,   box.Left);
+    dirty.Top    = std::min(dirty.Top,    box.Top);
+    dirty.Front  = std::min(dirty.Front,  box.Front);
+    dirty.Right  = std::max(dirty.Right,  box.Right);
+    dirty.Bottom = std::max(dirty.Bottom, box.Bottom);
+    dirty.Back   = std::max(dirty.Back,   box.Back);
+  }
+
+
   VkDeviceSize D3D9CommonTexture::GetMipSize(UINT Subresource, bool Fixup) const {
     const UINT MipLevel = Subresource % m_desc.MipLevels;
 
@@ -118,6 +118,14 @@ namespace dxvk {
       return m_format;
     }
 
+    /**
+     * \brief Resource type
+     * \returns The D3D9 resource type of the texture
+     */
+    D3DRESOURCETYPE GetType() const {
+      return m_type;
+    }
+
     /**
      * \brief Counts number of subresources
      * \returns Number of subresources
@@ -208,6 +216,32 @@ namespace dxvk {
       return m_lockFlags[Subresource];
     }
 
+    /**
+     * \brief Adds a dirty region
+     *
+     * Extends the region of the given subresource that
+     * has to be copied to the image when unlocking it.
+     * \param [in] Subresource Subresource index
+     * \param [in] pBox Locked box, or \c nullptr for the entire subresource
+     */
+    void AddDirtyBox(UINT Subresource, const D3DBOX* pBox);
+
+    /**
+     * \brief Dirty region
+     * \returns Union of all boxes locked since the last flush
+     */
+    const D3DBOX& GetDirtyBox(UINT Subresource) const {
+      return m_dirtyBoxes[Subresource];
+    }
+
+    /**
+     * \brief Clears the dirty region
+     * Called once the region has been copied to the image
+     */
+    void ClearDirtyBox(UINT Subresource) {
+      m_dirtyBoxes[Subresource] = D3DBOX();
+    }
+
     /**
      * \brief Shadow
      * \returns Whether the texture is to be depth compared
@@ -247,19 +281,19 @@ namespace dxvk {
     /**
      * \brief Creates a buffer
      * Creates mapping and staging buffers for a given subresource
-     * allocates new buffers if necessary
+     * allocates new buffers if necessary. Buffers are taken from
+     * the device's mapping buffer pool and may be larger than
+     * the subresource.
      * \returns Whether an allocation happened
      */
     bool CreateBufferSubresource(UINT Subresource);
 
     /**
      * \brief Destroys a buffer
-     * Destroys mapping and staging buffers for a given subresource
+     * Returns mapping and staging buffers for a given
+     * subresource to the device's mapping buffer pool
      */
-    void DestroyBufferSubresource(UINT Subresource) {
-      m_buffers[Subresource] = nullptr;
-      m_fixupBuffers[Subresource] = nullptr;
-    }
+    void DestroyBufferSubresource(UINT Subresource);
 
     /**
      * \brief Managed
@@ -313,6 +347,12 @@ namespace dxvk {
       return util::computeMipLevelExtent(GetExtent(), MipLevel);
     }
 
+    /**
+     * \brief Mip level
+     * \returns Size of packed mip level in bytes
+     */
+    VkDeviceSize GetMipSize(UINT Subresource, bool Fixup = false) const;
+
     bool MarkHazardous() {
       return std::exchange(m_views.Hazardous, true);
     }
@@ -331,6 +371,7 @@ namespace dxvk {
     D3D9SubresourceArray<
       Rc<DxvkBuffer>>             m_fixupBuffers;
     D3D9SubresourceArray<DWORD>   m_lockFlags;
+    D3D9SubresourceArray<D3DBOX>  m_dirtyBoxes = { };
 
     D3D9ViewSet                   m_views;
 
@@ -340,12 +381,6 @@ namespace dxvk {
 
     int64_t                       m_size = 0;
 
-    /**
-     * \brief Mip level
-     * \returns Size of packed mip level in bytes
-     */
-    VkDeviceSize GetMipSize(UINT Subresource, bool Fixup = false) const;
-
     Rc<DxvkImage> CreatePrimaryImage(D3DRESOURCETYPE ResourceType) const;
 
     Rc<DxvkImage> CreateResolveImage() const;
@@ -7,6 +7,7 @@
 #include "../util/util_math.h"
 #include "../util/util_vector.h"
 
+#include <cstddef>
 #include <cstdint>
 
 namespace dxvk {
@@ -26,11 +27,60 @@ namespace dxvk {
     } hardware;
   };
 
+  /**
+   * \brief Dirty register range
+   *
+   * Tracks the union of all registers of a given
+   * constant type that were written since the last
+   * upload, so that writes to registers the bound
+   * shader never reads do not cause an upload.
+   */
+  struct D3D9ConstantRange {
+    uint32_t lo = 0;
+    uint32_t hi = 0;
+
+    void add(uint32_t start, uint32_t count) {
+      if (lo == hi) {
+        lo = start;
+        hi = start + count;
+      } else {
+        lo = std::min(lo, start);
+        hi = std::max(hi, start + count);
+      }
+    }
+
+    bool overlaps(uint32_t count) const {
+      return lo < hi && lo < count;
+    }
+
+    void clear() {
+      lo = 0;
+      hi = 0;
+    }
+  };
+
   struct D3D9ConstantSets {
-    constexpr static uint32_t SetSize = sizeof(D3D9ShaderConstants);
+    constexpr static uint32_t     SetSize   = sizeof(D3D9ShaderConstants);
+    // Constant data is sub-allocated linearly from a ring
+    // buffer, which only gets renamed once it is exhausted.
+    constexpr static VkDeviceSize RingSize  = 64 << 10;
+
     Rc<DxvkBuffer>            buffer;
-    const DxsoShaderMetaInfo* meta  = nullptr;
-    bool                      dirty = true;
+    DxvkBufferSliceHandle     slice     = { };
+    VkDeviceSize              offset    = 0;
+
+    DxsoShaderMetaInfo        meta      = { };
+    bool                      dirty     = true;
+
+    D3D9ConstantRange         dirtyF;
+    D3D9ConstantRange         dirtyI;
+    uint32_t                  dirtyB    = 0;
+
+    void clearDirtyRanges() {
+      dirtyF.clear();
+      dirtyI.clear();
+      dirtyB = 0;
+    }
   };
 
 }
\ No newline at end of file
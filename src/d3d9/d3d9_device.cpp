@@ -57,6 +57,8 @@ namespace dxvk {
       m_flags.set(D3D9DeviceFlag::ExtendedDevice);
 
     m_initializer      = new D3D9Initializer(m_dxvkDevice);
+    m_mappingPool      = new D3D9MappingBufferPool(m_dxvkDevice,
+      VkDeviceSize(std::max(m_d3d9Options.mappingBufferPoolSize, 0)) << 20);
     m_frameLatencyCap  = m_d3d9Options.maxFrameLatency;
 
     for (uint32_t i = 0; i < m_frameEvents.size(); i++)
@@ -135,6 +137,9 @@ namespace dxvk {
 
 
   HRESULT STDMETHODCALLTYPE D3D9DeviceEx::EvictManagedResources() {
+    D3D9DeviceLock lock = LockDevice();
+
+    m_mappingPool->Trim(0);
     return D3D_OK;
   }
 
@@ -1613,6 +1618,29 @@ namespace dxvk {
           UpdatePushConstant<D3D9RenderStateItem::AlphaRef>();
           break;
 
+        case D3DRS_FOGENABLE:
+        case D3DRS_FOGTABLEMODE:
+        case D3DRS_POINTSPRITEENABLE:
+          // Applied through spec constants on the next draw
+          break;
+
+        case D3DRS_FOGCOLOR:
+          UpdatePushConstant<D3D9RenderStateItem::FogColor>();
+          break;
+
+        case D3DRS_FOGSTART:
+          UpdatePushConstant<D3D9RenderStateItem::FogScale>();
+          break;
+
+        case D3DRS_FOGEND:
+          UpdatePushConstant<D3D9RenderStateItem::FogScale>();
+          UpdatePushConstant<D3D9RenderStateItem::FogEnd>();
+          break;
+
+        case D3DRS_FOGDENSITY:
+          UpdatePushConstant<D3D9RenderStateItem::FogDensity>();
+          break;
+
         case D3DRS_TEXTUREFACTOR:
           m_flags.set(D3D9DeviceFlag::DirtyFFPixelData);
           break;
@@ -1785,7 +1813,25 @@ namespace dxvk {
       return m_recorder->SetTextureStageState(Stage, Type, Value);
 
     if (likely(m_state.textureStages[Stage][Type] != Value)) {
-      m_flags.set(D3D9DeviceFlag::DirtyFFPixelShader);
+      // Only a subset of texture stage states
+      // is part of the fixed function shader key.
+      switch (Type) {
+        case D3DTSS_COLOROP:
+        case D3DTSS_COLORARG0:
+        case D3DTSS_COLORARG1:
+        case D3DTSS_COLORARG2:
+        case D3DTSS_ALPHAOP:
+        case D3DTSS_ALPHAARG0:
+        case D3DTSS_ALPHAARG1:
+        case D3DTSS_ALPHAARG2:
+        case D3DTSS_RESULTARG:
+          m_flags.set(D3D9DeviceFlag::DirtyFFPixelShader);
+          break;
+
+        default:
+          break;
+      }
+
       m_state.textureStages[Stage][Type] = Value;
     }
 
@@ -1920,7 +1966,8 @@ namespace dxvk {
           UINT             PrimitiveCount) {
     D3D9DeviceLock lock = LockDevice();
 
-    PrepareDraw();
+    if (unlikely(!PrepareDraw(PrimitiveType)))
+      return D3D_OK;
 
     EmitCs([this,
       cPrimType    = PrimitiveType,
@@ -1950,7 +1997,8 @@ namespace dxvk {
           UINT             PrimitiveCount) {
     D3D9DeviceLock lock = LockDevice();
 
-    PrepareDraw();
+    if (unlikely(!PrepareDraw(PrimitiveType)))
+      return D3D_OK;
 
     EmitCs([this,
       cPrimType        = PrimitiveType,
@@ -1980,21 +2028,19 @@ namespace dxvk {
           UINT             VertexStreamZeroStride) {
     D3D9DeviceLock lock = LockDevice();
 
-    PrepareDraw(true);
+    if (unlikely(!PrepareDraw(PrimitiveType, true)))
+      return D3D_OK;
 
     auto drawInfo = GenerateDrawInfo(PrimitiveType, PrimitiveCount, 0);
 
     const uint32_t upSize = drawInfo.vertexCount * VertexStreamZeroStride;
 
-    AllocUpBuffer(upSize);
+    DxvkBufferSlice upSlice = AllocUpBuffer(upSize);
 
-    DxvkBufferSliceHandle physSlice = m_upBuffer->allocSlice();
-
-    std::memcpy(physSlice.mapPtr, pVertexStreamZeroData, upSize);
+    std::memcpy(upSlice.mapPtr(0), pVertexStreamZeroData, upSize);
 
     EmitCs([this,
-      cBuffer       = m_upBuffer,
-      cBufferSlice  = physSlice,
+      cBufferSlice  = std::move(upSlice),
       cPrimType     = PrimitiveType,
       cPrimCount    = PrimitiveCount,
       cInstanceCount = GetInstanceCount(),
@@ -2004,8 +2050,7 @@ namespace dxvk {
 
       ApplyPrimitiveType(ctx, cPrimType);
 
-      ctx->invalidateBuffer(cBuffer, cBufferSlice);
-      ctx->bindVertexBuffer(0, DxvkBufferSlice(cBuffer), cStride);
+      ctx->bindVertexBuffer(0, cBufferSlice, cStride);
       ctx->draw(
         drawInfo.vertexCount, drawInfo.instanceCount,
         0, 0);
@@ -2028,7 +2073,8 @@ namespace dxvk {
           UINT             VertexStreamZeroStride) {
     D3D9DeviceLock lock = LockDevice();
 
-    PrepareDraw(true);
+    if (unlikely(!PrepareDraw(PrimitiveType, true)))
+      return D3D_OK;
 
     auto drawInfo = GenerateDrawInfo(PrimitiveType, PrimitiveCount, 0);
 
@@ -2037,20 +2083,15 @@ namespace dxvk {
     const uint32_t indexSize = IndexDataFormat == D3DFMT_INDEX16 ? 2 : 4;
     const uint32_t indicesSize = drawInfo.vertexCount * indexSize;
 
-    const uint32_t upSize = vertexSize + indicesSize;
+    DxvkBufferSlice upVertexSlice = AllocUpBuffer(vertexSize);
+    DxvkBufferSlice upIndexSlice  = AllocUpBuffer(indicesSize);
 
-    AllocUpBuffer(upSize);
-
-    DxvkBufferSliceHandle physSlice = m_upBuffer->allocSlice();
-    uint8_t* data = reinterpret_cast<uint8_t*>(physSlice.mapPtr);
-
-    std::memcpy(data, pVertexStreamZeroData, vertexSize);
-    std::memcpy(data + vertexSize, pIndexData, indicesSize);
+    std::memcpy(upVertexSlice.mapPtr(0), pVertexStreamZeroData, vertexSize);
+    std::memcpy(upIndexSlice.mapPtr(0),  pIndexData,            indicesSize);
 
     EmitCs([this,
-      cVertexSize   = vertexSize,
-      cBuffer       = m_upBuffer,
-      cBufferSlice  = physSlice,
+      cVertexSlice  = std::move(upVertexSlice),
+      cIndexSlice   = std::move(upIndexSlice),
       cPrimType     = PrimitiveType,
       cPrimCount    = PrimitiveCount,
       cStride       = VertexStreamZeroStride,
@@ -2062,9 +2103,8 @@ namespace dxvk {
 
       ApplyPrimitiveType(ctx, cPrimType);
 
-      ctx->invalidateBuffer(cBuffer, cBufferSlice);
-      ctx->bindVertexBuffer(0, DxvkBufferSlice(cBuffer, 0, cVertexSize), cStride);
-      ctx->bindIndexBuffer(DxvkBufferSlice(cBuffer, cVertexSize, cBuffer->info().size - cVertexSize), cIndexType);
+      ctx->bindVertexBuffer(0, cVertexSlice, cStride);
+      ctx->bindIndexBuffer(cIndexSlice, cIndexType);
       ctx->drawIndexed(
         drawInfo.vertexCount, drawInfo.instanceCount,
         0,
@@ -2207,7 +2247,7 @@ namespace dxvk {
     DxsoModuleInfo moduleInfo;
     moduleInfo.options = m_dxsoOptions;
 
-    D3D9CommonShader module;
+    Rc<D3D9ShaderModule> module;
 
     if (FAILED(this->CreateShaderModule(&module,
       VK_SHADER_STAGE_VERTEX_BIT,
@@ -2232,30 +2272,17 @@ namespace dxvk {
     if (shader == m_state.vertexShader)
       return D3D_OK;
 
-    auto* oldShader = GetCommonShader(m_state.vertexShader);
-    auto* newShader = GetCommonShader(shader);
-
-    bool oldCopies = oldShader && oldShader->GetMeta().needsConstantCopies;
-    bool newCopies = newShader && newShader->GetMeta().needsConstantCopies;
-
-    m_consts[DxsoProgramTypes::VertexShader].dirty |= oldCopies || newCopies || !oldShader;
-    m_consts[DxsoProgramTypes::VertexShader].meta  = newShader ? &newShader->GetMeta() : nullptr;
-
-    if (newShader && oldShader) {
-      m_consts[DxsoProgramTypes::VertexShader].dirty
-        |= newShader->GetMeta().maxConstIndexF != oldShader->GetMeta().maxConstIndexF
-        || newShader->GetMeta().maxConstIndexI != oldShader->GetMeta().maxConstIndexI
-        || newShader->GetMeta().maxConstIndexB != oldShader->GetMeta().maxConstIndexB;
-    }
-
     changePrivate(m_state.vertexShader, shader);
 
+    // Translation may still be pending, so the shader
+    // only gets bound once a draw actually needs it
     if (shader != nullptr) {
       m_flags.set(D3D9DeviceFlag::DirtyFFVertexShader);
-
-      BindShader(
-        DxsoProgramTypes::VertexShader,
-        GetCommonShader(shader));
+      m_flags.set(D3D9DeviceFlag::DirtyProgVertexShader);
+    } else {
+      // Constants must be re-uploaded for the next shader
+      m_consts[DxsoProgramTypes::VertexShader].dirty = true;
+      m_flags.clr(D3D9DeviceFlag::DirtyProgVertexShader);
     }
 
     m_flags.set(D3D9DeviceFlag::DirtyInputLayout);
@@ -2532,7 +2559,7 @@ namespace dxvk {
     DxsoModuleInfo moduleInfo;
     moduleInfo.options = m_dxsoOptions;
 
-    D3D9CommonShader module;
+    Rc<D3D9ShaderModule> module;
 
     if (FAILED(this->CreateShaderModule(&module,
       VK_SHADER_STAGE_FRAGMENT_BIT,
@@ -2557,30 +2584,18 @@ namespace dxvk {
     if (shader == m_state.pixelShader)
       return D3D_OK;
 
-    auto* oldShader = GetCommonShader(m_state.pixelShader);
-    auto* newShader = GetCommonShader(shader);
-
-    bool oldCopies = oldShader && oldShader->GetMeta().needsConstantCopies;
-    bool newCopies = newShader && newShader->GetMeta().needsConstantCopies;
-
-    m_consts[DxsoProgramTypes::PixelShader].dirty |= oldCopies || newCopies || !oldShader;
-    m_consts[DxsoProgramTypes::PixelShader].meta  = newShader ? &newShader->GetMeta() : nullptr;
-
-    if (newShader && oldShader) {
-      m_consts[DxsoProgramTypes::PixelShader].dirty
-        |= newShader->GetMeta().maxConstIndexF != oldShader->GetMeta().maxConstIndexF
-        || newShader->GetMeta().maxConstIndexI != oldShader->GetMeta().maxConstIndexI
-        || newShader->GetMeta().maxConstIndexB != oldShader->GetMeta().maxConstIndexB;
-    }
-
     changePrivate(m_state.pixelShader, shader);
 
+    // Translation may still be pending, so the shader
+    // only gets bound once a draw actually needs it
     if (shader != nullptr) {
       m_flags.set(D3D9DeviceFlag::DirtyFFPixelShader);
-
-      BindShader(
-        DxsoProgramTypes::PixelShader,
-        GetCommonShader(shader));
+      m_ffKeyFSBound = false;
+      m_flags.set(D3D9DeviceFlag::DirtyProgPixelShader);
+    } else {
+      // Constants must be re-uploaded for the next shader
+      m_consts[DxsoProgramTypes::PixelShader].dirty = true;
+      m_flags.clr(D3D9DeviceFlag::DirtyProgPixelShader);
     }
 
     return D3D_OK;
@@ -3063,6 +3078,15 @@ namespace dxvk {
     rs[D3DRS_ALPHAREF]            = 0;
     UpdatePushConstant<D3D9RenderStateItem::AlphaRef>();
 
+    rs[D3DRS_FOGCOLOR]            = 0;
+    rs[D3DRS_FOGSTART]            = bit::cast<DWORD>(0.0f);
+    rs[D3DRS_FOGEND]              = bit::cast<DWORD>(1.0f);
+    rs[D3DRS_FOGDENSITY]          = bit::cast<DWORD>(1.0f);
+    UpdatePushConstant<D3D9RenderStateItem::FogColor>();
+    UpdatePushConstant<D3D9RenderStateItem::FogScale>();
+    UpdatePushConstant<D3D9RenderStateItem::FogEnd>();
+    UpdatePushConstant<D3D9RenderStateItem::FogDensity>();
+
     rs[D3DRS_MULTISAMPLEMASK]     = 0xffffffff;
     BindMultiSampleState();
 
@@ -3083,11 +3107,7 @@ namespace dxvk {
     SetRenderState(D3DRS_FOGENABLE, FALSE);
     SetRenderState(D3DRS_SPECULARENABLE, FALSE);
     //	SetRenderState(D3DRS_ZVISIBLE, 0);
-    SetRenderState(D3DRS_FOGCOLOR, 0);
     SetRenderState(D3DRS_FOGTABLEMODE, D3DFOG_NONE);
-    SetRenderState(D3DRS_FOGSTART, bit::cast<DWORD>(0.0f));
-    SetRenderState(D3DRS_FOGEND, bit::cast<DWORD>(1.0f));
-    SetRenderState(D3DRS_FOGDENSITY, bit::cast<DWORD>(1.0f));
     SetRenderState(D3DRS_RANGEFOGENABLE, FALSE);
     SetRenderState(D3DRS_WRAP0, 0);
     SetRenderState(D3DRS_WRAP1, 0);
@@ -3164,16 +3184,7 @@ namespace dxvk {
 
     for (uint32_t i = 0; i < m_state.textures.size(); i++) {
       m_state.textures[i] = nullptr;
-
-      DWORD sampler = i;
-      auto samplerInfo = RemapStateSamplerShader(sampler);
-      uint32_t slot = computeResourceSlotId(samplerInfo.first, DxsoBindingType::ColorImage, uint32_t(samplerInfo.second));
-
-      EmitCs([
-        cSlot = slot
-      ](DxvkContext* ctx) {
-        ctx->bindResourceView(cSlot, nullptr, nullptr);
-      });
+      BindTexture(i);
     }
 
     auto& ss = m_state.samplerStates;
@@ -3436,14 +3447,51 @@ namespace dxvk {
   }
 
 
-  void D3D9DeviceEx::AllocUpBuffer(uint32_t size) {
-    const uint32_t currentSize = m_upBuffer != nullptr
-      ? m_upBuffer->info().size
-      : 0;
+  DxvkBufferSlice D3D9DeviceEx::AllocUpBuffer(VkDeviceSize size) {
+    size = align(size, UpBufferAlignment);
 
-    if (likely(currentSize >= size))
-      return;
+    // Oversized allocations get a dedicated buffer, which
+    // is freed once the CS thread has finished using it.
+    if (unlikely(size > UpBufferPageSize))
+      return DxvkBufferSlice(CreateUpBuffer(size));
+
+    if (unlikely(m_upPage.buffer == nullptr
+              || m_upPage.offset + size > UpBufferPageSize)) {
+      // Retire the current page. It can be reused as soon as
+      // the GPU has finished executing the current submission.
+      if (m_upPage.buffer != nullptr) {
+        m_upPage.fence.revision = m_upPage.fence.event->reset();
+
+        EmitCs([
+          cFence = m_upPage.fence
+        ] (DxvkContext* ctx) {
+          ctx->signalEvent(cFence);
+        });
+
+        m_upRetiredPages.push(std::move(m_upPage));
+      }
 
+      // Pages are retired in order, so only the
+      // oldest page needs to be checked for reuse.
+      if (!m_upRetiredPages.empty()
+       && m_upRetiredPages.front().fence.event->getStatus() == DxvkEventStatus::Signaled) {
+        m_upPage = std::move(m_upRetiredPages.front());
+        m_upRetiredPages.pop();
+      } else {
+        m_upPage.buffer = CreateUpBuffer(UpBufferPageSize);
+        m_upPage.fence  = { new DxvkEvent(), 0 };
+      }
+
+      m_upPage.offset = 0;
+    }
+
+    DxvkBufferSlice slice(m_upPage.buffer, m_upPage.offset, size);
+    m_upPage.offset += size;
+    return slice;
+  }
+
+
+  Rc<DxvkBuffer> D3D9DeviceEx::CreateUpBuffer(VkDeviceSize size) {
     DxvkBufferCreateInfo  info;
     info.size   = size;
     info.usage  = VK_BUFFER_USAGE_VERTEX_BUFFER_BIT
@@ -3456,7 +3504,7 @@ namespace dxvk {
                                       | VK_MEMORY_PROPERTY_HOST_VISIBLE_BIT
                                       | VK_MEMORY_PROPERTY_HOST_COHERENT_BIT;
 
-    m_upBuffer = m_dxvkDevice->createBuffer(info, memoryFlags);
+    return m_dxvkDevice->createBuffer(info, memoryFlags);
   }
 
 
@@ -3558,6 +3606,9 @@ namespace dxvk {
     
     pResource->SetLockFlags(Subresource, Flags);
 
+    if (!(Flags & D3DLOCK_READONLY))
+      pResource->AddDirtyBox(Subresource, pBox);
+
     VkExtent3D levelExtent = pResource->GetExtentMip(MipLevel);
     VkExtent3D blockCount  = util::computeBlockCount(levelExtent, formatInfo->blockSize);
       
@@ -3691,6 +3742,21 @@ namespace dxvk {
   }
 
 
+  void D3D9DeviceEx::FreeMappingBuffer(
+          Rc<DxvkBuffer>&&        Buffer) {
+    D3D9DeviceLock lock = LockDevice();
+
+    // Commands using the buffer may still be queued, so
+    // only make it available again on the CS thread
+    EmitCs([
+      cPool   = m_mappingPool,
+      cBuffer = std::move(Buffer)
+    ] (DxvkContext* ctx) {
+      cPool->FreeBuffer(cBuffer);
+    });
+  }
+
+
   HRESULT D3D9DeviceEx::FlushImage(
         D3D9CommonTexture*      pResource,
         UINT                    Subresource) {
@@ -3712,15 +3778,72 @@ namespace dxvk {
       subresource.mipLevel,
       subresource.arrayLayer, 1 };
 
+    // Only copy the region that was actually locked since
+    // the last flush, rounded out to whole format blocks.
+    const D3DBOX& dirtyBox = pResource->GetDirtyBox(Subresource);
+
+    if (dirtyBox.Left >= dirtyBox.Right
+     || dirtyBox.Top  >= dirtyBox.Bottom
+     || dirtyBox.Front >= dirtyBox.Back)
+      return D3D_OK;
+
+    const VkExtent3D blockSize = formatInfo->blockSize;
+
+    VkOffset3D dstOffset = { 0, 0, 0 };
+    VkExtent3D dstExtent = levelExtent;
+
+    // ATI1 and ATI2 are locked with a fake pitch,
+    // so always copy the entire level for those
+    const D3D9Format format = pResource->Desc()->Format;
+
+    if (format != D3D9Format::ATI1 && format != D3D9Format::ATI2) {
+      dstOffset = VkOffset3D {
+        int32_t(dirtyBox.Left  - dirtyBox.Left  % blockSize.width),
+        int32_t(dirtyBox.Top   - dirtyBox.Top   % blockSize.height),
+        int32_t(dirtyBox.Front - dirtyBox.Front % blockSize.depth) };
+
+      dstExtent = VkExtent3D {
+        std::min(align(dirtyBox.Right,  blockSize.width),  levelExtent.width)  - uint32_t(dstOffset.x),
+        std::min(align(dirtyBox.Bottom, blockSize.height), levelExtent.height) - uint32_t(dstOffset.y),
+        std::min(align(dirtyBox.Back,   blockSize.depth),  levelExtent.depth)  - uint32_t(dstOffset.z) };
+    }
+
+    pResource->ClearDirtyBox(Subresource);
+
+    // The buffer stores the entire level tightly packed
+    VkExtent3D levelBlockCount = util::computeBlockCount(levelExtent, blockSize);
+    VkExtent3D copyBlockCount  = util::computeBlockCount(dstExtent,   blockSize);
+    VkOffset3D copyBlockOffset = util::computeBlockOffset(dstOffset,  blockSize);
+
+    VkDeviceSize rowPitch   = formatInfo->elementSize * levelBlockCount.width;
+    VkDeviceSize slicePitch = rowPitch * levelBlockCount.height;
+
+    VkDeviceSize srcOffset = copyBlockOffset.z * slicePitch
+                           + copyBlockOffset.y * rowPitch
+                           + copyBlockOffset.x * formatInfo->elementSize;
+
+    VkExtent2D srcExtent = {
+      levelBlockCount.width  * blockSize.width,
+      levelBlockCount.height * blockSize.height };
+
+    VkDeviceSize copySize = formatInfo->elementSize
+      * copyBlockCount.width * copyBlockCount.height * copyBlockCount.depth;
+
     EmitCs([
       cSrcBuffer      = copyBuffer,
+      cSrcOffset      = srcOffset,
+      cSrcExtent      = srcExtent,
       cDstImage       = image,
       cDstLayers      = subresourceLayers,
-      cDstLevelExtent = levelExtent
+      cDstOffset      = dstOffset,
+      cDstExtent      = dstExtent,
+      cCopySize       = copySize
     ] (DxvkContext* ctx) {
       ctx->copyBufferToImage(cDstImage, cDstLayers,
-        VkOffset3D{ 0, 0, 0 }, cDstLevelExtent,
-        cSrcBuffer, 0, { 0u, 0u });
+        cDstOffset, cDstExtent,
+        cSrcBuffer, cSrcOffset, cSrcExtent);
+
+      ctx->addStatCtr(DxvkStatCounter::UploadTextureBytes, cCopySize);
     });
 
     return D3D_OK;
@@ -3874,23 +3997,61 @@ namespace dxvk {
 
 
   void D3D9DeviceEx::FlushImplicit(BOOL StrongHint) {
-    // Flush only if the GPU is about to go idle, in
-    // order to keep the number of submissions low.
+    auto now = std::chrono::high_resolution_clock::now();
+
     uint32_t pending = m_dxvkDevice->pendingSubmissions();
+    UpdateFlushInterval(now, pending);
 
-    if (StrongHint || pending <= MaxPendingSubmits) {
-      auto now = std::chrono::high_resolution_clock::now();
+    // If the CS thread is far behind, the flush would only
+    // be executed much later, and only adds more work to it.
+    if (!StrongHint && m_csThread.pendingChunks() > MaxPendingCsChunks)
+      return;
 
-      uint32_t delay = MinFlushIntervalUs
-                     + IncFlushIntervalUs * pending;
+    // Flush only if the GPU is about to go idle, in
+    // order to keep the number of submissions low.
+    if (StrongHint || pending <= MaxPendingSubmits) {
+      // Feed the GPU as soon as possible when it has
+      // nothing to do, otherwise use the adaptive delay.
+      uint32_t delay = pending
+        ? m_flushInterval + IncFlushIntervalUs * pending
+        : MinFlushIntervalUs;
 
       // Prevent flushing too often in short intervals.
-      if (now - m_lastFlush >= std::chrono::microseconds(delay))
+      if (now - m_lastFlush >= std::chrono::microseconds(delay)) {
+        if (m_csIsBusy || m_csChunk->commandCount() != 0)
+          m_dxvkDevice->addStatCtr(DxvkStatCounter::QueueFlushCount, 1);
+
         Flush();
+      }
     }
   }
 
 
+  void D3D9DeviceEx::UpdateFlushInterval(
+          std::chrono::high_resolution_clock::time_point Now,
+          uint32_t                                      Pending) {
+    auto windowUs = std::chrono::duration_cast<std::chrono::microseconds>(Now - m_flushWindowStart).count();
+
+    if (windowUs < FlushWindowUs)
+      return;
+
+    uint64_t idle = m_dxvkDevice->gpuIdleTime();
+    uint64_t idleUs = idle - m_flushWindowIdle;
+
+    // If the GPU ran out of work for more than a small fraction
+    // of the window, we are flushing too late, so shorten the
+    // interval quickly. If it never went idle and still has
+    // work queued up, we can afford to submit less often.
+    if (idleUs * 20 > uint64_t(windowUs))
+      m_flushInterval = std::max(m_flushInterval * 3 / 4, MinFlushIntervalUs);
+    else if (idleUs * 100 < uint64_t(windowUs) && Pending > 1)
+      m_flushInterval = std::min(m_flushInterval + IncFlushIntervalUs, MaxFlushIntervalUs);
+
+    m_flushWindowStart = Now;
+    m_flushWindowIdle  = idle;
+  }
+
+
   void D3D9DeviceEx::SynchronizeCsThread() {
     D3D9DeviceLock lock = LockDevice();
 
@@ -3974,7 +4135,7 @@ namespace dxvk {
 
   void D3D9DeviceEx::CreateConstantBuffers() {
     DxvkBufferCreateInfo info;
-    info.size   = D3D9ConstantSets::SetSize;
+    info.size   = D3D9ConstantSets::RingSize;
     info.usage  = VK_BUFFER_USAGE_UNIFORM_BUFFER_BIT;
     info.access = VK_ACCESS_UNIFORM_READ_BIT;
     info.stages = VK_PIPELINE_STAGE_VERTEX_SHADER_BIT
@@ -3984,8 +4145,15 @@ namespace dxvk {
                                       | VK_MEMORY_PROPERTY_HOST_VISIBLE_BIT
                                       | VK_MEMORY_PROPERTY_HOST_COHERENT_BIT;
 
-    m_consts[DxsoProgramTypes::VertexShader].buffer = m_dxvkDevice->createBuffer(info, memoryFlags);
-    m_consts[DxsoProgramTypes::PixelShader].buffer  = m_dxvkDevice->createBuffer(info, memoryFlags);
+    m_constantAlignment = std::max<VkDeviceSize>(
+      m_dxvkAdapter->deviceProperties().limits.minUniformBufferOffsetAlignment,
+      alignof(D3D9ShaderConstants));
+
+    for (auto& constSet : m_consts) {
+      constSet.buffer = m_dxvkDevice->createBuffer(info, memoryFlags);
+      constSet.slice  = constSet.buffer->getSliceHandle();
+      constSet.offset = 0;
+    }
 
     info.size = caps::MaxClipPlanes * sizeof(D3D9ClipPlane);
     m_vsClipPlanes = m_dxvkDevice->createBuffer(info, memoryFlags);
@@ -4013,11 +4181,11 @@ namespace dxvk {
       });
     };
 
-    BindConstantBuffer(DxsoProgramTypes::VertexShader, m_consts[DxsoProgramTypes::VertexShader].buffer, DxsoConstantBuffers::VSConstantBuffer);
+    // The shader constant buffers themselves get bound with
+    // the appropriate offset whenever constants are uploaded.
     BindConstantBuffer(DxsoProgramTypes::VertexShader, m_vsClipPlanes,                                  DxsoConstantBuffers::VSClipPlanes);
     BindConstantBuffer(DxsoProgramTypes::VertexShader, m_vsFixedFunction,                               DxsoConstantBuffers::VSFixedFunction);
 
-    BindConstantBuffer(DxsoProgramTypes::PixelShader,  m_consts[DxsoProgramTypes::PixelShader].buffer,  DxsoConstantBuffers::PSConstantBuffer);
     BindConstantBuffer(DxsoProgramTypes::PixelShader,  m_psFixedFunction,                               DxsoConstantBuffers::PSFixedFunction);
     
     m_flags.set(
@@ -4029,37 +4197,92 @@ namespace dxvk {
   void D3D9DeviceEx::UploadConstants() {
     D3D9ConstantSets& constSet = m_consts[ShaderStage];
 
-    if (!constSet.dirty)
+    const DxsoShaderMetaInfo& meta = constSet.meta;
+
+    // Only registers which the shader can actually read
+    // need to be considered when checking dirty ranges.
+    const uint32_t readCountF = meta.usesRelativeIndexing
+      ? caps::MaxFloatConstants
+      : meta.maxConstIndexF;
+    const uint32_t readMaskB  = (1u << meta.maxConstIndexB) - 1;
+
+    if (!constSet.dirty
+     && !constSet.dirtyF.overlaps(readCountF)
+     && !constSet.dirtyI.overlaps(meta.maxConstIndexI)
+     && !(constSet.dirtyB & readMaskB))
       return;
 
     constSet.dirty = false;
+    constSet.clearDirtyRanges();
 
-    DxvkBufferSliceHandle slice = constSet.buffer->allocSlice();
+    // The constant buffer layout is fixed, so the uploaded range
+    // has to cover everything up to the last member in use.
+    VkDeviceSize size = 0;
 
-    auto dstData = reinterpret_cast<D3D9ShaderConstants*>(slice.mapPtr);
-    auto srcData = &m_state.consts[ShaderStage];
+    if (meta.usesRelativeIndexing)
+      size = D3D9ConstantSets::SetSize;
+    else {
+      if (meta.maxConstIndexF)
+        size = sizeof(Vector4) * meta.maxConstIndexF;
+      if (meta.maxConstIndexI)
+        size = offsetof(D3D9ShaderConstants, hardware.iConsts) + sizeof(Vector4i) * meta.maxConstIndexI;
+      if (meta.maxConstIndexB)
+        size = offsetof(D3D9ShaderConstants, hardware.boolBitfield) + sizeof(uint32_t);
+    }
+
+    if (unlikely(!size))
+      return;
+
+    VkDeviceSize allocSize = align(size, m_constantAlignment);
+
+    if (unlikely(constSet.offset + allocSize > D3D9ConstantSets::RingSize)) {
+      constSet.slice  = constSet.buffer->allocSlice();
+      constSet.offset = 0;
+
+      EmitCs([
+        cBuffer = constSet.buffer,
+        cSlice  = constSet.slice
+      ] (DxvkContext* ctx) {
+        ctx->invalidateBuffer(cBuffer, cSlice);
+      });
+    }
+
+    const uint32_t slotId = computeResourceSlotId(
+      ShaderStage, DxsoBindingType::ConstantBuffer,
+      ShaderStage == DxsoProgramTypes::VertexShader
+        ? DxsoConstantBuffers::VSConstantBuffer
+        : DxsoConstantBuffers::PSConstantBuffer);
 
     EmitCs([
+      cSlotId = slotId,
       cBuffer = constSet.buffer,
-      cSlice  = slice
+      cOffset = constSet.offset,
+      cLength = size
     ] (DxvkContext* ctx) {
-      ctx->invalidateBuffer(cBuffer, cSlice);
+      ctx->bindResourceBuffer(cSlotId,
+        DxvkBufferSlice(cBuffer, cOffset, cLength));
+      ctx->addStatCtr(DxvkStatCounter::UploadConstantBytes, uint32_t(cLength));
     });
 
-    if (constSet.meta->usesRelativeIndexing) {
+    auto dstData = reinterpret_cast<D3D9ShaderConstants*>(
+      reinterpret_cast<char*>(constSet.slice.mapPtr) + constSet.offset);
+    auto srcData = &m_state.consts[ShaderStage];
+
+    constSet.offset += allocSize;
+
+    if (meta.usesRelativeIndexing) {
       std::memcpy(dstData, srcData, D3D9ConstantSets::SetSize);
     } else {
-      if (constSet.meta->maxConstIndexF)
-        std::memcpy(&dstData->hardware.fConsts[0], &srcData->hardware.fConsts[0], sizeof(Vector4) * constSet.meta->maxConstIndexF);
-      if (constSet.meta->maxConstIndexI)
-        std::memcpy(&dstData->hardware.iConsts[0], &srcData->hardware.iConsts[0], sizeof(Vector4) * constSet.meta->maxConstIndexI);
-      if (constSet.meta->maxConstIndexB)
+      if (meta.maxConstIndexF)
+        std::memcpy(&dstData->hardware.fConsts[0], &srcData->hardware.fConsts[0], sizeof(Vector4) * meta.maxConstIndexF);
+      if (meta.maxConstIndexI)
+        std::memcpy(&dstData->hardware.iConsts[0], &srcData->hardware.iConsts[0], sizeof(Vector4) * meta.maxConstIndexI);
+      if (meta.maxConstIndexB)
         dstData->hardware.boolBitfield = srcData->hardware.boolBitfield;
     }
 
-    if (constSet.meta->needsConstantCopies) {
-      Vector4* data =
-        reinterpret_cast<Vector4*>(slice.mapPtr);
+    if (meta.needsConstantCopies) {
+      Vector4* data = reinterpret_cast<Vector4*>(dstData);
 
       if (ShaderStage == DxsoProgramTypes::VertexShader) {
         auto& shaderConsts = GetCommonShader(m_state.vertexShader)->GetConstants();
@@ -4120,6 +4343,25 @@ namespace dxvk {
       float alpha = float(rs[D3DRS_ALPHAREF]) / 255.0f;
       UpdatePushConstant<offsetof(D3D9RenderStateInfo, alphaRef), sizeof(float)>(&alpha);
     }
+    else if constexpr (Item == D3D9RenderStateItem::FogColor) {
+      float color[4];
+      DecodeD3DCOLOR(D3DCOLOR(rs[D3DRS_FOGCOLOR]), color);
+      UpdatePushConstant<offsetof(D3D9RenderStateInfo, fogColor), sizeof(float) * 3>(color);
+    }
+    else if constexpr (Item == D3D9RenderStateItem::FogScale) {
+      float fogEnd   = bit::cast<float>(rs[D3DRS_FOGEND]);
+      float fogStart = bit::cast<float>(rs[D3DRS_FOGSTART]);
+      float scale    = fogEnd != fogStart ? 1.0f / (fogEnd - fogStart) : 0.0f;
+      UpdatePushConstant<offsetof(D3D9RenderStateInfo, fogScale), sizeof(float)>(&scale);
+    }
+    else if constexpr (Item == D3D9RenderStateItem::FogEnd) {
+      float fogEnd = bit::cast<float>(rs[D3DRS_FOGEND]);
+      UpdatePushConstant<offsetof(D3D9RenderStateInfo, fogEnd), sizeof(float)>(&fogEnd);
+    }
+    else if constexpr (Item == D3D9RenderStateItem::FogDensity) {
+      float density = bit::cast<float>(rs[D3DRS_FOGDENSITY]);
+      UpdatePushConstant<offsetof(D3D9RenderStateInfo, fogDensity), sizeof(float)>(&density);
+    }
     else
       Logger::warn("D3D9: Invalid push constant set to update.");
   }
@@ -4132,6 +4374,19 @@ namespace dxvk {
     m_initializer->Flush();
 
     if (m_csIsBusy || m_csChunk->commandCount() != 0) {
+      // Relocate some buffers if the defragmenter
+      // is enabled, so that the copies get flushed.
+      // Pending initialization work was submitted above,
+      // so the buffers must be taken after that.
+      if (m_dxvkDevice->defragmenter()) {
+        EmitCs([
+          cBuffers = m_dxvkDevice->defragmenter()->takeRelocations()
+        ] (DxvkContext* ctx) {
+          for (const auto& buffer : cBuffers)
+            ctx->relocateBuffer(buffer);
+        });
+      }
+
       // Add commands to flush the threaded
       // context, then flush the command list
       EmitCs([](DxvkContext* ctx) {
@@ -4285,15 +4540,9 @@ namespace dxvk {
           16383 } };
     }
 
-    EmitCs([
-      cViewport = viewport,
-      cScissor = scissor
-    ] (DxvkContext* ctx) {
-      ctx->setViewports(
-        1,
-        &cViewport,
-        &cScissor);
-    });
+    m_drawState.dirty.set(D3D9DrawStateFlag::Viewport);
+    m_drawState.viewport = viewport;
+    m_drawState.scissor  = scissor;
   }
 
 
@@ -4306,11 +4555,8 @@ namespace dxvk {
       : 0xffffffff;
     msState.enableAlphaToCoverage = IsAlphaToCoverageEnabled();
 
-    EmitCs([
-      cState = msState
-    ] (DxvkContext* ctx) {
-      ctx->setMultisampleState(cState);
-    });
+    m_drawState.dirty.set(D3D9DrawStateFlag::MultiSample);
+    m_drawState.msState = msState;
   }
 
 
@@ -4348,12 +4594,8 @@ namespace dxvk {
       mode.writeMask = state[colorWriteIndices[i]];
     }
 
-    EmitCs([
-      cModes = modes
-    ](DxvkContext* ctx) {
-      for (uint32_t i = 0; i < cModes.size(); i++)
-        ctx->setBlendMode(i, cModes[i]);
-    });
+    m_drawState.dirty.set(D3D9DrawStateFlag::Blend);
+    m_drawState.blendModes = modes;
   }
 
 
@@ -4363,11 +4605,8 @@ namespace dxvk {
       D3DCOLOR(m_state.renderStates[D3DRS_BLENDFACTOR]),
       reinterpret_cast<float*>(&blendConstants));
 
-    EmitCs([
-      cBlendConstants = blendConstants
-    ](DxvkContext* ctx) {
-      ctx->setBlendConstants(cBlendConstants);
-    });
+    m_drawState.dirty.set(D3D9DrawStateFlag::BlendFactor);
+    m_drawState.blendConstants = blendConstants;
   }
 
 
@@ -4409,11 +4648,8 @@ namespace dxvk {
     else
       state.stencilOpBack = state.stencilOpFront;
 
-    EmitCs([
-      cState = state
-    ](DxvkContext* ctx) {
-      ctx->setDepthStencilState(cState);
-    });
+    m_drawState.dirty.set(D3D9DrawStateFlag::DepthStencil);
+    m_drawState.dsState = state;
   }
 
 
@@ -4441,13 +4677,9 @@ namespace dxvk {
     biases.depthBiasSlope    = slopeScaledDepthBias;
     biases.depthBiasClamp    = 0.0f;
 
-    EmitCs([
-      cState  = state,
-      cBiases = biases
-    ](DxvkContext* ctx) {
-      ctx->setRasterizerState(cState);
-      ctx->setDepthBias(cBiases);
-    });
+    m_drawState.dirty.set(D3D9DrawStateFlag::Rasterizer);
+    m_drawState.rsState   = state;
+    m_drawState.depthBias = biases;
   }
 
 
@@ -4460,23 +4692,123 @@ namespace dxvk {
       ? DecodeCompareOp(D3DCMPFUNC(rs[D3DRS_ALPHAFUNC]))
       : VK_COMPARE_OP_ALWAYS;
     
-    EmitCs([cAlphaOp = alphaOp] (DxvkContext* ctx) {
-      ctx->setSpecConstant(D3D9SpecConstantId::AlphaTestEnable, cAlphaOp != VK_COMPARE_OP_ALWAYS);
-      ctx->setSpecConstant(D3D9SpecConstantId::AlphaCompareOp,  cAlphaOp);
-    });
+    m_drawState.dirty.set(D3D9DrawStateFlag::AlphaTest);
+    m_drawState.alphaOp = alphaOp;
   }
 
 
-  void D3D9DeviceEx::BindDepthStencilRefrence() {
+  void D3D9DeviceEx::BindRenderStateSpecConstants(D3DPRIMITIVETYPE PrimitiveType) {
     auto& rs = m_state.renderStates;
 
-    uint32_t ref = uint32_t(rs[D3DRS_STENCILREF]);
+    // Spec constants are part of the pipeline state, so only pass
+    // values that the bound pixel shader actually reads. Otherwise,
+    // state changes would create pipelines with identical code.
+    const D3D9CommonShader* shader = UseProgrammablePS()
+      ? GetCommonShader(m_state.pixelShader)
+      : nullptr;
+
+    const uint32_t majorVersion = shader != nullptr
+      ? shader->GetMajorVersion()
+      : 0;
+
+    // Only shader model 1 shaders select the image type at runtime
+    uint32_t samplerTypes = 0;
+
+    if (majorVersion == 1) {
+      for (uint32_t i = 0; i < DxsoMaxSm1Samplers; i++) {
+        if (shader->IsSamplerUsed(i))
+          samplerTypes |= m_samplerTypes & (3u << (2 * i));
+      }
+    }
+
+    UpdateSpecConstant(D3D9SpecConstantId::SamplerType, samplerTypes);
+
+    // Fixed-function vertex shaders do not write a fog factor, so
+    // only table fog can be applied when no vertex shader is bound.
+    // Shader model 3 pixel shaders have to compute fog themselves.
+    const uint32_t fogMode = rs[D3DRS_FOGTABLEMODE];
+
+    const bool fogEnable = rs[D3DRS_FOGENABLE]
+      && (majorVersion == 1 || majorVersion == 2)
+      && (fogMode != D3DFOG_NONE || UseProgrammableVS());
+
+    UpdateSpecConstant(D3D9SpecConstantId::FogState,
+      fogEnable ? (1u | (fogMode << 1)) : 0u);
+
+    // Point coordinates are undefined for anything but points
+    const bool pointSprite = rs[D3DRS_POINTSPRITEENABLE]
+      && PrimitiveType == D3DPT_POINTLIST
+      && shader != nullptr;
+
+    UpdateSpecConstant(D3D9SpecConstantId::PointSprite, pointSprite);
+  }
+
+
+  void D3D9DeviceEx::UpdateSpecConstant(D3D9SpecConstantId Id, uint32_t Value) {
+    if (m_drawState.specConstants[Id] == Value)
+      return;
+
+    m_drawState.dirty.set(D3D9DrawStateFlag::SpecConstants);
+    m_drawState.specConstantMask |= 1u << Id;
+    m_drawState.specConstants[Id] = Value;
+  }
+
+
+  void D3D9DeviceEx::FlushDrawState() {
+    if (m_drawState.dirty.isClear())
+      return;
 
     EmitCs([
-      cRef = ref
-    ](DxvkContext* ctx) {
-      ctx->setStencilReference(cRef);
+      cState = m_drawState
+    ] (DxvkContext* ctx) {
+      if (cState.dirty.test(D3D9DrawStateFlag::Viewport))
+        ctx->setViewports(1, &cState.viewport, &cState.scissor);
+
+      if (cState.dirty.test(D3D9DrawStateFlag::MultiSample))
+        ctx->setMultisampleState(cState.msState);
+
+      if (cState.dirty.test(D3D9DrawStateFlag::Blend)) {
+        for (uint32_t i = 0; i < cState.blendModes.size(); i++)
+          ctx->setBlendMode(i, cState.blendModes[i]);
+      }
+
+      if (cState.dirty.test(D3D9DrawStateFlag::BlendFactor))
+        ctx->setBlendConstants(cState.blendConstants);
+
+      if (cState.dirty.test(D3D9DrawStateFlag::DepthStencil))
+        ctx->setDepthStencilState(cState.dsState);
+
+      if (cState.dirty.test(D3D9DrawStateFlag::StencilRef))
+        ctx->setStencilReference(cState.stencilRef);
+
+      if (cState.dirty.test(D3D9DrawStateFlag::Rasterizer)) {
+        ctx->setRasterizerState(cState.rsState);
+        ctx->setDepthBias(cState.depthBias);
+      }
+
+      if (cState.dirty.test(D3D9DrawStateFlag::AlphaTest)) {
+        ctx->setSpecConstant(D3D9SpecConstantId::AlphaTestEnable, cState.alphaOp != VK_COMPARE_OP_ALWAYS);
+        ctx->setSpecConstant(D3D9SpecConstantId::AlphaCompareOp,  cState.alphaOp);
+      }
+
+      if (cState.dirty.test(D3D9DrawStateFlag::SpecConstants)) {
+        for (uint32_t i = 0; i < cState.specConstants.size(); i++) {
+          if (cState.specConstantMask & (1u << i))
+            ctx->setSpecConstant(i, cState.specConstants[i]);
+        }
+      }
     });
+
+    m_drawState.dirty.clrAll();
+    m_drawState.specConstantMask = 0;
+  }
+
+
+  void D3D9DeviceEx::BindDepthStencilRefrence() {
+    auto& rs = m_state.renderStates;
+
+    m_drawState.dirty.set(D3D9DrawStateFlag::StencilRef);
+    m_drawState.stencilRef = uint32_t(rs[D3DRS_STENCILREF]);
   }
 
 
@@ -4507,17 +4839,41 @@ namespace dxvk {
       samplerInfo.first, DxsoBindingType::DepthImage,
       samplerInfo.second);
 
+    // Shader model 1 pixel shaders have one image per texture type
+    const bool typedSlots = samplerInfo.first == DxsoProgramTypes::PixelShader
+                         && samplerInfo.second < DxsoMaxSm1Samplers;
+
+    const uint32_t cubeSlot = typedSlots ? computeResourceSlotId(
+      samplerInfo.first, DxsoBindingType::ColorImageCube,
+      samplerInfo.second) : 0;
+
+    const uint32_t volumeSlot = typedSlots ? computeResourceSlotId(
+      samplerInfo.first, DxsoBindingType::ColorImage3D,
+      samplerInfo.second) : 0;
+
     EmitCs([
-      &cDevice   = m_dxvkDevice,
-      &cSamplers = m_samplers,
-      cColorSlot = colorSlot,
-      cDepthSlot = depthSlot,
-      cKey       = key
+      &cDevice    = m_dxvkDevice,
+      &cSamplers  = m_samplers,
+      cColorSlot  = colorSlot,
+      cDepthSlot  = depthSlot,
+      cTypedSlots = typedSlots,
+      cCubeSlot   = cubeSlot,
+      cVolumeSlot = volumeSlot,
+      cKey        = key
     ] (DxvkContext* ctx) {
-      auto pair = cSamplers.find(cKey);
-      if (pair != cSamplers.end()) {
-        ctx->bindResourceSampler(cColorSlot, pair->second.color);
-        ctx->bindResourceSampler(cDepthSlot, pair->second.depth);
+      auto BindPair = [&] (const D3D9SamplerPair& pair) {
+        ctx->bindResourceSampler(cColorSlot, pair.color);
+        ctx->bindResourceSampler(cDepthSlot, pair.depth);
+
+        if (cTypedSlots) {
+          ctx->bindResourceSampler(cCubeSlot,   pair.color);
+          ctx->bindResourceSampler(cVolumeSlot, pair.color);
+        }
+      };
+
+      const D3D9SamplerPair* pair = cSamplers.find(cKey);
+      if (pair != nullptr) {
+        BindPair(*pair);
         return;
       }
 
@@ -4553,9 +4909,9 @@ namespace dxvk {
         pair.color = cDevice->createSampler(colorInfo);
         pair.depth = cDevice->createSampler(depthInfo);
 
-        cSamplers.insert(std::make_pair(cKey, pair));
-        ctx->bindResourceSampler(cColorSlot, pair.color);
-        ctx->bindResourceSampler(cDepthSlot, pair.depth);
+        BindPair(pair);
+
+        cSamplers.insert(cKey, std::move(pair));
       }
       catch (const DxvkError& e) {
         Logger::err(e.message());
@@ -4579,13 +4935,52 @@ namespace dxvk {
     D3D9CommonTexture* commonTex =
       GetCommonTexture(m_state.textures[StateSampler]);
 
+    // Shader model 1 pixel shaders do not declare texture types, so
+    // they sample one of three images depending on the spec constant.
+    const bool typedSlots = shaderSampler.first == DxsoProgramTypes::PixelShader
+                         && shaderSampler.second < DxsoMaxSm1Samplers;
+
+    uint32_t cubeSlot = 0;
+    uint32_t volumeSlot = 0;
+
+    if (typedSlots) {
+      cubeSlot = computeResourceSlotId(shaderSampler.first,
+        DxsoBindingType::ColorImageCube, uint32_t(shaderSampler.second));
+
+      volumeSlot = computeResourceSlotId(shaderSampler.first,
+        DxsoBindingType::ColorImage3D, uint32_t(shaderSampler.second));
+
+      D3D9SamplerType samplerType = D3D9SamplerType::SamplerType2D;
+
+      if (commonTex != nullptr) {
+        switch (commonTex->GetType()) {
+          case D3DRTYPE_CUBETEXTURE:   samplerType = D3D9SamplerType::SamplerTypeCube; break;
+          case D3DRTYPE_VOLUMETEXTURE: samplerType = D3D9SamplerType::SamplerType3D;   break;
+          default: break;
+        }
+      }
+
+      const uint32_t shift = 2 * uint32_t(shaderSampler.second);
+
+      m_samplerTypes &= ~(3u << shift);
+      m_samplerTypes |= uint32_t(samplerType) << shift;
+    }
+
     if (commonTex == nullptr) {
       EmitCs([
-        cColorSlot = colorSlot,
-        cDepthSlot = depthSlot
+        cColorSlot  = colorSlot,
+        cDepthSlot  = depthSlot,
+        cTypedSlots = typedSlots,
+        cCubeSlot   = cubeSlot,
+        cVolumeSlot = volumeSlot
       ](DxvkContext* ctx) {
         ctx->bindResourceView(cColorSlot, nullptr, nullptr);
         ctx->bindResourceView(cDepthSlot, nullptr, nullptr);
+
+        if (cTypedSlots) {
+          ctx->bindResourceView(cCubeSlot,   nullptr, nullptr);
+          ctx->bindResourceView(cVolumeSlot, nullptr, nullptr);
+        }
       });
       return;
     }
@@ -4593,13 +4988,22 @@ namespace dxvk {
     const bool depth = commonTex ? commonTex->IsShadow() : false;
 
     EmitCs([
-      cColorSlot = colorSlot,
-      cDepthSlot = depthSlot,
-      cDepth     = depth,
-      cImageView = commonTex->GetViews().Sample.Pick(srgb)
+      cColorSlot  = colorSlot,
+      cDepthSlot  = depthSlot,
+      cTypedSlots = typedSlots,
+      cCubeSlot   = cubeSlot,
+      cVolumeSlot = volumeSlot,
+      cDepth      = depth,
+      cImageView  = commonTex->GetViews().Sample.Pick(srgb)
     ](DxvkContext* ctx) {
       ctx->bindResourceView(cColorSlot, !cDepth ? cImageView : nullptr, nullptr);
       ctx->bindResourceView(cDepthSlot,  cDepth ? cImageView : nullptr, nullptr);
+
+      // Only the image matching the view type will be used
+      if (cTypedSlots) {
+        ctx->bindResourceView(cCubeSlot,   !cDepth ? cImageView : nullptr, nullptr);
+        ctx->bindResourceView(cVolumeSlot, !cDepth ? cImageView : nullptr, nullptr);
+      }
     });
   }
 
@@ -4637,7 +5041,23 @@ namespace dxvk {
   }
 
 
-  void D3D9DeviceEx::PrepareDraw(bool up) {
+  bool D3D9DeviceEx::PrepareDraw(D3DPRIMITIVETYPE PrimitiveType, bool up) {
+    // Shaders are bound here rather than in Set*Shader, so that
+    // only draws have to wait for background translation.
+    if (m_flags.test(D3D9DeviceFlag::DirtyProgVertexShader) && UseProgrammableVS()) {
+      if (unlikely(!BindProgrammableShader<DxsoProgramTypes::VertexShader>(m_state.vertexShader)))
+        return false;
+
+      m_flags.clr(D3D9DeviceFlag::DirtyProgVertexShader);
+    }
+
+    if (m_flags.test(D3D9DeviceFlag::DirtyProgPixelShader) && UseProgrammablePS()) {
+      if (unlikely(!BindProgrammableShader<DxsoProgramTypes::PixelShader>(m_state.pixelShader)))
+        return false;
+
+      m_flags.clr(D3D9DeviceFlag::DirtyProgPixelShader);
+    }
+
     // This is fairly expensive to do!
     // So we only enable it on games & vendors that actually need it (for now)
     // This is not needed at all on NV either, etc...
@@ -4666,6 +5086,10 @@ namespace dxvk {
 
     if (m_flags.test(D3D9DeviceFlag::DirtyAlphaTestState))
       BindAlphaTestState();
+
+    BindRenderStateSpecConstants(PrimitiveType);
+
+    FlushDrawState();
     
     if (m_flags.test(D3D9DeviceFlag::DirtyClipPlanes))
       UpdateClipPlanes();
@@ -4696,6 +5120,43 @@ namespace dxvk {
       UploadConstants<DxsoProgramTypes::PixelShader>();
     else
       UpdateFixedFunctionPS();
+
+    return true;
+  }
+
+
+  template <DxsoProgramType ShaderStage, typename T>
+  bool D3D9DeviceEx::BindProgrammableShader(T* pShader) {
+    // Waits for pending translations
+    const D3D9CommonShader* shader = GetCommonShader(pShader);
+
+    // Shaders that failed to translate are treated as if
+    // nothing was bound, so draws using them are skipped
+    if (unlikely(pShader->HasFailed())) {
+      static bool s_errorShown = false;
+
+      if (!std::exchange(s_errorShown, true))
+        Logger::err("D3D9: Skipping draws with shaders that failed to translate");
+
+      return false;
+    }
+
+    D3D9ConstantSets& constSet = m_consts[ShaderStage];
+
+    const DxsoShaderMetaInfo& oldMeta = constSet.meta;
+    const DxsoShaderMetaInfo& newMeta = shader->GetMeta();
+
+    constSet.dirty |= oldMeta.needsConstantCopies
+      || newMeta.needsConstantCopies
+      || newMeta.maxConstIndexF != oldMeta.maxConstIndexF
+      || newMeta.maxConstIndexI != oldMeta.maxConstIndexI
+      || newMeta.maxConstIndexB != oldMeta.maxConstIndexB
+      || newMeta.usesRelativeIndexing != oldMeta.usesRelativeIndexing;
+
+    constSet.meta = newMeta;
+
+    BindShader(ShaderStage, shader);
+    return true;
   }
 
 
@@ -4904,7 +5365,7 @@ namespace dxvk {
     m_state.consts[DxsoProgramTypes::VertexShader].hardware.boolBitfield &= ~mask;
     m_state.consts[DxsoProgramTypes::VertexShader].hardware.boolBitfield |= bits & mask;
 
-    m_consts[DxsoProgramTypes::VertexShader].dirty = true;
+    m_consts[DxsoProgramTypes::VertexShader].dirtyB |= mask;
   }
 
 
@@ -4912,12 +5373,12 @@ namespace dxvk {
     m_state.consts[DxsoProgramTypes::PixelShader].hardware.boolBitfield &= ~mask;
     m_state.consts[DxsoProgramTypes::PixelShader].hardware.boolBitfield |= bits & mask;
 
-    m_consts[DxsoProgramTypes::PixelShader].dirty = true;
+    m_consts[DxsoProgramTypes::PixelShader].dirtyB |= mask;
   }
 
 
   HRESULT D3D9DeviceEx::CreateShaderModule(
-        D3D9CommonShader*     pShaderModule,
+        Rc<D3D9ShaderModule>* pShaderModule,
         VkShaderStageFlagBits ShaderStage,
   const DWORD*                pShaderBytecode,
   const DxsoModuleInfo*       pModuleInfo) {
@@ -4969,7 +5430,14 @@ namespace dxvk {
             pConstantData,
             Count);
 
-      m_consts[ProgramType].dirty = true;
+      D3D9ConstantSets& constSet = m_consts[ProgramType];
+
+      if constexpr (ConstantType == D3D9ConstantType::Float)
+        constSet.dirtyF.add(StartRegister, Count);
+      else if constexpr (ConstantType == D3D9ConstantType::Int)
+        constSet.dirtyI.add(StartRegister, Count);
+      else
+        constSet.dirtyB |= ((1u << Count) - 1) << StartRegister;
 
       UpdateStateConstants<
         ProgramType,
@@ -5088,25 +5556,39 @@ namespace dxvk {
         stage.ColorOp = m_state.textureStages[i][D3DTSS_COLOROP];
         stage.AlphaOp = m_state.textureStages[i][D3DTSS_ALPHAOP];
 
-        stage.ColorArg0 = m_state.textureStages[i][D3DTSS_COLORARG0];
-        stage.ColorArg1 = m_state.textureStages[i][D3DTSS_COLORARG1];
-        stage.ColorArg2 = m_state.textureStages[i][D3DTSS_COLORARG2];
+        // Arguments are ignored for disabled operations, so
+        // leave them zeroed in order to reduce key variants.
+        if (stage.ColorOp != D3DTOP_DISABLE) {
+          stage.ColorArg0 = m_state.textureStages[i][D3DTSS_COLORARG0];
+          stage.ColorArg1 = m_state.textureStages[i][D3DTSS_COLORARG1];
+          stage.ColorArg2 = m_state.textureStages[i][D3DTSS_COLORARG2];
+        }
 
-        stage.AlphaArg0 = m_state.textureStages[i][D3DTSS_ALPHAARG0];
-        stage.AlphaArg1 = m_state.textureStages[i][D3DTSS_ALPHAARG1];
-        stage.AlphaArg2 = m_state.textureStages[i][D3DTSS_ALPHAARG2];
+        if (stage.AlphaOp != D3DTOP_DISABLE) {
+          stage.AlphaArg0 = m_state.textureStages[i][D3DTSS_ALPHAARG0];
+          stage.AlphaArg1 = m_state.textureStages[i][D3DTSS_ALPHAARG1];
+          stage.AlphaArg2 = m_state.textureStages[i][D3DTSS_ALPHAARG2];
+        }
 
-        stage.ResultIsTemp = m_state.textureStages[i][D3DTSS_RESULTARG] == D3DTA_TEMP;
+        if (stage.ColorOp != D3DTOP_DISABLE || stage.AlphaOp != D3DTOP_DISABLE)
+          stage.ResultIsTemp = m_state.textureStages[i][D3DTSS_RESULTARG] == D3DTA_TEMP;
       }
 
-      EmitCs([
-        this,
-        cKey     = key,
-       &cShaders = m_ffModules
-      ](DxvkContext* ctx) {
-        auto shader = cShaders.GetShaderModule(this, cKey);
-        ctx->bindShader(VK_SHADER_STAGE_FRAGMENT_BIT, shader.GetShader());
-      });
+      // Skip the shader lookup entirely if the
+      // required shader is already bound.
+      if (!m_ffKeyFSBound || key != m_ffKeyFS) {
+        m_ffKeyFS      = key;
+        m_ffKeyFSBound = true;
+
+        EmitCs([
+          this,
+          cKey     = key,
+         &cShaders = m_ffModules
+        ](DxvkContext* ctx) {
+          auto shader = cShaders.GetShaderModule(this, cKey);
+          ctx->bindShader(VK_SHADER_STAGE_FRAGMENT_BIT, shader.GetShader());
+        });
+      }
     }
 
     // Constants
@@ -10,6 +10,7 @@
 #include "d3d9_constant_set.h"
 
 #include "d3d9_state.h"
+#include "d3d9_spec_constants.h"
 
 #include "d3d9_options.h"
 
@@ -20,7 +21,9 @@
 
 #include "d3d9_sampler.h"
 #include "d3d9_fixed_function.h"
+#include "d3d9_mapping_pool.h"
 
+#include <queue>
 #include <vector>
 #include <type_traits>
 #include <unordered_map>
@@ -31,6 +34,7 @@ namespace dxvk {
   class D3D9CommonTexture;
   class D3D9CommonBuffer;
   class D3D9CommonShader;
+  class D3D9ShaderModule;
   class D3D9ShaderModuleSet;
   class D3D9Initializer;
   class D3D9Query;
@@ -49,6 +53,8 @@ namespace dxvk {
     DirtyFFVertexData,
     DirtyFFVertexShader,
     DirtyFFPixelShader,
+    DirtyProgVertexShader,
+    DirtyProgPixelShader,
     DirtyFFViewport,
     DirtyFFPixelData,
     UpDirtiedVertices,
@@ -69,15 +75,66 @@ namespace dxvk {
     Rc<DxvkSampler> depth;
   };
 
+  enum class D3D9DrawStateFlag : uint32_t {
+    Viewport,
+    MultiSample,
+    Blend,
+    BlendFactor,
+    DepthStencil,
+    StencilRef,
+    Rasterizer,
+    AlphaTest,
+    SpecConstants
+  };
+
+  using D3D9DrawStateFlags = Flags<D3D9DrawStateFlag>;
+
+  /**
+   * \brief Packed draw state
+   *
+   * Fixed pipeline state written by the various Bind*
+   * helpers. All dirty parts get flushed to the CS thread
+   * in one single command before the next draw, rather
+   * than emitting one command per state object.
+   */
+  struct D3D9DrawState {
+    D3D9DrawStateFlags            dirty;
+    VkViewport                    viewport;
+    VkRect2D                      scissor;
+    DxvkMultisampleState          msState;
+    std::array<DxvkBlendMode, 4>  blendModes;
+    DxvkBlendConstants            blendConstants;
+    DxvkDepthStencilState         dsState;
+    uint32_t                      stencilRef;
+    DxvkRasterizerState           rsState;
+    DxvkDepthBias                 depthBias;
+    VkCompareOp                   alphaOp;
+    uint32_t                      specConstantMask = 0;
+    std::array<uint32_t, MaxNumSpecConstants> specConstants = { };
+  };
+
+  struct D3D9UPBufferPage {
+    Rc<DxvkBuffer>    buffer;
+    VkDeviceSize      offset = 0;
+    DxvkEventRevision fence  = { };
+  };
+
   class D3D9DeviceEx final : public ComObjectClamp<IDirect3DDevice9Ex> {
     constexpr static uint32_t DefaultFrameLatency = 3;
     constexpr static uint32_t MaxFrameLatency     = 20;
 
-    constexpr static uint32_t MinFlushIntervalUs = 750;
-    constexpr static uint32_t IncFlushIntervalUs = 250;
-    constexpr static uint32_t MaxPendingSubmits = 6;
+    constexpr static uint32_t MinFlushIntervalUs     = 250;
+    constexpr static uint32_t MaxFlushIntervalUs     = 4000;
+    constexpr static uint32_t DefaultFlushIntervalUs = 750;
+    constexpr static uint32_t IncFlushIntervalUs     = 250;
+    constexpr static uint32_t FlushWindowUs          = 8000;
+    constexpr static uint32_t MaxPendingSubmits      = 6;
+    constexpr static uint32_t MaxPendingCsChunks     = 16;
 
     constexpr static uint32_t NullStreamIdx = caps::MaxStreams;
+
+    constexpr static VkDeviceSize UpBufferPageSize  = 1 << 20;
+    constexpr static VkDeviceSize UpBufferAlignment = 16;
   public:
 
     D3D9DeviceEx(
@@ -643,6 +700,30 @@ namespace dxvk {
       const Rc<DxvkResource>&                 Resource,
             DWORD                             MapFlags);
 
+    /**
+     * \brief Allocates a texture mapping buffer
+     *
+     * \param [in] Size Minimum buffer size, in bytes
+     * \param [in] MemoryFlags Memory property flags
+     * \returns A buffer that is not in use by the GPU
+     */
+    Rc<DxvkBuffer> AllocMappingBuffer(
+            VkDeviceSize                      Size,
+            VkMemoryPropertyFlags             MemoryFlags) {
+      return m_mappingPool->AllocBuffer(Size, MemoryFlags);
+    }
+
+    /**
+     * \brief Releases a texture mapping buffer
+     *
+     * Returns the buffer to the mapping buffer pool
+     * once all previously emitted commands using it
+     * have been recorded.
+     * \param [in] Buffer The buffer
+     */
+    void FreeMappingBuffer(
+            Rc<DxvkBuffer>&&                  Buffer);
+
     /**
      * \brief Locks a subresource of an image
      * 
@@ -734,6 +815,12 @@ namespace dxvk {
     void BindRasterizerState();
 
     void BindAlphaTestState();
+
+    void BindRenderStateSpecConstants(D3DPRIMITIVETYPE PrimitiveType);
+
+    void UpdateSpecConstant(D3D9SpecConstantId Id, uint32_t Value);
+
+    void FlushDrawState();
     
     template <DxsoProgramType ShaderStage>
     void UploadConstants();
@@ -761,7 +848,10 @@ namespace dxvk {
     
     uint32_t GetInstanceCount() const;
 
-    void PrepareDraw(bool up = false);
+    bool PrepareDraw(D3DPRIMITIVETYPE PrimitiveType, bool up = false);
+
+    template <DxsoProgramType ShaderStage, typename T>
+    bool BindProgrammableShader(T* pShader);
 
     void BindShader(
             DxsoProgramType                   ShaderStage,
@@ -797,6 +887,10 @@ namespace dxvk {
 
     void FlushImplicit(BOOL StrongHint);
 
+    void UpdateFlushInterval(
+            std::chrono::high_resolution_clock::time_point Now,
+            uint32_t                                      Pending);
+
     bool ChangeReportedMemory(int64_t delta) {
       m_availableMemory += delta;
 
@@ -822,6 +916,11 @@ namespace dxvk {
     DxvkCsThread                    m_csThread;
     bool                            m_csIsBusy = false;
 
+    uint32_t                        m_flushInterval = DefaultFlushIntervalUs;
+    uint64_t                        m_flushWindowIdle = 0;
+    std::chrono::high_resolution_clock::time_point m_flushWindowStart
+      = std::chrono::high_resolution_clock::now();
+
     uint32_t                        m_frameLatencyCap;
     uint32_t                        m_frameLatency;
     uint32_t                        m_frameId = 0;
@@ -834,6 +933,9 @@ namespace dxvk {
 
     D3D9FFShaderModuleSet           m_ffModules;
 
+    D3D9FFShaderKeyFS               m_ffKeyFS;
+    bool                            m_ffKeyFSBound = false;
+
     DxvkCsChunkRef AllocCsChunk() {
       DxvkCsChunk* chunk = m_csChunkPool.allocChunk(DxvkCsChunkFlag::SingleUse);
       return DxvkCsChunkRef(chunk, &m_csChunkPool);
@@ -870,14 +972,18 @@ namespace dxvk {
 
     Rc<D3D9ShaderModuleSet>         m_shaderModules;
 
+    Rc<D3D9MappingBufferPool>       m_mappingPool;
+
     D3D9ConstantSets                m_consts[DxsoProgramTypes::Count];
+    VkDeviceSize                    m_constantAlignment = 0;
 
     Rc<DxvkBuffer>                  m_vsClipPlanes;
 
     Rc<DxvkBuffer>                  m_vsFixedFunction;
     Rc<DxvkBuffer>                  m_psFixedFunction;
 
-    Rc<DxvkBuffer>                  m_upBuffer;
+    D3D9UPBufferPage                m_upPage;
+    std::queue<D3D9UPBufferPage>    m_upRetiredPages;
 
     const D3D9VkFormatTable         m_d3d9Formats;
     const D3D9Options               m_d3d9Options;
@@ -892,7 +998,7 @@ namespace dxvk {
     std::vector<
       IDirect3DSwapChain9Ex*>       m_swapchains;
 
-    std::unordered_map<
+    sync::ConcurrentCache<
       D3D9SamplerKey,
       D3D9SamplerPair,
       D3D9SamplerKeyHash,
@@ -906,21 +1012,29 @@ namespace dxvk {
 
     uint32_t                        m_instancedData   = 0;
 
+    // Texture types of the bound PS textures, packed
+    // the same way as the SamplerType spec constant
+    uint32_t                        m_samplerTypes    = 0;
+
     D3D9ViewportInfo                m_viewportInfo;
 
+    D3D9DrawState                   m_drawState;
+
     std::atomic<int64_t>            m_availableMemory = 0;
 
     bool                            m_amdATOC         = false;
     bool                            m_nvATOC          = false;
 
-    void AllocUpBuffer(uint32_t size);
+    DxvkBufferSlice AllocUpBuffer(VkDeviceSize size);
+
+    Rc<DxvkBuffer> CreateUpBuffer(VkDeviceSize size);
 
     D3D9SwapChainEx* GetInternalSwapchain(UINT index);
 
     bool ShouldRecord();
 
     HRESULT               CreateShaderModule(
-            D3D9CommonShader*     pShaderModule,
+            Rc<D3D9ShaderModule>* pShaderModule,
             VkShaderStageFlagBits ShaderStage,
       const DWORD*                pShaderBytecode,
       const DxsoModuleInfo*       pModuleInfo);
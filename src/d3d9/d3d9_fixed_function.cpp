@@ -1088,7 +1088,7 @@ namespace dxvk {
     std::hash<uint64_t> uint64hash;
 
     for (uint32_t i = 0; i < caps::TextureStageCount; i++)
-      state.add(uint64hash(key.Stages->uint64[i]));
+      state.add(uint64hash(key.Stages[i].uint64));
 
     return state;
   }
@@ -35,26 +35,30 @@ namespace dxvk {
 
   constexpr uint32_t TextureArgCount = 3;
 
+  // Packed into a single qword per stage so that
+  // the key can be hashed and compared cheaply.
   struct D3D9FFShaderStage {
     union {
       struct {
-        uint16_t     ColorOp : 5;
-        uint16_t     ColorArg0 : 6;
-        uint16_t     ColorArg1 : 6;
-        uint16_t     ColorArg2 : 6;
+        uint64_t     ColorOp   : 5;
+        uint64_t     ColorArg0 : 6;
+        uint64_t     ColorArg1 : 6;
+        uint64_t     ColorArg2 : 6;
 
-        uint16_t     AlphaOp : 5;
-        uint16_t     AlphaArg0 : 6;
-        uint16_t     AlphaArg1 : 6;
-        uint16_t     AlphaArg2 : 6;
+        uint64_t     AlphaOp   : 5;
+        uint64_t     AlphaArg0 : 6;
+        uint64_t     AlphaArg1 : 6;
+        uint64_t     AlphaArg2 : 6;
 
-        uint16_t     ResultIsTemp : 1;
+        uint64_t     ResultIsTemp : 1;
       } data;
 
-      uint64_t uint64[8];
+      uint64_t uint64;
     };
   };
 
+  static_assert(sizeof(D3D9FFShaderStage) == sizeof(uint64_t));
+
   struct D3D9FFShaderKeyFS {
     D3D9FFShaderKeyFS() {
       // memcmp safety
@@ -134,15 +134,18 @@ namespace dxvk {
     for (uint32_t i = 0; i < pTexture->CountSubresources(); i++) {
       DxvkBufferSliceHandle mapSlice  = pTexture->GetMappingBuffer(i)->getSliceHandle();
 
+      // Mapping buffers may be larger than the subresource
+      VkDeviceSize mipSize = pTexture->GetMipSize(i);
+
       if (pInitialData != nullptr) {
         std::memcpy(
           mapSlice.mapPtr,
           pInitialData,
-          mapSlice.length);
+          mipSize);
       } else {
         std::memset(
           mapSlice.mapPtr, 0,
-          mapSlice.length);
+          mipSize);
       }
 
       if (pTexture->RequiresFixup())
@@ -0,0 +1,174 @@
+#include "d3d9_mapping_pool.h"
+
+namespace dxvk {
+
+  D3D9MappingBufferPool::D3D9MappingBufferPool(
+    const Rc<DxvkDevice>&       Device,
+          VkDeviceSize          MaxPooledSize)
+  : m_device(Device), m_maxPooledSize(MaxPooledSize) {
+
+  }
+
+
+  D3D9MappingBufferPool::~D3D9MappingBufferPool() {
+    Trim(0);
+  }
+
+
+  Rc<DxvkBuffer> D3D9MappingBufferPool::AllocBuffer(
+          VkDeviceSize          Size,
+          VkMemoryPropertyFlags MemoryFlags) {
+    int32_t index = GetBucketIndex(Size, MemoryFlags);
+
+    if (index < 0)
+      return CreateBuffer(Size, MemoryFlags);
+
+    { std::lock_guard<std::mutex> lock(m_mutex);
+
+      // Buffers are returned in order, so the oldest
+      // entries are the most likely to be idle already
+      auto& bucket = m_buckets[index];
+
+      for (auto e = bucket.begin(); e != bucket.end(); e++) {
+        if (!e->buffer->isInUse()) {
+          Rc<DxvkBuffer> buffer = std::move(e->buffer);
+          bucket.erase(e);
+
+          ChangePooledSize(buffer->info().size, false);
+          return buffer;
+        }
+      }
+    }
+
+    return CreateBuffer(GetBucketSize(index), MemoryFlags);
+  }
+
+
+  void D3D9MappingBufferPool::FreeBuffer(
+    const Rc<DxvkBuffer>&       Buffer) {
+    VkDeviceSize size  = Buffer->info().size;
+    int32_t      index = GetBucketIndex(size, Buffer->memFlags());
+
+    // Don't keep buffers that were not created by the pool
+    if (index < 0 || size != GetBucketSize(index))
+      return;
+
+    std::lock_guard<std::mutex> lock(m_mutex);
+    m_buckets[index].push_back({ Buffer, m_age++ });
+    ChangePooledSize(size, true);
+
+    if (m_pooledSize.load() > m_maxPooledSize)
+      TrimLocked(m_maxPooledSize);
+  }
+
+
+  void D3D9MappingBufferPool::Trim(
+          VkDeviceSize          MaxPooledSize) {
+    std::lock_guard<std::mutex> lock(m_mutex);
+    TrimLocked(MaxPooledSize);
+  }
+
+
+  Rc<DxvkBuffer> D3D9MappingBufferPool::CreateBuffer(
+          VkDeviceSize          Size,
+          VkMemoryPropertyFlags MemoryFlags) {
+    DxvkBufferCreateInfo info;
+    info.size   = Size;
+    info.usage  = VK_BUFFER_USAGE_TRANSFER_SRC_BIT
+                | VK_BUFFER_USAGE_TRANSFER_DST_BIT
+                | VK_BUFFER_USAGE_STORAGE_BUFFER_BIT;
+    info.stages = VK_PIPELINE_STAGE_TRANSFER_BIT;
+    info.access = VK_ACCESS_TRANSFER_READ_BIT
+                | VK_ACCESS_TRANSFER_WRITE_BIT;
+
+    try {
+      return m_device->createBuffer(info, MemoryFlags);
+    } catch (const DxvkError&) {
+      // Release all pooled memory and try again
+      // before reporting the error to the caller
+      if (!m_pooledSize.load())
+        throw;
+
+      Logger::warn(str::format("D3D9: Failed to allocate mapping buffer, releasing ",
+        m_pooledSize.load() >> 10, " kB of pooled buffers"));
+
+      Trim(0);
+      return m_device->createBuffer(info, MemoryFlags);
+    }
+  }
+
+
+  void D3D9MappingBufferPool::TrimLocked(
+          VkDeviceSize          MaxPooledSize) {
+    while (m_pooledSize.load() > MaxPooledSize) {
+      // Destroy the least recently returned buffer
+      uint32_t oldest = NumBuckets;
+
+      for (uint32_t i = 0; i < NumBuckets; i++) {
+        if (!m_buckets[i].empty() && (oldest == NumBuckets
+         || m_buckets[i].front().age < m_buckets[oldest].front().age))
+          oldest = i;
+      }
+
+      if (oldest == NumBuckets)
+        break;
+
+      ChangePooledSize(m_buckets[oldest].front().buffer->info().size, false);
+      m_buckets[oldest].pop_front();
+    }
+  }
+
+
+  void D3D9MappingBufferPool::ChangePooledSize(
+          VkDeviceSize          Size,
+          bool                  Add) {
+    if (Add)
+      m_pooledSize += Size;
+    else
+      m_pooledSize -= Size;
+
+    m_device->setStatCtr(DxvkStatCounter::MemoryPooled, m_pooledSize.load());
+  }
+
+
+  int32_t D3D9MappingBufferPool::GetBucketIndex(
+          VkDeviceSize          Size,
+          VkMemoryPropertyFlags MemoryFlags) {
+    int32_t index = 0;
+
+    if (Size > (VkDeviceSize(1) << MinSizeShift)) {
+      uint32_t shift = MinSizeShift;
+
+      while ((VkDeviceSize(2) << shift) < Size) {
+        if (++shift >= MaxSizeShift)
+          return -1;
+      }
+
+      // Size is in (base, 2 * base], pick the smallest
+      // sub-class of that range that can hold it
+      VkDeviceSize base = VkDeviceSize(1) << shift;
+      VkDeviceSize step = base / NumSubClasses;
+
+      index = 1 + NumSubClasses * (shift - MinSizeShift)
+            + int32_t((Size - base - 1) / step);
+    }
+
+    if (MemoryFlags & VK_MEMORY_PROPERTY_HOST_CACHED_BIT)
+      index += NumSizeClasses;
+
+    return index;
+  }
+
+
+  VkDeviceSize D3D9MappingBufferPool::GetBucketSize(
+          int32_t               Index) {
+    uint32_t sizeClass = uint32_t(Index) % NumSizeClasses;
+
+    if (!sizeClass)
+      return VkDeviceSize(1) << MinSizeShift;
+
+    VkDeviceSize base = VkDeviceSize(1) << (MinSizeShift + (sizeClass - 1) / NumSubClasses);
+    return base + (base / NumSubClasses) * ((sizeClass - 1) % NumSubClasses + 1);
+  }
+
+}
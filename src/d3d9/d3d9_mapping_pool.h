@@ -0,0 +1,127 @@
+#pragma once
+
+#include <array>
+#include <deque>
+#include <mutex>
+
+#include "d3d9_include.h"
+
+#include "../dxvk/dxvk_device.h"
+
+namespace dxvk {
+
+  /**
+   * \brief Mapping buffer pool
+   *
+   * Recycles the host-visible buffers that textures use
+   * to map their subresources, so that locking textures
+   * that had their buffers released does not have to
+   * allocate memory every single time.
+   *
+   * Buffers are grouped by memory type and by size.
+   * Sizes are rounded up to one of four size classes
+   * per power of two, so that at most a fifth of any
+   * buffer above 4 kB is wasted. Buffers above 16 MB
+   * are not pooled and are created with their exact
+   * size. Buffers that
+   * are returned to the pool may still be in use by the
+   * GPU, and will only be handed out again once the GPU
+   * has finished using them. If the total size of all
+   * pooled buffers exceeds the given budget, the least
+   * recently returned buffers get destroyed.
+   */
+  class D3D9MappingBufferPool : public RcObject {
+    constexpr static uint32_t     MinSizeShift   = 12;
+    constexpr static uint32_t     MaxSizeShift   = 24;
+    constexpr static uint32_t     NumSubClasses  = 4;
+    constexpr static uint32_t     NumSizeClasses = 1 + NumSubClasses * (MaxSizeShift - MinSizeShift);
+    constexpr static uint32_t     NumBuckets     = 2 * NumSizeClasses;
+  public:
+
+    D3D9MappingBufferPool(
+      const Rc<DxvkDevice>&       Device,
+            VkDeviceSize          MaxPooledSize);
+
+    ~D3D9MappingBufferPool();
+
+    /**
+     * \brief Allocates a mapping buffer
+     *
+     * Returns an idle buffer from the pool if one is
+     * available, or creates a new one otherwise. The
+     * buffer may be larger than requested, and its
+     * contents are undefined.
+     * \param [in] Size Minimum buffer size, in bytes
+     * \param [in] MemoryFlags Memory property flags
+     * \returns The buffer
+     */
+    Rc<DxvkBuffer> AllocBuffer(
+            VkDeviceSize          Size,
+            VkMemoryPropertyFlags MemoryFlags);
+
+    /**
+     * \brief Returns a buffer to the pool
+     *
+     * Must only be called once all commands using the
+     * buffer have been recorded, i.e. on the CS thread.
+     * \param [in] Buffer The buffer
+     */
+    void FreeBuffer(
+      const Rc<DxvkBuffer>&       Buffer);
+
+    /**
+     * \brief Destroys pooled buffers
+     *
+     * Used to release memory under memory pressure.
+     * \param [in] MaxPooledSize Size to shrink the pool to
+     */
+    void Trim(
+            VkDeviceSize          MaxPooledSize);
+
+    /**
+     * \brief Total size of all pooled buffers
+     * \returns Pooled memory, in bytes
+     */
+    VkDeviceSize GetPooledSize() const {
+      return m_pooledSize.load();
+    }
+
+  private:
+
+    struct Entry {
+      Rc<DxvkBuffer>              buffer;
+      uint64_t                    age;
+    };
+
+    Rc<DxvkDevice>                m_device;
+    VkDeviceSize                  m_maxPooledSize;
+
+    std::mutex                    m_mutex;
+    std::array<
+      std::deque<Entry>,
+      NumBuckets>                 m_buckets;
+    uint64_t                      m_age = 0;
+
+    std::atomic<VkDeviceSize>     m_pooledSize = { 0ull };
+
+    Rc<DxvkBuffer> CreateBuffer(
+            VkDeviceSize          Size,
+            VkMemoryPropertyFlags MemoryFlags);
+
+    void TrimLocked(
+            VkDeviceSize          MaxPooledSize);
+
+    void ChangePooledSize(
+            VkDeviceSize          Size,
+            bool                  Add);
+
+    static int32_t GetBucketIndex(
+            VkDeviceSize          Size,
+            VkMemoryPropertyFlags MemoryFlags);
+
+    static VkDeviceSize GetBucketSize(
+            int32_t               Index);
+
+  };
+
+}
@@ -59,6 +59,15 @@ namespace dxvk {
 
     /// R/W Framebuffer + Texture Hazards
     bool hasHazards;
+
+    /// Translate shaders on worker threads instead of in
+    /// CreateVertexShader / CreatePixelShader. Binding a
+    /// shader waits for its translation to complete.
+    bool asyncShaderTranslation;
+
+    /// Maximum amount of memory, in MB, to keep in released
+    /// texture mapping buffers for reuse by later locks.
+    int32_t mappingBufferPoolSize;
   };
 
 }
\ No newline at end of file
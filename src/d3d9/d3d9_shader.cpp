@@ -17,6 +17,8 @@ namespace dxvk {
     m_bytecode.resize(bytecodeLength);
     std::memcpy(m_bytecode.data(), pShaderBytecode, bytecodeLength);
 
+    m_majorVersion = pModule->info().majorVersion();
+
     const std::string name = pShaderKey->toString();
     Logger::debug(str::format("Compiling shader ", name));
     
@@ -47,16 +49,31 @@ namespace dxvk {
       }
     }
     
-    // Decide whether we need to create a pass-through
-    // geometry shader for vertex shader stream output
+    // Skip translation entirely if the shader
+    // was already translated in a previous run
+    Rc<DxvkShaderCache> shaderCache = pDevice->GetDXVKDevice()->getShaderCache();
+
+    DxvkShaderCacheKey cacheKey;
+    cacheKey.shader  = *pShaderKey;
+    cacheKey.options = pDxsoModuleInfo->options.hash();
+
+    std::vector<char> cacheData;
 
-    m_shader       = pModule->compile(*pDxsoModuleInfo, name, AnalysisInfo);
-    m_isgn         = pModule->isgn();
-    m_usedSamplers = pModule->usedSamplers();
-    m_usedRTs      = pModule->usedRTs();
+    if (shaderCache != nullptr)
+      m_shader = shaderCache->lookup(cacheKey, cacheData);
 
-    m_meta      = pModule->meta();
-    m_constants = pModule->constants();
+    if (m_shader == nullptr || !ReadCacheData(cacheData)) {
+      m_shader       = pModule->compile(*pDxsoModuleInfo, name, AnalysisInfo);
+      m_isgn         = pModule->isgn();
+      m_usedSamplers = pModule->usedSamplers();
+      m_usedRTs      = pModule->usedRTs();
+
+      m_meta      = pModule->meta();
+      m_constants = pModule->constants();
+
+      if (shaderCache != nullptr)
+        shaderCache->store(cacheKey, m_shader, WriteCacheData());
+    }
 
     m_shader->setShaderKey(*pShaderKey);
     
@@ -72,7 +89,154 @@ namespace dxvk {
   }
 
 
-  D3D9CommonShader D3D9ShaderModuleSet::GetShaderModule(
+  std::vector<char> D3D9CommonShader::WriteCacheData() const {
+    const uint32_t constCount = m_constants.size();
+
+    std::vector<char> data(sizeof(m_isgn)
+      + sizeof(m_usedSamplers) + sizeof(m_usedRTs) + sizeof(m_meta)
+      + sizeof(constCount) + constCount * sizeof(DxsoDefinedConstant));
+
+    char* ptr = data.data();
+    std::memcpy(ptr, &m_isgn,         sizeof(m_isgn));         ptr += sizeof(m_isgn);
+    std::memcpy(ptr, &m_usedSamplers, sizeof(m_usedSamplers)); ptr += sizeof(m_usedSamplers);
+    std::memcpy(ptr, &m_usedRTs,      sizeof(m_usedRTs));      ptr += sizeof(m_usedRTs);
+    std::memcpy(ptr, &m_meta,         sizeof(m_meta));         ptr += sizeof(m_meta);
+    std::memcpy(ptr, &constCount,     sizeof(constCount));     ptr += sizeof(constCount);
+    std::memcpy(ptr, m_constants.data(), constCount * sizeof(DxsoDefinedConstant));
+    return data;
+  }
+
+
+  bool D3D9CommonShader::ReadCacheData(const std::vector<char>& Data) {
+    const size_t headerSize = sizeof(m_isgn)
+      + sizeof(m_usedSamplers) + sizeof(m_usedRTs) + sizeof(m_meta);
+
+    uint32_t constCount = 0;
+
+    if (Data.size() < headerSize + sizeof(constCount))
+      return false;
+
+    const char* ptr = Data.data();
+    std::memcpy(&m_isgn,         ptr, sizeof(m_isgn));         ptr += sizeof(m_isgn);
+    std::memcpy(&m_usedSamplers, ptr, sizeof(m_usedSamplers)); ptr += sizeof(m_usedSamplers);
+    std::memcpy(&m_usedRTs,      ptr, sizeof(m_usedRTs));      ptr += sizeof(m_usedRTs);
+    std::memcpy(&m_meta,         ptr, sizeof(m_meta));         ptr += sizeof(m_meta);
+    std::memcpy(&constCount,     ptr, sizeof(constCount));     ptr += sizeof(constCount);
+
+    if (Data.size() != headerSize + sizeof(constCount) + constCount * sizeof(DxsoDefinedConstant))
+      return false;
+
+    m_constants.resize(constCount);
+    std::memcpy(m_constants.data(), ptr, constCount * sizeof(DxsoDefinedConstant));
+    return true;
+  }
+
+
+  D3D9ShaderModule::D3D9ShaderModule(
+      const D3D9CommonShader&     CommonShader)
+  : m_status(D3D9ShaderStatus::Ready),
+    m_shader(CommonShader) { }
+
+
+  D3D9ShaderModule::D3D9ShaderModule(
+          D3D9DeviceEx*         pDevice,
+    const DxvkShaderKey&        ShaderKey,
+    const DxsoModuleInfo&       ModuleInfo,
+    const void*                 pShaderBytecode,
+    const DxsoAnalysisInfo&     AnalysisInfo)
+  : m_device      (pDevice),
+    m_key         (ShaderKey),
+    m_moduleInfo  (ModuleInfo),
+    m_analysisInfo(AnalysisInfo),
+    m_status      (D3D9ShaderStatus::Pending) {
+    // The application may free its copy of the
+    // bytecode as soon as the create call returns
+    auto data = reinterpret_cast<const uint8_t*>(pShaderBytecode);
+    m_bytecode.assign(data, data + AnalysisInfo.bytecodeByteLength);
+  }
+
+
+  void D3D9ShaderModule::Translate() {
+    if (!TryBeginTranslation())
+      return;
+
+    D3D9CommonShader shader;
+    D3D9ShaderStatus status = D3D9ShaderStatus::Ready;
+    std::string      error;
+
+    try {
+      DxsoReader reader(
+        reinterpret_cast<const char*>(m_bytecode.data()));
+
+      DxsoModule module(reader);
+      module.analyze();
+
+      shader = D3D9CommonShader(
+        m_device, &m_key, &m_moduleInfo,
+        m_bytecode.data(), m_analysisInfo, &module);
+    }
+    catch (const DxvkError& e) {
+      // The create call has already returned, so the error
+      // gets reported when the application uses the shader
+      Logger::err(str::format("D3D9: Failed to translate shader ", m_key.toString()));
+      Logger::err(e.message());
+
+      status = D3D9ShaderStatus::Failed;
+      error  = e.message();
+    }
+
+    m_device->GetDXVKDevice()->addStatCtr(
+      DxvkStatCounter::ShaderTranslationsDone, 1);
+
+    std::lock_guard<std::mutex> lock(m_mutex);
+    m_shader = std::move(shader);
+    m_error  = std::move(error);
+    m_status.store(status, std::memory_order_release);
+    m_cond.notify_all();
+  }
+
+
+  bool D3D9ShaderModule::TryBeginTranslation() {
+    D3D9ShaderStatus expected = D3D9ShaderStatus::Pending;
+
+    return m_status.compare_exchange_strong(expected,
+      D3D9ShaderStatus::Translating, std::memory_order_acquire);
+  }
+
+
+  const D3D9CommonShader* D3D9ShaderModule::WaitForShader() {
+    // If no worker has started translating the shader yet,
+    // do it on the calling thread rather than waiting for
+    // the rest of the queue to be processed.
+    Translate();
+
+    std::unique_lock<std::mutex> lock(m_mutex);
+    m_cond.wait(lock, [this] {
+      D3D9ShaderStatus status = m_status.load(std::memory_order_acquire);
+      return status == D3D9ShaderStatus::Ready
+          || status == D3D9ShaderStatus::Failed;
+    });
+
+    return &m_shader;
+  }
+
+
+  D3D9ShaderModuleSet::~D3D9ShaderModuleSet() {
+    // Pending jobs are dropped rather than translated, since
+    // the device is going away. Workers only finish the job
+    // they are currently working on.
+    { std::lock_guard<std::mutex> lock(m_workerLock);
+      m_stopThreads = true;
+      m_workerQueue = { };
+      m_workerCond.notify_all();
+    }
+
+    for (auto& worker : m_workerThreads)
+      worker.join();
+  }
+
+
+  Rc<D3D9ShaderModule> D3D9ShaderModuleSet::GetShaderModule(
             D3D9DeviceEx*         pDevice,
             VkShaderStageFlagBits ShaderStage,
       const DxsoModuleInfo*       pDxbcModuleInfo,
@@ -89,32 +253,102 @@ namespace dxvk {
     DxvkShaderKey shaderKey = DxvkShaderKey(ShaderStage, hash);
     const DxvkShaderKey* pShaderKey = &shaderKey;
 
-    // Use the shader's unique key for the lookup
-    { std::unique_lock<std::mutex> lock(m_mutex);
-      
-      auto entry = m_modules.find(*pShaderKey);
-      if (entry != m_modules.end())
-        return entry->second;
+    // Use the shader's unique key for the lookup. This
+    // path is lock-free since it is hit far more often
+    // than new shaders get compiled.
+    const Rc<D3D9ShaderModule>* entry = m_modules.find(*pShaderKey);
+
+    if (entry != nullptr) {
+      // A previous async translation of the same bytecode failed,
+      // report the error the same way synchronous translation does
+      if (unlikely((*entry)->GetStatus() == D3D9ShaderStatus::Failed))
+        throw DxvkError((*entry)->GetError());
+
+      return *entry;
     }
+
+    Rc<DxvkDevice> dxvkDevice = pDevice->GetDXVKDevice();
     
+    // With async translation enabled, only set up the module
+    // here and let a worker thread do the expensive part.
+    if (pDevice->GetOptions()->asyncShaderTranslation) {
+      auto result = m_modules.insert(*pShaderKey,
+        new D3D9ShaderModule(pDevice, shaderKey,
+          *pDxbcModuleInfo, pShaderBytecode, info));
+
+      if (result.second)
+        EnqueueTranslation(pDevice, *result.first);
+
+      return *result.first;
+    }
+
     // This shader has not been compiled yet, so we have to create a
     // new module. This takes a while, so we won't lock the structure.
     D3D9CommonShader commonShader(
       pDevice, pShaderKey,
       pDxbcModuleInfo, pShaderBytecode,
       info, &module);
+
+    dxvkDevice->addStatCtr(DxvkStatCounter::ShaderTranslationsQueued, 1);
+    dxvkDevice->addStatCtr(DxvkStatCounter::ShaderTranslationsDone,   1);
     
     // Insert the new module into the lookup table. If another thread
     // has compiled the same shader in the meantime, we should return
     // that object instead and discard the newly created module.
-    { std::unique_lock<std::mutex> lock(m_mutex);
-      
-      auto status = m_modules.insert({ *pShaderKey, commonShader });
-      if (!status.second)
-        return status.first->second;
+    return *m_modules.insert(*pShaderKey,
+      new D3D9ShaderModule(commonShader)).first;
+  }
+
+
+  void D3D9ShaderModuleSet::EnqueueTranslation(
+          D3D9DeviceEx*         pDevice,
+    const Rc<D3D9ShaderModule>& Module) {
+    pDevice->GetDXVKDevice()->addStatCtr(
+      DxvkStatCounter::ShaderTranslationsQueued, 1);
+
+    std::lock_guard<std::mutex> lock(m_workerLock);
+
+    if (unlikely(m_workerThreads.empty())) {
+      // Leave some room for the application's own threads
+      // as well as the pipeline compiler workers
+      uint32_t numWorkers = dxvk::thread::hardware_concurrency() / 2;
+      numWorkers = std::clamp(numWorkers, 1u, 8u);
+
+      Logger::info(str::format("D3D9: Using ", numWorkers, " shader translation threads"));
+
+      for (uint32_t i = 0; i < numWorkers; i++) {
+        m_workerThreads.emplace_back([this] () { WorkerFunc(); });
+        m_workerThreads[i].set_priority(ThreadPriority::Lowest);
+      }
+    }
+
+    m_workerQueue.push(Module);
+    m_workerCond.notify_one();
+  }
+
+
+  void D3D9ShaderModuleSet::WorkerFunc() {
+    env::setThreadName("dxvk-dxso");
+
+    while (true) {
+      Rc<D3D9ShaderModule> module;
+
+      { std::unique_lock<std::mutex> lock(m_workerLock);
+
+        m_workerCond.wait(lock, [this] () {
+          return !m_workerQueue.empty()
+              || m_stopThreads;
+        });
+
+        if (m_stopThreads)
+          break;
+
+        module = std::move(m_workerQueue.front());
+        m_workerQueue.pop();
+      }
+
+      module->Translate();
     }
-    
-    return commonShader;
   }
 
-}
\ No newline at end of file
+}
@@ -3,6 +3,11 @@
 #include "d3d9_resource.h"
 #include "../dxso/dxso_module.h"
 
+#include "../util/thread.h"
+
+#include <condition_variable>
+#include <queue>
+
 namespace dxvk {
 
   /**
@@ -53,11 +58,20 @@ namespace dxvk {
       return m_usedRTs & (1u << index);
     }
 
+    uint32_t GetMajorVersion() const {
+      return m_majorVersion;
+    }
+
   private:
 
+    std::vector<char> WriteCacheData() const;
+
+    bool ReadCacheData(const std::vector<char>& Data);
+
     DxsoIsgn              m_isgn;
     uint32_t              m_usedSamplers;
     uint32_t              m_usedRTs;
+    uint32_t              m_majorVersion = 0;
 
     DxsoShaderMetaInfo    m_meta;
     DxsoDefinedConstants  m_constants;
@@ -68,6 +82,116 @@ namespace dxvk {
 
   };
 
+  /**
+   * \brief Shader translation status
+   */
+  enum class D3D9ShaderStatus : uint32_t {
+    Pending,
+    Translating,
+    Ready,
+    Failed,
+  };
+
+  /**
+   * \brief Shader module
+   *
+   * Owns a common shader which is either translated
+   * right away, or later on a worker thread if async
+   * shader translation is enabled. Accessing the
+   * common shader waits for translation to complete,
+   * or translates the shader on the calling thread
+   * if no worker has picked it up yet.
+   */
+  class D3D9ShaderModule : public RcObject {
+
+  public:
+
+    D3D9ShaderModule(
+      const D3D9CommonShader&     CommonShader);
+
+    D3D9ShaderModule(
+            D3D9DeviceEx*         pDevice,
+      const DxvkShaderKey&        ShaderKey,
+      const DxsoModuleInfo&       ModuleInfo,
+      const void*                 pShaderBytecode,
+      const DxsoAnalysisInfo&     AnalysisInfo);
+
+    /**
+     * \brief Retrieves the common shader
+     *
+     * Waits for pending translations.
+     * \returns The translated shader
+     */
+    const D3D9CommonShader* GetShader() {
+      if (likely(m_status.load(std::memory_order_acquire) == D3D9ShaderStatus::Ready))
+        return &m_shader;
+
+      return WaitForShader();
+    }
+
+    /**
+     * \brief Checks whether translation failed
+     *
+     * Waits for pending translations. Shaders that
+     * failed to translate behave as if they were
+     * empty, so they must not be used for rendering.
+     * \returns \c true if translation failed
+     */
+    bool HasFailed() {
+      GetShader();
+      return GetStatus() == D3D9ShaderStatus::Failed;
+    }
+
+    /**
+     * \brief Queries translation status
+     *
+     * Does not wait for pending translations.
+     * \returns Current translation status
+     */
+    D3D9ShaderStatus GetStatus() const {
+      return m_status.load(std::memory_order_acquire);
+    }
+
+    /**
+     * \brief Retrieves the translation error
+     *
+     * Only valid if translation has failed.
+     * \returns Error message
+     */
+    const std::string& GetError() const {
+      return m_error;
+    }
+
+    /**
+     * \brief Translates the shader
+     *
+     * Called by translation worker threads. Does
+     * nothing if the shader has already been or
+     * is currently being translated elsewhere.
+     */
+    void Translate();
+
+  private:
+
+    D3D9DeviceEx*                 m_device = nullptr;
+    DxvkShaderKey                 m_key;
+    DxsoModuleInfo                m_moduleInfo;
+    DxsoAnalysisInfo              m_analysisInfo;
+    std::vector<uint8_t>          m_bytecode;
+
+    std::atomic<D3D9ShaderStatus> m_status;
+    std::mutex                    m_mutex;
+    std::condition_variable       m_cond;
+
+    D3D9CommonShader              m_shader;
+    std::string                   m_error;
+
+    bool TryBeginTranslation();
+
+    const D3D9CommonShader* WaitForShader();
+
+  };
+
   /**
    * \brief Common shader interface
    * 
@@ -81,10 +205,10 @@ namespace dxvk {
   public:
 
     D3D9Shader(
-            D3D9DeviceEx*      pDevice,
-      const D3D9CommonShader&  CommonShader)
+            D3D9DeviceEx*            pDevice,
+      const Rc<D3D9ShaderModule>&    Module)
       : D3D9DeviceChild<Base>( pDevice )
-      , m_shader             ( CommonShader ) { }
+      , m_module             ( Module ) { }
 
     HRESULT STDMETHODCALLTYPE QueryInterface(REFIID riid, void** ppvObject) {
       if (ppvObject == nullptr)
@@ -107,7 +231,7 @@ namespace dxvk {
       if (pSizeOfData == nullptr)
         return D3DERR_INVALIDCALL;
 
-      const auto& bytecode = m_shader.GetBytecode();
+      const auto& bytecode = GetCommonShader()->GetBytecode();
 
       if (pOut == nullptr) {
         *pSizeOfData = bytecode.size();
@@ -121,12 +245,16 @@ namespace dxvk {
     }
 
     const D3D9CommonShader* GetCommonShader() const {
-      return &m_shader;
+      return m_module->GetShader();
+    }
+
+    bool HasFailed() const {
+      return m_module->HasFailed();
     }
 
   private:
 
-    D3D9CommonShader m_shader;
+    Rc<D3D9ShaderModule> m_module;
 
   };
 
@@ -137,9 +265,9 @@ namespace dxvk {
   public:
 
     D3D9VertexShader(
-            D3D9DeviceEx*      pDevice,
-      const D3D9CommonShader&  CommonShader)
-      : D3D9Shader<IDirect3DVertexShader9>( pDevice, CommonShader ) { }
+            D3D9DeviceEx*            pDevice,
+      const Rc<D3D9ShaderModule>&    Module)
+      : D3D9Shader<IDirect3DVertexShader9>( pDevice, Module ) { }
 
   };
 
@@ -148,9 +276,9 @@ namespace dxvk {
   public:
 
     D3D9PixelShader(
-            D3D9DeviceEx*      pDevice,
-      const D3D9CommonShader&  CommonShader)
-      : D3D9Shader<IDirect3DPixelShader9>( pDevice, CommonShader ) { }
+            D3D9DeviceEx*            pDevice,
+      const Rc<D3D9ShaderModule>&    Module)
+      : D3D9Shader<IDirect3DPixelShader9>( pDevice, Module ) { }
 
   };
 
@@ -161,12 +289,18 @@ namespace dxvk {
    * times, so we should cache the resulting shader modules
    * and reuse them rather than creating new ones. This
    * class is thread-safe.
+   *
+   * If async shader translation is enabled, new modules
+   * are handed to a pool of worker threads, which is
+   * started on first use.
    */
   class D3D9ShaderModuleSet : public RcObject {
     
   public:
+
+    ~D3D9ShaderModuleSet();
     
-    D3D9CommonShader GetShaderModule(
+    Rc<D3D9ShaderModule> GetShaderModule(
             D3D9DeviceEx*         pDevice,
             VkShaderStageFlagBits ShaderStage,
       const DxsoModuleInfo*       pDxbcModuleInfo,
@@ -174,12 +308,22 @@ namespace dxvk {
     
   private:
     
-    std::mutex m_mutex;
-    
-    std::unordered_map<
+    sync::ConcurrentCache<
       DxvkShaderKey,
-      D3D9CommonShader,
+      Rc<D3D9ShaderModule>,
       DxvkHash, DxvkEq> m_modules;
+
+    std::mutex                        m_workerLock;
+    std::condition_variable           m_workerCond;
+    std::queue<Rc<D3D9ShaderModule>>  m_workerQueue;
+    std::vector<dxvk::thread>         m_workerThreads;
+    bool                              m_stopThreads = false;
+
+    void EnqueueTranslation(
+            D3D9DeviceEx*         pDevice,
+      const Rc<D3D9ShaderModule>& Module);
+
+    void WorkerFunc();
     
 };
 
@@ -7,6 +7,23 @@ namespace dxvk {
   enum D3D9SpecConstantId : uint32_t {
     AlphaTestEnable = 0,
     AlphaCompareOp  = 1,
+    SamplerType     = 2, // 2 bits per PS sampler, see D3D9SamplerType
+    FogState        = 3, // Bit 0: fog enable, bits 1-2: D3DFOGMODE for table fog
+    PointSprite     = 4,
   };
 
-}
\ No newline at end of file
+  /**
+   * \brief Sampler texture type
+   *
+   * Packed into the \c SamplerType spec constant
+   * so that shader model 1 shaders, which do not
+   * declare sampler types, can sample any type of
+   * texture without being re-translated.
+   */
+  enum D3D9SamplerType : uint32_t {
+    SamplerType2D   = 0,
+    SamplerTypeCube = 1,
+    SamplerType3D   = 2,
+  };
+
+}
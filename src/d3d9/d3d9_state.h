@@ -31,12 +31,20 @@ namespace dxvk {
     float coeff[4];
   };
   struct D3D9RenderStateInfo {
-    float alphaRef = 0.0f;
+    float alphaRef    = 0.0f;
+    float fogScale    = 0.0f;
+    float fogEnd      = 1.0f;
+    float fogDensity  = 1.0f;
+    float fogColor[3] = { 0.0f, 0.0f, 0.0f };
   };
 
   enum class D3D9RenderStateItem {
-    AlphaRef = 0,
-    Count    = 1
+    AlphaRef   = 0,
+    FogColor   = 1,
+    FogScale   = 2,
+    FogEnd     = 3,
+    FogDensity = 4,
+    Count      = 5
   };
 
 
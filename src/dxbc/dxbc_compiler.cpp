@@ -17,7 +17,8 @@ namespace dxvk {
     const Rc<DxbcIsgn>&       osgn,
     const Rc<DxbcIsgn>&       psgn,
     const DxbcAnalysisInfo&   analysis)
-  : m_moduleInfo (moduleInfo),
+  : m_fileName   (fileName),
+    m_moduleInfo (moduleInfo),
     m_programInfo(programInfo),
     m_isgn       (isgn),
     m_osgn       (osgn),
@@ -234,13 +235,19 @@ namespace dxvk {
         shaderOptions.xfbStrides[i] = m_moduleInfo.xfb->strides[i];
     }
 
+    // Run the optimizer on the final code if enabled
+    SpirvCodeBuffer code = m_module.compile();
+
+    if (m_moduleInfo.options.optimizeSpirv)
+      code = optimizeSpirvShader(code, m_fileName);
+
     // Create the shader module object
     return new DxvkShader(
       m_programInfo.shaderStage(),
       m_resourceSlots.size(),
       m_resourceSlots.data(),
       m_interfaceSlots,
-      m_module.compile(),
+      std::move(code),
       shaderOptions,
       std::move(m_immConstData));
   }
@@ -4,6 +4,7 @@
 #include <vector>
 
 #include "../spirv/spirv_module.h"
+#include "../spirv/spirv_optimizer.h"
 
 #include "dxbc_analysis.h"
 #include "dxbc_chunk_isgn.h"
@@ -408,6 +409,7 @@ namespace dxvk {
     
   private:
     
+    std::string         m_fileName;
     DxbcModuleInfo      m_moduleInfo;
     DxbcProgramInfo     m_programInfo;
     SpirvModule         m_module;
@@ -55,6 +55,26 @@ namespace dxvk {
     
     // Apply shader-related options
     applyTristate(useSubgroupOpsForEarlyDiscard, device->config().useEarlyDiscard);
+
+    optimizeSpirv = device->config().optimizeShaders;
+  }
+
+
+  Sha1Hash DxbcOptions::hash() const {
+    const std::array<uint64_t, 10> values = {
+      uint64_t(useDepthClipWorkaround),
+      uint64_t(useStorageImageReadWithoutFormat),
+      uint64_t(useSubgroupOpsForAtomicCounters),
+      uint64_t(useSubgroupOpsForEarlyDiscard),
+      uint64_t(useSdivForBufferIndex),
+      uint64_t(strictDivision),
+      uint64_t(constantBufferRangeCheck),
+      uint64_t(zeroInitWorkgroupMemory),
+      uint64_t(minSsboAlignment),
+      uint64_t(optimizeSpirv),
+    };
+
+    return Sha1Hash::compute(values);
   }
   
 }
\ No newline at end of file
@@ -10,6 +10,16 @@ namespace dxvk {
     DxbcOptions();
     DxbcOptions(const Rc<DxvkDevice>& device, const D3D11Options& options);
 
+    /**
+     * \brief Computes hash of all options
+     *
+     * Used to identify translated shaders in
+     * the shader cache, since options affect
+     * the generated code.
+     * \returns Options hash
+     */
+    Sha1Hash hash() const;
+
     // Clamp oDepth in fragment shaders if the depth
     // clip device feature is not supported
     bool useDepthClipWorkaround = false;
@@ -39,6 +49,9 @@ namespace dxvk {
     /// Clear thread-group shared memory to zero
     bool zeroInitWorkgroupMemory = false;
 
+    /// Run the SPIR-V optimizer on generated code
+    bool optimizeSpirv = false;
+
     /// Minimum storage buffer alignment
     VkDeviceSize minSsboAlignment = 0;
   };
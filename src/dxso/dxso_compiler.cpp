@@ -19,7 +19,8 @@ namespace dxvk {
     const DxsoModuleInfo&   moduleInfo,
     const DxsoProgramInfo&  programInfo,
     const DxsoAnalysisInfo& analysis)
-    : m_moduleInfo ( moduleInfo )
+    : m_fileName   ( fileName )
+    , m_moduleInfo ( moduleInfo )
     , m_programInfo( programInfo )
     , m_analysis   ( &analysis ) {
     // Declare an entry point ID. We'll need it during the
@@ -188,13 +189,19 @@ namespace dxvk {
 
     DxvkShaderConstData constData = { };
 
+    // Run the optimizer on the final code if enabled
+    SpirvCodeBuffer code = m_module.compile();
+
+    if (m_moduleInfo.options.optimizeSpirv)
+      code = optimizeSpirvShader(code, m_fileName);
+
     // Create the shader module object
     return new DxvkShader(
       m_programInfo.shaderStage(),
       m_resourceSlots.size(),
       m_resourceSlots.data(),
       m_interfaceSlots,
-      m_module.compile(),
+      std::move(code),
       shaderOptions,
       std::move(constData));
   }
@@ -544,13 +551,13 @@ namespace dxvk {
     m_usedSamplers |= (1u << idx);
 
     auto DclSampler = [this](
-      uint32_t        idx,
-      DxsoTextureType type,
-      bool            depth) {
+      uint32_t         idx,
+      DxsoSamplerInfo& sampler,
+      DxsoTextureType  type,
+      DxsoBindingType  bindingType,
+      const char*      suffix) {
       // Setup our combines sampler.
-      DxsoSamplerInfo& sampler = !depth
-        ? m_samplers[idx].color
-        : m_samplers[idx].depth;
+      const bool depth = bindingType == DxsoBindingType::DepthImage;
 
       spv::Dim dimensionality;
       VkImageViewType viewType;
@@ -588,12 +595,11 @@ namespace dxvk {
           sampler.typeId, spv::StorageClassUniformConstant),
         spv::StorageClassUniformConstant);
 
-      std::string name = str::format("s", idx, depth ? "_shadow" : "");
+      std::string name = str::format("s", idx, suffix);
       m_module.setDebugName(sampler.varId, name.c_str());
 
-      const uint32_t bindingId = computeResourceSlotId(m_programInfo.type(),
-        !depth ? DxsoBindingType::ColorImage : DxsoBindingType::DepthImage,
-        idx);
+      const uint32_t bindingId = computeResourceSlotId(
+        m_programInfo.type(), bindingType, idx);
 
       m_module.decorateDescriptorSet(sampler.varId, 0);
       m_module.decorateBinding      (sampler.varId, bindingId);
@@ -607,16 +613,32 @@ namespace dxvk {
       m_resourceSlots.push_back(resource);
     };
 
-    DclSampler(idx, type, false);
-    DclSampler(idx, type, true);
+    DxsoSampler& sampler = m_samplers[idx];
+
+    DclSampler(idx, sampler.color, type, DxsoBindingType::ColorImage, "");
+    DclSampler(idx, sampler.depth, type, DxsoBindingType::DepthImage, "_shadow");
+
+    // Shader model 1 pixel shaders do not declare the texture
+    // type, so declare one image for each type and let the
+    // sampler type spec constant select the one to sample.
+    if (m_programInfo.type() == DxsoProgramTypes::PixelShader
+     && m_programInfo.majorVersion() < 2
+     && idx < DxsoMaxSm1Samplers) {
+      DclSampler(idx, sampler.colorCube, DxsoTextureType::TextureCube, DxsoBindingType::ColorImageCube, "_cube");
+      DclSampler(idx, sampler.color3D,   DxsoTextureType::Texture3D,   DxsoBindingType::ColorImage3D,   "_3d");
+
+      if (m_ps.samplerTypeSpec == 0) {
+        m_ps.samplerTypeSpec = m_module.specConst32(m_module.defIntType(32, 0), 0);
+        m_module.decorateSpecId(m_ps.samplerTypeSpec, getSpecId(D3D9SpecConstantId::SamplerType));
+        m_module.setDebugName(m_ps.samplerTypeSpec, "sampler_types");
+      }
+    }
 
     // Declare a specialization constant which will
     // store whether or not the depth view is bound.
     const uint32_t depthBinding = computeResourceSlotId(m_programInfo.type(),
       DxsoBindingType::DepthImage, idx);
 
-    DxsoSampler& sampler = m_samplers[idx];
-
     sampler.depthSpecConst = m_module.specConstBool(true);
     m_module.decorateSpecId(sampler.depthSpecConst, depthBinding);
     m_module.setDebugName(sampler.depthSpecConst,
@@ -1002,11 +1024,13 @@ namespace dxvk {
       case DxsoRegisterType::MiscType:
         if (reg.id.num == MiscTypePosition) {
           if (m_ps.vPos.id == 0) {
-            DxsoRegisterPointer fragCoord = this->emitRegisterPtr(
-              "ps_frag_coord", DxsoScalarType::Float32, 4, 0,
-              spv::StorageClassInput, spv::BuiltInFragCoord);
+            if (m_ps.fragCoord.id == 0) {
+              m_ps.fragCoord = this->emitRegisterPtr(
+                "ps_frag_coord", DxsoScalarType::Float32, 4, 0,
+                spv::StorageClassInput, spv::BuiltInFragCoord);
+            }
 
-            DxsoRegisterValue val = this->emitValueLoad(fragCoord);
+            DxsoRegisterValue val = this->emitValueLoad(m_ps.fragCoord);
             val.id = m_module.opFSub(
               getVectorTypeId(val.type), val.id,
               m_module.constvec4f32(0.5f, 0.5f, 0.0f, 0.0f));
@@ -2193,7 +2217,10 @@ void DxsoCompiler::emitControlFlowGenericLoop(
     DxsoSampler sampler = m_samplers.at(samplerIdx);
 
     if (sampler.color.varId == 0) {
-      Logger::warn("DxsoCompiler::emitTextureSample: Adding implicit 2D sampler");
+      // Samplers are never declared in shader model 1
+      if (m_programInfo.majorVersion() >= 2)
+        Logger::warn("DxsoCompiler::emitTextureSample: Adding implicit 2D sampler");
+
       emitDclSampler(samplerIdx, DxsoTextureType::Texture2D);
       sampler = m_samplers.at(samplerIdx);
     }
@@ -2274,6 +2301,38 @@ void DxsoCompiler::emitControlFlowGenericLoop(
       this->emitDstStore(dst, result, ctx.dst.mask, ctx.dst.saturate, ctx.dst.shift);
     };
 
+    uint32_t typeEndLabel = 0;
+
+    if (sampler.colorCube.varId != 0) {
+      // switch (sampler_type) { ... }
+      const uint32_t uintType = m_module.defIntType(32, 0);
+
+      uint32_t samplerType = m_module.opBitFieldUExtract(uintType,
+        m_ps.samplerTypeSpec, m_module.constu32(samplerIdx * 2), m_module.constu32(2));
+
+      std::array<SpirvSwitchCaseLabel, 2> typeCaseLabels = {{
+        { uint32_t(D3D9SamplerType::SamplerTypeCube), m_module.allocateId() },
+        { uint32_t(D3D9SamplerType::SamplerType3D),   m_module.allocateId() },
+      }};
+
+      uint32_t type2DLabel = m_module.allocateId();
+      typeEndLabel = m_module.allocateId();
+
+      m_module.opSelectionMerge(typeEndLabel, spv::SelectionControlMaskNone);
+      m_module.opSwitch(samplerType, type2DLabel,
+        typeCaseLabels.size(), typeCaseLabels.data());
+
+      m_module.opLabel(typeCaseLabels[0].labelId);
+      SampleImage(texcoordVar, sampler.colorCube, false);
+      m_module.opBranch(typeEndLabel);
+
+      m_module.opLabel(typeCaseLabels[1].labelId);
+      SampleImage(texcoordVar, sampler.color3D, false);
+      m_module.opBranch(typeEndLabel);
+
+      m_module.opLabel(type2DLabel);
+    }
+
     uint32_t colorLabel  = m_module.allocateId();
     uint32_t depthLabel  = m_module.allocateId();
     uint32_t endLabel    = m_module.allocateId();
@@ -2290,6 +2349,11 @@ void DxsoCompiler::emitControlFlowGenericLoop(
     m_module.opBranch(endLabel);
 
     m_module.opLabel(endLabel);
+
+    if (typeEndLabel != 0) {
+      m_module.opBranch(typeEndLabel);
+      m_module.opLabel(typeEndLabel);
+    }
   }
 
   void DxsoCompiler::emitTextureKill(const DxsoInstructionContext& ctx) {
@@ -2394,6 +2458,9 @@ void DxsoCompiler::emitControlFlowGenericLoop(
 
 
   void DxsoCompiler::emitInputSetup() {
+    uint32_t pointCoordVec = 0;
+    uint32_t pointSprite   = 0;
+
     for (uint32_t i = 0; i < m_isgn.elemCount; i++) {
       const auto& elem = m_isgn.elems[i];
       const uint32_t slot = elem.slot;
@@ -2453,6 +2520,40 @@ void DxsoCompiler::emitControlFlowGenericLoop(
       workingReg.id = m_module.opVectorShuffle(getVectorTypeId(workingReg.type),
         workingReg.id, indexVal.id, 4, indices.data());
 
+      // Replace texture coordinates with the point coordinate
+      // when rendering point sprites. The spec constant is only
+      // set for point list draws, where PointCoord is defined.
+      if (m_programInfo.type() == DxsoProgramTypes::PixelShader
+       && elem.semantic.usage == DxsoUsage::Texcoord) {
+        if (m_ps.pointSpriteSpec == 0) {
+          m_ps.pointSpriteSpec = m_module.specConstBool(false);
+          m_module.decorateSpecId(m_ps.pointSpriteSpec, getSpecId(D3D9SpecConstantId::PointSprite));
+          m_module.setDebugName(m_ps.pointSpriteSpec, "point_sprite");
+
+          DxsoRegisterPointer pointCoordPtr = this->emitRegisterPtr(
+            "ps_point_coord", DxsoScalarType::Float32, 2, 0,
+            spv::StorageClassInput, spv::BuiltInPointCoord);
+
+          DxsoRegisterValue pointCoord = this->emitValueLoad(pointCoordPtr);
+
+          std::array<uint32_t, 4> pointIndices = { 0, 1, 2, 3 };
+
+          pointCoordVec = m_module.opVectorShuffle(getVectorTypeId(workingReg.type),
+            pointCoord.id, m_module.constvec2f32(0.0f, 1.0f), 4, pointIndices.data());
+
+          std::array<uint32_t, 4> pointSpriteIds = {
+            m_ps.pointSpriteSpec, m_ps.pointSpriteSpec,
+            m_ps.pointSpriteSpec, m_ps.pointSpriteSpec };
+
+          pointSprite = m_module.opCompositeConstruct(
+            getVectorTypeId({ DxsoScalarType::Bool, 4 }),
+            pointSpriteIds.size(), pointSpriteIds.data());
+        }
+
+        workingReg.id = m_module.opSelect(getVectorTypeId(workingReg.type),
+          pointSprite, pointCoordVec, workingReg.id);
+      }
+
       m_module.opStore(indexPtr.id, workingReg.id);
     }
   }
@@ -2564,6 +2665,31 @@ void DxsoCompiler::emitControlFlowGenericLoop(
   }
 
 
+  void DxsoCompiler::emitVsFogOutput() {
+    // Shader model 3 writes fog to a regular output
+    // register, which is handled by the linker setup.
+    if (m_vs.oFog.id == 0)
+      return;
+
+    const uint32_t slot = RegisterLinkerSlot(DxsoSemantic{ DxsoUsage::Fog, 0 });
+
+    DxsoRegisterInfo info;
+    info.type.ctype   = DxsoScalarType::Float32;
+    info.type.ccount  = 4;
+    info.type.alength = 1;
+    info.sclass       = spv::StorageClassOutput;
+
+    uint32_t outputId = emitNewVariable(info);
+    m_module.decorateLocation(outputId, slot);
+    m_module.setDebugName(outputId, "out_fog");
+
+    m_entryPointInterfaces.push_back(outputId);
+    m_interfaceSlots.outputSlots |= 1u << slot;
+
+    m_module.opStore(outputId, emitValueLoad(m_vs.oFog).id);
+  }
+
+
   void DxsoCompiler::emitVsClipping() {
     uint32_t clipPlaneCountId = m_module.constu32(caps::MaxClipPlanes);
     
@@ -2651,8 +2777,12 @@ void DxsoCompiler::emitControlFlowGenericLoop(
       RsAlphaRef = 0,
     };
     
-    std::array<uint32_t, 1> rsMembers = {{
+    std::array<uint32_t, 5> rsMembers = {{
+      floatType,
+      floatType,
+      floatType,
       floatType,
+      m_module.defVectorType(floatType, 3),
     }};
     
     uint32_t rsStruct = m_module.defStructTypeUnique(rsMembers.size(), rsMembers.data());
@@ -2664,11 +2794,22 @@ void DxsoCompiler::emitControlFlowGenericLoop(
     m_module.decorate             (rsStruct, spv::DecorationBlock);
     m_module.setDebugMemberName   (rsStruct, 0, "alpha_ref");
     m_module.memberDecorateOffset (rsStruct, 0, offsetof(D3D9RenderStateInfo, alphaRef));
+    m_module.setDebugMemberName   (rsStruct, 1, "fog_scale");
+    m_module.memberDecorateOffset (rsStruct, 1, offsetof(D3D9RenderStateInfo, fogScale));
+    m_module.setDebugMemberName   (rsStruct, 2, "fog_end");
+    m_module.memberDecorateOffset (rsStruct, 2, offsetof(D3D9RenderStateInfo, fogEnd));
+    m_module.setDebugMemberName   (rsStruct, 3, "fog_density");
+    m_module.memberDecorateOffset (rsStruct, 3, offsetof(D3D9RenderStateInfo, fogDensity));
+    m_module.setDebugMemberName   (rsStruct, 4, "fog_color");
+    m_module.memberDecorateOffset (rsStruct, 4, offsetof(D3D9RenderStateInfo, fogColor));
     
     m_module.setDebugName         (rsBlock, "render_state");
 
     m_interfaceSlots.pushConstOffset = 0;
     m_interfaceSlots.pushConstSize   = sizeof(D3D9RenderStateInfo);
+
+    // Fixed-function fog is applied before the alpha test
+    this->emitPsFog(rsBlock);
     
     // Declare spec constants for render states
     uint32_t alphaTestId = m_module.specConstBool(false);
@@ -2776,6 +2917,183 @@ void DxsoCompiler::emitControlFlowGenericLoop(
     }
   }
 
+
+  void DxsoCompiler::emitPsFog(
+          uint32_t          rsBlock) {
+    // Shader model 3 pixel shaders have to compute fog themselves
+    if (m_programInfo.majorVersion() >= 3)
+      return;
+
+    // Render state push constant members
+    enum RenderStateMember : uint32_t {
+      RsFogScale   = 1,
+      RsFogEnd     = 2,
+      RsFogDensity = 3,
+      RsFogColor   = 4,
+    };
+
+    uint32_t boolType  = m_module.defBoolType();
+    uint32_t uintType  = m_module.defIntType(32, 0);
+    uint32_t floatType = m_module.defFloatType(32);
+    uint32_t vec3Type  = m_module.defVectorType(floatType, 3);
+    uint32_t vec4Type  = m_module.defVectorType(floatType, 4);
+    uint32_t floatPtr  = m_module.defPointerType(floatType, spv::StorageClassPushConstant);
+    uint32_t vec3Ptr   = m_module.defPointerType(vec3Type,  spv::StorageClassPushConstant);
+
+    auto LoadRenderState = [&] (uint32_t typeId, uint32_t ptrTypeId, uint32_t member) {
+      uint32_t memberId = m_module.constu32(member);
+      return m_module.opLoad(typeId,
+        m_module.opAccessChain(ptrTypeId, rsBlock, 1, &memberId));
+    };
+
+    // Bit 0 stores whether fog is enabled, the
+    // remaining bits store the table fog mode.
+    uint32_t fogStateId = m_module.specConst32(uintType, 0);
+    m_module.setDebugName   (fogStateId, "fog_state");
+    m_module.decorateSpecId (fogStateId, getSpecId(D3D9SpecConstantId::FogState));
+
+    uint32_t fogEnableId = m_module.opINotEqual(boolType,
+      m_module.opBitwiseAnd(uintType, fogStateId, m_module.constu32(1)),
+      m_module.constu32(0));
+
+    uint32_t fogModeId = m_module.opShiftRightLogical(
+      uintType, fogStateId, m_module.constu32(1));
+
+    DxsoRegister color0;
+    color0.id = DxsoRegisterId{ DxsoRegisterType::ColorOut, 0 };
+    auto oC0 = this->emitGetOperandPtr(color0);
+
+    std::array<SpirvSwitchCaseLabel, 3> fogCaseLabels = {{
+      { uint32_t(D3DFOG_EXP),    m_module.allocateId() },
+      { uint32_t(D3DFOG_EXP2),   m_module.allocateId() },
+      { uint32_t(D3DFOG_LINEAR), m_module.allocateId() },
+    }};
+
+    uint32_t fogBeginLabel  = m_module.allocateId();
+    uint32_t fogVertexLabel = m_module.allocateId();
+    uint32_t fogMergeLabel  = m_module.allocateId();
+    uint32_t fogSkipLabel   = m_module.allocateId();
+
+    // if (fog_enable) { ... }
+    m_module.opSelectionMerge(fogSkipLabel, spv::SelectionControlMaskNone);
+    m_module.opBranchConditional(fogEnableId, fogBeginLabel, fogSkipLabel);
+    m_module.opLabel(fogBeginLabel);
+
+    if (m_ps.fragCoord.id == 0) {
+      m_ps.fragCoord = this->emitRegisterPtr(
+        "ps_frag_coord", DxsoScalarType::Float32, 4, 0,
+        spv::StorageClassInput, spv::BuiltInFragCoord);
+    }
+
+    uint32_t depthComponentId = 2;
+    uint32_t depthId = m_module.opCompositeExtract(floatType,
+      emitValueLoad(m_ps.fragCoord).id, 1, &depthComponentId);
+
+    // switch (fog_mode) { ... }
+    m_module.opSelectionMerge(fogMergeLabel, spv::SelectionControlMaskNone);
+    m_module.opSwitch(fogModeId, fogVertexLabel,
+      fogCaseLabels.size(), fogCaseLabels.data());
+
+    // exp(x) = exp2(x * log2(e))
+    const float log2e = 1.44269504f;
+
+    std::array<SpirvPhiLabel, 4> fogVariables;
+
+    for (uint32_t i = 0; i < fogCaseLabels.size(); i++) {
+      m_module.opLabel(fogCaseLabels[i].labelId);
+
+      fogVariables[i].labelId = fogCaseLabels[i].labelId;
+      fogVariables[i].varId   = [&] {
+        switch (fogCaseLabels[i].literal) {
+          case D3DFOG_EXP: {
+            uint32_t density = LoadRenderState(floatType, floatPtr, RsFogDensity);
+            uint32_t exponent = m_module.opFMul(floatType, depthId, density);
+            exponent = m_module.opFMul(floatType, exponent, m_module.constf32(-log2e));
+            return m_module.opExp2(floatType, exponent);
+          }
+
+          case D3DFOG_EXP2: {
+            uint32_t density = LoadRenderState(floatType, floatPtr, RsFogDensity);
+            uint32_t exponent = m_module.opFMul(floatType, depthId, density);
+            exponent = m_module.opFMul(floatType, exponent, exponent);
+            exponent = m_module.opFMul(floatType, exponent, m_module.constf32(-log2e));
+            return m_module.opExp2(floatType, exponent);
+          }
+
+          default:
+          case D3DFOG_LINEAR: {
+            uint32_t fogEnd   = LoadRenderState(floatType, floatPtr, RsFogEnd);
+            uint32_t fogScale = LoadRenderState(floatType, floatPtr, RsFogScale);
+            return m_module.opFMul(floatType,
+              m_module.opFSub(floatType, fogEnd, depthId), fogScale);
+          }
+        }
+      }();
+
+      m_module.opBranch(fogMergeLabel);
+    }
+
+    // Vertex fog, use the fog factor written by the vertex shader
+    m_module.opLabel(fogVertexLabel);
+
+    const uint32_t fogSlot = RegisterLinkerSlot(DxsoSemantic{ DxsoUsage::Fog, 0 });
+
+    DxsoRegisterInfo fogInfo;
+    fogInfo.type.ctype   = DxsoScalarType::Float32;
+    fogInfo.type.ccount  = 4;
+    fogInfo.type.alength = 1;
+    fogInfo.sclass       = spv::StorageClassInput;
+
+    uint32_t fogInputId = emitNewVariable(fogInfo);
+    m_module.decorateLocation(fogInputId, fogSlot);
+    m_module.setDebugName(fogInputId, "in_fog");
+
+    m_entryPointInterfaces.push_back(fogInputId);
+    m_interfaceSlots.inputSlots |= 1u << fogSlot;
+
+    uint32_t fogComponentId = 0;
+    fogVariables[3].labelId = fogVertexLabel;
+    fogVariables[3].varId   = m_module.opCompositeExtract(floatType,
+      m_module.opLoad(vec4Type, fogInputId), 1, &fogComponentId);
+
+    m_module.opBranch(fogMergeLabel);
+
+    // end switch
+    m_module.opLabel(fogMergeLabel);
+
+    uint32_t fogFactor = m_module.opPhi(floatType,
+      fogVariables.size(), fogVariables.data());
+
+    fogFactor = m_module.opFClamp(floatType, fogFactor,
+      m_module.constf32(0.0f), m_module.constf32(1.0f));
+
+    // color.rgb = mix(fog_color, color.rgb, fog_factor)
+    std::array<uint32_t, 3> fogFactorIds = { fogFactor, fogFactor, fogFactor };
+
+    uint32_t colorId = m_module.opLoad(vec4Type, oC0.id);
+    uint32_t fogColorId = LoadRenderState(vec3Type, vec3Ptr, RsFogColor);
+
+    std::array<uint32_t, 4> indices = { 0, 1, 2, 3 };
+
+    uint32_t rgbId = m_module.opVectorShuffle(vec3Type,
+      colorId, colorId, 3, indices.data());
+
+    rgbId = m_module.opFMix(vec3Type, fogColorId, rgbId,
+      m_module.opCompositeConstruct(vec3Type, fogFactorIds.size(), fogFactorIds.data()));
+
+    indices[3] = 3 + 3;
+
+    colorId = m_module.opVectorShuffle(vec4Type,
+      rgbId, colorId, indices.size(), indices.data());
+
+    m_module.opStore(oC0.id, colorId);
+    m_module.opBranch(fogSkipLabel);
+
+    // end if (fog_enable)
+    m_module.opLabel(fogSkipLabel);
+  }
+
+
   void DxsoCompiler::emitOutputDepthClamp() {
     // HACK: Some drivers do not clamp FragDepth to [minDepth..maxDepth]
     // before writing to the depth attachment, but we do not have acccess
@@ -2806,6 +3124,7 @@ void DxsoCompiler::emitControlFlowGenericLoop(
       m_module.defVoidType(),
       m_vs.functionId, 0, nullptr);
     this->emitLinkerOutputSetup();
+    this->emitVsFogOutput();
 
     this->emitVsClipping();
 
@@ -2858,7 +3177,6 @@ void DxsoCompiler::emitControlFlowGenericLoop(
   }
 
 
-
   uint32_t DxsoCompiler::getScalarTypeId(DxsoScalarType type) {
     switch (type) {
       case DxsoScalarType::Uint32:  return m_module.defIntType(32, 0);
@@ -6,6 +6,7 @@
 #include "dxso_isgn.h"
 
 #include "../spirv/spirv_module.h"
+#include "../spirv/spirv_optimizer.h"
 
 namespace dxvk {
 
@@ -107,6 +108,10 @@ namespace dxvk {
     DxsoSamplerInfo color;
     DxsoSamplerInfo depth;
 
+    // Shader model 1 pixel shaders only
+    DxsoSamplerInfo colorCube;
+    DxsoSamplerInfo color3D;
+
     uint32_t depthSpecConst;
   };
 
@@ -140,6 +145,8 @@ namespace dxvk {
     DxsoRegisterPointer vPos;
     DxsoRegisterPointer vFace;
 
+    DxsoRegisterPointer fragCoord;
+
     ///////////////////
     // Colour Outputs
     std::array<DxsoRegisterPointer, 4> oColor;
@@ -150,6 +157,11 @@ namespace dxvk {
 
     uint32_t killState          = 0;
     uint32_t builtinLaneId      = 0;
+
+    ////////////////////////////
+    // Render state spec consts
+    uint32_t samplerTypeSpec    = 0;
+    uint32_t pointSpriteSpec    = 0;
   };
 
   struct DxsoCfgBlockIf {
@@ -219,6 +231,7 @@ namespace dxvk {
 
   private:
 
+    std::string                m_fileName;
     DxsoModuleInfo             m_moduleInfo;
     DxsoProgramInfo            m_programInfo;
     const DxsoAnalysisInfo*    m_analysis;
@@ -556,7 +569,11 @@ namespace dxvk {
     void emitPsProcessing();
     void emitOutputDepthClamp();
 
+    void emitPsFog(
+            uint32_t          rsBlock);
+
     void emitLinkerOutputSetup();
+    void emitVsFogOutput();
 
     void emitVsFinalize();
     void emitPsFinalize();
@@ -25,6 +25,20 @@ namespace dxvk {
     strictConstantCopies = options.strictConstantCopies;
 
     strictPow            = options.strictPow;
+
+    optimizeSpirv        = device->config().optimizeShaders;
+  }
+
+
+  Sha1Hash DxsoOptions::hash() const {
+    const std::array<uint32_t, 4> values = {
+      uint32_t(useSubgroupOpsForEarlyDiscard),
+      uint32_t(strictConstantCopies),
+      uint32_t(strictPow),
+      uint32_t(optimizeSpirv),
+    };
+
+    return Sha1Hash::compute(values);
   }
 
 }
\ No newline at end of file
@@ -11,6 +11,16 @@ namespace dxvk {
     DxsoOptions();
     DxsoOptions(const Rc<DxvkDevice>& device, const D3D9Options& options);
 
+    /**
+     * \brief Computes hash of all options
+     *
+     * Used to identify translated shaders in
+     * the shader cache, since options affect
+     * the generated code.
+     * \returns Options hash
+     */
+    Sha1Hash hash() const;
+
     /// Use subgroup operations to discard fragment
     /// shader invocations if derivatives remain valid.
     bool useSubgroupOpsForEarlyDiscard = false;
@@ -22,6 +32,9 @@ namespace dxvk {
 
     /// Whether or not we should care about pow(0, 0) = 1
     bool strictPow;
+
+    /// Run the SPIR-V optimizer on generated code
+    bool optimizeSpirv = false;
   };
 
 }
\ No newline at end of file
@@ -23,7 +23,9 @@ namespace dxvk {
       case DxsoBindingType::ConstantBuffer: return bindingIndex + stageOffset + 0;  // 0  + 2 = 2
         // The extra sampler here is being reserved for DMAP stuff later on.
       case DxsoBindingType::ColorImage:     return bindingIndex + stageOffset + 2;  // 2  + 17 = 19
-      case DxsoBindingType::DepthImage:     return bindingIndex + stageOffset + 19; // 19 + 17 = 26
+      case DxsoBindingType::DepthImage:     return bindingIndex + stageOffset + 19; // 19 + 17 = 36
+      case DxsoBindingType::ColorImageCube: return bindingIndex + stageOffset + 36; // 36 + 6  = 42
+      case DxsoBindingType::ColorImage3D:   return bindingIndex + stageOffset + 42; // 42 + 6  = 48
       default: Logger::err("computeResourceSlotId: Invalid resource type");
       }
     }
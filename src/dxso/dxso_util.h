@@ -10,9 +10,14 @@ namespace dxvk {
   enum class DxsoBindingType : uint32_t {
     ConstantBuffer,
     ColorImage,
-    DepthImage // <-- We use whatever one is bound to determine whether an image should be 'shadow' sampled or not.
+    DepthImage, // <-- We use whatever one is bound to determine whether an image should be 'shadow' sampled or not.
+    ColorImageCube, // <-- Shader model 1 pixel shaders only, the texture type is picked by a spec constant.
+    ColorImage3D
   };
 
+  // Shader model 1 pixel shaders can access at most six samplers.
+  constexpr uint32_t DxsoMaxSm1Samplers = 6;
+
   enum DxsoConstantBuffers : uint32_t {
     VSConstantBuffer = 0,
     VSClipPlanes     = 1,
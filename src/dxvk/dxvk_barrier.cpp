@@ -31,7 +31,7 @@ namespace dxvk {
     m_srcAccess |= srcAccess;
     m_dstAccess |= dstAccess;
 
-    m_bufSlices.push_back({ bufSlice, access });
+    m_bufSlices.insert(bufSlice.handle, getBufferRange(bufSlice), access);
   }
   
   
@@ -73,7 +73,7 @@ namespace dxvk {
       m_imgBarriers.push_back(barrier);
     }
 
-    m_imgSlices.push_back({ image.ptr(), subresources, access });
+    m_imgSlices.insert(image.ptr(), getImageRange(subresources), access);
   }
 
 
@@ -108,8 +108,8 @@ namespace dxvk {
     acquire.m_bufBarriers.push_back(barrier);
 
     DxvkAccessFlags access(DxvkAccess::Read, DxvkAccess::Write);
-    release.m_bufSlices.push_back({ bufSlice, access });
-    acquire.m_bufSlices.push_back({ bufSlice, access });
+    release.m_bufSlices.insert(bufSlice.handle, getBufferRange(bufSlice), access);
+    acquire.m_bufSlices.insert(bufSlice.handle, getBufferRange(bufSlice), access);
   }
 
 
@@ -152,25 +152,16 @@ namespace dxvk {
     acquire.m_imgBarriers.push_back(barrier);
 
     DxvkAccessFlags access(DxvkAccess::Read, DxvkAccess::Write);
-    release.m_imgSlices.push_back({ image.ptr(), subresources, access });
-    acquire.m_imgSlices.push_back({ image.ptr(), subresources, access });
+    release.m_imgSlices.insert(image.ptr(), getImageRange(subresources), access);
+    acquire.m_imgSlices.insert(image.ptr(), getImageRange(subresources), access);
   }
 
 
   bool DxvkBarrierSet::isBufferDirty(
     const DxvkBufferSliceHandle&    bufSlice,
           DxvkAccessFlags           bufAccess) {
-    bool result = false;
-
-    for (uint32_t i = 0; i < m_bufSlices.size() && !result; i++) {
-      const DxvkBufferSliceHandle& dstSlice = m_bufSlices[i].slice;
-
-      result = (bufSlice.handle == dstSlice.handle) && (bufAccess | m_bufSlices[i].access).test(DxvkAccess::Write)
-            && (bufSlice.offset + bufSlice.length > dstSlice.offset)
-            && (bufSlice.offset < dstSlice.offset + dstSlice.length);
-    }
-
-    return result;
+    return m_bufSlices.isDirty(bufSlice.handle,
+      getBufferRange(bufSlice), bufAccess);
   }
 
 
@@ -178,56 +169,23 @@ namespace dxvk {
     const Rc<DxvkImage>&            image,
     const VkImageSubresourceRange&  imgSubres,
           DxvkAccessFlags           imgAccess) {
-    bool result = false;
-
-    for (uint32_t i = 0; i < m_imgSlices.size() && !result; i++) {
-      const VkImageSubresourceRange& dstSubres = m_imgSlices[i].subres;
-
-      result = (image == m_imgSlices[i].image) && (imgAccess | m_imgSlices[i].access).test(DxvkAccess::Write)
-            && (imgSubres.baseArrayLayer < dstSubres.baseArrayLayer + dstSubres.layerCount)
-            && (imgSubres.baseArrayLayer + imgSubres.layerCount     > dstSubres.baseArrayLayer)
-            && (imgSubres.baseMipLevel   < dstSubres.baseMipLevel   + dstSubres.levelCount)
-            && (imgSubres.baseMipLevel   + imgSubres.levelCount     > dstSubres.baseMipLevel);
-    }
-
-    return result;
+    return m_imgSlices.isDirty(image.ptr(),
+      getImageRange(imgSubres), imgAccess);
   }
 
 
   DxvkAccessFlags DxvkBarrierSet::getBufferAccess(
     const DxvkBufferSliceHandle&    bufSlice) {
-    DxvkAccessFlags access;
-
-    for (uint32_t i = 0; i < m_bufSlices.size(); i++) {
-      const DxvkBufferSliceHandle& dstSlice = m_bufSlices[i].slice;
-
-      if ((bufSlice.handle == dstSlice.handle)
-       && (bufSlice.offset + bufSlice.length > dstSlice.offset)
-       && (bufSlice.offset < dstSlice.offset + dstSlice.length))
-        access = access | m_bufSlices[i].access;
-    }
-
-    return access;
+    return m_bufSlices.getAccess(bufSlice.handle,
+      getBufferRange(bufSlice));
   }
 
   
   DxvkAccessFlags DxvkBarrierSet::getImageAccess(
     const Rc<DxvkImage>&            image,
     const VkImageSubresourceRange&  imgSubres) {
-    DxvkAccessFlags access;
-
-    for (uint32_t i = 0; i < m_imgSlices.size(); i++) {
-      const VkImageSubresourceRange& dstSubres = m_imgSlices[i].subres;
-
-      if ((image == m_imgSlices[i].image)
-       && (imgSubres.baseArrayLayer < dstSubres.baseArrayLayer + dstSubres.layerCount)
-       && (imgSubres.baseArrayLayer + imgSubres.layerCount     > dstSubres.baseArrayLayer)
-       && (imgSubres.baseMipLevel   < dstSubres.baseMipLevel   + dstSubres.levelCount)
-       && (imgSubres.baseMipLevel   + imgSubres.levelCount     > dstSubres.baseMipLevel))
-        access = access | m_imgSlices[i].access;
-    }
-
-    return access;
+    return m_imgSlices.getAccess(image.ptr(),
+      getImageRange(imgSubres));
   }
 
 
@@ -272,8 +230,8 @@ namespace dxvk {
     m_bufBarriers.resize(0);
     m_imgBarriers.resize(0);
 
-    m_bufSlices.resize(0);
-    m_imgSlices.resize(0);
+    m_bufSlices.clear();
+    m_imgSlices.clear();
   }
   
   
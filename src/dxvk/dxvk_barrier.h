@@ -5,6 +5,234 @@
 #include "dxvk_image.h"
 
 namespace dxvk {
+
+  /**
+   * \brief Buffer range for barrier tracking
+   */
+  struct DxvkBarrierBufferRange {
+    VkDeviceSize offset;
+    VkDeviceSize length;
+
+    bool overlaps(const DxvkBarrierBufferRange& range) const {
+      return offset + length > range.offset
+          && offset < range.offset + range.length;
+    }
+
+    void merge(const DxvkBarrierBufferRange& range) {
+      VkDeviceSize end = std::max(offset + length, range.offset + range.length);
+      offset = std::min(offset, range.offset);
+      length = end - offset;
+    }
+  };
+
+
+  /**
+   * \brief Image subresource range for barrier tracking
+   */
+  struct DxvkBarrierImageRange {
+    uint32_t baseMipLevel;
+    uint32_t levelCount;
+    uint32_t baseArrayLayer;
+    uint32_t layerCount;
+
+    bool overlaps(const DxvkBarrierImageRange& range) const {
+      return baseArrayLayer < range.baseArrayLayer + range.layerCount
+          && baseArrayLayer + layerCount > range.baseArrayLayer
+          && baseMipLevel   < range.baseMipLevel   + range.levelCount
+          && baseMipLevel   + levelCount > range.baseMipLevel;
+    }
+
+    void merge(const DxvkBarrierImageRange& range) {
+      uint32_t mipEnd   = std::max(baseMipLevel   + levelCount, range.baseMipLevel   + range.levelCount);
+      uint32_t layerEnd = std::max(baseArrayLayer + layerCount, range.baseArrayLayer + range.layerCount);
+      baseMipLevel   = std::min(baseMipLevel,   range.baseMipLevel);
+      baseArrayLayer = std::min(baseArrayLayer, range.baseArrayLayer);
+      levelCount     = mipEnd   - baseMipLevel;
+      layerCount     = layerEnd - baseArrayLayer;
+    }
+  };
+
+
+  /**
+   * \brief Barrier slice map
+   *
+   * Maps resource handles to the list of ranges that
+   * were accessed since the last barrier. Uses an open
+   * addressing hash table that stores the union of all
+   * ranges and access types per resource, so that most
+   * lookups do not need to walk the range list at all.
+   *
+   * Entries are invalidated by bumping a version number,
+   * so that resetting the map does not have to touch
+   * the entire hash table.
+   */
+  template<typename Key, typename Range>
+  class DxvkBarrierSliceMap {
+    constexpr static uint32_t InvalidIndex = ~0u;
+  public:
+
+    DxvkBarrierSliceMap() {
+      m_buckets.resize(MinBucketCount);
+    }
+
+    /**
+     * \brief Adds an accessed range
+     *
+     * \param [in] key Resource handle
+     * \param [in] range Accessed range
+     * \param [in] access Access types
+     */
+    void insert(Key key, const Range& range, DxvkAccessFlags access) {
+      if (unlikely(2 * (m_used + 1) > m_buckets.size()))
+        grow();
+
+      Bucket& bucket = m_buckets[findBucket(m_buckets, key)];
+
+      if (bucket.version != m_version) {
+        bucket.key     = key;
+        bucket.version = m_version;
+        bucket.head    = InvalidIndex;
+        bucket.bounds  = range;
+        bucket.access  = access;
+        m_used += 1;
+      } else {
+        bucket.bounds.merge(range);
+        bucket.access = bucket.access | access;
+      }
+
+      m_nodes.push_back({ range, access, bucket.head });
+      bucket.head = m_nodes.size() - 1;
+    }
+
+    /**
+     * \brief Checks for conflicting accesses
+     *
+     * \param [in] key Resource handle
+     * \param [in] range Range to check
+     * \param [in] access Access types of the new access
+     * \returns \c true if an overlapping range is
+     *    accessed and either access is a write
+     */
+    bool isDirty(Key key, const Range& range, DxvkAccessFlags access) const {
+      const Bucket* bucket = lookup(key, range);
+
+      if (!bucket || !(access | bucket->access).test(DxvkAccess::Write))
+        return false;
+
+      for (uint32_t i = bucket->head; i != InvalidIndex; i = m_nodes[i].next) {
+        if ((access | m_nodes[i].access).test(DxvkAccess::Write)
+         && m_nodes[i].range.overlaps(range))
+          return true;
+      }
+
+      return false;
+    }
+
+    /**
+     * \brief Queries access types of a range
+     *
+     * \param [in] key Resource handle
+     * \param [in] range Range to check
+     * \returns Access types of all overlapping ranges
+     */
+    DxvkAccessFlags getAccess(Key key, const Range& range) const {
+      DxvkAccessFlags result;
+
+      const Bucket* bucket = lookup(key, range);
+
+      if (!bucket)
+        return result;
+
+      for (uint32_t i = bucket->head; i != InvalidIndex && result != bucket->access; i = m_nodes[i].next) {
+        if (m_nodes[i].range.overlaps(range))
+          result = result | m_nodes[i].access;
+      }
+
+      return result;
+    }
+
+    /**
+     * \brief Removes all entries
+     */
+    void clear() {
+      if (!m_used)
+        return;
+
+      if (unlikely(!(++m_version))) {
+        for (auto& bucket : m_buckets)
+          bucket.version = 0;
+
+        m_version = 1;
+      }
+
+      m_nodes.resize(0);
+      m_used = 0;
+    }
+
+  private:
+
+    constexpr static size_t MinBucketCount = 64;
+
+    struct Bucket {
+      Key             key     = Key();
+      uint32_t        version = 0;
+      uint32_t        head    = InvalidIndex;
+      Range           bounds  = { };
+      DxvkAccessFlags access;
+    };
+
+    struct Node {
+      Range           range;
+      DxvkAccessFlags access;
+      uint32_t        next;
+    };
+
+    std::vector<Bucket> m_buckets;
+    std::vector<Node>   m_nodes;
+
+    uint32_t            m_version = 1;
+    uint32_t            m_used    = 0;
+
+    const Bucket* lookup(Key key, const Range& range) const {
+      if (!m_used)
+        return nullptr;
+
+      const Bucket& bucket = m_buckets[findBucket(m_buckets, key)];
+
+      if (bucket.version != m_version || !bucket.bounds.overlaps(range))
+        return nullptr;
+
+      return &bucket;
+    }
+
+    size_t findBucket(const std::vector<Bucket>& buckets, Key key) const {
+      size_t mask  = buckets.size() - 1;
+      size_t index = getHash(key) & mask;
+
+      // Linear probing, the table is at most half full
+      while (buckets[index].version == m_version && buckets[index].key != key)
+        index = (index + 1) & mask;
+
+      return index;
+    }
+
+    void grow() {
+      std::vector<Bucket> buckets(2 * m_buckets.size());
+
+      for (const auto& bucket : m_buckets) {
+        if (bucket.version == m_version)
+          buckets[findBucket(buckets, bucket.key)] = bucket;
+      }
+
+      m_buckets = std::move(buckets);
+    }
+
+    static size_t getHash(Key key) {
+      uint64_t hash = uint64_t(std::hash<Key>()(key));
+      return size_t((hash * 0x9e3779b97f4a7c15ull) >> 32);
+    }
+
+  };
   
   /**
    * \brief Barrier set
@@ -87,17 +315,6 @@ namespace dxvk {
     
   private:
 
-    struct BufSlice {
-      DxvkBufferSliceHandle   slice;
-      DxvkAccessFlags         access;
-    };
-
-    struct ImgSlice {
-      DxvkImage*              image;
-      VkImageSubresourceRange subres;
-      DxvkAccessFlags         access;
-    };
-
     DxvkCmdBuffer m_cmdBuffer;
     
     VkPipelineStageFlags m_srcStages = 0;
@@ -109,10 +326,21 @@ namespace dxvk {
     std::vector<VkBufferMemoryBarrier> m_bufBarriers;
     std::vector<VkImageMemoryBarrier>  m_imgBarriers;
 
-    std::vector<BufSlice> m_bufSlices;
-    std::vector<ImgSlice> m_imgSlices;
+    DxvkBarrierSliceMap<VkBuffer,   DxvkBarrierBufferRange> m_bufSlices;
+    DxvkBarrierSliceMap<DxvkImage*, DxvkBarrierImageRange>  m_imgSlices;
     
     DxvkAccessFlags getAccessTypes(VkAccessFlags flags) const;
+
+    static DxvkBarrierBufferRange getBufferRange(
+      const DxvkBufferSliceHandle&    bufSlice) {
+      return { bufSlice.offset, bufSlice.length };
+    }
+
+    static DxvkBarrierImageRange getImageRange(
+      const VkImageSubresourceRange&  imgSubres) {
+      return { imgSubres.baseMipLevel,   imgSubres.levelCount,
+               imgSubres.baseArrayLayer, imgSubres.layerCount };
+    }
     
   };
   
@@ -24,15 +24,51 @@ namespace dxvk {
     m_physSlice.offset = 0;
     m_physSlice.length = m_physSliceLength;
     m_physSlice.mapPtr = m_buffer.memory.mapPtr(0);
+
+    if (m_device->defragmenter() && isRelocatable())
+      m_device->defragmenter()->registerBuffer(this);
   }
 
 
   DxvkBuffer::~DxvkBuffer() {
+    if (m_device->defragmenter() && isRelocatable())
+      m_device->defragmenter()->unregisterBuffer(this);
+
     auto vkd = m_device->vkd();
 
     for (const auto& buffer : m_buffers)
       vkd->vkDestroyBuffer(vkd->device(), buffer.buffer, nullptr);
     vkd->vkDestroyBuffer(vkd->device(), m_buffer.buffer, nullptr);
+    vkd->vkDestroyBuffer(vkd->device(), m_retired.buffer, nullptr);
+  }
+
+
+  bool DxvkBuffer::needsRelocation() {
+    std::unique_lock<sync::Spinlock> freeLock(m_freeMutex);
+    std::unique_lock<sync::Spinlock> swapLock(m_swapMutex);
+
+    return m_buffers.empty()
+        && m_retired.buffer == VK_NULL_HANDLE
+        && m_buffer.memory.isEvacuating();
+  }
+
+
+  bool DxvkBuffer::relocate(DxvkBufferSliceHandle& slice) {
+    std::unique_lock<sync::Spinlock> freeLock(m_freeMutex);
+    std::unique_lock<sync::Spinlock> swapLock(m_swapMutex);
+
+    // The buffer may have been renamed since it was queued
+    if (!m_buffers.empty() || m_retired.buffer != VK_NULL_HANDLE
+     || m_physSlice.handle != m_buffer.buffer)
+      return false;
+
+    m_retired = std::exchange(m_buffer, allocBuffer(1));
+
+    slice.handle = m_buffer.buffer;
+    slice.offset = 0;
+    slice.length = m_physSliceLength;
+    slice.mapPtr = m_buffer.memory.mapPtr(0);
+    return true;
   }
   
   
@@ -102,6 +138,31 @@ namespace dxvk {
   }
 
 
+  bool DxvkBuffer::isRelocatable() const {
+    // Host-visible buffers may be written by the application
+    // at any time, and buffer views are cached per slice
+    VkBufferUsageFlags viewUsage = VK_BUFFER_USAGE_UNIFORM_TEXEL_BUFFER_BIT
+                                 | VK_BUFFER_USAGE_STORAGE_TEXEL_BUFFER_BIT;
+
+    return (m_memFlags & VK_MEMORY_PROPERTY_DEVICE_LOCAL_BIT)
+       && !(m_memFlags & VK_MEMORY_PROPERTY_HOST_VISIBLE_BIT)
+       && !(m_info.usage & viewUsage);
+  }
+
+
+  void DxvkBuffer::freeRetiredBuffer() {
+    DxvkBufferHandle handle;
+
+    { std::unique_lock<sync::Spinlock> swapLock(m_swapMutex);
+      handle = std::move(m_retired);
+      m_retired.buffer = VK_NULL_HANDLE;
+    }
+
+    auto vkd = m_device->vkd();
+    vkd->vkDestroyBuffer(vkd->device(), handle.buffer, nullptr);
+  }
+
+
   
   DxvkBufferView::DxvkBufferView(
     const Rc<vk::DeviceFn>&         vkd,
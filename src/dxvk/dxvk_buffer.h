@@ -277,9 +277,40 @@ namespace dxvk {
     void freeSlice(const DxvkBufferSliceHandle& slice) {
       // Add slice to a separate free list to reduce lock contention.
       std::unique_lock<sync::Spinlock> swapLock(m_swapMutex);
+
+      if (unlikely(slice.handle == m_retired.buffer)) {
+        swapLock.unlock();
+        freeRetiredBuffer();
+        return;
+      }
+
       m_nextSlices.push_back(slice);
     }
     
+    /**
+     * \brief Checks whether the buffer should be relocated
+     * 
+     * Only buffers that have never been renamed can be
+     * relocated, since the slices of the physical buffers
+     * used for renaming may still be in use by the GPU.
+     * \returns \c true if the buffer memory is allocated
+     *    from a chunk that is currently being evacuated
+     */
+    bool needsRelocation();
+    
+    /**
+     * \brief Allocates new backing storage
+     * 
+     * Creates a new physical buffer and retires the current
+     * one, which will be destroyed once the slice returned
+     * by \ref rename is passed to \ref freeSlice. Do not call
+     * this directly as this is called implicitly by the
+     * context's \c relocateBuffer method.
+     * \param [out] slice The new buffer slice
+     * \returns \c false if the buffer cannot be relocated
+     */
+    bool relocate(DxvkBufferSliceHandle& slice);
+    
   private:
 
     DxvkDevice*             m_device;
@@ -288,6 +319,7 @@ namespace dxvk {
     VkMemoryPropertyFlags   m_memFlags;
     
     DxvkBufferHandle        m_buffer;
+    DxvkBufferHandle        m_retired;
     DxvkBufferSliceHandle   m_physSlice;
 
     uint32_t                m_vertexStride = 0;
@@ -306,6 +338,10 @@ namespace dxvk {
     DxvkBufferHandle allocBuffer(
             VkDeviceSize          sliceCount) const;
     
+    bool isRelocatable() const;
+    
+    void freeRetiredBuffer();
+    
   };
   
   
@@ -102,7 +102,14 @@ namespace dxvk {
     DxvkShaderModuleCreateInfo moduleInfo;
     moduleInfo.fsDualSrcBlend = false;
 
-    auto csm = m_cs->createShaderModule(m_vkd, m_slotMapping, moduleInfo);
+    bool cacheHit = false;
+
+    auto csm = m_cs->createShaderModule(m_vkd, m_slotMapping, moduleInfo, cacheHit);
+
+    if (cacheHit)
+      m_pipeMgr->m_numModuleCacheHits += 1;
+    else
+      m_pipeMgr->m_numModuleCacheMisses += 1;
 
     VkComputePipelineCreateInfo info;
     info.sType                = VK_STRUCTURE_TYPE_COMPUTE_PIPELINE_CREATE_INFO;
@@ -44,6 +44,10 @@ namespace dxvk {
     m_cmd = cmdList;
     m_cmd->beginRecording();
 
+    // Cached descriptor sets may reference resources
+    // that are not kept alive by the new command list
+    m_descCache.clear();
+
     // Mark all resources as untracked
     m_vbTracked.clear();
     m_rcTracked.clear();
@@ -1812,6 +1816,47 @@ namespace dxvk {
   }
   
   
+  void DxvkContext::relocateBuffer(
+    const Rc<DxvkBuffer>&           buffer) {
+    DxvkBufferSliceHandle dstSlice;
+
+    if (!buffer->relocate(dstSlice))
+      return;
+
+    this->spillRenderPass();
+
+    auto srcSlice = buffer->getSliceHandle();
+
+    if (m_execBarriers.isBufferDirty(srcSlice, DxvkAccess::Read))
+      m_execBarriers.recordCommands(m_cmd);
+
+    VkBufferCopy bufferRegion;
+    bufferRegion.srcOffset = srcSlice.offset;
+    bufferRegion.dstOffset = dstSlice.offset;
+    bufferRegion.size      = dstSlice.length;
+
+    m_cmd->cmdCopyBuffer(DxvkCmdBuffer::ExecBuffer,
+      srcSlice.handle, dstSlice.handle, 1, &bufferRegion);
+
+    m_execBarriers.accessBuffer(srcSlice,
+      VK_PIPELINE_STAGE_TRANSFER_BIT,
+      VK_ACCESS_TRANSFER_READ_BIT,
+      buffer->info().stages,
+      buffer->info().access);
+
+    m_execBarriers.accessBuffer(dstSlice,
+      VK_PIPELINE_STAGE_TRANSFER_BIT,
+      VK_ACCESS_TRANSFER_WRITE_BIT,
+      buffer->info().stages,
+      buffer->info().access);
+
+    // Freeing the old slice destroys the retired buffer
+    this->invalidateBuffer(buffer, dstSlice);
+
+    m_cmd->trackResource(buffer);
+  }
+
+
   void DxvkContext::resolveImage(
     const Rc<DxvkImage>&            dstImage,
     const Rc<DxvkImage>&            srcImage,
@@ -3524,11 +3569,24 @@ namespace dxvk {
         ? DxvkContextFlag::GpDynamicStencilRef
         : DxvkContextFlag::GpDirtyStencilRef);
       
-      // Retrieve and bind actual Vulkan pipeline handle
-      m_gpActivePipeline = m_state.gp.pipeline != nullptr && m_state.om.framebuffer != nullptr
-        ? m_state.gp.pipeline->getPipelineHandle(m_state.gp.state,
-            m_state.om.framebuffer->getRenderPass())
-        : VK_NULL_HANDLE;
+      // Retrieve and bind actual Vulkan pipeline handle. In async mode,
+      // draws are skipped until the pipeline is ready, so we need to
+      // check again on the next draw.
+      m_gpActivePipeline = VK_NULL_HANDLE;
+      m_flags.clr(DxvkContextFlag::GpPipelinePending);
+
+      if (m_state.gp.pipeline != nullptr && m_state.om.framebuffer != nullptr) {
+        if (m_device->config().enableAsyncPipelines) {
+          if (!m_state.gp.pipeline->tryGetPipelineHandle(m_state.gp.state,
+              m_state.om.framebuffer->getRenderPass(), m_gpActivePipeline)) {
+            m_flags.set(DxvkContextFlag::GpDirtyPipelineState,
+                        DxvkContextFlag::GpPipelinePending);
+          }
+        } else {
+          m_gpActivePipeline = m_state.gp.pipeline->getPipelineHandle(m_state.gp.state,
+            m_state.om.framebuffer->getRenderPass());
+        }
+      }
       
       if (m_gpActivePipeline != VK_NULL_HANDLE) {
         m_cmd->cmdBindPipeline(
@@ -3769,12 +3827,28 @@ namespace dxvk {
     VkDescriptorSet descriptorSet = VK_NULL_HANDLE;
 
     if (layout->bindingCount() != 0) {
-      descriptorSet = allocateDescriptorSet(
-        layout->descriptorSetLayout());
-      
-      m_cmd->updateDescriptorSetWithTemplate(
-        descriptorSet, layout->descriptorTemplate(),
-        m_descInfos.data());
+      VkDescriptorSetLayout setLayout = layout->descriptorSetLayout();
+
+      size_t hash = DxvkDescriptorSetCache::hash(setLayout,
+        layout->bindingCount(), m_descInfos.data());
+
+      descriptorSet = m_descCache.find(setLayout,
+        layout->bindingCount(), m_descInfos.data(), hash);
+
+      if (descriptorSet != VK_NULL_HANDLE) {
+        this->addStatCtr(DxvkStatCounter::DescriptorCacheHits, 1);
+      } else {
+        descriptorSet = allocateDescriptorSet(setLayout);
+        
+        m_cmd->updateDescriptorSetWithTemplate(
+          descriptorSet, layout->descriptorTemplate(),
+          m_descInfos.data());
+
+        m_descCache.insert(setLayout, layout->bindingCount(),
+          m_descInfos.data(), hash, descriptorSet);
+
+        this->addStatCtr(DxvkStatCounter::DescriptorCacheMisses, 1);
+      }
     }
 
     return descriptorSet;
@@ -4023,8 +4097,13 @@ namespace dxvk {
   
   
   bool DxvkContext::validateGraphicsState() {
-    return m_gpActivePipeline != VK_NULL_HANDLE
-        && m_flags.test(DxvkContextFlag::GpRenderPassBound);
+    if (m_gpActivePipeline == VK_NULL_HANDLE) {
+      if (m_flags.test(DxvkContextFlag::GpPipelinePending))
+        m_cmd->addStatCtr(DxvkStatCounter::CmdDrawsSkipped, 1);
+      return false;
+    }
+
+    return m_flags.test(DxvkContextFlag::GpRenderPassBound);
   }
   
   
@@ -4285,6 +4364,7 @@ namespace dxvk {
 
     if (set == VK_NULL_HANDLE) {
       m_cmd->trackDescriptorPool(std::move(m_descPool));
+      m_descCache.clear();
 
       m_descPool = m_device->createDescriptorPool();
       set = m_descPool->alloc(layout);
@@ -680,6 +680,22 @@ namespace dxvk {
             uint32_t                  size,
       const void*                     data);
     
+    /**
+     * \brief Moves a buffer to new memory
+     * 
+     * Allocates new backing storage for the buffer,
+     * copies the current contents and renames the
+     * buffer. The old backing storage is destroyed
+     * once the GPU is done using it. Does nothing
+     * if the buffer cannot be relocated.
+     * 
+     * \warning If the buffer is used by another context,
+     * relocating it will result in undefined behaviour.
+     * \param [in] buffer The buffer to relocate
+     */
+    void relocateBuffer(
+      const Rc<DxvkBuffer>&           buffer);
+    
     /**
      * \brief Resolves a multisampled image resource
      * 
@@ -991,6 +1007,21 @@ namespace dxvk {
      */
     void trimStagingBuffers();
     
+    /**
+     * \brief Increments a stat counter
+     * 
+     * Allows client APIs to report statistics that
+     * are tracked outside of the context, such as
+     * the amount of data uploaded by the frontend.
+     * \param [in] ctr Counter to increment
+     * \param [in] val Number to add to counter value
+     */
+    void addStatCtr(
+            DxvkStatCounter       ctr,
+            uint32_t              val) {
+      m_cmd->addStatCtr(ctr, val);
+    }
+    
   private:
     
     const Rc<DxvkDevice>              m_device;
@@ -1004,6 +1035,7 @@ namespace dxvk {
     
     Rc<DxvkCommandList>     m_cmd;
     Rc<DxvkDescriptorPool>  m_descPool;
+    DxvkDescriptorSetCache  m_descCache;
 
     DxvkContextFlags        m_flags;
     DxvkContextState        m_state;
@@ -28,6 +28,7 @@ namespace dxvk {
     GpDirtyFramebuffer,         ///< Framebuffer binding is out of date
     GpDirtyPipeline,            ///< Graphics pipeline binding is out of date
     GpDirtyPipelineState,       ///< Graphics pipeline needs to be recompiled
+    GpPipelinePending,          ///< Graphics pipeline is being compiled in the background
     GpDirtyResources,           ///< Graphics pipeline resource bindings are out of date
     GpDirtyDescriptorOffsets,   ///< Graphics descriptor set needs to be rebound
     GpDirtyDescriptorSet,       ///< Graphics descriptor set needs to be updated
@@ -104,31 +104,38 @@ namespace dxvk {
   
   
   DxvkCsThread::~DxvkCsThread() {
-    { std::unique_lock<std::mutex> lock(m_mutex);
-      m_stopped.store(true);
-    }
-    
-    m_condOnAdd.notify_one();
+    m_stopped.store(true);
+    m_chunksQueued.stop();
     m_thread.join();
   }
   
   
   void DxvkCsThread::dispatchChunk(DxvkCsChunkRef&& chunk) {
-    { std::unique_lock<std::mutex> lock(m_mutex);
-      m_chunksQueued.push(std::move(chunk));
-      m_chunksPending += 1;
-    }
-    
-    m_condOnAdd.notify_one();
+    m_chunksPending += 1;
+    m_chunksQueued.push(std::move(chunk));
   }
   
   
   void DxvkCsThread::synchronize() {
+    // Most synchronization points only have to wait
+    // for a short amount of time, so spin for a bit
+    // before going to sleep
+    for (uint32_t i = 0; i < SyncSpinCount; i++) {
+      if (!m_chunksPending.load())
+        return;
+
+      if (i >= SyncSpinCount / 2)
+        dxvk::this_thread::yield();
+    }
+
     std::unique_lock<std::mutex> lock(m_mutex);
+    m_syncWaiting.store(true);
     
     m_condOnSync.wait(lock, [this] {
-      return m_chunksPending == 0;
+      return !m_chunksPending.load();
     });
+
+    m_syncWaiting.store(false);
   }
   
   
@@ -137,30 +144,17 @@ namespace dxvk {
 
     DxvkCsChunkRef chunk;
     
-    while (!m_stopped.load()) {
-      { std::unique_lock<std::mutex> lock(m_mutex);
-        if (chunk) {
-          if (--m_chunksPending == 0)
-            m_condOnSync.notify_one();
-          
-          chunk = DxvkCsChunkRef();
-        }
-        
-        if (m_chunksQueued.size() == 0) {
-          m_condOnAdd.wait(lock, [this] {
-            return (m_chunksQueued.size() != 0)
-                || (m_stopped.load());
-          });
-        }
-        
-        if (m_chunksQueued.size() != 0) {
-          chunk = std::move(m_chunksQueued.front());
-          m_chunksQueued.pop();
-        }
+    while (!m_stopped.load() && m_chunksQueued.pop(chunk)) {
+      chunk->executeAll(m_context.ptr());
+      chunk = DxvkCsChunkRef();
+
+      // Pairs with the store in synchronize(), so that
+      // either the waiting thread sees the new count or
+      // we see that it is waiting
+      if (!(--m_chunksPending) && m_syncWaiting.load()) {
+        { std::lock_guard<std::mutex> lock(m_mutex); }
+        m_condOnSync.notify_one();
       }
-      
-      if (chunk)
-        chunk->executeAll(m_context.ptr());
     }
   }
   
@@ -6,6 +6,7 @@
 #include <queue>
 
 #include "../util/thread.h"
+#include "../util/sync/sync_spsc.h"
 #include "dxvk_context.h"
 
 namespace dxvk {
@@ -352,6 +353,10 @@ namespace dxvk {
     DxvkCsChunk* operator -> () const {
       return m_chunk;
     }
+
+    DxvkCsChunk* ptr() const {
+      return m_chunk;
+    }
     
     operator bool () const {
       return m_chunk != nullptr;
@@ -379,10 +384,14 @@ namespace dxvk {
    * \brief Command stream thread
    * 
    * Spawns a thread that will execute
-   * commands on a DXVK context. 
+   * commands on a DXVK context. Chunks are
+   * handed over through a lock-free queue,
+   * so only one thread at a time may call
+   * \ref dispatchChunk or \ref synchronize.
    */
   class DxvkCsThread {
-    
+    constexpr static uint32_t MaxQueuedChunks = 256;
+    constexpr static uint32_t SyncSpinCount   = 2000;
   public:
     
     DxvkCsThread(const Rc<DxvkContext>& context);
@@ -406,20 +415,35 @@ namespace dxvk {
      * \ref flush.
      */
     void synchronize();
+
+    /**
+     * \brief Number of pending chunks
+     *
+     * Chunks that have been dispatched, but
+     * not yet fully executed by the thread.
+     * \returns Pending chunk count
+     */
+    uint32_t pendingChunks() const {
+      return m_chunksPending.load();
+    }
     
   private:
     
     const Rc<DxvkContext>       m_context;
     
     std::atomic<bool>           m_stopped = { false };
+    std::atomic<bool>           m_syncWaiting = { false };
+    std::atomic<uint32_t>       m_chunksPending = { 0u };
+
     std::mutex                  m_mutex;
-    std::condition_variable     m_condOnAdd;
     std::condition_variable     m_condOnSync;
-    std::queue<DxvkCsChunkRef>  m_chunksQueued;
+
+    sync::SpscQueue<
+      DxvkCsChunkRef,
+      MaxQueuedChunks>          m_chunksQueued;
+
     dxvk::thread                m_thread;
     
-    uint32_t                    m_chunksPending = 0;
-    
     void threadFunc();
     
   };
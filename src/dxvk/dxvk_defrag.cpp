@@ -0,0 +1,87 @@
+#include "dxvk_defrag.h"
+
+namespace dxvk {
+
+  DxvkDefragmenter::DxvkDefragmenter(DxvkMemoryAllocator* memAlloc)
+  : m_memAlloc(memAlloc),
+    m_thread([this] () { runWorker(); }) {
+    Logger::info("DXVK: Memory defragmentation enabled");
+  }
+
+
+  DxvkDefragmenter::~DxvkDefragmenter() {
+    { std::lock_guard<std::mutex> lock(m_mutex);
+      m_stopped = true;
+    }
+
+    m_cond.notify_one();
+    m_thread.join();
+
+    // Releasing the buffers may unregister them
+    std::vector<Rc<DxvkBuffer>> queue = std::move(m_queue);
+  }
+
+
+  void DxvkDefragmenter::registerBuffer(DxvkBuffer* buffer) {
+    std::lock_guard<std::mutex> lock(m_mutex);
+    m_buffers.insert(buffer);
+  }
+
+
+  void DxvkDefragmenter::unregisterBuffer(DxvkBuffer* buffer) {
+    std::lock_guard<std::mutex> lock(m_mutex);
+    m_buffers.erase(buffer);
+  }
+
+
+  std::vector<Rc<DxvkBuffer>> DxvkDefragmenter::takeRelocations() {
+    // Limit the amount of data copied per flush
+    constexpr VkDeviceSize MaxRelocationSize = 16 << 20;
+
+    std::lock_guard<std::mutex> lock(m_mutex);
+
+    std::vector<Rc<DxvkBuffer>> buffers;
+    VkDeviceSize size = 0;
+
+    while (!m_queue.empty() && size < MaxRelocationSize) {
+      size += m_queue.back()->info().size;
+      buffers.push_back(std::move(m_queue.back()));
+      m_queue.pop_back();
+    }
+
+    return buffers;
+  }
+
+
+  void DxvkDefragmenter::runWorker() {
+    env::setThreadName("dxvk-defrag");
+
+    std::unique_lock<std::mutex> lock(m_mutex);
+
+    while (!m_stopped) {
+      m_cond.wait_for(lock, std::chrono::seconds(1),
+        [this] { return m_stopped; });
+
+      if (m_stopped || !m_queue.empty())
+        continue;
+
+      lock.unlock();
+      bool evacuating = m_memAlloc->selectEvacuatedChunks();
+      lock.lock();
+
+      if (!evacuating)
+        continue;
+
+      // Buffers are only guaranteed to stay alive while
+      // the lock is held, and their reference count may
+      // already have dropped to zero at this point.
+      for (DxvkBuffer* buffer : m_buffers) {
+        if (buffer->needsRelocation() && buffer->tryIncRef()) {
+          m_queue.push_back(buffer);
+          buffer->decRef();
+        }
+      }
+    }
+  }
+
+}
@@ -0,0 +1,90 @@
+#pragma once
+
+#include <condition_variable>
+#include <mutex>
+#include <unordered_set>
+#include <vector>
+
+#include "dxvk_buffer.h"
+
+#include "../util/thread.h"
+
+namespace dxvk {
+
+  /**
+   * \brief Memory defragmenter
+   *
+   * Periodically looks for sparsely used memory chunks on
+   * device-local memory types and marks them for evacuation,
+   * so that they are no longer used for new allocations and
+   * get freed once they are empty. Buffers residing in those
+   * chunks are queued up for relocation, which is performed
+   * by the context that executes the application's commands
+   * through the regular buffer renaming mechanism.
+   *
+   * Images cannot be relocated since image views reference
+   * the Vulkan image directly, so chunks containing images
+   * will only be freed once those images get destroyed.
+   */
+  class DxvkDefragmenter : public RcObject {
+
+  public:
+
+    DxvkDefragmenter(DxvkMemoryAllocator* memAlloc);
+
+    ~DxvkDefragmenter();
+
+    /**
+     * \brief Registers a buffer
+     *
+     * Called by buffers which can be relocated
+     * when they get created. Buffers must not be
+     * used by the defragmenter before they are
+     * owned by at least one reference.
+     * \param [in] buffer The buffer
+     */
+    void registerBuffer(DxvkBuffer* buffer);
+
+    /**
+     * \brief Unregisters a buffer
+     *
+     * Must be called before the buffer
+     * releases any of its resources.
+     * \param [in] buffer The buffer
+     */
+    void unregisterBuffer(DxvkBuffer* buffer);
+
+    /**
+     * \brief Takes a batch of queued buffers
+     *
+     * Returns up to a fixed amount of data per call in order
+     * to not stall the GPU for too long. Must be called on the
+     * thread that emits the relocation commands, after all
+     * pending resource initialization work has been submitted,
+     * since relocating a buffer retires the Vulkan buffer that
+     * any previously recorded commands may still write to. The
+     * returned buffers must be passed to the context's
+     * \c relocateBuffer method on the context that records
+     * all of the application's commands.
+     * \returns Buffers to relocate
+     */
+    std::vector<Rc<DxvkBuffer>> takeRelocations();
+
+  private:
+
+    DxvkMemoryAllocator*              m_memAlloc;
+
+    std::mutex                        m_mutex;
+    std::condition_variable           m_cond;
+    bool                              m_stopped = false;
+
+    std::unordered_set<DxvkBuffer*>   m_buffers;
+    std::vector<Rc<DxvkBuffer>>       m_queue;
+
+    dxvk::thread                      m_thread;
+
+    void runWorker();
+
+  };
+
+}
@@ -61,6 +61,79 @@ namespace dxvk {
 
 
 
+  DxvkDescriptorSetCache::DxvkDescriptorSetCache() {
+
+  }
+
+
+  DxvkDescriptorSetCache::~DxvkDescriptorSetCache() {
+
+  }
+
+
+  size_t DxvkDescriptorSetCache::hash(
+          VkDescriptorSetLayout layout,
+          uint32_t              count,
+    const DxvkDescriptorInfo*   infos) {
+    DxvkHashState result;
+    result.add(std::hash<VkDescriptorSetLayout>()(layout));
+
+    // Descriptor infos may contain stale data in unused
+    // bytes, this only affects the hit rate of the cache
+    auto words = reinterpret_cast<const uint64_t*>(infos);
+    size_t wordCount = count * sizeof(DxvkDescriptorInfo) / sizeof(uint64_t);
+
+    for (size_t i = 0; i < wordCount; i++)
+      result.add(std::hash<uint64_t>()(words[i]));
+
+    return result;
+  }
+
+
+  VkDescriptorSet DxvkDescriptorSetCache::find(
+          VkDescriptorSetLayout layout,
+          uint32_t              count,
+    const DxvkDescriptorInfo*   infos,
+          size_t                hash) const {
+    auto range = m_sets.equal_range(hash);
+
+    for (auto i = range.first; i != range.second; i++) {
+      const Entry& entry = i->second;
+
+      if (entry.layout == layout && entry.count == count
+       && !std::memcmp(&m_infos[entry.index], infos, count * sizeof(DxvkDescriptorInfo)))
+        return entry.set;
+    }
+
+    return VK_NULL_HANDLE;
+  }
+
+
+  void DxvkDescriptorSetCache::insert(
+          VkDescriptorSetLayout layout,
+          uint32_t              count,
+    const DxvkDescriptorInfo*   infos,
+          size_t                hash,
+          VkDescriptorSet       set) {
+    Entry entry;
+    entry.layout = layout;
+    entry.set    = set;
+    entry.count  = count;
+    entry.index  = m_infos.size();
+
+    m_infos.insert(m_infos.end(), infos, infos + count);
+    m_sets.insert({ hash, entry });
+  }
+
+
+  void DxvkDescriptorSetCache::clear() {
+    m_sets.clear();
+    m_infos.clear();
+  }
+
+
+
+
   DxvkDescriptorPoolTracker::DxvkDescriptorPoolTracker(DxvkDevice* device)
   : m_device(device) {
 
@@ -1,7 +1,9 @@
 #pragma once
 
+#include <unordered_map>
 #include <vector>
 
+#include "dxvk_hash.h"
 #include "dxvk_include.h"
 
 namespace dxvk {
@@ -60,6 +62,91 @@ namespace dxvk {
   };
 
 
+  /**
+   * \brief Descriptor set cache
+   * 
+   * Maps the contents of a descriptor set to a set that
+   * has already been written with those contents, so that
+   * repeatedly used combinations of resources do not need
+   * a new descriptor set every time. Cached sets are only
+   * valid as long as the pool they were allocated from has
+   * not been reset, and as long as the resources that they
+   * reference are kept alive by the command list, so the
+   * cache must be cleared whenever either one changes.
+   */
+  class DxvkDescriptorSetCache {
+
+  public:
+
+    DxvkDescriptorSetCache();
+    ~DxvkDescriptorSetCache();
+
+    /**
+     * \brief Computes hash of descriptor set contents
+     * 
+     * \param [in] layout Descriptor set layout
+     * \param [in] count Number of descriptors
+     * \param [in] infos Descriptor infos
+     * \returns Hash of the descriptor set contents
+     */
+    static size_t hash(
+            VkDescriptorSetLayout layout,
+            uint32_t              count,
+      const DxvkDescriptorInfo*   infos);
+
+    /**
+     * \brief Looks up a descriptor set
+     * 
+     * \param [in] layout Descriptor set layout
+     * \param [in] count Number of descriptors
+     * \param [in] infos Descriptor infos
+     * \param [in] hash Hash of the contents
+     * \returns Matching descriptor set, or
+     *    \c VK_NULL_HANDLE if none was found
+     */
+    VkDescriptorSet find(
+            VkDescriptorSetLayout layout,
+            uint32_t              count,
+      const DxvkDescriptorInfo*   infos,
+            size_t                hash) const;
+
+    /**
+     * \brief Adds a descriptor set
+     * 
+     * \param [in] layout Descriptor set layout
+     * \param [in] count Number of descriptors
+     * \param [in] infos Descriptor infos
+     * \param [in] hash Hash of the contents
+     * \param [in] set Descriptor set that has
+     *    been written with the given infos
+     */
+    void insert(
+            VkDescriptorSetLayout layout,
+            uint32_t              count,
+      const DxvkDescriptorInfo*   infos,
+            size_t                hash,
+            VkDescriptorSet       set);
+
+    /**
+     * \brief Removes all descriptor sets
+     */
+    void clear();
+
+  private:
+
+    struct Entry {
+      VkDescriptorSetLayout layout;
+      VkDescriptorSet       set;
+      uint32_t              count;
+      size_t                index;
+    };
+
+    std::unordered_multimap<size_t, Entry> m_sets;
+    std::vector<DxvkDescriptorInfo>        m_infos;
+
+  };
+
+
   /**
    * \brief Descriptor pool tracker
    * 
@@ -31,6 +31,14 @@ namespace dxvk {
     auto queueFamilies = m_adapter->findQueueFamilies();
     m_queues.graphics = getQueue(queueFamilies.graphics, 0);
     m_queues.transfer = getQueue(queueFamilies.transfer, 0);
+
+    std::string useShaderCache = env::getEnvVar("DXVK_SHADER_CACHE");
+
+    if (useShaderCache != "0" && m_options.enableShaderCache)
+      m_shaderCache = new DxvkShaderCache(this);
+
+    if (m_options.enableMemoryDefrag)
+      m_defrag = new DxvkDefragmenter(m_memory.ptr());
   }
   
   
@@ -179,14 +187,21 @@ namespace dxvk {
   DxvkStatCounters DxvkDevice::getStatCounters() {
     DxvkMemoryStats mem = m_memory->getMemoryStats();
     DxvkPipelineCount pipe = m_pipelineManager->getPipelineCount();
+    DxvkShaderModuleStats modules = m_pipelineManager->getShaderModuleStats();
     
     DxvkStatCounters result;
     result.setCtr(DxvkStatCounter::MemoryAllocated,   mem.memoryAllocated);
     result.setCtr(DxvkStatCounter::MemoryUsed,        mem.memoryUsed);
+    result.setCtr(DxvkStatCounter::MemoryFragmented,  mem.memoryFragmented);
+    result.setCtr(DxvkStatCounter::MemoryReclaimed,   mem.memoryReclaimed);
     result.setCtr(DxvkStatCounter::PipeCountGraphics, pipe.numGraphicsPipelines);
     result.setCtr(DxvkStatCounter::PipeCountCompute,  pipe.numComputePipelines);
     result.setCtr(DxvkStatCounter::PipeCompilerBusy,  m_pipelineManager->isCompilingShaders());
+    result.setCtr(DxvkStatCounter::PipeStallTime,     m_pipelineManager->getStallTime());
     result.setCtr(DxvkStatCounter::SamplerCount,      m_numSamplers.load());
+    result.setCtr(DxvkStatCounter::GpuIdleTime,       m_submissionQueue.gpuIdleTime());
+    result.setCtr(DxvkStatCounter::ShaderModuleCacheHits,   modules.numCacheHits);
+    result.setCtr(DxvkStatCounter::ShaderModuleCacheMisses, modules.numCacheMisses);
 
     std::lock_guard<sync::Spinlock> lock(m_statLock);
     result.merge(m_statCounters);
@@ -194,6 +209,24 @@ namespace dxvk {
   }
 
 
+  void DxvkDevice::addStatCtr(DxvkStatCounter ctr, uint64_t val) {
+    std::lock_guard<sync::Spinlock> lock(m_statLock);
+    m_statCounters.addCtr(ctr, val);
+  }
+
+
+  void DxvkDevice::subStatCtr(DxvkStatCounter ctr, uint64_t val) {
+    std::lock_guard<sync::Spinlock> lock(m_statLock);
+    m_statCounters.subCtr(ctr, val);
+  }
+
+
+  void DxvkDevice::setStatCtr(DxvkStatCounter ctr, uint64_t val) {
+    std::lock_guard<sync::Spinlock> lock(m_statLock);
+    m_statCounters.setCtr(ctr, val);
+  }
+
+
   uint32_t DxvkDevice::getCurrentFrameId() const {
     return m_statCounters.getCtr(DxvkStatCounter::QueuePresentCount);
   }
@@ -5,6 +5,7 @@
 #include "dxvk_compute.h"
 #include "dxvk_constant_state.h"
 #include "dxvk_context.h"
+#include "dxvk_defrag.h"
 #include "dxvk_extensions.h"
 #include "dxvk_framebuffer.h"
 #include "dxvk_image.h"
@@ -18,6 +19,7 @@
 #include "dxvk_renderpass.h"
 #include "dxvk_sampler.h"
 #include "dxvk_shader.h"
+#include "dxvk_shader_cache.h"
 #include "dxvk_stats.h"
 #include "dxvk_unbound.h"
 
@@ -110,6 +112,16 @@ namespace dxvk {
       return m_options;
     }
     
+    /**
+     * \brief Memory defragmenter
+     * 
+     * Only available if enabled by the user.
+     * \returns Defragmenter, or \c nullptr
+     */
+    DxvkDefragmenter* defragmenter() const {
+      return m_defrag.ptr();
+    }
+    
     /**
      * \brief Queue handles
      * 
@@ -303,6 +315,47 @@ namespace dxvk {
      */
     DxvkStatCounters getStatCounters();
 
+    /**
+     * \brief Retrieves the shader cache
+     * 
+     * \returns The on-disk shader cache, or
+     *    \c nullptr if it is disabled
+     */
+    Rc<DxvkShaderCache> getShaderCache() const {
+      return m_shaderCache;
+    }
+
+    /**
+     * \brief Increments a stat counter
+     *
+     * Used to report statistics that are not
+     * tied to any command list, e.g. work done
+     * by front-end worker threads.
+     * \param [in] ctr The counter to increment
+     * \param [in] val The value to add
+     */
+    void addStatCtr(DxvkStatCounter ctr, uint64_t val);
+
+    /**
+     * \brief Decrements a stat counter
+     *
+     * Used together with \ref addStatCtr for values
+     * that are shared by multiple front-end objects.
+     * \param [in] ctr The counter to decrement
+     * \param [in] val The value to subtract
+     */
+    void subStatCtr(DxvkStatCounter ctr, uint64_t val);
+
+    /**
+     * \brief Sets a stat counter
+     *
+     * Used to report absolute values, such as the
+     * amount of memory held by front-end pools.
+     * \param [in] ctr The counter to set
+     * \param [in] val The new value
+     */
+    void setStatCtr(DxvkStatCounter ctr, uint64_t val);
+
     /**
      * \brief Retreves current frame ID
      * \returns Current frame ID
@@ -384,6 +437,15 @@ namespace dxvk {
     uint32_t pendingSubmissions() const {
       return m_submissionQueue.pendingSubmissions();
     }
+
+    /**
+     * \brief Total GPU idle time
+     * \returns Time during which no command lists
+     *    were pending, in microseconds
+     */
+    uint64_t gpuIdleTime() const {
+      return m_submissionQueue.gpuIdleTime();
+    }
     
     /**
      * \brief Waits until the device becomes idle
@@ -408,8 +470,10 @@ namespace dxvk {
     VkPhysicalDeviceProperties  m_properties;
     
     Rc<DxvkMemoryAllocator>     m_memory;
+    Rc<DxvkDefragmenter>        m_defrag;
     Rc<DxvkRenderPassPool>      m_renderPassPool;
     Rc<DxvkPipelineManager>     m_pipelineManager;
+    Rc<DxvkShaderCache>         m_shaderCache;
 
     Rc<DxvkGpuEventPool>        m_gpuEventPool;
     Rc<DxvkGpuQueryPool>        m_gpuQueryPool;
@@ -103,24 +103,155 @@ namespace dxvk {
     const DxvkRenderPass&                renderPass) {
     VkRenderPass renderPassHandle = renderPass.getDefaultHandle();
     
-    VkPipeline newPipelineHandle = VK_NULL_HANDLE;
-
     { std::lock_guard<sync::Spinlock> lock(m_mutex);
     
       auto instance = this->findInstance(state, renderPassHandle);
       
       if (instance != nullptr)
         return instance->pipeline();
+    }
     
+    // The calling thread cannot continue until the pipeline
+    // is ready, so any queued up variants of this pipeline
+    // should be compiled before speculative state cache work.
+    auto t0 = std::chrono::high_resolution_clock::now();
+
+    if (m_pipeMgr->m_workers != nullptr)
+      m_pipeMgr->m_workers->prioritize(this);
+    
+    VkPipeline newPipelineHandle = this->createInstance(state, renderPass, true);
+    
+    auto t1 = std::chrono::high_resolution_clock::now();
+    auto us = std::chrono::duration_cast<std::chrono::microseconds>(t1 - t0);
+    m_pipeMgr->m_stallTime += us.count();
+    return newPipelineHandle;
+  }
+  
+  
+  bool DxvkGraphicsPipeline::tryGetPipelineHandle(
+    const DxvkGraphicsPipelineStateInfo& state,
+    const DxvkRenderPass&                renderPass,
+          VkPipeline&                    pipeline) {
+    VkRenderPass renderPassHandle = renderPass.getDefaultHandle();
+    
+    pipeline = VK_NULL_HANDLE;
+    
+    { std::lock_guard<sync::Spinlock> lock(m_mutex);
+    
+      auto instance = this->findInstance(state, renderPassHandle);
+      
+      if (instance != nullptr) {
+        pipeline = instance->pipeline();
+        return true;
+      }
+      
+      if (hasInstance(m_pending, state, renderPassHandle)
+       || hasInstance(m_queued,  state, renderPassHandle))
+        return false;
+      
+      // Invalid pipelines will never become ready
+      if (!this->validatePipelineState(state))
+        return true;
+      
+      m_queued.emplace_back(state, renderPassHandle, VkPipeline(VK_NULL_HANDLE));
+    }
+    
+    m_pipeMgr->m_workers->compileGraphicsPipeline(this, state,
+      m_pipeMgr->m_passManager->getRenderPass(renderPass.format()),
+      DxvkPipelinePriority::High);
+    return false;
+  }
+  
+  
+  void DxvkGraphicsPipeline::compilePipeline(
+    const DxvkGraphicsPipelineStateInfo& state,
+    const DxvkRenderPass&                renderPass) {
+    this->createInstance(state, renderPass, false);
+  }
+  
+  
+  const DxvkGraphicsPipelineInstance* DxvkGraphicsPipeline::findInstance(
+    const DxvkGraphicsPipelineStateInfo& state,
+          VkRenderPass                   renderPass) const {
+    for (const auto& instance : m_pipelines) {
+      if (instance.isCompatible(state, renderPass))
+        return &instance;
+    }
+    
+    return nullptr;
+  }
+  
+  
+  bool DxvkGraphicsPipeline::hasInstance(
+    const std::vector<DxvkGraphicsPipelineInstance>& list,
+    const DxvkGraphicsPipelineStateInfo& state,
+          VkRenderPass                   renderPass) {
+    for (const auto& instance : list) {
+      if (instance.isCompatible(state, renderPass))
+        return true;
+    }
+    
+    return false;
+  }
+  
+  
+  void DxvkGraphicsPipeline::removeInstance(
+          std::vector<DxvkGraphicsPipelineInstance>& list,
+    const DxvkGraphicsPipelineStateInfo& state,
+          VkRenderPass                   renderPass) {
+    for (auto i = list.begin(); i != list.end(); i++) {
+      if (i->isCompatible(state, renderPass)) {
+        list.erase(i);
+        return;
+      }
+    }
+  }
+  
+  
+  VkPipeline DxvkGraphicsPipeline::createInstance(
+    const DxvkGraphicsPipelineStateInfo& state,
+    const DxvkRenderPass&                renderPass,
+          bool                           wait) {
+    VkRenderPass renderPassHandle = renderPass.getDefaultHandle();
+    VkPipeline   baseHandle       = VK_NULL_HANDLE;
+    
+    { std::unique_lock<sync::Spinlock> lock(m_mutex);
+      removeInstance(m_queued, state, renderPassHandle);
+      
+      // If another thread is already compiling the same
+      // pipeline, wait for it rather than compiling it
+      // twice. The lock must not be held while compiling.
+      if (hasInstance(m_pending, state, renderPassHandle)) {
+        if (!wait)
+          return VK_NULL_HANDLE;
+        
+        m_pendingCond.wait(lock, [&] {
+          return !hasInstance(m_pending, state, renderPassHandle);
+        });
+      }
+      
+      auto instance = this->findInstance(state, renderPassHandle);
+      
+      if (instance != nullptr)
+        return instance->pipeline();
+      
       // If the pipeline state vector is invalid, don't try
       // to create a new pipeline, it won't work anyway.
       if (!this->validatePipelineState(state))
         return VK_NULL_HANDLE;
       
-      // If no pipeline instance exists with the given state
-      // vector, create a new one and add it to the list.
-      newPipelineHandle = this->compilePipeline(state, renderPass, m_basePipeline);
-
+      m_pending.emplace_back(state, renderPassHandle, VkPipeline(VK_NULL_HANDLE));
+      baseHandle = m_basePipeline;
+    }
+    
+    // If no pipeline instance exists with the given state
+    // vector, create a new one and add it to the list.
+    VkPipeline newPipelineHandle = this->createPipeline(state, renderPass, baseHandle);
+    
+    { std::lock_guard<sync::Spinlock> lock(m_mutex);
+      
+      removeInstance(m_pending, state, renderPassHandle);
+      
       // Add new pipeline to the set
       m_pipelines.emplace_back(state, renderPassHandle, newPipelineHandle);
       m_pipeMgr->m_numGraphicsPipelines += 1;
@@ -129,6 +260,8 @@ namespace dxvk {
         m_basePipeline = newPipelineHandle;
     }
     
+    m_pendingCond.notify_all();
+    
     if (newPipelineHandle != VK_NULL_HANDLE)
       this->writePipelineStateToCache(state, renderPass.format());
     
@@ -136,19 +269,7 @@ namespace dxvk {
   }
   
   
-  const DxvkGraphicsPipelineInstance* DxvkGraphicsPipeline::findInstance(
-    const DxvkGraphicsPipelineStateInfo& state,
-          VkRenderPass                   renderPass) const {
-    for (const auto& instance : m_pipelines) {
-      if (instance.isCompatible(state, renderPass))
-        return &instance;
-    }
-    
-    return nullptr;
-  }
-  
-  
-  VkPipeline DxvkGraphicsPipeline::compilePipeline(
+  VkPipeline DxvkGraphicsPipeline::createPipeline(
     const DxvkGraphicsPipelineStateInfo& state,
     const DxvkRenderPass&                renderPass,
           VkPipeline                     baseHandle) const {
@@ -463,9 +584,20 @@ namespace dxvk {
   DxvkShaderModule DxvkGraphicsPipeline::createShaderModule(
     const Rc<DxvkShader>&                shader,
     const DxvkShaderModuleCreateInfo&    info) const {
-    return shader != nullptr
-      ? shader->createShaderModule(m_vkd, m_slotMapping, info)
-      : DxvkShaderModule();
+    if (shader == nullptr)
+      return DxvkShaderModule();
+    
+    bool cacheHit = false;
+    
+    DxvkShaderModule result = shader->createShaderModule(
+      m_vkd, m_slotMapping, info, cacheHit);
+    
+    if (cacheHit)
+      m_pipeMgr->m_numModuleCacheHits += 1;
+    else
+      m_pipeMgr->m_numModuleCacheMisses += 1;
+    
+    return result;
   }
 
 
@@ -1,5 +1,6 @@
 #pragma once
 
+#include <condition_variable>
 #include <mutex>
 
 #include "dxvk_bind_mask.h"
@@ -240,6 +241,35 @@ namespace dxvk {
       const DxvkGraphicsPipelineStateInfo&    state,
       const DxvkRenderPass&                   renderPass);
     
+    /**
+     * \brief Pipeline handle, without stalling
+     * 
+     * If the pipeline does not exist yet, it will be
+     * queued for compilation on a worker thread with
+     * high priority, and no handle will be returned.
+     * \param [in] state Pipeline state vector
+     * \param [in] renderPass The render pass
+     * \param [out] pipeline Pipeline handle
+     * \returns \c false if the pipeline is not ready yet
+     */
+    bool tryGetPipelineHandle(
+      const DxvkGraphicsPipelineStateInfo&    state,
+      const DxvkRenderPass&                   renderPass,
+            VkPipeline&                       pipeline);
+    
+    /**
+     * \brief Compiles a pipeline
+     * 
+     * Used by background workers. Does nothing if
+     * the pipeline already exists or is currently
+     * being compiled by another thread.
+     * \param [in] state Pipeline state vector
+     * \param [in] renderPass The render pass
+     */
+    void compilePipeline(
+      const DxvkGraphicsPipelineStateInfo&    state,
+      const DxvkRenderPass&                   renderPass);
+    
   private:
     
     struct PipelineStruct {
@@ -270,6 +300,13 @@ namespace dxvk {
     alignas(CACHE_LINE_SIZE) sync::Spinlock   m_mutex;
     std::vector<DxvkGraphicsPipelineInstance> m_pipelines;
     
+    // Instances that are currently being compiled
+    std::vector<DxvkGraphicsPipelineInstance> m_pending;
+    std::condition_variable_any               m_pendingCond;
+    
+    // Instances queued up for background compilation
+    std::vector<DxvkGraphicsPipelineInstance> m_queued;
+    
     // Pipeline handles used for derivative pipelines
     VkPipeline m_basePipeline = VK_NULL_HANDLE;
     
@@ -277,7 +314,22 @@ namespace dxvk {
       const DxvkGraphicsPipelineStateInfo& state,
             VkRenderPass                   renderPass) const;
     
-    VkPipeline compilePipeline(
+    static bool hasInstance(
+      const std::vector<DxvkGraphicsPipelineInstance>& list,
+      const DxvkGraphicsPipelineStateInfo& state,
+            VkRenderPass                   renderPass);
+    
+    static void removeInstance(
+            std::vector<DxvkGraphicsPipelineInstance>& list,
+      const DxvkGraphicsPipelineStateInfo& state,
+            VkRenderPass                   renderPass);
+    
+    VkPipeline createInstance(
+      const DxvkGraphicsPipelineStateInfo& state,
+      const DxvkRenderPass&                renderPass,
+            bool                           wait);
+    
+    VkPipeline createPipeline(
       const DxvkGraphicsPipelineStateInfo& state,
       const DxvkRenderPass&                renderPass,
             VkPipeline                     baseHandle) const;
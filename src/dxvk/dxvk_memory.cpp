@@ -11,14 +11,16 @@ namespace dxvk {
           VkDeviceMemory        memory,
           VkDeviceSize          offset,
           VkDeviceSize          length,
-          void*                 mapPtr)
+          void*                 mapPtr,
+          uint32_t              block)
   : m_alloc   (alloc),
     m_chunk   (chunk),
     m_type    (type),
     m_memory  (memory),
     m_offset  (offset),
     m_length  (length),
-    m_mapPtr  (mapPtr) { }
+    m_mapPtr  (mapPtr),
+    m_block   (block) { }
   
   
   DxvkMemory::DxvkMemory(DxvkMemory&& other)
@@ -28,7 +30,8 @@ namespace dxvk {
     m_memory  (std::exchange(other.m_memory, VkDeviceMemory(VK_NULL_HANDLE))),
     m_offset  (std::exchange(other.m_offset, 0)),
     m_length  (std::exchange(other.m_length, 0)),
-    m_mapPtr  (std::exchange(other.m_mapPtr, nullptr)) { }
+    m_mapPtr  (std::exchange(other.m_mapPtr, nullptr)),
+    m_block   (std::exchange(other.m_block,  DxvkTlsfAllocator::InvalidBlock)) { }
   
   
   DxvkMemory& DxvkMemory::operator = (DxvkMemory&& other) {
@@ -40,6 +43,7 @@ namespace dxvk {
     m_offset  = std::exchange(other.m_offset, 0);
     m_length  = std::exchange(other.m_length, 0);
     m_mapPtr  = std::exchange(other.m_mapPtr, nullptr);
+    m_block   = std::exchange(other.m_block,  DxvkTlsfAllocator::InvalidBlock);
     return *this;
   }
   
@@ -49,6 +53,12 @@ namespace dxvk {
   }
   
   
+  bool DxvkMemory::isEvacuating() const {
+    return m_chunk != nullptr
+        && m_chunk->isEvacuating();
+  }
+  
+  
   void DxvkMemory::free() {
     if (m_alloc != nullptr)
       m_alloc->free(*this);
@@ -59,15 +69,16 @@ namespace dxvk {
           DxvkMemoryAllocator*  alloc,
           DxvkMemoryType*       type,
           DxvkDeviceMemory      memory)
-  : m_alloc(alloc), m_type(type), m_memory(memory) {
-    // Mark the entire chunk as free
-    m_freeList.push_back(FreeSlice { 0, memory.memSize });
+  : m_alloc(alloc), m_type(type), m_memory(memory),
+    m_allocator(memory.memSize) {
+    
   }
   
   
   DxvkMemoryChunk::~DxvkMemoryChunk() {
-    // This call is technically not thread-safe, but it
-    // doesn't need to be since we don't free chunks
+    // Chunks only get destroyed with the memory
+    // type's lock held, or when the allocator
+    // itself is being destroyed.
     m_alloc->freeDeviceMemory(m_type, m_memory);
   }
   
@@ -83,72 +94,47 @@ namespace dxvk {
      || m_memory.priority != priority)
       return DxvkMemory();
     
-    // If the chunk is full, return
-    if (m_freeList.size() == 0)
+    // Don't put anything new into a chunk
+    // that we are trying to empty
+    if (m_evacuating.load())
       return DxvkMemory();
     
-    // Select the slice to allocate from in a worst-fit
-    // manner. This may help keep fragmentation low.
-    auto bestSlice = m_freeList.begin();
-    
-    for (auto slice = m_freeList.begin(); slice != m_freeList.end(); slice++) {
-      if (slice->length == size) {
-        bestSlice = slice;
-        break;
-      } else if (slice->length > bestSlice->length) {
-        bestSlice = slice;
-      }
-    }
-    
-    // We need to align the allocation to the requested alignment
-    const VkDeviceSize sliceStart = bestSlice->offset;
-    const VkDeviceSize sliceEnd   = bestSlice->offset + bestSlice->length;
-    
-    const VkDeviceSize allocStart = dxvk::align(sliceStart,        align);
-    const VkDeviceSize allocEnd   = dxvk::align(allocStart + size, align);
-    
-    if (allocEnd > sliceEnd)
+    uint32_t block = m_allocator.alloc(size, align);
+
+    if (block == DxvkTlsfAllocator::InvalidBlock)
       return DxvkMemory();
     
-    // We can use this slice, but we'll have to add
-    // the unused parts of it back to the free list.
-    m_freeList.erase(bestSlice);
-    
-    if (allocStart != sliceStart)
-      m_freeList.push_back({ sliceStart, allocStart - sliceStart });
-    
-    if (allocEnd != sliceEnd)
-      m_freeList.push_back({ allocEnd, sliceEnd - allocEnd });
-    
-    // Create the memory object with the aligned slice
+    VkDeviceSize offset = m_allocator.blockOffset(block);
+    VkDeviceSize length = m_allocator.blockLength(block);
+
     return DxvkMemory(m_alloc, this, m_type,
-      m_memory.memHandle, allocStart, allocEnd - allocStart,
-      reinterpret_cast<char*>(m_memory.memPointer) + allocStart);
+      m_memory.memHandle, offset, length,
+      reinterpret_cast<char*>(m_memory.memPointer) + offset,
+      block);
   }
   
   
   void DxvkMemoryChunk::free(
-          VkDeviceSize  offset,
-          VkDeviceSize  length) {
-    // Remove adjacent entries from the free list and then add
-    // a new slice that covers all those entries. Without doing
-    // so, the slice could not be reused for larger allocations.
-    auto curr = m_freeList.begin();
-    
-    while (curr != m_freeList.end()) {
-      if (curr->offset == offset + length) {
-        length += curr->length;
-        curr = m_freeList.erase(curr);
-      } else if (curr->offset + curr->length == offset) {
-        offset -= curr->length;
-        length += curr->length;
-        curr = m_freeList.erase(curr);
-      } else {
-        curr++;
-      }
-    }
-    
-    m_freeList.push_back({ offset, length });
+          uint32_t      block) {
+    m_allocator.free(block);
+  }
+  
+  
+  void DxvkMemoryChunk::addStats(
+          DxvkMemoryStats& stats) const {
+    stats.memoryFragmented += m_allocator.freeSize() - m_allocator.largestFreeBlock();
+    stats.freeBlockCount   += m_allocator.freeBlockCount();
+  }
+  
+  
+  void DxvkMemoryChunk::setEvacuating(bool evacuate) {
+    // If the chunk could not be emptied, remember how much
+    // memory was still in use so that we don't try again
+    // unless something got freed or allocated in between
+    if (!evacuate && m_evacuating.load())
+      m_failedEvacuationSize = usedSize();
+
+    m_evacuating.store(evacuate);
   }
   
   
@@ -162,7 +148,6 @@ namespace dxvk {
       
       m_memHeaps[i].properties = m_memProps.memoryHeaps[i];
       m_memHeaps[i].chunkSize  = pickChunkSize(heapSize);
-      m_memHeaps[i].stats      = DxvkMemoryStats { 0, 0 };
     }
     
     for (uint32_t i = 0; i < m_memProps.memoryTypeCount; i++) {
@@ -185,8 +170,6 @@ namespace dxvk {
     const VkMemoryDedicatedAllocateInfoKHR& dedAllocInfo,
           VkMemoryPropertyFlags             flags,
           float                             priority) {
-    std::lock_guard<std::mutex> lock(m_mutex);
-
     // Try to allocate from a memory type which supports the given flags exactly
     auto dedAllocPtr = dedAllocReq.prefersDedicatedAllocation ? &dedAllocInfo : nullptr;
     DxvkMemory result = this->tryAlloc(req, dedAllocPtr, flags, priority);
@@ -214,8 +197,8 @@ namespace dxvk {
 
       for (uint32_t i = 0; i < m_memProps.memoryHeapCount; i++) {
         Logger::err(str::format("Heap ", i, ": ",
-          (m_memHeaps[i].stats.memoryAllocated >> 20), " MB allocated, ",
-          (m_memHeaps[i].stats.memoryUsed      >> 20), " MB used, ",
+          (m_memHeaps[i].memoryAllocated.load() >> 20), " MB allocated, ",
+          (m_memHeaps[i].memoryUsed.load()      >> 20), " MB used, ",
           (m_memHeaps[i].properties.size       >> 20), " MB available"));
       }
 
@@ -227,19 +210,90 @@ namespace dxvk {
   
   
   DxvkMemoryStats DxvkMemoryAllocator::getMemoryStats() {
-    std::lock_guard<std::mutex> lock(m_mutex);
-
     DxvkMemoryStats totalStats;
     
     for (size_t i = 0; i < m_memProps.memoryHeapCount; i++) {
-      totalStats.memoryAllocated += m_memHeaps[i].stats.memoryAllocated;
-      totalStats.memoryUsed      += m_memHeaps[i].stats.memoryUsed;
+      totalStats.memoryAllocated += m_memHeaps[i].memoryAllocated.load();
+      totalStats.memoryUsed      += m_memHeaps[i].memoryUsed.load();
     }
-      
+    
+    for (size_t i = 0; i < m_memProps.memoryTypeCount; i++) {
+      std::lock_guard<std::mutex> lock(m_memTypes[i].mutex);
+
+      for (const auto& chunk : m_memTypes[i].chunks)
+        chunk->addStats(totalStats);
+    }
+    
+    totalStats.memoryReclaimed = m_memoryReclaimed.load();
     return totalStats;
   }
   
   
+  bool DxvkMemoryAllocator::selectEvacuatedChunks() {
+    // Number of calls after which we give up on a chunk
+    constexpr uint32_t MaxEvacuationTicks = 8;
+
+    bool result = false;
+
+    for (uint32_t i = 0; i < m_memProps.memoryTypeCount; i++) {
+      DxvkMemoryType* type = &m_memTypes[i];
+
+      if (!(type->memType.propertyFlags & VK_MEMORY_PROPERTY_DEVICE_LOCAL_BIT))
+        continue;
+
+      std::lock_guard<std::mutex> lock(type->mutex);
+
+      if (type->chunks.size() < 2)
+        continue;
+
+      // Only evacuate one chunk per memory type at a time
+      DxvkMemoryChunk* evacuating = nullptr;
+      DxvkMemoryChunk* candidate  = nullptr;
+
+      VkDeviceSize freeSize = 0;
+
+      for (const auto& chunk : type->chunks) {
+        freeSize += chunk->freeSize();
+
+        if (chunk->isEvacuating())
+          evacuating = chunk.ptr();
+        else if (chunk->canEvacuate() && (!candidate || chunk->usedSize() < candidate->usedSize()))
+          candidate = chunk.ptr();
+      }
+
+      if (evacuating) {
+        if (++type->evacuationTicks < MaxEvacuationTicks) {
+          result = true;
+        } else {
+          evacuating->setEvacuating(false);
+          type->evacuationTicks = 0;
+        }
+        continue;
+      }
+
+      // Only consider chunks that are mostly empty, and make sure
+      // that their allocations can be moved to the other chunks
+      // without having to allocate additional device memory
+      if (!candidate || candidate->usedSize() > candidate->size() / 4)
+        continue;
+
+      if (freeSize - candidate->freeSize() < candidate->usedSize())
+        continue;
+
+      if (!candidate->usedSize()) {
+        this->freeEvacuatedChunk(type, candidate);
+        continue;
+      }
+
+      candidate->setEvacuating(true);
+      type->evacuationTicks = 0;
+      result = true;
+    }
+
+    return result;
+  }
+  
+  
   DxvkMemory DxvkMemoryAllocator::tryAlloc(
     const VkMemoryRequirements*             req,
     const VkMemoryDedicatedAllocateInfoKHR* dedAllocInfo,
@@ -280,9 +334,13 @@ namespace dxvk {
       DxvkDeviceMemory devMem = this->tryAllocDeviceMemory(
         type, flags, size, priority, dedAllocInfo);
 
-      if (devMem.memHandle != VK_NULL_HANDLE)
-        memory = DxvkMemory(this, nullptr, type, devMem.memHandle, 0, size, devMem.memPointer);
+      if (devMem.memHandle != VK_NULL_HANDLE) {
+        memory = DxvkMemory(this, nullptr, type, devMem.memHandle, 0, size,
+          devMem.memPointer, DxvkTlsfAllocator::InvalidBlock);
+      }
     } else {
+      std::lock_guard<std::mutex> lock(type->mutex);
+
       for (uint32_t i = 0; i < type->chunks.size() && !memory; i++)
         memory = type->chunks[i]->alloc(flags, size, align, priority);
       
@@ -301,7 +359,7 @@ namespace dxvk {
     }
 
     if (memory)
-      type->heap->stats.memoryUsed += memory.m_length;
+      type->heap->memoryUsed += memory.m_length;
 
     return memory;
   }
@@ -344,7 +402,7 @@ namespace dxvk {
       }
     }
 
-    type->heap->stats.memoryAllocated += size;
+    type->heap->memoryAllocated += size;
     m_device->adapter()->notifyHeapMemoryAlloc(type->heapId, size);
     return result;
   }
@@ -352,15 +410,13 @@ namespace dxvk {
 
   void DxvkMemoryAllocator::free(
     const DxvkMemory&           memory) {
-    std::lock_guard<std::mutex> lock(m_mutex);
-    memory.m_type->heap->stats.memoryUsed -= memory.m_length;
+    memory.m_type->heap->memoryUsed -= memory.m_length;
 
     if (memory.m_chunk != nullptr) {
       this->freeChunkMemory(
         memory.m_type,
         memory.m_chunk,
-        memory.m_offset,
-        memory.m_length);
+        memory.m_block);
     } else {
       DxvkDeviceMemory devMem;
       devMem.memHandle  = memory.m_memory;
@@ -374,9 +430,32 @@ namespace dxvk {
   void DxvkMemoryAllocator::freeChunkMemory(
           DxvkMemoryType*       type,
           DxvkMemoryChunk*      chunk,
-          VkDeviceSize          offset,
-          VkDeviceSize          length) {
-    chunk->free(offset, length);
+          uint32_t              block) {
+    std::lock_guard<std::mutex> lock(type->mutex);
+    chunk->free(block);
+
+    if (unlikely(chunk->isEvacuating()) && !chunk->usedSize())
+      this->freeEvacuatedChunk(type, chunk);
+  }
+  
+  
+  void DxvkMemoryAllocator::freeEvacuatedChunk(
+          DxvkMemoryType*       type,
+          DxvkMemoryChunk*      chunk) {
+    VkDeviceSize size = chunk->size();
+
+    for (auto i = type->chunks.begin(); i != type->chunks.end(); i++) {
+      if (i->ptr() == chunk) {
+        type->chunks.erase(i);
+        break;
+      }
+    }
+
+    m_memoryReclaimed += size;
+
+    Logger::debug(str::format(
+      "DxvkMemoryAllocator: Freed evacuated chunk on memory type ",
+      type->memTypeId, ", ", size >> 20, " MB reclaimed"));
   }
   
 
@@ -384,7 +463,7 @@ namespace dxvk {
           DxvkMemoryType*       type,
           DxvkDeviceMemory      memory) {
     m_vkd->vkFreeMemory(m_vkd->device(), memory.memHandle, nullptr);
-    type->heap->stats.memoryAllocated -= memory.memSize;
+    type->heap->memoryAllocated -= memory.memSize;
     m_device->adapter()->notifyHeapMemoryFree(type->heapId, memory.memSize);
   }
 
@@ -1,6 +1,7 @@
 #pragma once
 
 #include "dxvk_adapter.h"
+#include "dxvk_memory_tlsf.h"
 
 namespace dxvk {
   
@@ -12,10 +13,18 @@ namespace dxvk {
    * 
    * Reports the amount of device memory
    * allocated and used by the application.
+   * Fragmented memory is free memory inside
+   * chunks that is not part of the largest
+   * free block of the respective chunk. Reclaimed
+   * memory is the total size of all chunks that were
+   * freed after being evacuated by the defragmenter.
    */
   struct DxvkMemoryStats {
-    VkDeviceSize memoryAllocated = 0;
-    VkDeviceSize memoryUsed      = 0;
+    VkDeviceSize memoryAllocated  = 0;
+    VkDeviceSize memoryUsed       = 0;
+    VkDeviceSize memoryFragmented = 0;
+    VkDeviceSize memoryReclaimed  = 0;
+    uint32_t     freeBlockCount   = 0;
   };
   
   
@@ -40,11 +49,14 @@ namespace dxvk {
    * 
    * Corresponds to a Vulkan memory heap and stores
    * its properties as well as allocation statistics.
+   * Statistics are updated atomically since memory
+   * types sharing a heap are locked separately.
    */
   struct DxvkMemoryHeap {
-    VkMemoryHeap      properties;
-    VkDeviceSize      chunkSize;
-    DxvkMemoryStats   stats;
+    VkMemoryHeap              properties;
+    VkDeviceSize              chunkSize;
+    std::atomic<VkDeviceSize> memoryAllocated = { 0ull };
+    std::atomic<VkDeviceSize> memoryUsed      = { 0ull };
   };
 
 
@@ -53,7 +65,9 @@ namespace dxvk {
    * 
    * Corresponds to a Vulkan memory type and stores
    * memory chunks used to sub-allocate memory on
-   * this memory type.
+   * this memory type. The chunks are protected by
+   * a per-type lock, so that allocations from
+   * different memory types do not block each other.
    */
   struct DxvkMemoryType {
     DxvkMemoryHeap*   heap;
@@ -62,7 +76,10 @@ namespace dxvk {
     VkMemoryType      memType;
     uint32_t          memTypeId;
 
+    std::mutex        mutex;
     std::vector<Rc<DxvkMemoryChunk>> chunks;
+
+    uint32_t          evacuationTicks = 0;
   };
   
   
@@ -84,7 +101,8 @@ namespace dxvk {
       VkDeviceMemory        memory,
       VkDeviceSize          offset,
       VkDeviceSize          length,
-      void*                 mapPtr);
+      void*                 mapPtr,
+      uint32_t              block);
     DxvkMemory             (DxvkMemory&& other);
     DxvkMemory& operator = (DxvkMemory&& other);
     ~DxvkMemory();
@@ -130,6 +148,14 @@ namespace dxvk {
     operator bool () const {
       return m_memory != VK_NULL_HANDLE;
     }
+
+    /**
+     * \brief Checks whether the slice should be moved
+     * 
+     * \returns \c true if the slice was allocated from
+     *    a chunk that is currently being evacuated
+     */
+    bool isEvacuating() const;
     
   private:
     
@@ -140,6 +166,7 @@ namespace dxvk {
     VkDeviceSize          m_offset = 0;
     VkDeviceSize          m_length = 0;
     void*                 m_mapPtr = nullptr;
+    uint32_t              m_block  = DxvkTlsfAllocator::InvalidBlock;
     
     void free();
     
@@ -150,7 +177,8 @@ namespace dxvk {
    * \brief Memory chunk
    * 
    * A single chunk of memory that provides a
-   * sub-allocator. This is not thread-safe.
+   * sub-allocator. This is not thread-safe,
+   * the memory type's lock must be held.
    */
   class DxvkMemoryChunk : public RcObject {
     
@@ -186,25 +214,86 @@ namespace dxvk {
      * Returns a slice back to the chunk.
      * Called automatically when a memory
      * slice runs out of scope.
-     * \param [in] offset Slice offset
-     * \param [in] length Slice length
+     * \param [in] block Sub-allocator block
      */
     void free(
-            VkDeviceSize  offset,
-            VkDeviceSize  length);
+            uint32_t      block);
     
-  private:
+    /**
+     * \brief Adds fragmentation statistics
+     * 
+     * Accumulates the amount of fragmented
+     * memory and the number of free blocks.
+     * \param [in,out] stats Memory stats
+     */
+    void addStats(
+            DxvkMemoryStats& stats) const;
+    
+    /**
+     * \brief Chunk size
+     * \returns Size of the chunk, in bytes
+     */
+    VkDeviceSize size() const {
+      return m_memory.memSize;
+    }
     
-    struct FreeSlice {
-      VkDeviceSize offset;
-      VkDeviceSize length;
-    };
+    /**
+     * \brief Amount of memory in use
+     * \returns Allocated bytes
+     */
+    VkDeviceSize usedSize() const {
+      return m_memory.memSize - m_allocator.freeSize();
+    }
+    
+    /**
+     * \brief Amount of free memory
+     * \returns Free bytes
+     */
+    VkDeviceSize freeSize() const {
+      return m_allocator.freeSize();
+    }
+    
+    /**
+     * \brief Checks whether the chunk is being evacuated
+     * 
+     * Evacuated chunks are not used for new allocations,
+     * and get freed as soon as they no longer contain any
+     * allocations. May be called without holding the lock.
+     * \returns \c true if the chunk is being evacuated
+     */
+    bool isEvacuating() const {
+      return m_evacuating.load();
+    }
+    
+    /**
+     * \brief Checks whether the chunk can be evacuated
+     * 
+     * Returns \c false if a previous evacuation attempt
+     * failed and no allocations were freed since then,
+     * which happens when the chunk contains resources
+     * that cannot be relocated.
+     * \returns \c true if the chunk can be evacuated
+     */
+    bool canEvacuate() const {
+      return usedSize() != m_failedEvacuationSize;
+    }
+    
+    /**
+     * \brief Starts or cancels evacuation
+     * \param [in] evacuate Whether to evacuate the chunk
+     */
+    void setEvacuating(bool evacuate);
+    
+  private:
     
     DxvkMemoryAllocator*  m_alloc;
     DxvkMemoryType*       m_type;
     DxvkDeviceMemory      m_memory;
     
-    std::vector<FreeSlice> m_freeList;
+    DxvkTlsfAllocator     m_allocator;
+    
+    std::atomic<bool>     m_evacuating = { false };
+    VkDeviceSize          m_failedEvacuationSize = ~VkDeviceSize(0);
     
   };
   
@@ -261,6 +350,19 @@ namespace dxvk {
      */
     DxvkMemoryStats getMemoryStats();
     
+    /**
+     * \brief Selects chunks to evacuate
+     * 
+     * For each device-local memory type, marks the least
+     * used chunk for evacuation if it is sparsely used and
+     * its allocations fit into the remaining chunks. Chunks
+     * that do not get emptied within a few calls are given
+     * up on, since they likely contain resources that cannot
+     * be relocated. Used by the defragmenter.
+     * \returns \c true if any chunk is being evacuated
+     */
+    bool selectEvacuatedChunks();
+    
   private:
 
     const Rc<vk::DeviceFn>                 m_vkd;
@@ -268,10 +370,11 @@ namespace dxvk {
     const VkPhysicalDeviceProperties       m_devProps;
     const VkPhysicalDeviceMemoryProperties m_memProps;
     
-    std::mutex                                      m_mutex;
     std::array<DxvkMemoryHeap, VK_MAX_MEMORY_HEAPS> m_memHeaps;
     std::array<DxvkMemoryType, VK_MAX_MEMORY_TYPES> m_memTypes;
     
+    std::atomic<VkDeviceSize> m_memoryReclaimed = { 0ull };
+    
     DxvkMemory tryAlloc(
       const VkMemoryRequirements*             req,
       const VkMemoryDedicatedAllocateInfoKHR* dedAllocInfo,
@@ -299,8 +402,11 @@ namespace dxvk {
     void freeChunkMemory(
             DxvkMemoryType*       type,
             DxvkMemoryChunk*      chunk,
-            VkDeviceSize          offset,
-            VkDeviceSize          length);
+            uint32_t              block);
+    
+    void freeEvacuatedChunk(
+            DxvkMemoryType*       type,
+            DxvkMemoryChunk*      chunk);
     
     void freeDeviceMemory(
             DxvkMemoryType*       type,
@@ -0,0 +1,264 @@
+#include "dxvk_memory_tlsf.h"
+
+namespace dxvk {
+
+  DxvkTlsfAllocator::DxvkTlsfAllocator(VkDeviceSize size) {
+    for (auto& heads : m_heads)
+      heads.fill(InvalidBlock);
+
+    // Mark the entire range as free
+    insertFreeBlock(createBlock(0, size, InvalidBlock, InvalidBlock));
+  }
+
+
+  DxvkTlsfAllocator::~DxvkTlsfAllocator() {
+
+  }
+
+
+  uint32_t DxvkTlsfAllocator::alloc(
+          VkDeviceSize          size,
+          VkDeviceSize          align) {
+    VkDeviceSize length = dxvk::align(std::max<VkDeviceSize>(size, 1), align);
+
+    // Blocks in the selected list are large enough, but may not be
+    // suitably aligned. In that case, look for a block that can hold
+    // the allocation at any offset. This only matters for resources
+    // with large alignment requirements, such as images.
+    uint32_t block = findFreeBlock(length);
+
+    if (block != InvalidBlock) {
+      VkDeviceSize offset = m_blocks[block].offset;
+
+      if (dxvk::align(offset, align) + length > offset + m_blocks[block].length)
+        block = InvalidBlock;
+    }
+
+    if (block == InvalidBlock && align > 1)
+      block = findFreeBlock(length + align - 1);
+
+    if (block == InvalidBlock)
+      return InvalidBlock;
+
+    removeFreeBlock(block);
+
+    // Return unused parts of the block to the free lists
+    VkDeviceSize padding = dxvk::align(m_blocks[block].offset, align) - m_blocks[block].offset;
+
+    if (padding) {
+      uint32_t next = splitBlock(block, padding);
+      insertFreeBlock(block);
+      block = next;
+    }
+
+    if (m_blocks[block].length > length)
+      insertFreeBlock(splitBlock(block, length));
+
+    return block;
+  }
+
+
+  void DxvkTlsfAllocator::free(
+          uint32_t              block) {
+    // Merge the block with adjacent free blocks so
+    // that they can be reused for larger allocations
+    uint32_t prev = m_blocks[block].prevPhys;
+    uint32_t next = m_blocks[block].nextPhys;
+
+    if (prev != InvalidBlock && m_blocks[prev].isFree) {
+      removeFreeBlock(prev);
+
+      m_blocks[prev].length  += m_blocks[block].length;
+      m_blocks[prev].nextPhys = next;
+
+      if (next != InvalidBlock)
+        m_blocks[next].prevPhys = prev;
+
+      destroyBlock(block);
+      block = prev;
+    }
+
+    if (next != InvalidBlock && m_blocks[next].isFree) {
+      removeFreeBlock(next);
+
+      uint32_t nextNext = m_blocks[next].nextPhys;
+      m_blocks[block].length  += m_blocks[next].length;
+      m_blocks[block].nextPhys = nextNext;
+
+      if (nextNext != InvalidBlock)
+        m_blocks[nextNext].prevPhys = block;
+
+      destroyBlock(next);
+    }
+
+    insertFreeBlock(block);
+  }
+
+
+  VkDeviceSize DxvkTlsfAllocator::largestFreeBlock() const {
+    if (!m_flMask)
+      return 0;
+
+    uint32_t fl = 63 - bit::lzcnt(uint64_t(m_flMask));
+    uint32_t sl = 63 - bit::lzcnt(uint64_t(m_slMasks[fl]));
+
+    VkDeviceSize result = 0;
+
+    for (uint32_t b = m_heads[fl][sl]; b != InvalidBlock; b = m_blocks[b].nextFree)
+      result = std::max(result, m_blocks[b].length);
+
+    return result;
+  }
+
+
+  uint32_t DxvkTlsfAllocator::createBlock(
+          VkDeviceSize          offset,
+          VkDeviceSize          length,
+          uint32_t              prevPhys,
+          uint32_t              nextPhys) {
+    uint32_t block = m_unusedBlocks;
+
+    if (block != InvalidBlock) {
+      m_unusedBlocks = m_blocks[block].nextFree;
+    } else {
+      block = uint32_t(m_blocks.size());
+      m_blocks.emplace_back();
+    }
+
+    Block& b = m_blocks[block];
+    b.offset   = offset;
+    b.length   = length;
+    b.prevPhys = prevPhys;
+    b.nextPhys = nextPhys;
+    b.prevFree = InvalidBlock;
+    b.nextFree = InvalidBlock;
+    b.isFree   = false;
+    return block;
+  }
+
+
+  void DxvkTlsfAllocator::destroyBlock(
+          uint32_t              block) {
+    m_blocks[block].nextFree = m_unusedBlocks;
+    m_unusedBlocks = block;
+  }
+
+
+  void DxvkTlsfAllocator::insertFreeBlock(
+          uint32_t              block) {
+    uint32_t fl, sl;
+    mapSize(m_blocks[block].length, fl, sl);
+
+    uint32_t head = m_heads[fl][sl];
+
+    m_blocks[block].isFree   = true;
+    m_blocks[block].prevFree = InvalidBlock;
+    m_blocks[block].nextFree = head;
+
+    if (head != InvalidBlock)
+      m_blocks[head].prevFree = block;
+
+    m_heads[fl][sl] = block;
+    m_slMasks[fl] |= 1u << sl;
+    m_flMask      |= 1u << fl;
+
+    m_freeSize       += m_blocks[block].length;
+    m_freeBlockCount += 1;
+  }
+
+
+  void DxvkTlsfAllocator::removeFreeBlock(
+          uint32_t              block) {
+    uint32_t fl, sl;
+    mapSize(m_blocks[block].length, fl, sl);
+
+    uint32_t prev = m_blocks[block].prevFree;
+    uint32_t next = m_blocks[block].nextFree;
+
+    if (prev != InvalidBlock)
+      m_blocks[prev].nextFree = next;
+    else
+      m_heads[fl][sl] = next;
+
+    if (next != InvalidBlock)
+      m_blocks[next].prevFree = prev;
+
+    if (m_heads[fl][sl] == InvalidBlock) {
+      m_slMasks[fl] &= ~(1u << sl);
+
+      if (!m_slMasks[fl])
+        m_flMask &= ~(1u << fl);
+    }
+
+    m_blocks[block].isFree = false;
+
+    m_freeSize       -= m_blocks[block].length;
+    m_freeBlockCount -= 1;
+  }
+
+
+  uint32_t DxvkTlsfAllocator::findFreeBlock(
+          VkDeviceSize          size) const {
+    // Round up to the next list boundary so that
+    // any block in the selected list is large enough
+    if (size >= SlCount)
+      size += (VkDeviceSize(1) << (63 - bit::lzcnt(size) - SlBits)) - 1;
+
+    uint32_t fl, sl;
+    mapSize(size, fl, sl);
+
+    if (fl >= FlCount)
+      return InvalidBlock;
+
+    uint32_t slMask = m_slMasks[fl] & (~0u << sl);
+
+    if (!slMask) {
+      uint32_t flMask = fl + 1 < FlCount
+        ? m_flMask & (~0u << (fl + 1))
+        : 0u;
+
+      if (!flMask)
+        return InvalidBlock;
+
+      fl = bit::tzcnt(flMask);
+      slMask = m_slMasks[fl];
+    }
+
+    return m_heads[fl][bit::tzcnt(slMask)];
+  }
+
+
+  uint32_t DxvkTlsfAllocator::splitBlock(
+          uint32_t              block,
+          VkDeviceSize          length) {
+    uint32_t next = m_blocks[block].nextPhys;
+
+    uint32_t rest = createBlock(
+      m_blocks[block].offset + length,
+      m_blocks[block].length - length,
+      block, next);
+
+    if (next != InvalidBlock)
+      m_blocks[next].prevPhys = rest;
+
+    m_blocks[block].length   = length;
+    m_blocks[block].nextPhys = rest;
+    return rest;
+  }
+
+
+  void DxvkTlsfAllocator::mapSize(
+          VkDeviceSize          size,
+          uint32_t&             fl,
+          uint32_t&             sl) {
+    if (size < SlCount) {
+      fl = 0;
+      sl = uint32_t(size);
+    } else {
+      uint32_t msb = 63 - bit::lzcnt(size);
+      fl = msb - SlBits + 1;
+      sl = uint32_t(size >> (msb - SlBits)) - SlCount;
+    }
+  }
+
+}
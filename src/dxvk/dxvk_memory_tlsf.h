@@ -0,0 +1,150 @@
+#pragma once
+
+#include <array>
+#include <vector>
+
+#include "dxvk_include.h"
+
+namespace dxvk {
+
+  /**
+   * \brief TLSF sub-allocator
+   *
+   * Manages a range of memory using a two-level
+   * segregated fit allocator. Free blocks are kept
+   * in lists which are indexed by the logarithm of
+   * the block size and a linear subdivision thereof,
+   * and bit masks are used to find a list with large
+   * enough blocks in constant time. Adjacent free
+   * blocks are merged when a block is freed.
+   *
+   * Only stores offsets and sizes, the memory itself
+   * is never accessed. The managed range must be
+   * smaller than 32 GB. This is not thread-safe.
+   */
+  class DxvkTlsfAllocator {
+    constexpr static uint32_t SlBits  = 4;
+    constexpr static uint32_t SlCount = 1u << SlBits;
+    constexpr static uint32_t FlCount = 32;
+  public:
+
+    constexpr static uint32_t InvalidBlock = ~0u;
+
+    DxvkTlsfAllocator(VkDeviceSize size);
+    ~DxvkTlsfAllocator();
+
+    /**
+     * \brief Allocates a block
+     *
+     * \param [in] size Number of bytes to allocate
+     * \param [in] align Required alignment
+     * \returns Block index, or \c InvalidBlock
+     *    if no sufficiently large block is free
+     */
+    uint32_t alloc(
+            VkDeviceSize          size,
+            VkDeviceSize          align);
+
+    /**
+     * \brief Frees a block
+     * \param [in] block Block index
+     */
+    void free(
+            uint32_t              block);
+
+    /**
+     * \brief Block offset
+     *
+     * \param [in] block Block index
+     * \returns Offset of the block, in bytes
+     */
+    VkDeviceSize blockOffset(uint32_t block) const {
+      return m_blocks[block].offset;
+    }
+
+    /**
+     * \brief Block length
+     *
+     * \param [in] block Block index
+     * \returns Size of the block, in bytes
+     */
+    VkDeviceSize blockLength(uint32_t block) const {
+      return m_blocks[block].length;
+    }
+
+    /**
+     * \brief Total amount of free memory
+     * \returns Free memory, in bytes
+     */
+    VkDeviceSize freeSize() const {
+      return m_freeSize;
+    }
+
+    /**
+     * \brief Number of free blocks
+     * \returns Free block count
+     */
+    uint32_t freeBlockCount() const {
+      return m_freeBlockCount;
+    }
+
+    /**
+     * \brief Size of the largest free block
+     *
+     * Only scans the list of largest blocks.
+     * \returns Largest free block size, in bytes
+     */
+    VkDeviceSize largestFreeBlock() const;
+
+  private:
+
+    struct Block {
+      VkDeviceSize  offset;
+      VkDeviceSize  length;
+      uint32_t      prevPhys;
+      uint32_t      nextPhys;
+      uint32_t      prevFree;
+      uint32_t      nextFree;
+      bool          isFree;
+    };
+
+    std::vector<Block>    m_blocks;
+    uint32_t              m_unusedBlocks = InvalidBlock;
+
+    uint32_t                                      m_flMask = 0;
+    std::array<uint32_t, FlCount>                 m_slMasks = { };
+    std::array<std::array<uint32_t, SlCount>, FlCount> m_heads;
+
+    VkDeviceSize          m_freeSize       = 0;
+    uint32_t              m_freeBlockCount = 0;
+
+    uint32_t createBlock(
+            VkDeviceSize          offset,
+            VkDeviceSize          length,
+            uint32_t              prevPhys,
+            uint32_t              nextPhys);
+
+    void destroyBlock(
+            uint32_t              block);
+
+    void insertFreeBlock(
+            uint32_t              block);
+
+    void removeFreeBlock(
+            uint32_t              block);
+
+    uint32_t findFreeBlock(
+            VkDeviceSize          size) const;
+
+    uint32_t splitBlock(
+            uint32_t              block,
+            VkDeviceSize          length);
+
+    static void mapSize(
+            VkDeviceSize          size,
+            uint32_t&             fl,
+            uint32_t&             sl);
+
+  };
+
+}
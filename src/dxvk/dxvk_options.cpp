@@ -4,10 +4,16 @@ namespace dxvk {
 
   DxvkOptions::DxvkOptions(const Config& config) {
     enableStateCache      = config.getOption<bool>    ("dxvk.enableStateCache",       true);
+    enableShaderCache     = config.getOption<bool>    ("dxvk.enableShaderCache",      true);
+    shaderCacheSize       = config.getOption<int32_t> ("dxvk.shaderCacheSize",        256);
     enableTransferQueue   = config.getOption<bool>    ("dxvk.enableTransferQueue",    true);
+    stagingMemoryBudget   = config.getOption<int32_t> ("dxvk.stagingMemoryBudget",    64);
+    enableMemoryDefrag    = config.getOption<bool>    ("dxvk.enableMemoryDefrag",     false);
+    enableAsyncPipelines  = config.getOption<bool>    ("dxvk.enableAsyncPipelines",   false);
     numCompilerThreads    = config.getOption<int32_t> ("dxvk.numCompilerThreads",     0);
     useRawSsbo            = config.getOption<Tristate>("dxvk.useRawSsbo",             Tristate::Auto);
     useEarlyDiscard       = config.getOption<Tristate>("dxvk.useEarlyDiscard",        Tristate::Auto);
+    optimizeShaders       = config.getOption<bool>    ("dxvk.optimizeShaders",        false);
   }
 
 }
\ No newline at end of file
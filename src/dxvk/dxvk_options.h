@@ -11,16 +11,37 @@ namespace dxvk {
     /// Enable state cache
     bool enableStateCache;
 
+    /// Enable on-disk cache of translated shaders
+    bool enableShaderCache;
+
+    /// Maximum size of the shader cache, in MB
+    int32_t shaderCacheSize;
+
     /// Use transfer queue if available
     bool enableTransferQueue;
 
-    /// Number of compiler threads
-    /// when using the state cache
+    /// Maximum amount of memory used for
+    /// staging pages per context, in MB
+    int32_t stagingMemoryBudget;
+
+    /// Relocate buffers out of sparsely
+    /// used memory chunks in the background
+    bool enableMemoryDefrag;
+
+    /// Compile missing graphics pipelines in the
+    /// background and skip draws until they are ready
+    bool enableAsyncPipelines;
+
+    /// Number of pipeline compiler threads
     int32_t numCompilerThreads;
 
     /// Shader-related options
     Tristate useRawSsbo;
     Tristate useEarlyDiscard;
+
+    /// Run the in-tree SPIR-V optimizer
+    /// on translated shaders
+    bool optimizeShaders;
   };
 
 }
\ No newline at end of file
@@ -98,8 +98,7 @@ namespace dxvk {
     for (uint32_t i = 0; i < bindingCount; i++)
       m_bindingSlots[i] = bindingInfos[i];
     
-    std::vector<VkDescriptorSetLayoutBinding>       bindings(bindingCount);
-    std::vector<VkDescriptorUpdateTemplateEntryKHR> tEntries(bindingCount);
+    std::vector<VkDescriptorSetLayoutBinding> bindings(bindingCount);
     
     for (uint32_t i = 0; i < bindingCount; i++) {
       bindings[i].binding            = i;
@@ -107,13 +106,6 @@ namespace dxvk {
       bindings[i].descriptorCount    = 1;
       bindings[i].stageFlags         = bindingInfos[i].stages;
       bindings[i].pImmutableSamplers = nullptr;
-      
-      tEntries[i].dstBinding      = i;
-      tEntries[i].dstArrayElement = 0;
-      tEntries[i].descriptorCount = 1;
-      tEntries[i].descriptorType  = bindingInfos[i].type;
-      tEntries[i].offset          = sizeof(DxvkDescriptorInfo) * i;
-      tEntries[i].stride          = 0;
 
       if (bindingInfos[i].type == VK_DESCRIPTOR_TYPE_UNIFORM_BUFFER_DYNAMIC
        || bindingInfos[i].type == VK_DESCRIPTOR_TYPE_STORAGE_BUFFER_DYNAMIC)
@@ -161,6 +153,8 @@ namespace dxvk {
     // Create descriptor update template. If there are no active
     // resource bindings, there won't be any descriptors to update.
     if (bindingCount > 0) {
+      auto tEntries = getTemplateEntries(bindingCount, bindingInfos);
+
       VkDescriptorUpdateTemplateCreateInfoKHR templateInfo;
       templateInfo.sType = VK_STRUCTURE_TYPE_DESCRIPTOR_UPDATE_TEMPLATE_CREATE_INFO_KHR;
       templateInfo.pNext = nullptr;
@@ -193,5 +187,33 @@ namespace dxvk {
     m_vkd->vkDestroyDescriptorSetLayout(
       m_vkd->device(), m_descriptorSetLayout, nullptr);
   }
+
+  
+  std::vector<VkDescriptorUpdateTemplateEntryKHR> DxvkPipelineLayout::getTemplateEntries(
+          uint32_t            bindingCount,
+    const DxvkDescriptorSlot* bindingInfos) {
+    std::vector<VkDescriptorUpdateTemplateEntryKHR> result;
+
+    for (uint32_t i = 0; i < bindingCount; i++) {
+      // Updates that exceed the size of a binding continue with
+      // the next binding, as long as type and stages match
+      if (i > 0 && bindingInfos[i].type   == bindingInfos[i - 1].type
+                && bindingInfos[i].stages == bindingInfos[i - 1].stages) {
+        result.back().descriptorCount += 1;
+        continue;
+      }
+
+      VkDescriptorUpdateTemplateEntryKHR entry;
+      entry.dstBinding      = i;
+      entry.dstArrayElement = 0;
+      entry.descriptorCount = 1;
+      entry.descriptorType  = bindingInfos[i].type;
+      entry.offset          = sizeof(DxvkDescriptorInfo) * i;
+      entry.stride          = sizeof(DxvkDescriptorInfo);
+      result.push_back(entry);
+    }
+
+    return result;
+  }
   
 }
\ No newline at end of file
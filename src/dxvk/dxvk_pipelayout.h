@@ -262,6 +262,24 @@ namespace dxvk {
       
       return stages;
     }
+    
+    /**
+     * \brief Builds descriptor update template entries
+     * 
+     * Descriptor infos are read from a tightly packed
+     * array of \ref DxvkDescriptorInfo structures, with
+     * one element per binding. Consecutive bindings with
+     * the same descriptor type and stage flags share one
+     * entry, so that the driver can process them as one
+     * array update rather than looping over single
+     * descriptors.
+     * \param [in] bindingCount Number of bindings
+     * \param [in] bindingInfos Binding infos
+     * \returns Update template entries
+     */
+    static std::vector<VkDescriptorUpdateTemplateEntryKHR> getTemplateEntries(
+            uint32_t            bindingCount,
+      const DxvkDescriptorSlot* bindingInfos);
 
   private:
     
@@ -39,20 +39,207 @@ namespace dxvk {
   }
   
   
+  DxvkPipelineWorkers::DxvkPipelineWorkers(
+    const DxvkDevice*               device) {
+    // Use half the available CPU cores for pipeline compilation
+    uint32_t numCpuCores = dxvk::thread::hardware_concurrency();
+    uint32_t numWorkers  = numCpuCores > 8
+      ? numCpuCores * 3 / 4
+      : numCpuCores * 1 / 2;
+
+    if (numWorkers <  1) numWorkers =  1;
+    if (numWorkers > 16) numWorkers = 16;
+
+    if (device->config().numCompilerThreads > 0)
+      numWorkers = device->config().numCompilerThreads;
+    
+    Logger::info(str::format("DXVK: Using ", numWorkers, " compiler threads"));
+    
+    m_workersBusy.store(numWorkers);
+
+    for (uint32_t i = 0; i < numWorkers; i++) {
+      m_workers.emplace_back([this] () { runWorker(); });
+      m_workers[i].set_priority(ThreadPriority::Lowest);
+    }
+  }
+
+
+  DxvkPipelineWorkers::~DxvkPipelineWorkers() {
+    this->stopWorkers();
+  }
+
+
+  void DxvkPipelineWorkers::stopWorkers() {
+    { std::lock_guard<std::mutex> lock(m_mutex);
+
+      if (m_stopped)
+        return;
+
+      m_stopped = true;
+
+      for (auto& queue : m_queues)
+        queue.clear();
+
+      m_normalJobs.clear();
+    }
+
+    m_cond.notify_all();
+
+    for (auto& worker : m_workers)
+      worker.join();
+
+    m_workers.clear();
+  }
+
+
+  void DxvkPipelineWorkers::compileGraphicsPipeline(
+    const Rc<DxvkGraphicsPipeline>&       pipeline,
+    const DxvkGraphicsPipelineStateInfo&  state,
+    const Rc<DxvkRenderPass>&             renderPass,
+          DxvkPipelinePriority            priority) {
+    Job job;
+    job.gp          = pipeline;
+    job.gpState     = state;
+    job.renderPass  = renderPass;
+
+    this->enqueue(std::move(job), priority);
+  }
+
+
+  void DxvkPipelineWorkers::compileComputePipeline(
+    const Rc<DxvkComputePipeline>&        pipeline,
+    const DxvkComputePipelineStateInfo&   state,
+          DxvkPipelinePriority            priority) {
+    Job job;
+    job.cp          = pipeline;
+    job.cpState     = state;
+
+    this->enqueue(std::move(job), priority);
+  }
+
+
+  void DxvkPipelineWorkers::prioritize(
+    const DxvkGraphicsPipeline*           pipeline) {
+    std::lock_guard<std::mutex> lock(m_mutex);
+
+    auto entry = m_normalJobs.find(pipeline);
+
+    if (entry == m_normalJobs.end())
+      return;
+
+    auto& srcQueue = m_queues[uint32_t(DxvkPipelinePriority::Normal)];
+    auto& dstQueue = m_queues[uint32_t(DxvkPipelinePriority::High)];
+
+    // Jobs are indexed in queue order, so splicing
+    // them one by one preserves their relative order
+    for (auto job : entry->second)
+      dstQueue.splice(dstQueue.end(), srcQueue, job);
+
+    m_normalJobs.erase(entry);
+  }
+
+
+  void DxvkPipelineWorkers::enqueue(
+          Job&&                           job,
+          DxvkPipelinePriority            priority) {
+    std::lock_guard<std::mutex> lock(m_mutex);
+
+    if (m_stopped)
+      return;
+
+    auto& queue = m_queues[uint32_t(priority)];
+    queue.push_back(std::move(job));
+
+    if (priority == DxvkPipelinePriority::Normal && queue.back().gp != nullptr)
+      m_normalJobs[queue.back().gp.ptr()].push_back(std::prev(queue.end()));
+
+    m_cond.notify_one();
+  }
+
+
+  void DxvkPipelineWorkers::runWorker() {
+    env::setThreadName("dxvk-shader");
+
+    auto hasJobs = [this] () {
+      for (const auto& queue : m_queues) {
+        if (!queue.empty())
+          return true;
+      }
+
+      return false;
+    };
+
+    while (true) {
+      Job job;
+
+      { std::unique_lock<std::mutex> lock(m_mutex);
+
+        if (!hasJobs()) {
+          m_workersBusy -= 1;
+          m_cond.wait(lock, [this, &hasJobs] () {
+            return hasJobs() || m_stopped;
+          });
+          m_workersBusy += 1;
+        }
+
+        if (m_stopped)
+          break;
+
+        // Queues are ordered by priority
+        for (uint32_t i = 0; i < m_queues.size(); i++) {
+          auto& queue = m_queues[i];
+
+          if (!queue.empty()) {
+            job = std::move(queue.front());
+            queue.pop_front();
+
+            if (i == uint32_t(DxvkPipelinePriority::Normal) && job.gp != nullptr) {
+              auto entry = m_normalJobs.find(job.gp.ptr());
+              entry->second.pop_front();
+
+              if (entry->second.empty())
+                m_normalJobs.erase(entry);
+            }
+            break;
+          }
+        }
+      }
+
+      if (job.gp != nullptr)
+        job.gp->compilePipeline(job.gpState, *job.renderPass);
+      else if (job.cp != nullptr)
+        job.cp->getPipelineHandle(job.cpState);
+    }
+  }
+
+
   DxvkPipelineManager::DxvkPipelineManager(
     const DxvkDevice*         device,
           DxvkRenderPassPool* passManager)
-  : m_device    (device),
-    m_cache     (new DxvkPipelineCache(device->vkd())) {
+  : m_device      (device),
+    m_passManager (passManager),
+    m_cache       (new DxvkPipelineCache(device->vkd())) {
     std::string useStateCache = env::getEnvVar("DXVK_STATE_CACHE");
     
-    if (useStateCache != "0" && device->config().enableStateCache)
+    bool enableStateCache = useStateCache != "0"
+      && device->config().enableStateCache;
+
+    // Only the state cache and async pipeline
+    // compilation queue up background work
+    if (enableStateCache || device->config().enableAsyncPipelines)
+      m_workers = new DxvkPipelineWorkers(device);
+
+    if (enableStateCache)
       m_stateCache = new DxvkStateCache(device, this, passManager);
   }
   
   
   DxvkPipelineManager::~DxvkPipelineManager() {
-    
+    // Compile jobs access the state cache and the pipeline
+    // counters, so the workers must be stopped before any
+    // of these objects get destroyed.
+    if (m_workers != nullptr)
+      m_workers->stopWorkers();
   }
   
   
@@ -123,9 +310,17 @@ namespace dxvk {
   }
 
 
+  DxvkShaderModuleStats DxvkPipelineManager::getShaderModuleStats() const {
+    DxvkShaderModuleStats result;
+    result.numCacheHits   = m_numModuleCacheHits.load();
+    result.numCacheMisses = m_numModuleCacheMisses.load();
+    return result;
+  }
+
+
   bool DxvkPipelineManager::isCompilingShaders() const {
-    return m_stateCache != nullptr
-        && m_stateCache->isCompilingShaders();
+    return m_workers != nullptr
+        && m_workers->isBusy();
   }
   
 }
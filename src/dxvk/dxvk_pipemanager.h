@@ -1,5 +1,8 @@
 #pragma once
 
+#include <condition_variable>
+#include <deque>
+#include <list>
 #include <mutex>
 #include <unordered_map>
 
@@ -20,6 +23,31 @@ namespace dxvk {
     uint32_t numGraphicsPipelines;
     uint32_t numComputePipelines;
   };
+
+
+  /**
+   * \brief Shader module cache statistics
+   * 
+   * Number of shader modules that were reused
+   * or had to be created for new pipelines.
+   */
+  struct DxvkShaderModuleStats {
+    uint64_t numCacheHits;
+    uint64_t numCacheMisses;
+  };
+
+
+  /**
+   * \brief Pipeline compile priority
+   *
+   * Pipelines with a higher priority will be
+   * compiled before any pipelines with a lower
+   * priority that have been queued up earlier.
+   */
+  enum class DxvkPipelinePriority : uint32_t {
+    High    = 0,  ///< Pipelines needed for rendering
+    Normal  = 1,  ///< Speculative state cache work
+  };
   
   /**
    * \brief Compute pipeline key
@@ -59,6 +87,118 @@ namespace dxvk {
   };
   
   
+  /**
+   * \brief Pipeline compiler workers
+   *
+   * Thread pool shared between everything that
+   * compiles pipelines in the background. Jobs
+   * are processed in the order they were queued
+   * up, but jobs with a higher priority always
+   * jump ahead of jobs with a lower priority.
+   */
+  class DxvkPipelineWorkers : public RcObject {
+
+  public:
+
+    DxvkPipelineWorkers(
+      const DxvkDevice*               device);
+
+    ~DxvkPipelineWorkers();
+
+    /**
+     * \brief Stops all worker threads
+     *
+     * Discards any jobs that have not been started
+     * yet and waits for running jobs to finish. Jobs
+     * queued up after this will be ignored. Must be
+     * called before destroying any object that the
+     * workers may access while compiling pipelines.
+     */
+    void stopWorkers();
+
+    /**
+     * \brief Queues a graphics pipeline for compilation
+     *
+     * Does nothing when the job is executed if the
+     * pipeline has already been compiled by then.
+     * \param [in] pipeline The pipeline object
+     * \param [in] state Pipeline state vector
+     * \param [in] renderPass The render pass
+     * \param [in] priority Compile priority
+     */
+    void compileGraphicsPipeline(
+      const Rc<DxvkGraphicsPipeline>&       pipeline,
+      const DxvkGraphicsPipelineStateInfo&  state,
+      const Rc<DxvkRenderPass>&             renderPass,
+            DxvkPipelinePriority            priority);
+
+    /**
+     * \brief Queues a compute pipeline for compilation
+     *
+     * \param [in] pipeline The pipeline object
+     * \param [in] state Pipeline state vector
+     * \param [in] priority Compile priority
+     */
+    void compileComputePipeline(
+      const Rc<DxvkComputePipeline>&        pipeline,
+      const DxvkComputePipelineStateInfo&   state,
+            DxvkPipelinePriority            priority);
+
+    /**
+     * \brief Raises priority of queued graphics pipelines
+     *
+     * Moves all jobs for the given pipeline object from
+     * the normal priority queue to the high priority
+     * queue, so that variants of a pipeline that is in
+     * use get compiled before any speculative work. The
+     * cost only depends on the number of jobs moved.
+     * \param [in] pipeline The pipeline object
+     */
+    void prioritize(
+      const DxvkGraphicsPipeline*           pipeline);
+
+    /**
+     * \brief Checks whether any worker is busy
+     * \returns \c true if pipelines are being compiled
+     */
+    bool isBusy() const {
+      return m_workersBusy.load() > 0;
+    }
+
+  private:
+
+    struct Job {
+      Rc<DxvkGraphicsPipeline>      gp;
+      Rc<DxvkComputePipeline>       cp;
+      DxvkGraphicsPipelineStateInfo gpState;
+      DxvkComputePipelineStateInfo  cpState;
+      Rc<DxvkRenderPass>            renderPass;
+    };
+
+    std::mutex                        m_mutex;
+    std::condition_variable           m_cond;
+    bool                              m_stopped = false;
+
+    using JobList = std::list<Job>;
+
+    std::array<JobList, 2>            m_queues;
+
+    std::unordered_map<
+      const DxvkGraphicsPipeline*,
+      std::deque<JobList::iterator>>  m_normalJobs;
+
+    std::atomic<uint32_t>             m_workersBusy = { 0u };
+    std::vector<dxvk::thread>         m_workers;
+
+    void enqueue(
+            Job&&                           job,
+            DxvkPipelinePriority            priority);
+
+    void runWorker();
+
+  };
+
+
   /**
    * \brief Pipeline manager
    * 
@@ -71,6 +211,7 @@ namespace dxvk {
   class DxvkPipelineManager : public RcObject {
     friend class DxvkComputePipeline;
     friend class DxvkGraphicsPipeline;
+    friend class DxvkStateCache;
   public:
     
     DxvkPipelineManager(
@@ -128,6 +269,23 @@ namespace dxvk {
      */
     DxvkPipelineCount getPipelineCount() const;
 
+    /**
+     * \brief Retrieves total pipeline stall time
+     *
+     * Time the thread executing the context spent
+     * waiting for pipelines to get compiled.
+     * \returns Stall time, in microseconds
+     */
+    uint64_t getStallTime() const {
+      return m_stallTime.load();
+    }
+
+    /**
+     * \brief Retrieves shader module cache statistics
+     * \returns Shader module cache hits and misses
+     */
+    DxvkShaderModuleStats getShaderModuleStats() const;
+
     /**
      * \brief Checks whether async compiler is busy
      * \returns \c true if shaders are being compiled
@@ -137,11 +295,17 @@ namespace dxvk {
   private:
     
     const DxvkDevice*         m_device;
+    DxvkRenderPassPool*       m_passManager;
     Rc<DxvkPipelineCache>     m_cache;
     Rc<DxvkStateCache>        m_stateCache;
 
     std::atomic<uint32_t>     m_numComputePipelines  = { 0 };
     std::atomic<uint32_t>     m_numGraphicsPipelines = { 0 };
+    std::atomic<uint64_t>     m_stallTime            = { 0 };
+    std::atomic<uint64_t>     m_numModuleCacheHits   = { 0 };
+    std::atomic<uint64_t>     m_numModuleCacheMisses = { 0 };
+
+    Rc<DxvkPipelineWorkers>   m_workers;
     
     std::mutex m_mutex;
     
@@ -31,7 +31,14 @@ namespace dxvk {
       return m_submitQueue.size() + m_finishQueue.size() <= MaxNumQueuedCommandBuffers;
     });
 
-    m_pending += 1;
+    // If no work was pending, the GPU has been idle
+    // since the last command list has completed
+    if (!(m_pending++)) {
+      auto now = std::chrono::high_resolution_clock::now();
+      auto us  = std::chrono::duration_cast<std::chrono::microseconds>(now - m_idleStart);
+      m_idleTimeUs += us.count();
+    }
+
     m_submitQueue.push(std::move(submitInfo));
     m_appendCond.notify_all();
   }
@@ -101,7 +108,9 @@ namespace dxvk {
         Logger::err(str::format(
           "DxvkSubmissionQueue: Command submission failed with ",
           status));
-        m_pending -= 1;
+
+        if (!(--m_pending))
+          m_idleStart = std::chrono::high_resolution_clock::now();
       }
     }
   }
@@ -137,7 +146,9 @@ namespace dxvk {
       }
 
       lock = std::unique_lock<std::mutex>(m_mutex);
-      m_pending -= 1;
+
+      if (!(--m_pending))
+        m_idleStart = std::chrono::high_resolution_clock::now();
 
       m_finishQueue.pop();
       m_finishCond.notify_all();
@@ -1,5 +1,6 @@
 #pragma once
 
+#include <chrono>
 #include <condition_variable>
 #include <mutex>
 #include <queue>
@@ -59,6 +60,18 @@ namespace dxvk {
     uint32_t pendingSubmissions() const {
       return m_pending.load();
     }
+
+    /**
+     * \brief Total GPU idle time
+     *
+     * Accumulated time during which no command
+     * lists were pending, as observed by the
+     * submission and fence wait threads.
+     * \returns GPU idle time, in microseconds
+     */
+    uint64_t gpuIdleTime() const {
+      return m_idleTimeUs.load();
+    }
     
     /**
      * \brief Submits a command list asynchronously
@@ -115,6 +128,10 @@ namespace dxvk {
     
     std::atomic<bool>       m_stopped = { false };
     std::atomic<uint32_t>   m_pending = { 0u };
+    std::atomic<uint64_t>   m_idleTimeUs = { 0ull };
+
+    std::chrono::high_resolution_clock::time_point m_idleStart
+      = std::chrono::high_resolution_clock::now();
 
     std::mutex              m_mutex;
     std::mutex              m_mutexQueue;
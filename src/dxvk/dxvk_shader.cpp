@@ -41,59 +41,60 @@ namespace dxvk {
 
 
   DxvkShaderModule::DxvkShaderModule()
-  : m_vkd(nullptr), m_stage() {
+  : m_stage() {
 
   }
 
 
-  DxvkShaderModule::DxvkShaderModule(DxvkShaderModule&& other)
-  : m_vkd(std::move(other.m_vkd)) {
+  DxvkShaderModule::DxvkShaderModule(DxvkShaderModule&& other) {
     this->m_stage = other.m_stage;
     other.m_stage = VkPipelineShaderStageCreateInfo();
   }
 
 
   DxvkShaderModule::DxvkShaderModule(
-    const Rc<vk::DeviceFn>&     vkd,
     const Rc<DxvkShader>&       shader,
-    const SpirvCodeBuffer&      code)
-  : m_vkd(vkd), m_stage() {
+          VkShaderModule        module)
+  : m_stage() {
     m_stage.sType = VK_STRUCTURE_TYPE_PIPELINE_SHADER_STAGE_CREATE_INFO;
     m_stage.pNext = nullptr;
     m_stage.flags = 0;
     m_stage.stage = shader->stage();
-    m_stage.module = VK_NULL_HANDLE;
+    m_stage.module = module;
     m_stage.pName = "main";
     m_stage.pSpecializationInfo = nullptr;
-
-    VkShaderModuleCreateInfo info;
-    info.sType    = VK_STRUCTURE_TYPE_SHADER_MODULE_CREATE_INFO;
-    info.pNext    = nullptr;
-    info.flags    = 0;
-    info.codeSize = code.size();
-    info.pCode    = code.data();
-    
-    if (m_vkd->vkCreateShaderModule(m_vkd->device(), &info, nullptr, &m_stage.module) != VK_SUCCESS)
-      throw DxvkError("DxvkComputePipeline::DxvkComputePipeline: Failed to create shader module");
   }
   
   
   DxvkShaderModule::~DxvkShaderModule() {
-    if (m_vkd != nullptr) {
-      m_vkd->vkDestroyShaderModule(
-        m_vkd->device(), m_stage.module, nullptr);
-    }
+
   }
   
   
   DxvkShaderModule& DxvkShaderModule::operator = (DxvkShaderModule&& other) {
-    this->m_vkd   = std::move(other.m_vkd);
     this->m_stage = other.m_stage;
     other.m_stage = VkPipelineShaderStageCreateInfo();
     return *this;
   }
 
 
+  bool DxvkShaderModuleKey::eq(const DxvkShaderModuleKey& other) const {
+    return info.fsDualSrcBlend == other.info.fsDualSrcBlend
+        && bindingIds == other.bindingIds;
+  }
+
+
+  size_t DxvkShaderModuleKey::hash() const {
+    DxvkHashState state;
+    state.add(info.fsDualSrcBlend);
+
+    for (uint32_t id : bindingIds)
+      state.add(id);
+
+    return state;
+  }
+
+
   DxvkShader::DxvkShader(
           VkShaderStageFlagBits   stage,
           uint32_t                slotCount,
@@ -115,8 +116,10 @@ namespace dxvk {
     for (auto ins : code) {
       if (ins.opCode() == spv::OpDecorate) {
         if (ins.arg(2) == spv::DecorationBinding
-         || ins.arg(2) == spv::DecorationSpecId)
+         || ins.arg(2) == spv::DecorationSpecId) {
           m_idOffsets.push_back(ins.offset() + 3);
+          m_idSlots.push_back(ins.arg(3));
+        }
         
         if (ins.arg(2) == spv::DecorationLocation && ins.arg(3) == 1) {
           m_o1LocOffset = ins.offset() + 3;
@@ -134,7 +137,8 @@ namespace dxvk {
   
   
   DxvkShader::~DxvkShader() {
-    
+    for (const auto& pair : m_modules)
+      m_moduleVkd->vkDestroyShaderModule(m_moduleVkd->device(), pair.second, nullptr);
   }
   
   
@@ -163,27 +167,131 @@ namespace dxvk {
   DxvkShaderModule DxvkShader::createShaderModule(
     const Rc<vk::DeviceFn>&          vkd,
     const DxvkDescriptorSlotMapping& mapping,
-    const DxvkShaderModuleCreateInfo& info) {
+    const DxvkShaderModuleCreateInfo& info,
+          bool&                      cacheHit) {
+    DxvkShaderModuleKey key;
+    key.info = info;
+    key.bindingIds.resize(m_idSlots.size());
+
+    // The module only depends on the binding IDs that the
+    // shader's own slots map to, not the entire mapping
+    for (size_t i = 0; i < m_idSlots.size(); i++) {
+      key.bindingIds[i] = m_idSlots[i] < MaxNumResourceSlots
+        ? mapping.getBindingId(m_idSlots[i])
+        : m_idSlots[i];
+    }
+
+    // Dual-source blending only affects shaders which
+    // actually write to location 1, ignore it otherwise
+    if (!m_o1IdxOffset || !m_o1LocOffset)
+      key.info.fsDualSrcBlend = false;
+
+    std::lock_guard<std::mutex> lock(m_moduleMutex);
+
+    auto entry = m_modules.find(key);
+    cacheHit = entry != m_modules.end();
+
+    if (cacheHit)
+      return DxvkShaderModule(this, entry->second);
+
+    VkShaderModule module = createModule(vkd, key);
+    m_moduleVkd = vkd;
+    m_modules.insert({ std::move(key), module });
+    return DxvkShaderModule(this, module);
+  }
+  
+  
+  void DxvkShader::dump(std::ostream& outputStream) const {
+    m_code.decompress().store(outputStream);
+  }
+  
+  
+  void DxvkShader::write(std::ostream& outputStream) const {
+    uint32_t slotCount = m_slots.size();
+    uint32_t constSize = m_constData.sizeInBytes();
+    
+    outputStream.write(reinterpret_cast<const char*>(&m_stage),     sizeof(m_stage));
+    outputStream.write(reinterpret_cast<const char*>(&slotCount),   sizeof(slotCount));
+    outputStream.write(reinterpret_cast<const char*>(m_slots.data()), slotCount * sizeof(DxvkResourceSlot));
+    outputStream.write(reinterpret_cast<const char*>(&m_interface), sizeof(m_interface));
+    outputStream.write(reinterpret_cast<const char*>(&m_options),   sizeof(m_options));
+    outputStream.write(reinterpret_cast<const char*>(&constSize),   sizeof(constSize));
+    outputStream.write(reinterpret_cast<const char*>(m_constData.data()), constSize);
+    
+    m_code.write(outputStream);
+  }
+  
+  
+  Rc<DxvkShader> DxvkShader::read(std::istream& inputStream) {
+    VkShaderStageFlagBits stage     = VkShaderStageFlagBits(0);
+    uint32_t              slotCount = 0;
+    uint32_t              constSize = 0;
+    DxvkInterfaceSlots    iface;
+    DxvkShaderOptions     options;
+    
+    if (!inputStream.read(reinterpret_cast<char*>(&stage),     sizeof(stage))
+     || !inputStream.read(reinterpret_cast<char*>(&slotCount), sizeof(slotCount))
+     || slotCount > MaxNumResourceSlots)
+      return nullptr;
+    
+    std::vector<DxvkResourceSlot> slots(slotCount);
+    
+    if (!inputStream.read(reinterpret_cast<char*>(slots.data()), slotCount * sizeof(DxvkResourceSlot))
+     || !inputStream.read(reinterpret_cast<char*>(&iface),      sizeof(iface))
+     || !inputStream.read(reinterpret_cast<char*>(&options),    sizeof(options))
+     || !inputStream.read(reinterpret_cast<char*>(&constSize),  sizeof(constSize))
+     || constSize % sizeof(uint32_t))
+      return nullptr;
+    
+    std::vector<uint32_t> constWords(constSize / sizeof(uint32_t));
+    
+    if (!inputStream.read(reinterpret_cast<char*>(constWords.data()), constSize))
+      return nullptr;
+    
+    SpirvCompressedBuffer code;
+    
+    if (!code.read(inputStream))
+      return nullptr;
+    
+    DxvkShaderConstData constData = constWords.empty()
+      ? DxvkShaderConstData()
+      : DxvkShaderConstData(constWords.size(), constWords.data());
+    
+    return new DxvkShader(stage,
+      slots.size(), slots.data(), iface,
+      code.decompress(), options,
+      std::move(constData));
+  }
+  
+  
+  VkShaderModule DxvkShader::createModule(
+    const Rc<vk::DeviceFn>&           vkd,
+    const DxvkShaderModuleKey&        key) const {
     SpirvCodeBuffer spirvCode = m_code.decompress();
     uint32_t* code = spirvCode.data();
     
     // Remap resource binding IDs
-    for (uint32_t ofs : m_idOffsets) {
-      if (code[ofs] < MaxNumResourceSlots)
-        code[ofs] = mapping.getBindingId(code[ofs]);
-    }
+    for (size_t i = 0; i < m_idOffsets.size(); i++)
+      code[m_idOffsets[i]] = key.bindingIds[i];
 
     // For dual-source blending we need to re-map
     // location 1, index 0 to location 0, index 1
-    if (info.fsDualSrcBlend && m_o1IdxOffset && m_o1LocOffset)
+    if (key.info.fsDualSrcBlend)
       std::swap(code[m_o1IdxOffset], code[m_o1LocOffset]);
     
-    return DxvkShaderModule(vkd, this, spirvCode);
-  }
-  
-  
-  void DxvkShader::dump(std::ostream& outputStream) const {
-    m_code.decompress().store(outputStream);
+    VkShaderModuleCreateInfo info;
+    info.sType    = VK_STRUCTURE_TYPE_SHADER_MODULE_CREATE_INFO;
+    info.pNext    = nullptr;
+    info.flags    = 0;
+    info.codeSize = spirvCode.size();
+    info.pCode    = spirvCode.data();
+    
+    VkShaderModule module = VK_NULL_HANDLE;
+
+    if (vkd->vkCreateShaderModule(vkd->device(), &info, nullptr, &module) != VK_SUCCESS)
+      throw DxvkError("DxvkShader::createShaderModule: Failed to create shader module");
+
+    return module;
   }
   
 }
\ No newline at end of file
@@ -1,7 +1,10 @@
 #pragma once
 
+#include <mutex>
+#include <unordered_map>
 #include <vector>
 
+#include "dxvk_hash.h"
 #include "dxvk_include.h"
 #include "dxvk_limits.h"
 #include "dxvk_pipelayout.h"
@@ -109,6 +112,23 @@ namespace dxvk {
   struct DxvkShaderModuleCreateInfo {
     bool fsDualSrcBlend;
   };
+
+
+  /**
+   * \brief Shader module key
+   * 
+   * Stores the remapped binding IDs along with
+   * the module create info. Together, these fully
+   * determine the patched SPIR-V code of a shader.
+   */
+  struct DxvkShaderModuleKey {
+    DxvkShaderModuleCreateInfo  info;
+    std::vector<uint32_t>       bindingIds;
+
+    bool eq(const DxvkShaderModuleKey& other) const;
+
+    size_t hash() const;
+  };
   
   
   /**
@@ -118,6 +138,10 @@ namespace dxvk {
    * bindings that the shader uses. In order to use
    * the shader with a pipeline, a shader module
    * needs to be created from he shader object.
+   * 
+   * Shader modules are cached per binding layout,
+   * since most pipelines using the same shader
+   * will end up with the same slot mapping.
    */
   class DxvkShader : public RcObject {
     
@@ -167,16 +191,24 @@ namespace dxvk {
     /**
      * \brief Creates a shader module
      * 
-     * Maps the binding slot numbers 
+     * Maps the binding slot numbers and looks up a
+     * previously created shader module with the same
+     * binding IDs. If none exists, the code will be
+     * patched and a new module is added to the cache.
+     * The returned module does not own the Vulkan
+     * object, which lives as long as the shader.
      * \param [in] vkd Vulkan device functions
      * \param [in] mapping Resource slot mapping
      * \param [in] info Module create info
+     * \param [out] cacheHit Set to \c true if the
+     *    module was taken from the cache
      * \returns The shader module
      */
     DxvkShaderModule createShaderModule(
       const Rc<vk::DeviceFn>&          vkd,
       const DxvkDescriptorSlotMapping& mapping,
-      const DxvkShaderModuleCreateInfo& info);
+      const DxvkShaderModuleCreateInfo& info,
+            bool&                      cacheHit);
     
     /**
      * \brief Inter-stage interface slots
@@ -217,6 +249,27 @@ namespace dxvk {
      */
     void dump(std::ostream& outputStream) const;
     
+    /**
+     * \brief Serializes the shader
+     * 
+     * Writes all data required to recreate the
+     * shader object. The code is stored in its
+     * compressed form.
+     * \param [in] outputStream Stream to write to
+     */
+    void write(std::ostream& outputStream) const;
+    
+    /**
+     * \brief Deserializes a shader
+     * 
+     * Recreates a shader object previously
+     * serialized with \ref write. The shader
+     * key is not stored and must be set again.
+     * \param [in] inputStream Stream to read from
+     * \returns Shader object, or \c nullptr on error
+     */
+    static Rc<DxvkShader> read(std::istream& inputStream);
+    
     /**
      * \brief Sets the shader key
      * \param [in] key Unique key
@@ -248,6 +301,7 @@ namespace dxvk {
     
     std::vector<DxvkResourceSlot> m_slots;
     std::vector<size_t>           m_idOffsets;
+    std::vector<uint32_t>         m_idSlots;
     DxvkInterfaceSlots            m_interface;
     DxvkShaderOptions             m_options;
     DxvkShaderConstData           m_constData;
@@ -257,6 +311,18 @@ namespace dxvk {
 
     size_t m_o1IdxOffset = 0;
     size_t m_o1LocOffset = 0;
+
+    std::mutex                    m_moduleMutex;
+    Rc<vk::DeviceFn>              m_moduleVkd;
+
+    std::unordered_map<
+      DxvkShaderModuleKey,
+      VkShaderModule,
+      DxvkHash, DxvkEq>           m_modules;
+
+    VkShaderModule createModule(
+      const Rc<vk::DeviceFn>&           vkd,
+      const DxvkShaderModuleKey&        key) const;
     
   };
   
@@ -264,10 +330,10 @@ namespace dxvk {
   /**
    * \brief Shader module object
    * 
-   * Manages a Vulkan shader module. This will not
-   * perform any shader compilation. Instead, the
-   * context will create pipeline objects on the
-   * fly when executing draw calls.
+   * Wraps a Vulkan shader module owned by the shader
+   * that created it. This will not perform any shader
+   * compilation. Instead, the context will create
+   * pipeline objects on the fly when executing draws.
    */
   class DxvkShaderModule {
     
@@ -276,11 +342,19 @@ namespace dxvk {
     DxvkShaderModule();
 
     DxvkShaderModule(DxvkShaderModule&& other);
-    
+
+    /**
+     * \brief Wraps an existing shader module
+     * 
+     * The resulting object does not take ownership
+     * of the Vulkan shader module, so the caller must
+     * ensure that it outlives the wrapper object.
+     * \param [in] shader The shader
+     * \param [in] module Vulkan shader module
+     */
     DxvkShaderModule(
-      const Rc<vk::DeviceFn>&     vkd,
       const Rc<DxvkShader>&       shader,
-      const SpirvCodeBuffer&      code);
+            VkShaderModule        module);
     
     ~DxvkShaderModule();
 
@@ -309,7 +383,6 @@ namespace dxvk {
     
   private:
     
-    Rc<vk::DeviceFn>                m_vkd;
     VkPipelineShaderStageCreateInfo m_stage;
     
   };
@@ -0,0 +1,352 @@
+#include <version.h>
+
+#include <algorithm>
+#include <cstring>
+#include <sstream>
+
+#include "dxvk_device.h"
+#include "dxvk_shader_cache.h"
+
+namespace dxvk {
+
+  bool DxvkShaderCacheKey::eq(const DxvkShaderCacheKey& key) const {
+    return this->shader.eq(key.shader)
+        && this->options == key.options;
+  }
+
+
+  size_t DxvkShaderCacheKey::hash() const {
+    DxvkHashState hash;
+    hash.add(this->shader.hash());
+    hash.add(this->options.dword(0));
+    return hash;
+  }
+
+
+  DxvkShaderCache::DxvkShaderCache(
+    const DxvkDevice*           device)
+  : m_maxSize(VkDeviceSize(std::max(device->config().shaderCacheSize, 1)) << 20) {
+    m_header.compiler = Sha1Hash::compute(
+      DXVK_VERSION, std::strlen(DXVK_VERSION));
+
+    bool needsRewrite = false;
+
+    if (!readCacheFile(needsRewrite)) {
+      Logger::warn("DXVK: Creating new shader cache file");
+
+      m_entries.clear();
+      needsRewrite = true;
+    }
+
+    needsRewrite |= evictEntries();
+
+    if (needsRewrite)
+      writeCacheFile();
+
+    m_writerThread = dxvk::thread([this] () { writerFunc(); });
+  }
+
+
+  DxvkShaderCache::~DxvkShaderCache() {
+    { std::lock_guard<std::mutex> lock(m_writerLock);
+
+      m_stopThread.store(true);
+      m_writerCond.notify_one();
+    }
+
+    m_writerThread.join();
+  }
+
+
+  Rc<DxvkShader> DxvkShaderCache::lookup(
+    const DxvkShaderCacheKey&     key,
+          std::vector<char>&      userData) {
+    std::string data;
+
+    { std::lock_guard<std::mutex> lock(m_entryLock);
+
+      auto entry = m_entries.find(key);
+
+      if (entry == m_entries.end())
+        return nullptr;
+
+      // Record the first use of each entry in this
+      // session so that it survives eviction
+      if (entry->second.session != m_session) {
+        entry->second.session = m_session;
+        enqueueRecord(key, std::string());
+      }
+
+      data = entry->second.data;
+    }
+
+    std::istringstream stream(data, std::ios_base::binary);
+    Rc<DxvkShader> shader = DxvkShader::read(stream);
+
+    uint32_t userSize = 0;
+
+    if (shader == nullptr
+     || !stream.read(reinterpret_cast<char*>(&userSize), sizeof(userSize))) {
+      Logger::warn(str::format("DXVK: Failed to load cached shader ", key.shader.toString()));
+      return nullptr;
+    }
+
+    userData.resize(userSize);
+
+    if (!stream.read(userData.data(), userSize)) {
+      Logger::warn(str::format("DXVK: Failed to load cached shader ", key.shader.toString()));
+      return nullptr;
+    }
+
+    return shader;
+  }
+
+
+  void DxvkShaderCache::store(
+    const DxvkShaderCacheKey&     key,
+    const Rc<DxvkShader>&         shader,
+    const std::vector<char>&      userData) {
+    std::ostringstream stream(std::ios_base::binary);
+    shader->write(stream);
+
+    uint32_t userSize = userData.size();
+    stream.write(reinterpret_cast<const char*>(&userSize), sizeof(userSize));
+    stream.write(userData.data(), userSize);
+
+    std::string data = stream.str();
+
+    std::lock_guard<std::mutex> lock(m_entryLock);
+
+    auto result = m_entries.insert({ key, Entry { data, m_session } });
+
+    if (result.second)
+      enqueueRecord(key, data);
+  }
+
+
+  bool DxvkShaderCache::readCacheFile(
+          bool&                     needsRewrite) {
+    std::ifstream ifile(getCacheFileName(), std::ios_base::binary);
+
+    if (!ifile) {
+      Logger::warn("DXVK: No shader cache file found");
+      return false;
+    }
+
+    // Discard caches written by other versions
+    // of the shader compilers altogether
+    DxvkShaderCacheHeader header;
+
+    if (!ifile.read(reinterpret_cast<char*>(&header), sizeof(header))
+     || std::memcmp(header.magic, m_header.magic, sizeof(header.magic))
+     || header.version != m_header.version
+     || !(header.compiler == m_header.compiler)) {
+      Logger::warn("DXVK: Shader cache out of date");
+      return false;
+    }
+
+    uint32_t numRecords = 0;
+    uint32_t maxSession = 0;
+
+    DxvkShaderCacheRecord record;
+    std::string           data;
+
+    while (ifile.peek() != std::char_traits<char>::eof()) {
+      if (!readCacheRecord(ifile, record, data)) {
+        // Most likely the process was killed while writing
+        // a record, so keep everything that was read so far
+        Logger::warn("DXVK: Skipped invalid shader cache records");
+        needsRewrite = true;
+        break;
+      }
+
+      if (record.dataSize != 0) {
+        m_entries[record.key] = Entry { std::move(data), record.session };
+      } else {
+        auto entry = m_entries.find(record.key);
+
+        if (entry != m_entries.end())
+          entry->second.session = std::max(entry->second.session, record.session);
+      }
+
+      maxSession = std::max(maxSession, record.session);
+      numRecords += 1;
+    }
+
+    m_session = maxSession + 1;
+
+    // Compact the file if most records only mark
+    // entries as used, since they waste load time
+    if (numRecords > 2 * m_entries.size())
+      needsRewrite = true;
+
+    Logger::info(str::format(
+      "DXVK: Read ", m_entries.size(),
+      " valid shader cache entries"));
+    return true;
+  }
+
+
+  bool DxvkShaderCache::readCacheRecord(
+          std::istream&             stream,
+          DxvkShaderCacheRecord&    record,
+          std::string&              data) const {
+    constexpr uint32_t MaxDataSize = 16 << 20;
+
+    if (!stream.read(reinterpret_cast<char*>(&record), sizeof(record))
+     || record.dataSize > MaxDataSize)
+      return false;
+
+    data.resize(record.dataSize);
+
+    if (!stream.read(&data[0], record.dataSize))
+      return false;
+
+    return record.dataSize == 0
+        || Sha1Hash::compute(data.data(), data.size()) == record.dataHash;
+  }
+
+
+  void DxvkShaderCache::writeCacheFile() {
+    std::ofstream file(getCacheFileName(),
+      std::ios_base::binary |
+      std::ios_base::trunc);
+
+    if (!file && env::createDirectory(getCacheDir())) {
+      file = std::ofstream(getCacheFileName(),
+        std::ios_base::binary |
+        std::ios_base::trunc);
+    }
+
+    file.write(reinterpret_cast<const char*>(&m_header), sizeof(m_header));
+
+    for (const auto& e : m_entries) {
+      DxvkShaderCacheRecord record;
+      record.key     = e.first;
+      record.session = e.second.session;
+
+      writeCacheRecord(file, record, e.second.data);
+    }
+  }
+
+
+  void DxvkShaderCache::writeCacheRecord(
+          std::ostream&             stream,
+          DxvkShaderCacheRecord&    record,
+    const std::string&              data) const {
+    record.dataSize = data.size();
+    record.dataHash = Sha1Hash::compute(data.data(), data.size());
+
+    stream.write(reinterpret_cast<const char*>(&record), sizeof(record));
+    stream.write(data.data(), data.size());
+  }
+
+
+  void DxvkShaderCache::enqueueRecord(
+    const DxvkShaderCacheKey&       key,
+    const std::string&              data) {
+    WriterItem item;
+    item.record.key     = key;
+    item.record.session = m_session;
+    item.data           = data;
+
+    std::lock_guard<std::mutex> lock(m_writerLock);
+    m_writerQueue.push(std::move(item));
+    m_writerCond.notify_one();
+  }
+
+
+  bool DxvkShaderCache::evictEntries() {
+    VkDeviceSize totalSize = 0;
+
+    for (const auto& e : m_entries)
+      totalSize += e.second.data.size() + sizeof(DxvkShaderCacheRecord);
+
+    if (totalSize <= m_maxSize)
+      return false;
+
+    // Keep the most recently used entries, and drop
+    // everything else until we're within the budget
+    std::vector<std::pair<uint32_t, DxvkShaderCacheKey>> order;
+    order.reserve(m_entries.size());
+
+    for (const auto& e : m_entries)
+      order.push_back({ e.second.session, e.first });
+
+    std::sort(order.begin(), order.end(),
+      [] (const auto& a, const auto& b) { return a.first > b.first; });
+
+    VkDeviceSize keepSize = 0;
+    size_t       numEvicted = 0;
+
+    for (const auto& o : order) {
+      auto entry = m_entries.find(o.second);
+      VkDeviceSize size = entry->second.data.size() + sizeof(DxvkShaderCacheRecord);
+
+      if (keepSize + size > m_maxSize) {
+        m_entries.erase(entry);
+        numEvicted += 1;
+      } else {
+        keepSize += size;
+      }
+    }
+
+    Logger::info(str::format("DXVK: Evicted ", numEvicted, " shader cache entries"));
+    return true;
+  }
+
+
+  void DxvkShaderCache::writerFunc() {
+    env::setThreadName("dxvk-shader-cache");
+
+    std::ofstream file(getCacheFileName(),
+      std::ios_base::binary |
+      std::ios_base::app);
+
+    while (true) {
+      WriterItem item;
+
+      { std::unique_lock<std::mutex> lock(m_writerLock);
+
+        m_writerCond.wait(lock, [this] () {
+          return m_writerQueue.size()
+              || m_stopThread.load();
+        });
+
+        // Write out everything that is still queued
+        // before exiting so that no entries get lost
+        if (m_writerQueue.size() == 0)
+          break;
+
+        item = std::move(m_writerQueue.front());
+        m_writerQueue.pop();
+      }
+
+      writeCacheRecord(file, item.record, item.data);
+      file.flush();
+    }
+  }
+
+
+  std::string DxvkShaderCache::getCacheFileName() const {
+    std::string path = getCacheDir();
+
+    if (!path.empty() && *path.rbegin() != '/')
+      path += '/';
+
+    std::string exeName = env::getExeName();
+    auto extp = exeName.find_last_of('.');
+
+    if (extp != std::string::npos && exeName.substr(extp + 1) == "exe")
+      exeName.erase(extp);
+
+    path += exeName + ".dxvk-spirv";
+    return path;
+  }
+
+
+  std::string DxvkShaderCache::getCacheDir() const {
+    return env::getEnvVar("DXVK_STATE_CACHE_PATH");
+  }
+
+}
@@ -0,0 +1,175 @@
+#pragma once
+
+#include <atomic>
+#include <condition_variable>
+#include <fstream>
+#include <mutex>
+#include <queue>
+#include <unordered_map>
+#include <vector>
+
+#include "dxvk_shader.h"
+
+#include "../util/thread.h"
+
+namespace dxvk {
+
+  class DxvkDevice;
+
+  /**
+   * \brief Shader cache key
+   *
+   * Identifies a translated shader by the hash of
+   * its original bytecode, as well as the hash of
+   * all front-end options that affect translation.
+   */
+  struct DxvkShaderCacheKey {
+    DxvkShaderKey shader;
+    Sha1Hash      options;
+
+    bool eq(const DxvkShaderCacheKey& key) const;
+
+    size_t hash() const;
+  };
+
+
+  /**
+   * \brief Shader cache file header
+   *
+   * Caches written by a different version of the
+   * shader compilers are discarded, since their
+   * output may differ.
+   */
+  struct DxvkShaderCacheHeader {
+    char     magic[4]   = { 'D', 'X', 'S', 'C' };
+    uint32_t version    = 2;
+    Sha1Hash compiler;
+  };
+
+  static_assert(sizeof(DxvkShaderCacheHeader) == 28);
+
+
+  /**
+   * \brief Shader cache record
+   *
+   * Precedes the serialized shader data in the cache
+   * file. Records with no data mark an existing entry
+   * as used in the given session, which is used to
+   * evict the least recently used entries.
+   */
+  struct DxvkShaderCacheRecord {
+    DxvkShaderCacheKey key;
+    uint32_t           session;
+    uint32_t           dataSize;
+    Sha1Hash           dataHash;
+  };
+
+
+  /**
+   * \brief Shader cache
+   *
+   * Persistently stores translated shaders, so that
+   * front-ends can skip translating DXBC and DXSO
+   * shaders that were already seen in a previous run.
+   * Front-ends may store additional data alongside
+   * each shader, e.g. reflection info.
+   *
+   * New entries and entry uses are appended to the
+   * cache file by a background thread. If the file
+   * exceeds the configured size when it is loaded,
+   * it gets rewritten without the least recently
+   * used entries.
+   */
+  class DxvkShaderCache : public RcObject {
+
+  public:
+
+    DxvkShaderCache(
+      const DxvkDevice*           device);
+
+    ~DxvkShaderCache();
+
+    /**
+     * \brief Looks up a shader
+     *
+     * \param [in] key Shader cache key
+     * \param [out] userData Front-end data stored with the shader
+     * \returns The shader, or \c nullptr if not cached
+     */
+    Rc<DxvkShader> lookup(
+      const DxvkShaderCacheKey&     key,
+            std::vector<char>&      userData);
+
+    /**
+     * \brief Adds a shader to the cache
+     *
+     * Does nothing if the shader is already cached.
+     * \param [in] key Shader cache key
+     * \param [in] shader The translated shader
+     * \param [in] userData Front-end data to store
+     */
+    void store(
+      const DxvkShaderCacheKey&     key,
+      const Rc<DxvkShader>&         shader,
+      const std::vector<char>&      userData);
+
+  private:
+
+    struct Entry {
+      std::string           data;
+      uint32_t              session;
+    };
+
+    struct WriterItem {
+      DxvkShaderCacheRecord record;
+      std::string           data;
+    };
+
+    DxvkShaderCacheHeader             m_header;
+    VkDeviceSize                      m_maxSize;
+    uint32_t                          m_session = 0;
+
+    std::mutex                        m_entryLock;
+
+    std::unordered_map<
+      DxvkShaderCacheKey,
+      Entry,
+      DxvkHash, DxvkEq>               m_entries;
+
+    std::atomic<bool>                 m_stopThread = { false };
+
+    std::mutex                        m_writerLock;
+    std::condition_variable           m_writerCond;
+    std::queue<WriterItem>            m_writerQueue;
+    dxvk::thread                      m_writerThread;
+
+    bool readCacheFile(
+            bool&                     needsRewrite);
+
+    bool readCacheRecord(
+            std::istream&             stream,
+            DxvkShaderCacheRecord&    record,
+            std::string&              data) const;
+
+    void writeCacheFile();
+
+    void writeCacheRecord(
+            std::ostream&             stream,
+            DxvkShaderCacheRecord&    record,
+      const std::string&              data) const;
+
+    void enqueueRecord(
+      const DxvkShaderCacheKey&       key,
+      const std::string&              data);
+
+    bool evictEntries();
+
+    void writerFunc();
+
+    std::string getCacheFileName() const;
+
+    std::string getCacheDir() const;
+
+  };
+
+}
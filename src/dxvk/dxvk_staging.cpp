@@ -5,53 +5,125 @@ namespace dxvk {
   
   DxvkStagingDataAlloc::DxvkStagingDataAlloc(const Rc<DxvkDevice>& device)
   : m_device(device) {
-
+    VkDeviceSize budget = VkDeviceSize(std::max(device->config().stagingMemoryBudget, 0)) << 20;
+    m_maxPageCount = std::max<uint32_t>(uint32_t(budget / PageSize), 1);
   }
 
 
   DxvkStagingDataAlloc::~DxvkStagingDataAlloc() {
-
+    this->trim();
   }
 
 
   DxvkBufferSlice DxvkStagingDataAlloc::alloc(VkDeviceSize align, VkDeviceSize size) {
-    if (size > MaxBufferSize)
-      return DxvkBufferSlice(createBuffer(size));
+    if (unlikely(!m_fallbackBuffers.empty()))
+      this->freeFallbackBuffers();
+
+    if (size > PageSize)
+      return this->allocFallback(align, size);
     
-    if (m_buffer == nullptr)
-      m_buffer = createBuffer(MaxBufferSize);
+    if (m_pages.empty())
+      m_pages.push_back(createBuffer(PageSize));
     
-    if (!m_buffer->isInUse())
+    // If the GPU is done with the current page,
+    // we can start over at the beginning
+    if (!m_pages[m_pageIndex]->isInUse())
       m_offset = 0;
     
     m_offset = dxvk::align(m_offset, align);
 
-    if (m_offset + size > MaxBufferSize) {
-      m_offset = 0;
+    if (m_offset + size > PageSize) {
+      // Advance to the oldest page in the ring if the GPU
+      // is done with it, or insert a new page in front of
+      // it as long as we are within the budget.
+      uint32_t next = (m_pageIndex + 1) % m_pages.size();
 
-      if (m_buffers.size() < MaxBufferCount)
-        m_buffers.push(std::move(m_buffer));
+      if (m_pages[next]->isInUse()) {
+        if (m_pages.size() >= m_maxPageCount)
+          return this->allocFallback(align, size);
 
-      if (!m_buffers.front()->isInUse()) {
-        m_buffer = std::move(m_buffers.front());
-        m_buffers.pop();
-      } else {
-        m_buffer = createBuffer(MaxBufferSize);
+        next = m_pageIndex + 1;
+        m_pages.insert(m_pages.begin() + next, createBuffer(PageSize));
       }
+
+      m_pageIndex = next;
+      m_offset    = 0;
     }
 
-    DxvkBufferSlice slice(m_buffer, m_offset, size);
+    // The ring has space again, so the temporary
+    // page can go away once the GPU is done with it
+    if (unlikely(m_fallbackPage != nullptr))
+      this->retireFallbackPage();
+
+    DxvkBufferSlice slice(m_pages[m_pageIndex], m_offset, size);
     m_offset = dxvk::align(m_offset + size, align);
     return slice;
   }
 
 
   void DxvkStagingDataAlloc::trim() {
-    m_buffer = nullptr;
-    m_offset = 0;
+    for (auto& page : m_pages)
+      this->destroyBuffer(std::move(page));
+
+    m_pages.clear();
+    m_pageIndex = 0;
+    m_offset    = 0;
+
+    if (m_fallbackPage != nullptr)
+      this->destroyBuffer(std::move(m_fallbackPage));
 
-    while (!m_buffers.empty())
-      m_buffers.pop();
+    m_fallbackOffset = 0;
+
+    for (auto& buffer : m_fallbackBuffers)
+      this->destroyBuffer(std::move(buffer));
+
+    m_fallbackBuffers.clear();
+  }
+
+
+  DxvkBufferSlice DxvkStagingDataAlloc::allocFallback(VkDeviceSize align, VkDeviceSize size) {
+    if (size > PageSize) {
+      Rc<DxvkBuffer> buffer = createBuffer(size);
+      m_fallbackBuffers.push_back(buffer);
+      return DxvkBufferSlice(buffer);
+    }
+
+    // Sub-allocate from a temporary page while the ring
+    // is exhausted, and replace the page once it is full
+    if (m_fallbackPage != nullptr && !m_fallbackPage->isInUse())
+      m_fallbackOffset = 0;
+
+    m_fallbackOffset = dxvk::align(m_fallbackOffset, align);
+
+    if (m_fallbackPage == nullptr || m_fallbackOffset + size > PageSize) {
+      if (m_fallbackPage != nullptr)
+        this->retireFallbackPage();
+
+      m_fallbackPage   = createBuffer(PageSize);
+      m_fallbackOffset = 0;
+    }
+
+    DxvkBufferSlice slice(m_fallbackPage, m_fallbackOffset, size);
+    m_fallbackOffset = dxvk::align(m_fallbackOffset + size, align);
+    return slice;
+  }
+
+
+  void DxvkStagingDataAlloc::retireFallbackPage() {
+    m_fallbackBuffers.push_back(std::move(m_fallbackPage));
+    m_fallbackOffset = 0;
+  }
+
+
+  void DxvkStagingDataAlloc::freeFallbackBuffers() {
+    for (auto i = m_fallbackBuffers.begin(); i != m_fallbackBuffers.end(); ) {
+      if (!(*i)->isInUse()) {
+        this->destroyBuffer(std::move(*i));
+        i = m_fallbackBuffers.erase(i);
+      } else {
+        i++;
+      }
+    }
   }
 
 
@@ -62,9 +134,18 @@ namespace dxvk {
     info.stages = VK_PIPELINE_STAGE_TRANSFER_BIT;
     info.access = VK_ACCESS_TRANSFER_READ_BIT;
 
-    return m_device->createBuffer(info,
+    Rc<DxvkBuffer> buffer = m_device->createBuffer(info,
       VK_MEMORY_PROPERTY_HOST_VISIBLE_BIT |
       VK_MEMORY_PROPERTY_HOST_COHERENT_BIT);
+
+    m_device->addStatCtr(DxvkStatCounter::MemoryStaging, size);
+    return buffer;
+  }
+
+
+  void DxvkStagingDataAlloc::destroyBuffer(Rc<DxvkBuffer>&& buffer) {
+    m_device->subStatCtr(DxvkStatCounter::MemoryStaging, buffer->info().size);
+    buffer = nullptr;
   }
   
 }
@@ -1,6 +1,6 @@
 #pragma once
 
-#include <queue>
+#include <vector>
 
 #include "dxvk_buffer.h"
 
@@ -11,13 +11,22 @@ namespace dxvk {
   /**
    * \brief Staging data allocator
    *
-   * Allocates buffer slices for resource uploads,
-   * while trying to keep the number of allocations
-   * but also the amount of allocated memory low.
+   * Allocates buffer slices for resource uploads from
+   * a ring of persistently mapped staging pages. Pages
+   * are recycled once the GPU is done with them, which
+   * is the case when the fences of all command lists
+   * that use the page have been signaled. New pages are
+   * only added to the ring while the total size of all
+   * pages stays within the configured budget.
+   *
+   * Allocations that cannot be served without exceeding
+   * the budget are sub-allocated from temporary pages
+   * outside the ring, which are destroyed once the GPU
+   * is done with them. Allocations that are larger than
+   * a page use a dedicated buffer.
    */
   class DxvkStagingDataAlloc {
-    constexpr static VkDeviceSize MaxBufferSize  = 1 << 24; // 16 MiB
-    constexpr static uint32_t     MaxBufferCount = 2;
+    constexpr static VkDeviceSize PageSize = 1 << 24; // 16 MiB
   public:
 
     DxvkStagingDataAlloc(const Rc<DxvkDevice>& device);
@@ -27,6 +36,8 @@ namespace dxvk {
     /**
      * \brief Alloctaes a staging buffer slice
      * 
+     * The returned slice must be used by the
+     * context before allocating the next one.
      * \param [in] align Alignment of the allocation
      * \param [in] size Size of the allocation
      * \returns Staging buffer slice
@@ -43,14 +54,28 @@ namespace dxvk {
 
   private:
 
-    Rc<DxvkDevice>  m_device;
-    Rc<DxvkBuffer>  m_buffer;
-    VkDeviceSize    m_offset = 0;
+    Rc<DxvkDevice>              m_device;
+    uint32_t                    m_maxPageCount;
+
+    std::vector<Rc<DxvkBuffer>> m_pages;
+    uint32_t                    m_pageIndex = 0;
+    VkDeviceSize                m_offset    = 0;
+
+    Rc<DxvkBuffer>              m_fallbackPage;
+    VkDeviceSize                m_fallbackOffset = 0;
+
+    std::vector<Rc<DxvkBuffer>> m_fallbackBuffers;
 
-    std::queue<Rc<DxvkBuffer>> m_buffers;
+    DxvkBufferSlice allocFallback(VkDeviceSize align, VkDeviceSize size);
+
+    void retireFallbackPage();
+
+    void freeFallbackBuffers();
 
     Rc<DxvkBuffer> createBuffer(VkDeviceSize size);
 
+    void destroyBuffer(Rc<DxvkBuffer>&& buffer);
+
   };
   
 }
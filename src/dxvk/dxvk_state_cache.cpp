@@ -79,45 +79,20 @@ namespace dxvk {
         writeCacheEntry(file, e);
     }
 
-    // Use half the available CPU cores for pipeline compilation
-    uint32_t numCpuCores = dxvk::thread::hardware_concurrency();
-    uint32_t numWorkers  = numCpuCores > 8
-      ? numCpuCores * 3 / 4
-      : numCpuCores * 1 / 2;
-
-    if (numWorkers <  1) numWorkers =  1;
-    if (numWorkers > 16) numWorkers = 16;
-
-    if (device->config().numCompilerThreads > 0)
-      numWorkers = device->config().numCompilerThreads;
-    
-    Logger::info(str::format("DXVK: Using ", numWorkers, " compiler threads"));
-    
-    // Start the worker threads and the file writer
-    m_workerBusy.store(numWorkers);
-
-    for (uint32_t i = 0; i < numWorkers; i++) {
-      m_workerThreads.emplace_back([this] () { workerFunc(); });
-      m_workerThreads[i].set_priority(ThreadPriority::Lowest);
-    }
-    
+    // Start the file writer, pipelines are compiled
+    // by the pipeline manager's worker threads
     m_writerThread = dxvk::thread([this] () { writerFunc(); });
   }
   
 
   DxvkStateCache::~DxvkStateCache() {
-    { std::lock_guard<std::mutex> workerLock(m_workerLock);
-      std::lock_guard<std::mutex> writerLock(m_writerLock);
+    { std::lock_guard<std::mutex> writerLock(m_writerLock);
 
       m_stopThreads.store(true);
 
-      m_workerCond.notify_all();
       m_writerCond.notify_all();
     }
 
-    for (auto& worker : m_workerThreads)
-      worker.join();
-    
     m_writerThread.join();
   }
 
@@ -183,9 +158,6 @@ namespace dxvk {
     std::unique_lock<std::mutex> entryLock(m_entryLock);
     m_shaderMap.insert({ key, shader });
 
-    // Deferred lock, don't stall workers unless we have to
-    std::unique_lock<std::mutex> workerLock;
-
     auto pipelines = m_pipelineMap.equal_range(key);
 
     for (auto p = pipelines.first; p != pipelines.second; p++) {
@@ -199,14 +171,8 @@ namespace dxvk {
        || !getShaderByKey(p->second.cs,  item.cs))
         continue;
       
-      if (!workerLock)
-        workerLock = std::unique_lock<std::mutex>(m_workerLock);
-      
-      m_workerQueue.push(item);
+      compilePipelines(item);
     }
-
-    if (workerLock)
-      m_workerCond.notify_all();
   }
 
 
@@ -263,7 +229,8 @@ namespace dxvk {
         const auto& entry = m_entries[e->second];
 
         auto rp = m_passManager->getRenderPass(entry.format);
-        pipeline->getPipelineHandle(entry.gpState, *rp);
+        m_pipeManager->m_workers->compileGraphicsPipeline(
+          pipeline, entry.gpState, rp, DxvkPipelinePriority::Normal);
       }
     } else {
       auto pipeline = m_pipeManager->createComputePipeline(item.cs);
@@ -271,7 +238,8 @@ namespace dxvk {
 
       for (auto e = entries.first; e != entries.second; e++) {
         const auto& entry = m_entries[e->second];
-        pipeline->getPipelineHandle(entry.cpState);
+        m_pipeManager->m_workers->compileComputePipeline(
+          pipeline, entry.cpState, DxvkPipelinePriority::Normal);
       }
     }
   }
@@ -481,37 +449,6 @@ namespace dxvk {
   }
 
 
-  void DxvkStateCache::workerFunc() {
-    env::setThreadName("dxvk-shader");
-
-    while (!m_stopThreads.load()) {
-      WorkerItem item;
-
-      { std::unique_lock<std::mutex> lock(m_workerLock);
-
-        if (m_workerQueue.empty()) {
-          m_workerBusy -= 1;
-          m_workerCond.wait(lock, [this] () {
-            return m_workerQueue.size()
-                || m_stopThreads.load();
-          });
-
-          if (!m_workerQueue.empty())
-            m_workerBusy += 1;
-        }
-
-        if (m_workerQueue.empty())
-          break;
-        
-        item = m_workerQueue.front();
-        m_workerQueue.pop();
-      }
-
-      compilePipelines(item);
-    }
-  }
-
-
   void DxvkStateCache::writerFunc() {
     env::setThreadName("dxvk-writer");
 
@@ -71,14 +71,6 @@ namespace dxvk {
     void registerShader(
       const Rc<DxvkShader>&                 shader);
     
-    /**
-     * \brief Checks whether compiler threads are busy
-     * \returns \c true if we're compiling shaders
-     */
-    bool isCompilingShaders() {
-      return m_workerBusy.load() > 0;
-    }
-
   private:
 
     using WriterItem = DxvkStateCacheEntry;
@@ -112,12 +104,6 @@ namespace dxvk {
       DxvkShaderKey, Rc<DxvkShader>,
       DxvkHash, DxvkEq> m_shaderMap;
 
-    std::mutex                        m_workerLock;
-    std::condition_variable           m_workerCond;
-    std::queue<WorkerItem>            m_workerQueue;
-    std::atomic<uint32_t>             m_workerBusy;
-    std::vector<dxvk::thread>         m_workerThreads;
-
     std::mutex                        m_writerLock;
     std::condition_variable           m_writerCond;
     std::queue<WriterItem>            m_writerQueue;
@@ -163,8 +149,6 @@ namespace dxvk {
       const DxvkStateCacheEntryV4&    in,
             DxvkStateCacheEntry&      out) const;
     
-    void workerFunc();
-
     void writerFunc();
 
     std::string getCacheFileName() const;
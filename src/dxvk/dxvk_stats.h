@@ -12,17 +12,33 @@ namespace dxvk {
    */
   enum class DxvkStatCounter : uint32_t {
     CmdDrawCalls,             ///< Number of draw calls
+    CmdDrawsSkipped,          ///< Number of draws skipped due to pipeline compilation
     CmdDispatchCalls,         ///< Number of compute calls
     CmdRenderPassCount,       ///< Number of render passes
+    DescriptorCacheHits,      ///< Number of reused descriptor sets
+    DescriptorCacheMisses,    ///< Number of newly written descriptor sets
     MemoryAllocationCount,    ///< Number of memory allocations
     MemoryAllocated,          ///< Amount of memory allocated
     MemoryUsed,               ///< Amount of memory used
+    MemoryFragmented,         ///< Amount of free memory outside the largest free block of each chunk
+    MemoryPooled,             ///< Amount of memory in front-end buffer pools
+    MemoryReclaimed,          ///< Amount of memory freed by the defragmenter
+    MemoryStaging,            ///< Amount of memory in staging buffers
     PipeCountGraphics,        ///< Number of graphics pipelines
     PipeCountCompute,         ///< Number of compute pipelines
     PipeCompilerBusy,         ///< Boolean indicating compiler activity
+    PipeStallTime,            ///< Time spent waiting for pipeline compilation, in us
     QueueSubmitCount,         ///< Number of command buffer submissions
     QueuePresentCount,        ///< Number of present calls / frames
+    QueueFlushCount,          ///< Number of implicit context flushes
+    GpuIdleTime,              ///< Time with no pending submissions, in us
     SamplerCount,             ///< Number of samplers
+    UploadConstantBytes,      ///< Amount of shader constant data uploaded
+    UploadTextureBytes,       ///< Amount of texture data uploaded
+    ShaderTranslationsQueued, ///< Number of shaders queued for translation
+    ShaderTranslationsDone,   ///< Number of shaders translated
+    ShaderModuleCacheHits,    ///< Number of shader modules reused
+    ShaderModuleCacheMisses,  ///< Number of shader modules created
     NumCounters,              ///< Number of counters available
   };
   
@@ -70,6 +86,16 @@ namespace dxvk {
       m_counters[uint32_t(ctr)] += val;
     }
     
+    /**
+     * \brief Decrements a counter value
+     * 
+     * \param [in] ctr Counter to decrement
+     * \param [in] val Number to subtract from counter value
+     */
+    void subCtr(DxvkStatCounter ctr, uint64_t val) {
+      m_counters[uint32_t(ctr)] -= val;
+    }
+    
     /**
      * \brief Resets a counter
      * \param [in] ctr The counter
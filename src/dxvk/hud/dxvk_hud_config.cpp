@@ -13,6 +13,9 @@ namespace dxvk::hud {
     { "pipelines",    HudElement::StatPipelines     },
     { "samplers",     HudElement::StatSamplers     },
     { "memory",       HudElement::StatMemory        },
+    { "uploads",      HudElement::StatUploads       },
+    { "shaders",      HudElement::StatShaders       },
+    { "descriptors",  HudElement::StatDescriptors   },
     { "version",      HudElement::DxvkVersion       },
     { "api",          HudElement::DxvkClientApi     },
     { "compiler",     HudElement::CompilerActivity  },
@@ -21,7 +21,10 @@ namespace dxvk::hud {
     DxvkVersion       = 7,
     DxvkClientApi     = 8,
     CompilerActivity  = 9,
-    StatSamplers      = 10
+    StatSamplers      = 10,
+    StatUploads       = 11,
+    StatShaders       = 12,
+    StatDescriptors   = 13,
   };
   
   using HudElements = Flags<HudElement>;
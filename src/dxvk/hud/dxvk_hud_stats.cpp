@@ -43,6 +43,15 @@ namespace dxvk::hud {
     if (m_elements.test(HudElement::StatMemory))
       position = this->printMemoryStats(context, renderer, position);
     
+    if (m_elements.test(HudElement::StatUploads))
+      position = this->printUploadStats(context, renderer, position);
+    
+    if (m_elements.test(HudElement::StatShaders))
+      position = this->printShaderStats(context, renderer, position);
+    
+    if (m_elements.test(HudElement::StatDescriptors))
+      position = this->printDescriptorStats(context, renderer, position);
+    
     if (m_elements.test(HudElement::CompilerActivity)) {
       this->printCompilerActivity(context, renderer,
         { position.x, float(renderer.surfaceSize().height) - 20.0f });
@@ -59,10 +68,12 @@ namespace dxvk::hud {
     const uint64_t frameCount = std::max<uint64_t>(m_diffCounters.getCtr(DxvkStatCounter::QueuePresentCount), 1);
     
     const uint64_t gpCalls = m_diffCounters.getCtr(DxvkStatCounter::CmdDrawCalls)       / frameCount;
+    const uint64_t gpSkips = m_diffCounters.getCtr(DxvkStatCounter::CmdDrawsSkipped)    / frameCount;
     const uint64_t cpCalls = m_diffCounters.getCtr(DxvkStatCounter::CmdDispatchCalls)   / frameCount;
     const uint64_t rpCalls = m_diffCounters.getCtr(DxvkStatCounter::CmdRenderPassCount) / frameCount;
     
     const std::string strDrawCalls      = str::format("Draw calls:     ", gpCalls);
+    const std::string strDrawsSkipped   = str::format("Skipped draws:  ", gpSkips);
     const std::string strDispatchCalls  = str::format("Dispatch calls: ", cpCalls);
     const std::string strRenderPasses   = str::format("Render passes:  ", rpCalls);
     
@@ -81,7 +92,16 @@ namespace dxvk::hud {
       { 1.0f, 1.0f, 1.0f, 1.0f },
       strRenderPasses);
     
-    return { position.x, position.y + 64 };
+    // Only shown if any draws were skipped
+    if (!m_diffCounters.getCtr(DxvkStatCounter::CmdDrawsSkipped))
+      return { position.x, position.y + 64 };
+    
+    renderer.drawText(context, 16.0f,
+      { position.x, position.y + 60.0f },
+      { 1.0f, 1.0f, 1.0f, 1.0f },
+      strDrawsSkipped);
+    
+    return { position.x, position.y + 84 };
   }
   
   
@@ -91,15 +111,29 @@ namespace dxvk::hud {
           HudPos            position) {
     const uint64_t frameCount = std::max<uint64_t>(m_diffCounters.getCtr(DxvkStatCounter::QueuePresentCount), 1);
     const uint64_t numSubmits = m_diffCounters.getCtr(DxvkStatCounter::QueueSubmitCount) / frameCount;
+    const uint64_t numFlushes = m_diffCounters.getCtr(DxvkStatCounter::QueueFlushCount)  / frameCount;
+    const uint64_t gpuIdleUs  = m_diffCounters.getCtr(DxvkStatCounter::GpuIdleTime)      / frameCount;
     
     const std::string strSubmissions = str::format("Queue submissions: ", numSubmits);
+    const std::string strFlushes     = str::format("Implicit flushes:  ", numFlushes);
+    const std::string strGpuIdle     = str::format("GPU idle:          ", gpuIdleUs, " us");
     
     renderer.drawText(context, 16.0f,
       { position.x, position.y },
       { 1.0f, 1.0f, 1.0f, 1.0f },
       strSubmissions);
     
-    return { position.x, position.y + 24.0f };
+    renderer.drawText(context, 16.0f,
+      { position.x, position.y + 20.0f },
+      { 1.0f, 1.0f, 1.0f, 1.0f },
+      strFlushes);
+    
+    renderer.drawText(context, 16.0f,
+      { position.x, position.y + 40.0f },
+      { 1.0f, 1.0f, 1.0f, 1.0f },
+      strGpuIdle);
+    
+    return { position.x, position.y + 64.0f };
   }
   
   
@@ -107,11 +141,15 @@ namespace dxvk::hud {
     const Rc<DxvkContext>&  context,
           HudRenderer&      renderer,
           HudPos            position) {
+    const uint64_t frameCount = std::max<uint64_t>(m_diffCounters.getCtr(DxvkStatCounter::QueuePresentCount), 1);
+    
     const uint64_t gpCount = m_prevCounters.getCtr(DxvkStatCounter::PipeCountGraphics);
     const uint64_t cpCount = m_prevCounters.getCtr(DxvkStatCounter::PipeCountCompute);
+    const uint64_t stallUs = m_diffCounters.getCtr(DxvkStatCounter::PipeStallTime) / frameCount;
     
     const std::string strGpCount = str::format("Graphics pipelines: ", gpCount);
     const std::string strCpCount = str::format("Compute pipelines:  ", cpCount);
+    const std::string strStall   = str::format("Pipeline stalls:    ", stallUs, " us");
     
     renderer.drawText(context, 16.0f,
       { position.x, position.y },
@@ -123,7 +161,12 @@ namespace dxvk::hud {
       { 1.0f, 1.0f, 1.0f, 1.0f },
       strCpCount);
     
-    return { position.x, position.y + 44.0f };
+    renderer.drawText(context, 16.0f,
+      { position.x, position.y + 40.0f },
+      { 1.0f, 1.0f, 1.0f, 1.0f },
+      strStall);
+    
+    return { position.x, position.y + 64.0f };
   }
   
   
@@ -133,11 +176,20 @@ namespace dxvk::hud {
           HudPos            position) {
     constexpr uint64_t mib = 1024 * 1024;
     
-    const uint64_t memAllocated = m_prevCounters.getCtr(DxvkStatCounter::MemoryAllocated);
-    const uint64_t memUsed      = m_prevCounters.getCtr(DxvkStatCounter::MemoryUsed);
+    const uint64_t memAllocated  = m_prevCounters.getCtr(DxvkStatCounter::MemoryAllocated);
+    const uint64_t memUsed       = m_prevCounters.getCtr(DxvkStatCounter::MemoryUsed);
+    const uint64_t memFragmented = m_prevCounters.getCtr(DxvkStatCounter::MemoryFragmented);
+    
+    const uint64_t memPooled     = m_prevCounters.getCtr(DxvkStatCounter::MemoryPooled);
+    const uint64_t memReclaimed  = m_prevCounters.getCtr(DxvkStatCounter::MemoryReclaimed);
+    const uint64_t memStaging    = m_prevCounters.getCtr(DxvkStatCounter::MemoryStaging);
     
-    const std::string strMemAllocated = str::format("Memory allocated: ", memAllocated / mib, " MB");
-    const std::string strMemUsed      = str::format("Memory used:      ", memUsed      / mib, " MB");
+    const std::string strMemAllocated  = str::format("Memory allocated:  ", memAllocated  / mib, " MB");
+    const std::string strMemUsed       = str::format("Memory used:       ", memUsed       / mib, " MB");
+    const std::string strMemFragmented = str::format("Memory fragmented: ", memFragmented / mib, " MB");
+    const std::string strMemPooled     = str::format("Memory pooled:     ", memPooled     / mib, " MB");
+    const std::string strMemReclaimed  = str::format("Memory reclaimed:  ", memReclaimed  / mib, " MB");
+    const std::string strMemStaging    = str::format("Memory staging:    ", memStaging    / mib, " MB");
     
     renderer.drawText(context, 16.0f,
       { position.x, position.y },
@@ -149,7 +201,41 @@ namespace dxvk::hud {
       { 1.0f, 1.0f, 1.0f, 1.0f },
       strMemUsed);
     
-    return { position.x, position.y + 44.0f };
+    renderer.drawText(context, 16.0f,
+      { position.x, position.y + 40.0f },
+      { 1.0f, 1.0f, 1.0f, 1.0f },
+      strMemFragmented);
+    
+    float offset = 60.0f;
+    
+    // Only front-ends that pool buffers report this
+    if (memPooled) {
+      renderer.drawText(context, 16.0f,
+        { position.x, position.y + offset },
+        { 1.0f, 1.0f, 1.0f, 1.0f },
+        strMemPooled);
+      offset += 20.0f;
+    }
+    
+    // Memory held by staging buffers, whether in use or not
+    if (memStaging) {
+      renderer.drawText(context, 16.0f,
+        { position.x, position.y + offset },
+        { 1.0f, 1.0f, 1.0f, 1.0f },
+        strMemStaging);
+      offset += 20.0f;
+    }
+    
+    // Only reported if the defragmenter is enabled
+    if (memReclaimed) {
+      renderer.drawText(context, 16.0f,
+        { position.x, position.y + offset },
+        { 1.0f, 1.0f, 1.0f, 1.0f },
+        strMemReclaimed);
+      offset += 20.0f;
+    }
+    
+    return { position.x, position.y + offset + 4.0f };
   }
 
 
@@ -196,6 +282,87 @@ namespace dxvk::hud {
     return { position.x, position.y + 24.0f };
   }
 
+
+
+  HudPos HudStats::printUploadStats(
+    const Rc<DxvkContext>&  context,
+          HudRenderer&      renderer,
+          HudPos            position) {
+    constexpr uint64_t kib = 1024;
+
+    const uint64_t frameCount = std::max<uint64_t>(m_diffCounters.getCtr(DxvkStatCounter::QueuePresentCount), 1);
+    const uint64_t constBytes = m_diffCounters.getCtr(DxvkStatCounter::UploadConstantBytes) / frameCount;
+    const uint64_t texBytes   = m_diffCounters.getCtr(DxvkStatCounter::UploadTextureBytes)  / frameCount;
+
+    const std::string strConstBytes = str::format("Constant uploads: ", constBytes / kib, " kB");
+    const std::string strTexBytes   = str::format("Texture uploads:  ", texBytes   / kib, " kB");
+
+    renderer.drawText(context, 16.0f,
+      { position.x, position.y },
+      { 1.0f, 1.0f, 1.0f, 1.0f },
+      strConstBytes);
+
+    renderer.drawText(context, 16.0f,
+      { position.x, position.y + 20.0f },
+      { 1.0f, 1.0f, 1.0f, 1.0f },
+      strTexBytes);
+
+    return { position.x, position.y + 44.0f };
+  }
+
+
+  HudPos HudStats::printShaderStats(
+    const Rc<DxvkContext>&  context,
+          HudRenderer&      renderer,
+          HudPos            position) {
+    const uint64_t queued = m_prevCounters.getCtr(DxvkStatCounter::ShaderTranslationsQueued);
+    const uint64_t done   = m_prevCounters.getCtr(DxvkStatCounter::ShaderTranslationsDone);
+
+    const uint64_t hits   = m_prevCounters.getCtr(DxvkStatCounter::ShaderModuleCacheHits);
+    const uint64_t misses = m_prevCounters.getCtr(DxvkStatCounter::ShaderModuleCacheMisses);
+
+    const std::string strShaders = str::format("Shaders translated: ", done, " / ", queued);
+    const std::string strModules = str::format("Shader modules:     ", misses, " (", hits, " reused)");
+
+    renderer.drawText(context, 16.0f,
+      { position.x, position.y },
+      { 1.0f, 1.0f, 1.0f, 1.0f },
+      strShaders);
+
+    renderer.drawText(context, 16.0f,
+      { position.x, position.y + 20.0f },
+      { 1.0f, 1.0f, 1.0f, 1.0f },
+      strModules);
+
+    return { position.x, position.y + 44.0f };
+  }
+
+
+  HudPos HudStats::printDescriptorStats(
+    const Rc<DxvkContext>&  context,
+          HudRenderer&      renderer,
+          HudPos            position) {
+    const uint64_t frameCount = std::max<uint64_t>(m_diffCounters.getCtr(DxvkStatCounter::QueuePresentCount), 1);
+    const uint64_t hits       = m_diffCounters.getCtr(DxvkStatCounter::DescriptorCacheHits);
+    const uint64_t misses     = m_diffCounters.getCtr(DxvkStatCounter::DescriptorCacheMisses);
+    const uint64_t hitRate    = hits + misses ? (100 * hits) / (hits + misses) : 0;
+
+    const std::string strSets    = str::format("Descriptor sets: ", (hits + misses) / frameCount);
+    const std::string strHitRate = str::format("Set cache hits:  ", hitRate, "%");
+
+    renderer.drawText(context, 16.0f,
+      { position.x, position.y },
+      { 1.0f, 1.0f, 1.0f, 1.0f },
+      strSets);
+
+    renderer.drawText(context, 16.0f,
+      { position.x, position.y + 20.0f },
+      { 1.0f, 1.0f, 1.0f, 1.0f },
+      strHitRate);
+
+    return { position.x, position.y + 44.0f };
+  }
+
   
   HudElements HudStats::filterElements(HudElements elements) {
     return elements & HudElements(
@@ -204,6 +371,9 @@ namespace dxvk::hud {
       HudElement::StatPipelines,
       HudElement::StatSamplers,
       HudElement::StatMemory,
+      HudElement::StatUploads,
+      HudElement::StatShaders,
+      HudElement::StatDescriptors,
       HudElement::CompilerActivity);
   }
   
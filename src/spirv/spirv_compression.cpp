@@ -1,15 +1,153 @@
+#include <cstring>
+
 #include "spirv_compression.h"
 
+#if defined(_MSC_VER)
+#define SPIRV_TARGET_SSSE3
+#else
+#define SPIRV_TARGET_SSSE3 __attribute__((target("ssse3")))
+#endif
+
 namespace dxvk {
 
+  /**
+   * \brief Shuffle tables for compressed code
+   *
+   * Each control byte stores the byte counts of four
+   * consecutive DWORDs, so a single shuffle can expand
+   * or compact four DWORDs at once. The tables are
+   * indexed by the control byte.
+   */
+  struct SpirvCompressionTables {
+    alignas(16) uint8_t decode[256][16];
+    alignas(16) uint8_t encode[256][16];
+    uint8_t length[256];
+
+    constexpr SpirvCompressionTables()
+    : decode(), encode(), length() {
+      for (uint32_t c = 0; c < 256; c++) {
+        uint32_t offset = 0;
+
+        for (uint32_t i = 0; i < 16; i++) {
+          decode[c][i] = 0x80;
+          encode[c][i] = 0x80;
+        }
+
+        for (uint32_t w = 0; w < 4; w++) {
+          uint32_t bytes = ((c >> (2 * w)) & 3) + 1;
+
+          for (uint32_t b = 0; b < bytes; b++) {
+            decode[c][4 * w + b] = offset + b;
+            encode[c][offset + b] = 4 * w + b;
+          }
+
+          offset += bytes;
+        }
+
+        length[c] = offset;
+      }
+    }
+  };
+
+  static constexpr SpirvCompressionTables g_tables;
+
+  static bool hasSsse3() {
+    #if defined(_MSC_VER)
+    int info[4];
+    __cpuid(info, 1);
+    return info[2] & (1 << 9);
+    #else
+    return __builtin_cpu_supports("ssse3");
+    #endif
+  }
+
+  static const bool g_useSsse3 = hasSsse3();
+
+
+  /**
+   * \brief Compresses groups of four DWORDs using SSSE3
+   *
+   * Stops when there are less than four DWORDs left.
+   * The destination must have 16 bytes of padding.
+   * \returns Number of DWORDs processed
+   */
+  SPIRV_TARGET_SSSE3
+  static uint32_t encodeSsse3(
+          uint32_t                count,
+    const uint32_t*               src,
+          uint8_t*                ctrl,
+          uint8_t*                dst,
+          size_t&                 dstOffset) {
+    uint32_t i = 0;
+
+    for ( ; i + 4 <= count; i += 4) {
+      uint32_t c = 0;
+
+      for (uint32_t w = 0; w < 4; w++) {
+        uint32_t word = src[i + w];
+        c |= ((word >= (1u << 8)) + (word >= (1u << 16)) + (word >= (1u << 24))) << (2 * w);
+      }
+
+      __m128i data = _mm_loadu_si128(reinterpret_cast<const __m128i*>(src + i));
+      __m128i shuf = _mm_load_si128(reinterpret_cast<const __m128i*>(g_tables.encode[c]));
+      _mm_storeu_si128(reinterpret_cast<__m128i*>(dst + dstOffset), _mm_shuffle_epi8(data, shuf));
+
+      ctrl[i / 4] = c;
+      dstOffset += g_tables.length[c];
+    }
+
+    return i;
+  }
+
+
+  /**
+   * \brief Decompresses groups of four DWORDs using SSSE3
+   *
+   * Stops when there are less than four DWORDs left, or
+   * when a 16-byte load would exceed the source buffer.
+   * \returns Number of DWORDs processed
+   */
+  SPIRV_TARGET_SSSE3
+  static uint32_t decodeSsse3(
+          uint32_t                count,
+    const uint8_t*                ctrl,
+    const uint8_t*                src,
+          size_t                  srcSize,
+          size_t&                 srcOffset,
+          uint32_t*               dst) {
+    uint32_t i = 0;
+
+    for ( ; i + 4 <= count && srcOffset + 16 <= srcSize; i += 4) {
+      uint32_t c = ctrl[i / 4];
+
+      __m128i data = _mm_loadu_si128(reinterpret_cast<const __m128i*>(src + srcOffset));
+      __m128i shuf = _mm_load_si128(reinterpret_cast<const __m128i*>(g_tables.decode[c]));
+      _mm_storeu_si128(reinterpret_cast<__m128i*>(dst + i), _mm_shuffle_epi8(data, shuf));
+
+      srcOffset += g_tables.length[c];
+    }
+
+    return i;
+  }
+
   SpirvCompressedBuffer::SpirvCompressedBuffer()
   : m_size(0) {
 
   }
 
 
+  static bool useSsse3(SpirvCompressionCodec codec) {
+    switch (codec) {
+      case SpirvCompressionCodec::Default: return g_useSsse3;
+      case SpirvCompressionCodec::Ssse3:   return true;
+      default:                             return false;
+    }
+  }
+
+
   SpirvCompressedBuffer::SpirvCompressedBuffer(
-    const SpirvCodeBuffer& code)
+    const SpirvCodeBuffer&      code,
+          SpirvCompressionCodec codec)
   : m_size(code.dwords()) {
     const uint32_t* data = code.data();
 
@@ -19,46 +157,43 @@ namespace dxvk {
     // each DWORD, a two-bit integer is stored which indicates
     // the number of bytes it takes in the compressed buffer.
     // This way, it can achieve a compression ratio of ~50%.
-    m_mask.reserve((m_size + NumMaskWords - 1) / NumMaskWords);
-    m_code.reserve((m_size + 1) / 2);
-
-    uint64_t dstWord  = 0;
-    uint32_t dstShift = 0;
+    //
+    // The remaining bytes are stored as a contiguous stream,
+    // and every group of four DWORDs has its byte counts in
+    // one byte of the mask, which allows encoding and decoding
+    // four DWORDs at a time with a single byte shuffle.
+    m_mask.resize((m_size + NumMaskWords - 1) / NumMaskWords);
+    m_code.resize((4 * m_size + 16 + 7) / 8);
 
-    for (uint32_t i = 0; i < m_size; i += NumMaskWords) {
-      uint64_t byteCounts = 0;
+    auto ctrl = reinterpret_cast<uint8_t*>(m_mask.data());
+    auto dst  = reinterpret_cast<uint8_t*>(m_code.data());
 
-      for (uint32_t w = 0; w < NumMaskWords && i + w < m_size; w++) {
-        uint64_t word = data[i + w];
-        uint64_t bytes = 0;
+    size_t   dstOffset = 0;
+    uint32_t i = 0;
 
-        if      (word < (1 <<  8)) bytes = 0;
-        else if (word < (1 << 16)) bytes = 1;
-        else if (word < (1 << 24)) bytes = 2;
-        else                       bytes = 3;
+    if (useSsse3(codec))
+      i = encodeSsse3(m_size, data, ctrl, dst, dstOffset);
 
-        byteCounts |= bytes << (2 * w);
+    for ( ; i < m_size; i++) {
+      uint32_t word  = data[i];
+      uint32_t bytes = 0;
 
-        uint32_t bits = 8 * bytes + 8;
-        uint32_t rem  = bit::pack(dstWord, dstShift, word, bits);
+      if      (word < (1 <<  8)) bytes = 0;
+      else if (word < (1 << 16)) bytes = 1;
+      else if (word < (1 << 24)) bytes = 2;
+      else                       bytes = 3;
 
-        if (unlikely(rem != 0)) {
-          m_code.push_back(dstWord);
+      ctrl[i / 4] |= bytes << (2 * (i % 4));
 
-          dstWord  = 0;
-          dstShift = 0;
-
-          bit::pack(dstWord, dstShift, word >> (bits - rem), rem);
-        }
-      }
-
-      m_mask.push_back(byteCounts);
+      std::memcpy(dst + dstOffset, &word, sizeof(word));
+      dstOffset += bytes + 1;
     }
 
-    if (dstShift)
-      m_code.push_back(dstWord);
+    // Clear any bytes written past the end of the stream
+    size_t codeSize = (dstOffset + 7) / 8;
+    std::memset(dst + dstOffset, 0, codeSize * 8 - dstOffset);
 
-    m_mask.shrink_to_fit();
+    m_code.resize(codeSize);
     m_code.shrink_to_fit();
   }
 
@@ -68,43 +203,95 @@ namespace dxvk {
   }
 
 
-  SpirvCodeBuffer SpirvCompressedBuffer::decompress() const {
+  SpirvCodeBuffer SpirvCompressedBuffer::decompress(
+          SpirvCompressionCodec codec) const {
     SpirvCodeBuffer code(m_size);
     uint32_t* data = code.data();
 
-    if (m_size == 0)
-      return code;
-
-    uint32_t maskIdx = 0;
-    uint32_t codeIdx = 0;
-
-    uint64_t srcWord  = m_code[codeIdx++];
-    uint32_t srcShift = 0;
-
-    for (uint32_t i = 0; i < m_size; i += NumMaskWords) {
-      uint64_t srcMask = m_mask[maskIdx++];
+    auto ctrl = reinterpret_cast<const uint8_t*>(m_mask.data());
+    auto src  = reinterpret_cast<const uint8_t*>(m_code.data());
 
-      for (uint32_t w = 0; w < NumMaskWords && i + w < m_size; w++) {
-        uint32_t bits = 8 * ((srcMask & 3) + 1);
+    size_t   srcSize   = m_code.size() * sizeof(uint64_t);
+    size_t   srcOffset = 0;
+    uint32_t i = 0;
 
-        uint64_t word = 0;
-        uint32_t rem = bit::unpack(word, srcWord, srcShift, bits);
+    if (useSsse3(codec))
+      i = decodeSsse3(m_size, ctrl, src, srcSize, srcOffset, data);
 
-        if (unlikely(rem != 0)) {
-          srcWord  = m_code[codeIdx++];
-          srcShift = 0;
+    for ( ; i < m_size; i++) {
+      uint32_t bytes = ((ctrl[i / 4] >> (2 * (i % 4))) & 3) + 1;
 
-          uint64_t tmp = 0;
-          bit::unpack(tmp, srcWord, srcShift, rem);
-          word |= tmp << (bits - rem);
-        }
+      uint32_t word = 0;
 
-        data[i + w] = word;
-        srcMask >>= 2;
+      // Avoid reading past the end of the buffer
+      if (likely(srcOffset + sizeof(word) <= srcSize)) {
+        std::memcpy(&word, src + srcOffset, sizeof(word));
+        word &= ~0ull >> (64 - 8 * bytes);
+      } else {
+        std::memcpy(&word, src + srcOffset, bytes);
       }
+
+      data[i] = word;
+      srcOffset += bytes;
     }
 
     return code;
   }
 
-}
\ No newline at end of file
+
+  bool SpirvCompressedBuffer::isCodecSupported(
+          SpirvCompressionCodec codec) {
+    return codec != SpirvCompressionCodec::Ssse3 || g_useSsse3;
+  }
+
+
+  void SpirvCompressedBuffer::write(std::ostream& stream) const {
+    uint32_t maskCount = m_mask.size();
+    uint32_t codeCount = m_code.size();
+
+    stream.write(reinterpret_cast<const char*>(&m_size),    sizeof(m_size));
+    stream.write(reinterpret_cast<const char*>(&maskCount), sizeof(maskCount));
+    stream.write(reinterpret_cast<const char*>(&codeCount), sizeof(codeCount));
+
+    stream.write(reinterpret_cast<const char*>(m_mask.data()), maskCount * sizeof(uint64_t));
+    stream.write(reinterpret_cast<const char*>(m_code.data()), codeCount * sizeof(uint64_t));
+  }
+
+
+  bool SpirvCompressedBuffer::read(std::istream& stream) {
+    uint32_t maskCount = 0;
+    uint32_t codeCount = 0;
+
+    if (!stream.read(reinterpret_cast<char*>(&m_size),    sizeof(m_size))
+     || !stream.read(reinterpret_cast<char*>(&maskCount), sizeof(maskCount))
+     || !stream.read(reinterpret_cast<char*>(&codeCount), sizeof(codeCount)))
+      return false;
+
+    // Reject sizes that cannot possibly be valid
+    // before allocating memory for the arrays
+    if (maskCount != (m_size + NumMaskWords - 1) / NumMaskWords
+     || codeCount > m_size)
+      return false;
+
+    m_mask.resize(maskCount);
+    m_code.resize(codeCount);
+
+    if (!stream.read(reinterpret_cast<char*>(m_mask.data()), maskCount * sizeof(uint64_t))
+     || !stream.read(reinterpret_cast<char*>(m_code.data()), codeCount * sizeof(uint64_t)))
+      return false;
+
+    // Decoding trusts the byte counts stored in the
+    // mask, so they must not exceed the payload size
+    auto ctrl = reinterpret_cast<const uint8_t*>(m_mask.data());
+    size_t codeSize = 0;
+
+    for (uint32_t i = 0; i < m_size / 4; i++)
+      codeSize += g_tables.length[ctrl[i]];
+
+    for (uint32_t i = m_size & ~3u; i < m_size; i++)
+      codeSize += ((ctrl[i / 4] >> (2 * (i % 4))) & 3) + 1;
+
+    return codeSize <= codeCount * sizeof(uint64_t);
+  }
+
+}
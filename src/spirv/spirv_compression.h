@@ -1,11 +1,25 @@
 #pragma once
 
+#include <iostream>
 #include <vector>
 
 #include "spirv_code_buffer.h"
 
 namespace dxvk {
 
+  /**
+   * \brief SPIR-V compression codec
+   *
+   * All codecs produce the same compressed data,
+   * they only differ in how fast they are. Mostly
+   * useful to test and benchmark each of them.
+   */
+  enum class SpirvCompressionCodec : uint32_t {
+    Default,  ///< Fastest codec supported by the CPU
+    Scalar,   ///< Portable implementation
+    Ssse3,    ///< Four DWORDs at a time with byte shuffles
+  };
+
   /**
    * \brief Compressed SPIR-V code buffer
    *
@@ -19,11 +33,42 @@ namespace dxvk {
     SpirvCompressedBuffer();
 
     SpirvCompressedBuffer(
-      const SpirvCodeBuffer&  code);
+      const SpirvCodeBuffer&  code,
+            SpirvCompressionCodec codec = SpirvCompressionCodec::Default);
     
     ~SpirvCompressedBuffer();
     
-    SpirvCodeBuffer decompress() const;
+    SpirvCodeBuffer decompress(
+            SpirvCompressionCodec codec = SpirvCompressionCodec::Default) const;
+
+    /**
+     * \brief Checks whether a codec can be used
+     *
+     * \param [in] codec The codec to check
+     * \returns \c true if the CPU supports the codec
+     */
+    static bool isCodecSupported(
+            SpirvCompressionCodec codec);
+
+    /**
+     * \brief Writes compressed code to a stream
+     *
+     * Stores the buffer in its compressed form
+     * so that it can be read back without
+     * having to compress the code again.
+     * \param [in] stream Output stream
+     */
+    void write(std::ostream& stream) const;
+
+    /**
+     * \brief Reads compressed code from a stream
+     *
+     * Fails if the data is truncated, or if the
+     * stored sizes are inconsistent.
+     * \param [in] stream Input stream
+     * \returns \c true on success
+     */
+    bool read(std::istream& stream);
 
   private:
 
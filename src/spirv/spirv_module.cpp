@@ -2,6 +2,8 @@
 
 #include "spirv_module.h"
 
+#include "../dxvk/dxvk_hash.h"
+
 namespace dxvk {
   
   SpirvModule:: SpirvModule() {
@@ -389,6 +391,8 @@ namespace dxvk {
       ? spv::OpSpecConstantTrue
       : spv::OpSpecConstantFalse;
     
+    this->indexTypeConst(op, typeId, 0, nullptr);
+    
     m_typeConstDefs.putIns  (op, 3);
     m_typeConstDefs.putWord (typeId);
     m_typeConstDefs.putWord (resultId);
@@ -401,6 +405,8 @@ namespace dxvk {
           uint32_t                value) {
     uint32_t resultId = this->allocateId();
     
+    this->indexTypeConst(spv::OpSpecConstant, typeId, 1, &value);
+    
     m_typeConstDefs.putIns  (spv::OpSpecConstant, 4);
     m_typeConstDefs.putWord (typeId);
     m_typeConstDefs.putWord (resultId);
@@ -644,6 +650,9 @@ namespace dxvk {
           uint32_t                length) {
     uint32_t resultId = this->allocateId();
     
+    std::array<uint32_t, 2> args = { typeId, length };
+    this->indexTypeConst(spv::OpTypeArray, 0, args.size(), args.data());
+    
     m_typeConstDefs.putIns (spv::OpTypeArray, 4);
     m_typeConstDefs.putWord(resultId);
     m_typeConstDefs.putWord(typeId);
@@ -665,6 +674,8 @@ namespace dxvk {
           uint32_t                typeId) {
     uint32_t resultId = this->allocateId();
     
+    this->indexTypeConst(spv::OpTypeRuntimeArray, 0, 1, &typeId);
+    
     m_typeConstDefs.putIns (spv::OpTypeRuntimeArray, 3);
     m_typeConstDefs.putWord(resultId);
     m_typeConstDefs.putWord(typeId);
@@ -700,6 +711,8 @@ namespace dxvk {
     const uint32_t*               memberTypes) {
     uint32_t resultId = this->allocateId();
     
+    this->indexTypeConst(spv::OpTypeStruct, 0, memberCount, memberTypes);
+    
     m_typeConstDefs.putIns (spv::OpTypeStruct, 2 + memberCount);
     m_typeConstDefs.putWord(resultId);
     
@@ -3394,19 +3407,16 @@ namespace dxvk {
     // Since the type info is stored in the code buffer,
     // we can use the code buffer to look up type IDs as
     // well. Result IDs are always stored as argument 1.
-    for (auto ins : m_typeConstDefs) {
-      bool match = ins.opCode() == op
-                && ins.length() == 2 + argCount;
-      
-      for (uint32_t i = 0; i < argCount && match; i++)
-        match &= ins.arg(2 + i) == argIds[i];
-      
-      if (match)
-        return ins.arg(1);
-    }
+    size_t hash = hashTypeConst(op, 0, argCount, argIds);
+    
+    uint32_t resultId = this->findTypeConst(hash, op, 0, argCount, argIds);
+    
+    if (resultId)
+      return resultId;
     
     // Type not yet declared, create a new one.
-    uint32_t resultId = this->allocateId();
+    resultId = this->allocateId();
+    m_typeConstIndex.insert({ hash, m_typeConstDefs.dwords() });
     m_typeConstDefs.putIns (op, 2 + argCount);
     m_typeConstDefs.putWord(resultId);
     
@@ -3422,20 +3432,16 @@ namespace dxvk {
           uint32_t                argCount,
     const uint32_t*               argIds) {
     // Avoid declaring constants multiple times
-    for (auto ins : m_typeConstDefs) {
-      bool match = ins.opCode() == op
-                && ins.length() == 3 + argCount
-                && ins.arg(1)   == typeId;
-      
-      for (uint32_t i = 0; i < argCount && match; i++)
-        match &= ins.arg(3 + i) == argIds[i];
-      
-      if (match)
-        return ins.arg(2);
-    }
+    size_t hash = hashTypeConst(op, typeId, argCount, argIds);
+    
+    uint32_t resultId = this->findTypeConst(hash, op, typeId, argCount, argIds);
+    
+    if (resultId)
+      return resultId;
     
     // Constant not yet declared, make a new one
-    uint32_t resultId = this->allocateId();
+    resultId = this->allocateId();
+    m_typeConstIndex.insert({ hash, m_typeConstDefs.dwords() });
     m_typeConstDefs.putIns (op, 3 + argCount);
     m_typeConstDefs.putWord(typeId);
     m_typeConstDefs.putWord(resultId);
@@ -3446,6 +3452,66 @@ namespace dxvk {
   }
   
   
+  uint32_t SpirvModule::findTypeConst(
+          size_t                  hash,
+          spv::Op                 op,
+          uint32_t                typeId,
+          uint32_t                argCount,
+    const uint32_t*               argIds) {
+    // Types have no result type, so the result ID is stored
+    // as argument 1. For constants, it is stored as argument 2.
+    const uint32_t argOffset = typeId ? 3 : 2;
+    
+    auto entries = m_typeConstIndex.equal_range(hash);
+    
+    for (auto e = entries.first; e != entries.second; e++) {
+      SpirvInstruction ins(m_typeConstDefs.data(), e->second, m_typeConstDefs.dwords());
+      
+      bool match = ins.opCode() == op
+                && ins.length() == argOffset + argCount
+                && (!typeId || ins.arg(1) == typeId);
+      
+      for (uint32_t i = 0; i < argCount && match; i++)
+        match &= ins.arg(argOffset + i) == argIds[i];
+      
+      if (match)
+        return ins.arg(argOffset - 1);
+    }
+    
+    return 0;
+  }
+  
+  
+  void SpirvModule::indexTypeConst(
+          spv::Op                 op,
+          uint32_t                typeId,
+          uint32_t                argCount,
+    const uint32_t*               argIds) {
+    // Only the first matching declaration may be indexed, so
+    // that lookups return the same ID as a linear search would
+    size_t hash = hashTypeConst(op, typeId, argCount, argIds);
+    
+    if (!this->findTypeConst(hash, op, typeId, argCount, argIds))
+      m_typeConstIndex.insert({ hash, m_typeConstDefs.dwords() });
+  }
+  
+  
+  size_t SpirvModule::hashTypeConst(
+          spv::Op                 op,
+          uint32_t                typeId,
+          uint32_t                argCount,
+    const uint32_t*               argIds) {
+    DxvkHashState hash;
+    hash.add(uint32_t(op));
+    hash.add(typeId);
+    
+    for (uint32_t i = 0; i < argCount; i++)
+      hash.add(argIds[i]);
+    
+    return hash;
+  }
+  
+  
   void SpirvModule::instImportGlsl450() {
     m_instExtGlsl450 = this->allocateId();
     const char* name = "GLSL.std.450";
@@ -1,5 +1,7 @@
 #pragma once
 
+#include <unordered_map>
+
 #include "spirv_code_buffer.h"
 
 namespace dxvk {
@@ -1172,6 +1174,11 @@ namespace dxvk {
     SpirvCodeBuffer m_variables;
     SpirvCodeBuffer m_code;
     
+    // Maps the hash of a type or constant declaration,
+    // excluding its result ID, to its dword offset in
+    // the type and constant declaration code buffer.
+    std::unordered_multimap<size_t, uint32_t> m_typeConstIndex;
+    
     uint32_t defType(
             spv::Op                 op, 
             uint32_t                argCount,
@@ -1183,6 +1190,25 @@ namespace dxvk {
             uint32_t                argCount,
       const uint32_t*               argIds);
     
+    uint32_t findTypeConst(
+            size_t                  hash,
+            spv::Op                 op,
+            uint32_t                typeId,
+            uint32_t                argCount,
+      const uint32_t*               argIds);
+    
+    void indexTypeConst(
+            spv::Op                 op,
+            uint32_t                typeId,
+            uint32_t                argCount,
+      const uint32_t*               argIds);
+    
+    static size_t hashTypeConst(
+            spv::Op                 op,
+            uint32_t                typeId,
+            uint32_t                argCount,
+      const uint32_t*               argIds);
+    
     void instImportGlsl450();
     
     uint32_t getImageOperandWordCount(
@@ -0,0 +1,1206 @@
+#include <array>
+#include <chrono>
+#include <cmath>
+#include <cstring>
+
+#include "spirv_optimizer.h"
+
+namespace dxvk {
+
+  /**
+   * \brief Operand layout of an instruction
+   *
+   * Stores which arguments of an instruction are IDs.
+   * Instructions with an unknown layout are treated
+   * conservatively, i.e. every argument is assumed
+   * to potentially reference an ID.
+   */
+  struct SpirvOperandInfo {
+    bool     known     = true;
+    uint32_t resultArg = 0;
+    uint32_t idMask    = 0;
+    uint32_t idsFrom   = 0;
+  };
+
+
+  static bool isValueOp(spv::Op op) {
+    switch (op) {
+      case spv::OpConstantComposite:
+      case spv::OpSpecConstantComposite:
+      case spv::OpFunctionParameter:
+      case spv::OpFunctionCall:
+      case spv::OpAccessChain:
+      case spv::OpInBoundsAccessChain:
+      case spv::OpSampledImage:
+      case spv::OpImage:
+      case spv::OpVectorExtractDynamic:
+      case spv::OpVectorInsertDynamic:
+      case spv::OpCompositeConstruct:
+      case spv::OpCopyObject:
+      case spv::OpTranspose:
+      case spv::OpConvertFToU:
+      case spv::OpConvertFToS:
+      case spv::OpConvertSToF:
+      case spv::OpConvertUToF:
+      case spv::OpUConvert:
+      case spv::OpSConvert:
+      case spv::OpFConvert:
+      case spv::OpQuantizeToF16:
+      case spv::OpBitcast:
+      case spv::OpSNegate:
+      case spv::OpFNegate:
+      case spv::OpIAdd:
+      case spv::OpFAdd:
+      case spv::OpISub:
+      case spv::OpFSub:
+      case spv::OpIMul:
+      case spv::OpFMul:
+      case spv::OpUDiv:
+      case spv::OpSDiv:
+      case spv::OpFDiv:
+      case spv::OpUMod:
+      case spv::OpSRem:
+      case spv::OpSMod:
+      case spv::OpFRem:
+      case spv::OpFMod:
+      case spv::OpVectorTimesScalar:
+      case spv::OpMatrixTimesScalar:
+      case spv::OpVectorTimesMatrix:
+      case spv::OpMatrixTimesVector:
+      case spv::OpMatrixTimesMatrix:
+      case spv::OpOuterProduct:
+      case spv::OpDot:
+      case spv::OpIAddCarry:
+      case spv::OpISubBorrow:
+      case spv::OpUMulExtended:
+      case spv::OpSMulExtended:
+      case spv::OpAny:
+      case spv::OpAll:
+      case spv::OpIsNan:
+      case spv::OpIsInf:
+      case spv::OpLogicalEqual:
+      case spv::OpLogicalNotEqual:
+      case spv::OpLogicalOr:
+      case spv::OpLogicalAnd:
+      case spv::OpLogicalNot:
+      case spv::OpSelect:
+      case spv::OpIEqual:
+      case spv::OpINotEqual:
+      case spv::OpUGreaterThan:
+      case spv::OpSGreaterThan:
+      case spv::OpUGreaterThanEqual:
+      case spv::OpSGreaterThanEqual:
+      case spv::OpULessThan:
+      case spv::OpSLessThan:
+      case spv::OpULessThanEqual:
+      case spv::OpSLessThanEqual:
+      case spv::OpFOrdEqual:
+      case spv::OpFUnordEqual:
+      case spv::OpFOrdNotEqual:
+      case spv::OpFUnordNotEqual:
+      case spv::OpFOrdLessThan:
+      case spv::OpFUnordLessThan:
+      case spv::OpFOrdGreaterThan:
+      case spv::OpFUnordGreaterThan:
+      case spv::OpFOrdLessThanEqual:
+      case spv::OpFUnordLessThanEqual:
+      case spv::OpFOrdGreaterThanEqual:
+      case spv::OpFUnordGreaterThanEqual:
+      case spv::OpShiftRightLogical:
+      case spv::OpShiftRightArithmetic:
+      case spv::OpShiftLeftLogical:
+      case spv::OpBitwiseOr:
+      case spv::OpBitwiseXor:
+      case spv::OpBitwiseAnd:
+      case spv::OpNot:
+      case spv::OpBitFieldInsert:
+      case spv::OpBitFieldSExtract:
+      case spv::OpBitFieldUExtract:
+      case spv::OpBitReverse:
+      case spv::OpBitCount:
+      case spv::OpDPdx:
+      case spv::OpDPdy:
+      case spv::OpFwidth:
+      case spv::OpDPdxFine:
+      case spv::OpDPdyFine:
+      case spv::OpFwidthFine:
+      case spv::OpDPdxCoarse:
+      case spv::OpDPdyCoarse:
+      case spv::OpFwidthCoarse:
+      case spv::OpPhi:
+        return true;
+
+      default:
+        return false;
+    }
+  }
+
+
+  static SpirvOperandInfo computeOperandInfo(spv::Op op) {
+    SpirvOperandInfo result;
+
+    switch (op) {
+      // Debug instructions and annotations are handled
+      // separately since they do not count as uses
+      case spv::OpNop:
+      case spv::OpSource:
+      case spv::OpSourceExtension:
+      case spv::OpName:
+      case spv::OpMemberName:
+      case spv::OpDecorate:
+      case spv::OpMemberDecorate:
+      case spv::OpCapability:
+      case spv::OpExtension:
+      case spv::OpMemoryModel:
+      case spv::OpReturn:
+      case spv::OpKill:
+      case spv::OpUnreachable:
+      case spv::OpFunctionEnd:
+      case spv::OpEmitVertex:
+      case spv::OpEndPrimitive:
+        break;
+
+      case spv::OpString:
+      case spv::OpExtInstImport:
+      case spv::OpLabel:
+      case spv::OpTypeVoid:
+      case spv::OpTypeBool:
+      case spv::OpTypeInt:
+      case spv::OpTypeFloat:
+      case spv::OpTypeSampler:
+        result.resultArg = 1;
+        break;
+
+      case spv::OpTypeVector:
+      case spv::OpTypeMatrix:
+      case spv::OpTypeImage:
+      case spv::OpTypeSampledImage:
+      case spv::OpTypeRuntimeArray:
+        result.resultArg = 1;
+        result.idMask    = 0x4;
+        break;
+
+      case spv::OpTypeArray:
+        result.resultArg = 1;
+        result.idMask    = 0xc;
+        break;
+
+      case spv::OpTypePointer:
+        result.resultArg = 1;
+        result.idMask    = 0x8;
+        break;
+
+      case spv::OpTypeStruct:
+      case spv::OpTypeFunction:
+        result.resultArg = 1;
+        result.idsFrom   = 2;
+        break;
+
+      case spv::OpUndef:
+      case spv::OpConstantTrue:
+      case spv::OpConstantFalse:
+      case spv::OpConstant:
+      case spv::OpConstantNull:
+      case spv::OpSpecConstantTrue:
+      case spv::OpSpecConstantFalse:
+      case spv::OpSpecConstant:
+        result.resultArg = 2;
+        result.idMask    = 0x2;
+        break;
+
+      case spv::OpVariable:
+      case spv::OpFunction:
+        result.resultArg = 2;
+        result.idMask    = 0x12;
+        break;
+
+      case spv::OpLoad:
+      case spv::OpCompositeExtract:
+        result.resultArg = 2;
+        result.idMask    = 0xa;
+        break;
+
+      case spv::OpCompositeInsert:
+      case spv::OpVectorShuffle:
+        result.resultArg = 2;
+        result.idMask    = 0x1a;
+        break;
+
+      case spv::OpExtInst:
+        result.resultArg = 2;
+        result.idMask    = 0xa;
+        result.idsFrom   = 5;
+        break;
+
+      case spv::OpStore:
+      case spv::OpLoopMerge:
+        result.idMask    = 0x6;
+        break;
+
+      case spv::OpBranch:
+      case spv::OpReturnValue:
+      case spv::OpSelectionMerge:
+      case spv::OpEmitStreamVertex:
+      case spv::OpEndStreamPrimitive:
+        result.idMask    = 0x2;
+        break;
+
+      case spv::OpBranchConditional:
+        result.idMask    = 0xe;
+        break;
+
+      case spv::OpControlBarrier:
+      case spv::OpMemoryBarrier:
+        result.idsFrom   = 1;
+        break;
+
+      default:
+        if (isValueOp(op)) {
+          result.resultArg = 2;
+          result.idMask    = 0x2;
+          result.idsFrom   = 3;
+        } else {
+          result.known     = false;
+        }
+    }
+
+    return result;
+  }
+
+
+  static const SpirvOperandInfo& getOperandInfo(spv::Op op) {
+    // All instructions that we know of have small op codes,
+    // so we can avoid going through the switch every time.
+    static const SpirvOperandInfo unknown = computeOperandInfo(spv::OpMax);
+    static const std::array<SpirvOperandInfo, 512> table = [] {
+      std::array<SpirvOperandInfo, 512> result;
+
+      for (uint32_t i = 0; i < result.size(); i++)
+        result[i] = computeOperandInfo(spv::Op(i));
+
+      return result;
+    } ();
+
+    return uint32_t(op) < table.size() ? table[op] : unknown;
+  }
+
+
+  template<typename Fn>
+  static void forEachIdArg(
+    const SpirvOperandInfo&       info,
+          uint32_t                length,
+    const Fn&                     fn) {
+    for (uint32_t i = 1; i < length; i++) {
+      if (i == info.resultArg)
+        continue;
+
+      bool isId = !info.known
+        || (i < 32 && (info.idMask & (1u << i)))
+        || (info.idsFrom && i >= info.idsFrom);
+
+      if (isId)
+        fn(i);
+    }
+  }
+
+
+  static bool isScalarConstant(const uint32_t* words) {
+    spv::Op op = spv::Op(words[0] & spv::OpCodeMask);
+
+    return op == spv::OpConstant
+        || op == spv::OpConstantTrue
+        || op == spv::OpConstantFalse;
+  }
+
+
+  static bool isFoldableFloat(float value) {
+    // GPUs may flush denormals, so we cannot
+    // know what the result would have been
+    return std::fpclassify(value) != FP_SUBNORMAL;
+  }
+
+
+  SpirvOptimizer::SpirvOptimizer() {
+
+  }
+
+
+  SpirvOptimizer::~SpirvOptimizer() {
+
+  }
+
+
+  SpirvCodeBuffer SpirvOptimizer::optimize(
+    const SpirvCodeBuffer&  code) {
+    auto t0 = std::chrono::high_resolution_clock::now();
+
+    m_stats = SpirvOptimizerStats();
+    m_stats.sizeBefore = code.size();
+    m_stats.sizeAfter  = code.size();
+
+    m_code.assign(code.data(), code.data() + code.dwords());
+
+    if (m_code.size() < 5 || m_code[0] != spv::MagicNumber)
+      return code;
+
+    // Each pass may enable further optimizations in the
+    // other passes, but most of the work is usually done
+    // after the first couple of iterations.
+    constexpr uint32_t MaxIterations = 4;
+
+    for (uint32_t i = 0; i < MaxIterations; i++) {
+      bool progress = false;
+      progress |= runPass(&SpirvOptimizer::foldConstants);
+      progress |= runPass(&SpirvOptimizer::forwardLoads);
+      progress |= runPass(&SpirvOptimizer::eliminateDeadStores);
+      progress |= runPass(&SpirvOptimizer::eliminateDeadCode);
+
+      if (!progress)
+        break;
+    }
+
+    SpirvCodeBuffer result(m_code.size(), m_code.data());
+    m_stats.sizeAfter = result.size();
+
+    auto t1 = std::chrono::high_resolution_clock::now();
+    m_stats.timeUs = std::chrono::duration_cast<std::chrono::microseconds>(t1 - t0).count();
+    return result;
+  }
+
+
+  bool SpirvOptimizer::runPass(
+          bool (SpirvOptimizer::*pass)()) {
+    if (!parse())
+      return false;
+
+    if (!(this->*pass)())
+      return false;
+
+    rebuild();
+    return true;
+  }
+
+
+  bool SpirvOptimizer::parse() {
+    uint32_t bound = m_code[3];
+
+    m_instructions.clear();
+    m_removed.clear();
+
+    m_defs.assign(bound, ~0u);
+    m_uses.assign(bound, 0);
+    m_unknownUses.assign(bound, false);
+    m_decorated.assign(bound, false);
+    m_replacements.assign(bound, 0);
+
+    for (uint32_t offset = 5; offset < m_code.size(); ) {
+      Instruction ins;
+      ins.op     = spv::Op(m_code[offset] & spv::OpCodeMask);
+      ins.offset = offset;
+      ins.length = m_code[offset] >> spv::WordCountShift;
+
+      if (!ins.length || offset + ins.length > m_code.size())
+        return false;
+
+      uint32_t index = m_instructions.size();
+      m_instructions.push_back(ins);
+      m_removed.push_back(false);
+
+      const SpirvOperandInfo& info = getOperandInfo(ins.op);
+
+      if (info.resultArg && info.resultArg < ins.length) {
+        uint32_t id = arg(ins, info.resultArg);
+
+        if (id < bound)
+          m_defs[id] = index;
+      }
+
+      if (ins.op == spv::OpDecorate) {
+        uint32_t id = arg(ins, 1);
+
+        if (id < bound)
+          m_decorated[id] = true;
+      } else if (ins.op != spv::OpName && ins.op != spv::OpMemberName) {
+        forEachIdArg(info, ins.length, [&] (uint32_t i) {
+          uint32_t id = arg(ins, i);
+
+          if (id < bound) {
+            m_uses[id] += 1;
+            m_unknownUses[id] = m_unknownUses[id] || !info.known;
+          }
+        });
+      }
+
+      offset += ins.length;
+    }
+
+    m_newIndex = m_instructions.size();
+    return true;
+  }
+
+
+  void SpirvOptimizer::rebuild() {
+    std::vector<bool> removedIds(m_code[3], false);
+
+    for (uint32_t i = 0; i < m_instructions.size(); i++) {
+      if (!m_removed[i])
+        continue;
+
+      const Instruction& ins = m_instructions[i];
+      const SpirvOperandInfo& info = getOperandInfo(ins.op);
+
+      if (info.resultArg && arg(ins, info.resultArg) < removedIds.size())
+        removedIds[arg(ins, info.resultArg)] = true;
+    }
+
+    std::vector<uint32_t> code(m_code.begin(), m_code.begin() + 5);
+    code.reserve(m_code.size());
+
+    auto emit = [&] (uint32_t index) {
+      const Instruction& ins = m_instructions[index];
+
+      if (m_removed[index])
+        return;
+
+      if (ins.op == spv::OpName || ins.op == spv::OpDecorate) {
+        if (arg(ins, 1) < removedIds.size() && removedIds[arg(ins, 1)])
+          return;
+      }
+
+      size_t start = code.size();
+      code.insert(code.end(),
+        m_code.begin() + ins.offset,
+        m_code.begin() + ins.offset + ins.length);
+
+      const SpirvOperandInfo& info = getOperandInfo(ins.op);
+
+      if (info.known && ins.op != spv::OpName && ins.op != spv::OpDecorate) {
+        forEachIdArg(info, ins.length, [&] (uint32_t i) {
+          code[start + i] = resolve(code[start + i]);
+        });
+      }
+    };
+
+    // Constants created by the optimizer go right
+    // before the first function so that all types
+    // and constants they use are already defined
+    uint32_t firstFunction = 0;
+
+    while (firstFunction < m_newIndex
+        && m_instructions[firstFunction].op != spv::OpFunction)
+      firstFunction += 1;
+
+    for (uint32_t i = 0; i < firstFunction; i++)
+      emit(i);
+
+    for (uint32_t i = m_newIndex; i < m_instructions.size(); i++)
+      emit(i);
+
+    for (uint32_t i = firstFunction; i < m_newIndex; i++)
+      emit(i);
+
+    m_code = std::move(code);
+  }
+
+
+  bool SpirvOptimizer::forwardLoads() {
+    std::vector<bool> eligible = getEligibleVariables();
+
+    std::map<PointerKey, uint32_t> values;
+    std::map<PointerKey, uint32_t> stores;
+
+    auto invalidate = [] (std::map<PointerKey, uint32_t>& map, uint32_t var) {
+      auto entry = map.lower_bound(PointerKey { var });
+
+      while (entry != map.end() && entry->first[0] == var)
+        entry = map.erase(entry);
+    };
+
+    bool progress = false;
+
+    for (uint32_t i = 0; i < m_newIndex; i++) {
+      const Instruction ins = m_instructions[i];
+
+      switch (ins.op) {
+        // Values are only tracked within a block, and
+        // function calls may access private variables
+        case spv::OpLabel:
+        case spv::OpFunctionCall:
+          values.clear();
+          stores.clear();
+          break;
+
+        case spv::OpStore: {
+          PointerKey key;
+
+          if (!getPointerKey(arg(ins, 1), eligible, key))
+            break;
+
+          // The previous store to the same location was
+          // not read since, so it can be removed
+          auto store = stores.find(key);
+
+          if (store != stores.end()) {
+            remove(store->second);
+            m_stats.storesRemoved += 1;
+            progress = true;
+          }
+
+          invalidate(values, key[0]);
+          values[key] = resolve(arg(ins, 2));
+          stores[key] = i;
+        } break;
+
+        case spv::OpLoad: {
+          PointerKey key;
+
+          if (!getPointerKey(arg(ins, 3), eligible, key))
+            break;
+
+          invalidate(stores, key[0]);
+
+          uint32_t id    = arg(ins, 2);
+          auto     value = values.find(key);
+
+          if (value != values.end() && canReplace(id)) {
+            replace(id, value->second);
+            m_stats.loadsForwarded += 1;
+            progress = true;
+          } else if (!m_decorated[id]) {
+            values[key] = id;
+          }
+        } break;
+
+        default:
+          break;
+      }
+    }
+
+    return progress;
+  }
+
+
+  bool SpirvOptimizer::foldConstants() {
+    std::vector<bool> eligible = getEligibleVariables();
+
+    // Find variables that are initialized with a
+    // constant and never written to afterwards
+    std::vector<bool> constVars(m_defs.size(), false);
+
+    m_constantLookup.clear();
+
+    for (uint32_t i = 0; i < m_newIndex; i++) {
+      const Instruction& ins = m_instructions[i];
+
+      // Existing constants can be reused for folded values
+      if (ins.op == spv::OpConstant
+       || ins.op == spv::OpConstantTrue
+       || ins.op == spv::OpConstantFalse
+       || ins.op == spv::OpConstantComposite) {
+        std::vector<uint32_t> key = { uint32_t(ins.op), arg(ins, 1) };
+        key.insert(key.end(), &m_code[ins.offset + 3], &m_code[ins.offset + ins.length]);
+        m_constantLookup.insert({ std::move(key), arg(ins, 2) });
+      }
+
+      if (ins.op == spv::OpVariable && ins.length > 4 && eligible[arg(ins, 2)]) {
+        uint32_t length = 0;
+        const uint32_t* init = getDefinition(arg(ins, 4), length);
+
+        constVars[arg(ins, 2)] = init && (isScalarConstant(init)
+          || spv::Op(init[0] & spv::OpCodeMask) == spv::OpConstantComposite);
+      }
+
+      if (ins.op == spv::OpStore) {
+        PointerKey key;
+
+        if (getPointerKey(arg(ins, 1), eligible, key))
+          constVars[key[0]] = false;
+      }
+    }
+
+    bool progress = false;
+
+    for (uint32_t i = 0; i < m_newIndex; i++) {
+      const Instruction ins = m_instructions[i];
+
+      if (m_removed[i] || !getOperandInfo(ins.op).known || getOperandInfo(ins.op).resultArg != 2)
+        continue;
+
+      uint32_t id    = arg(ins, 2);
+      uint32_t value = 0;
+
+      if (ins.op == spv::OpLoad) {
+        PointerKey key;
+
+        if (getPointerKey(arg(ins, 3), eligible, key) && constVars[key[0]]) {
+          value = m_code[m_instructions[m_defs[key[0]]].offset + 4];
+
+          for (uint32_t k = 1; k < key.size() && value; k++) {
+            uint32_t length = 0;
+            const uint32_t* index = getDefinition(key[k], length);
+
+            value = index && spv::Op(index[0] & spv::OpCodeMask) == spv::OpConstant
+              ? getConstantMember(value, index[3])
+              : 0;
+          }
+        }
+      } else {
+        value = foldInstruction(ins);
+      }
+
+      if (value && canReplace(id)) {
+        replace(id, value);
+        m_stats.constantsFolded += 1;
+        progress = true;
+      }
+    }
+
+    return progress;
+  }
+
+
+  bool SpirvOptimizer::eliminateDeadStores() {
+    std::vector<bool> eligible = getEligibleVariables();
+    std::vector<bool> loaded(m_defs.size(), false);
+
+    for (uint32_t i = 0; i < m_newIndex; i++) {
+      const Instruction& ins = m_instructions[i];
+      PointerKey key;
+
+      if (ins.op == spv::OpLoad && getPointerKey(arg(ins, 3), eligible, key))
+        loaded[key[0]] = true;
+    }
+
+    bool progress = false;
+
+    for (uint32_t i = 0; i < m_newIndex; i++) {
+      const Instruction& ins = m_instructions[i];
+      PointerKey key;
+
+      if (ins.op == spv::OpStore && getPointerKey(arg(ins, 1), eligible, key) && !loaded[key[0]]) {
+        remove(i);
+        m_stats.storesRemoved += 1;
+        progress = true;
+      }
+    }
+
+    return progress;
+  }
+
+
+  bool SpirvOptimizer::eliminateDeadCode() {
+    std::vector<uint32_t> worklist;
+
+    for (uint32_t i = 0; i < m_newIndex; i++) {
+      if (isRemovable(i))
+        worklist.push_back(i);
+    }
+
+    bool progress = false;
+
+    while (!worklist.empty()) {
+      uint32_t index = worklist.back();
+      worklist.pop_back();
+
+      if (!isRemovable(index))
+        continue;
+
+      const Instruction& ins = m_instructions[index];
+      remove(index);
+
+      m_stats.instructionsRemoved += 1;
+      progress = true;
+
+      // Operands may have become unused as well
+      forEachIdArg(getOperandInfo(ins.op), ins.length, [&] (uint32_t i) {
+        uint32_t id = arg(ins, i);
+
+        if (id < m_uses.size() && m_uses[id] && !(--m_uses[id]) && m_defs[id] != ~0u)
+          worklist.push_back(m_defs[id]);
+      });
+    }
+
+    return progress;
+  }
+
+
+  std::vector<bool> SpirvOptimizer::getEligibleVariables() const {
+    std::vector<bool> eligible(m_defs.size(), false);
+    std::vector<uint32_t> bases(m_defs.size(), 0);
+
+    // Only consider function-local and private variables
+    // that are not decorated or used by unknown instructions
+    for (uint32_t i = 0; i < m_newIndex; i++) {
+      const Instruction& ins = m_instructions[i];
+
+      if (ins.op == spv::OpVariable) {
+        uint32_t id = arg(ins, 2);
+
+        auto storage = spv::StorageClass(arg(ins, 3));
+
+        if ((storage == spv::StorageClassFunction || storage == spv::StorageClassPrivate)
+         && !m_decorated[id] && !m_unknownUses[id]) {
+          eligible[id] = true;
+          bases[id] = id;
+        }
+      }
+
+      if (ins.op == spv::OpAccessChain || ins.op == spv::OpInBoundsAccessChain) {
+        uint32_t id   = arg(ins, 2);
+        uint32_t base = arg(ins, 3);
+
+        if (base < bases.size() && bases[base] == base && base) {
+          bases[id] = base;
+
+          if (m_decorated[id] || m_unknownUses[id])
+            eligible[base] = false;
+        }
+      }
+    }
+
+    // Pointers must only be used directly by loads and
+    // stores, and access chains must use the variable
+    for (uint32_t i = 0; i < m_newIndex; i++) {
+      const Instruction& ins = m_instructions[i];
+      const SpirvOperandInfo& info = getOperandInfo(ins.op);
+
+      if (!info.known || ins.op == spv::OpName || ins.op == spv::OpDecorate)
+        continue;
+
+      forEachIdArg(info, ins.length, [&] (uint32_t k) {
+        uint32_t id = arg(ins, k);
+
+        if (id >= bases.size() || !bases[id])
+          return;
+
+        bool allowed = (ins.op == spv::OpLoad && k == 3 && ins.length == 4)
+                    || (ins.op == spv::OpStore && k == 1 && ins.length == 3)
+                    || ((ins.op == spv::OpAccessChain || ins.op == spv::OpInBoundsAccessChain)
+                      && k == 3 && bases[id] == id);
+
+        if (!allowed)
+          eligible[bases[id]] = false;
+      });
+    }
+
+    return eligible;
+  }
+
+
+  bool SpirvOptimizer::getPointerKey(
+          uint32_t                pointer,
+    const std::vector<bool>&      eligible,
+          PointerKey&             key) const {
+    if (pointer >= m_defs.size() || m_defs[pointer] == ~0u)
+      return false;
+
+    const Instruction& ins = m_instructions[m_defs[pointer]];
+
+    if (ins.op == spv::OpVariable) {
+      if (!eligible[pointer])
+        return false;
+
+      key = { pointer };
+      return true;
+    }
+
+    if (ins.op == spv::OpAccessChain || ins.op == spv::OpInBoundsAccessChain) {
+      uint32_t base = arg(ins, 3);
+
+      if (base >= eligible.size() || !eligible[base])
+        return false;
+
+      key = { base };
+
+      for (uint32_t i = 4; i < ins.length; i++)
+        key.push_back(resolve(arg(ins, i)));
+
+      return true;
+    }
+
+    return false;
+  }
+
+
+  bool SpirvOptimizer::isRemovable(
+          uint32_t                index) const {
+    if (m_removed[index])
+      return false;
+
+    const Instruction& ins = m_instructions[index];
+
+    if (getOperandInfo(ins.op).resultArg != 2 || m_uses[arg(ins, 2)])
+      return false;
+
+    switch (ins.op) {
+      case spv::OpUndef:
+      case spv::OpConstantTrue:
+      case spv::OpConstantFalse:
+      case spv::OpConstant:
+      case spv::OpConstantComposite:
+      case spv::OpConstantNull:
+      case spv::OpLoad:
+      case spv::OpCompositeExtract:
+      case spv::OpCompositeInsert:
+      case spv::OpVectorShuffle:
+        return true;
+
+      case spv::OpVariable: {
+        auto storage = spv::StorageClass(arg(ins, 3));
+
+        return storage == spv::StorageClassFunction
+            || storage == spv::StorageClassPrivate;
+      }
+
+      case spv::OpExtInst: {
+        // Only consider well-known instruction sets
+        uint32_t length = 0;
+        const uint32_t* set = getDefinition(arg(ins, 3), length);
+
+        return set && spv::Op(set[0] & spv::OpCodeMask) == spv::OpExtInstImport
+            && length > 2 && !std::strncmp(reinterpret_cast<const char*>(&set[2]),
+              "GLSL.std.450", (length - 2) * sizeof(uint32_t));
+      }
+
+      case spv::OpSpecConstantComposite:
+      case spv::OpFunctionParameter:
+      case spv::OpFunctionCall:
+        return false;
+
+      default:
+        return isValueOp(ins.op);
+    }
+  }
+
+
+  uint32_t SpirvOptimizer::foldInstruction(
+    const Instruction&            ins) {
+    switch (ins.op) {
+      case spv::OpCompositeExtract: {
+        uint32_t value = resolve(arg(ins, 3));
+
+        for (uint32_t i = 4; i < ins.length && value; i++)
+          value = getConstantMember(value, arg(ins, i));
+
+        return value;
+      }
+
+      case spv::OpVectorShuffle: {
+        uint32_t aLength = 0;
+        uint32_t bLength = 0;
+
+        uint32_t a = resolve(arg(ins, 3));
+        uint32_t b = resolve(arg(ins, 4));
+
+        const uint32_t* aDef = getDefinition(a, aLength);
+        const uint32_t* bDef = getDefinition(b, bLength);
+
+        if (!aDef || spv::Op(aDef[0] & spv::OpCodeMask) != spv::OpConstantComposite
+         || !bDef || spv::Op(bDef[0] & spv::OpCodeMask) != spv::OpConstantComposite)
+          return 0;
+
+        std::vector<uint32_t> words = { uint32_t(spv::OpConstantComposite), arg(ins, 1) };
+
+        for (uint32_t i = 5; i < ins.length; i++) {
+          uint32_t index = arg(ins, i);
+
+          if (index == 0xFFFFFFFFu)
+            return 0;
+
+          uint32_t member = index < aLength - 3
+            ? getConstantMember(a, index)
+            : getConstantMember(b, index - (aLength - 3));
+
+          if (!member)
+            return 0;
+
+          words.push_back(member);
+        }
+
+        return getConstant(words);
+      }
+
+      case spv::OpCompositeConstruct: {
+        uint32_t length = 0;
+        const uint32_t* type = getDefinition(arg(ins, 1), length);
+
+        // Vector operands would need to be flattened
+        if (!type || spv::Op(type[0] & spv::OpCodeMask) != spv::OpTypeVector
+         || type[3] != ins.length - 3)
+          return 0;
+
+        std::vector<uint32_t> words = { uint32_t(spv::OpConstantComposite), arg(ins, 1) };
+
+        for (uint32_t i = 3; i < ins.length; i++) {
+          uint32_t member = resolve(arg(ins, i));
+          const uint32_t* def = getDefinition(member, length);
+
+          if (!def || !isScalarConstant(def))
+            return 0;
+
+          words.push_back(member);
+        }
+
+        return getConstant(words);
+      }
+
+      case spv::OpSelect: {
+        uint32_t length = 0;
+        const uint32_t* cond = getDefinition(resolve(arg(ins, 3)), length);
+
+        if (!cond)
+          return 0;
+
+        switch (spv::Op(cond[0] & spv::OpCodeMask)) {
+          case spv::OpConstantTrue:  return resolve(arg(ins, 4));
+          case spv::OpConstantFalse: return resolve(arg(ins, 5));
+          default:                   return 0;
+        }
+      }
+
+      default:
+        return foldArithmetic(ins);
+    }
+  }
+
+
+  uint32_t SpirvOptimizer::foldArithmetic(
+    const Instruction&            ins) {
+    bool isFloatOp = false;
+    uint32_t operandCount = 2;
+
+    switch (ins.op) {
+      case spv::OpFNegate:
+        operandCount = 1;
+        /* fall through */
+      case spv::OpFAdd:
+      case spv::OpFSub:
+      case spv::OpFMul:
+        isFloatOp = true;
+        break;
+
+      case spv::OpSNegate:
+      case spv::OpNot:
+        operandCount = 1;
+        /* fall through */
+      case spv::OpIAdd:
+      case spv::OpISub:
+      case spv::OpIMul:
+      case spv::OpBitwiseAnd:
+      case spv::OpBitwiseOr:
+      case spv::OpBitwiseXor:
+        break;
+
+      default:
+        return 0;
+    }
+
+    if (ins.length != 3 + operandCount)
+      return 0;
+
+    // Only 32-bit scalars and vectors are supported
+    uint32_t length = 0;
+    uint32_t typeId = arg(ins, 1);
+    uint32_t scalarTypeId = typeId;
+    uint32_t componentCount = 0;
+
+    const uint32_t* type = getDefinition(typeId, length);
+
+    if (type && spv::Op(type[0] & spv::OpCodeMask) == spv::OpTypeVector) {
+      scalarTypeId   = type[2];
+      componentCount = type[3];
+      type = getDefinition(scalarTypeId, length);
+    }
+
+    if (!type || type[2] != 32 || spv::Op(type[0] & spv::OpCodeMask)
+        != (isFloatOp ? spv::OpTypeFloat : spv::OpTypeInt))
+      return 0;
+
+    std::array<std::vector<uint32_t>, 2> operands;
+
+    for (uint32_t i = 0; i < operandCount; i++) {
+      uint32_t id = resolve(arg(ins, 3 + i));
+      const uint32_t* def = getDefinition(id, length);
+
+      if (!def)
+        return 0;
+
+      if (componentCount) {
+        if (spv::Op(def[0] & spv::OpCodeMask) != spv::OpConstantComposite)
+          return 0;
+
+        for (uint32_t j = 0; j < componentCount; j++) {
+          uint32_t memberLength = 0;
+          const uint32_t* member = getDefinition(getConstantMember(id, j), memberLength);
+
+          if (!member || spv::Op(member[0] & spv::OpCodeMask) != spv::OpConstant || memberLength != 4)
+            return 0;
+
+          operands[i].push_back(member[3]);
+        }
+      } else {
+        if (spv::Op(def[0] & spv::OpCodeMask) != spv::OpConstant || length != 4)
+          return 0;
+
+        operands[i].push_back(def[3]);
+      }
+    }
+
+    std::vector<uint32_t> results;
+
+    for (uint32_t i = 0; i < operands[0].size(); i++) {
+      uint32_t a = operands[0][i];
+      uint32_t b = operandCount > 1 ? operands[1][i] : 0;
+      uint32_t r = 0;
+
+      if (isFloatOp) {
+        float af, bf, rf;
+        std::memcpy(&af, &a, sizeof(af));
+        std::memcpy(&bf, &b, sizeof(bf));
+
+        switch (ins.op) {
+          case spv::OpFNegate: rf = -af;     break;
+          case spv::OpFAdd:    rf = af + bf; break;
+          case spv::OpFSub:    rf = af - bf; break;
+          case spv::OpFMul:    rf = af * bf; break;
+          default: return 0;
+        }
+
+        if (!isFoldableFloat(af) || !isFoldableFloat(bf) || !isFoldableFloat(rf))
+          return 0;
+
+        std::memcpy(&r, &rf, sizeof(r));
+      } else {
+        switch (ins.op) {
+          case spv::OpSNegate:    r = 0u - a; break;
+          case spv::OpNot:        r = ~a;     break;
+          case spv::OpIAdd:       r = a + b;  break;
+          case spv::OpISub:       r = a - b;  break;
+          case spv::OpIMul:       r = a * b;  break;
+          case spv::OpBitwiseAnd: r = a & b;  break;
+          case spv::OpBitwiseOr:  r = a | b;  break;
+          case spv::OpBitwiseXor: r = a ^ b;  break;
+          default: return 0;
+        }
+      }
+
+      results.push_back(r);
+    }
+
+    // Create constants only after all operands have been
+    // read since this may invalidate definition pointers
+    std::vector<uint32_t> words = { uint32_t(spv::OpConstantComposite), typeId };
+
+    for (uint32_t r : results)
+      words.push_back(getConstant({ uint32_t(spv::OpConstant), scalarTypeId, r }));
+
+    return componentCount ? getConstant(words) : words[2];
+  }
+
+
+  uint32_t SpirvOptimizer::getConstantMember(
+          uint32_t                constant,
+          uint32_t                index) const {
+    uint32_t length = 0;
+    const uint32_t* def = getDefinition(constant, length);
+
+    if (!def || spv::Op(def[0] & spv::OpCodeMask) != spv::OpConstantComposite
+     || index >= length - 3)
+      return 0;
+
+    return def[3 + index];
+  }
+
+
+  uint32_t SpirvOptimizer::getConstant(
+    const std::vector<uint32_t>&  words) {
+    auto entry = m_constantLookup.find(words);
+
+    if (entry != m_constantLookup.end())
+      return entry->second;
+
+    uint32_t id = m_code[3]++;
+
+    m_defs.push_back(m_instructions.size());
+    m_uses.push_back(0);
+    m_unknownUses.push_back(false);
+    m_decorated.push_back(false);
+    m_replacements.push_back(0);
+
+    Instruction ins;
+    ins.op     = spv::Op(words[0]);
+    ins.offset = m_code.size();
+    ins.length = words.size() + 1;
+
+    m_code.push_back(words[0] | (ins.length << spv::WordCountShift));
+    m_code.push_back(words[1]);
+    m_code.push_back(id);
+    m_code.insert(m_code.end(), words.begin() + 2, words.end());
+
+    m_instructions.push_back(ins);
+    m_removed.push_back(false);
+
+    m_constantLookup.insert({ words, id });
+    return id;
+  }
+
+
+  const uint32_t* SpirvOptimizer::getDefinition(
+          uint32_t                id,
+          uint32_t&               length) const {
+    if (id >= m_defs.size() || m_defs[id] == ~0u || m_removed[m_defs[id]])
+      return nullptr;
+
+    const Instruction& ins = m_instructions[m_defs[id]];
+    length = ins.length;
+    return &m_code[ins.offset];
+  }
+
+
+  uint32_t SpirvOptimizer::resolve(
+          uint32_t                id) const {
+    while (id < m_replacements.size() && m_replacements[id])
+      id = m_replacements[id];
+
+    return id;
+  }
+
+
+  bool SpirvOptimizer::canReplace(
+          uint32_t                id) const {
+    return id < m_defs.size()
+        && !m_unknownUses[id]
+        && !m_decorated[id];
+  }
+
+
+  void SpirvOptimizer::replace(
+          uint32_t                id,
+          uint32_t                value) {
+    m_replacements[id] = value;
+    remove(m_defs[id]);
+  }
+
+
+  void SpirvOptimizer::remove(
+          uint32_t                index) {
+    m_removed[index] = true;
+  }
+
+
+  SpirvCodeBuffer optimizeSpirvShader(
+    const SpirvCodeBuffer&  code,
+    const std::string&      name) {
+    SpirvOptimizer optimizer;
+    SpirvCodeBuffer result = optimizer.optimize(code);
+
+    const SpirvOptimizerStats& stats = optimizer.stats();
+
+    Logger::debug(str::format(name, ": Optimized ",
+      stats.sizeBefore, " -> ", stats.sizeAfter, " bytes in ", stats.timeUs, " us (",
+      stats.loadsForwarded, " loads forwarded, ", stats.storesRemoved, " stores removed, ",
+      stats.constantsFolded, " constants folded, ", stats.instructionsRemoved, " instructions removed)"));
+    return result;
+  }
+
+}
@@ -0,0 +1,180 @@
+#pragma once
+
+#include <map>
+#include <string>
+#include <vector>
+
+#include "spirv_code_buffer.h"
+
+namespace dxvk {
+
+  /**
+   * \brief SPIR-V optimizer statistics
+   *
+   * Summarizes what the optimizer did to a
+   * single module. Useful for debugging.
+   */
+  struct SpirvOptimizerStats {
+    size_t   sizeBefore          = 0;
+    size_t   sizeAfter           = 0;
+    uint32_t loadsForwarded      = 0;
+    uint32_t storesRemoved       = 0;
+    uint32_t constantsFolded     = 0;
+    uint32_t instructionsRemoved = 0;
+    uint64_t timeUs              = 0;
+  };
+
+
+  /**
+   * \brief SPIR-V optimizer
+   *
+   * Runs a small set of conservative passes over a
+   * SPIR-V module in order to remove the redundant
+   * code that the shader compilers tend to generate:
+   *
+   * - Forwarding of stored and previously loaded values
+   *   for function-local and private variables within a
+   *   block, and removal of overwritten stores.
+   * - Constant folding, including loads from variables
+   *   that are initialized with a constant and never
+   *   written, such as shader model 1-3 \c def constants.
+   * - Removal of stores to variables that are never read.
+   * - Removal of unused constants and side-effect free
+   *   instructions whose results are never used.
+   *
+   * Instructions that the optimizer does not know are
+   * left untouched, and any ID that they reference is
+   * assumed to be in use.
+   */
+  class SpirvOptimizer {
+
+    struct Instruction {
+      spv::Op  op;
+      uint32_t offset;
+      uint32_t length;
+    };
+
+    using PointerKey = std::vector<uint32_t>;
+
+  public:
+
+    SpirvOptimizer();
+
+    ~SpirvOptimizer();
+
+    /**
+     * \brief Optimizes a SPIR-V module
+     *
+     * \param [in] code The module to optimize
+     * \returns Optimized module
+     */
+    SpirvCodeBuffer optimize(
+      const SpirvCodeBuffer&  code);
+
+    /**
+     * \brief Retrieves optimizer statistics
+     *
+     * Stats are reset for every module.
+     * \returns Stats for the last module
+     */
+    const SpirvOptimizerStats& stats() const {
+      return m_stats;
+    }
+
+  private:
+
+    SpirvOptimizerStats         m_stats;
+
+    std::vector<uint32_t>       m_code;
+    std::vector<Instruction>    m_instructions;
+    std::vector<bool>           m_removed;
+
+    std::vector<uint32_t>       m_defs;
+    std::vector<uint32_t>       m_uses;
+    std::vector<bool>           m_unknownUses;
+    std::vector<bool>           m_decorated;
+    std::vector<uint32_t>       m_replacements;
+
+    size_t                      m_newIndex = 0;
+    std::map<
+      std::vector<uint32_t>,
+      uint32_t>                 m_constantLookup;
+
+    bool runPass(
+            bool (SpirvOptimizer::*pass)());
+
+    bool parse();
+
+    void rebuild();
+
+    bool forwardLoads();
+
+    bool foldConstants();
+
+    bool eliminateDeadStores();
+
+    bool eliminateDeadCode();
+
+    std::vector<bool> getEligibleVariables() const;
+
+    bool getPointerKey(
+            uint32_t                pointer,
+      const std::vector<bool>&      eligible,
+            PointerKey&             key) const;
+
+    bool isRemovable(
+            uint32_t                index) const;
+
+    uint32_t foldInstruction(
+      const Instruction&            ins);
+
+    uint32_t foldArithmetic(
+      const Instruction&            ins);
+
+    uint32_t getConstantMember(
+            uint32_t                constant,
+            uint32_t                index) const;
+
+    uint32_t getConstant(
+      const std::vector<uint32_t>&  words);
+
+    const uint32_t* getDefinition(
+            uint32_t                id,
+            uint32_t&               length) const;
+
+    uint32_t resolve(
+            uint32_t                id) const;
+
+    bool canReplace(
+            uint32_t                id) const;
+
+    void replace(
+            uint32_t                id,
+            uint32_t                value);
+
+    void remove(
+            uint32_t                index);
+
+    uint32_t arg(
+      const Instruction&            ins,
+            uint32_t                index) const {
+      return index < ins.length ? m_code[ins.offset + index] : 0;
+    }
+
+  };
+
+
+  /**
+   * \brief Optimizes a shader module
+   *
+   * Runs the optimizer on the given code and
+   * logs the optimizer statistics.
+   * \param [in] code The module to optimize
+   * \param [in] name Shader name for logging
+   * \returns Optimized module
+   */
+  SpirvCodeBuffer optimizeSpirvShader(
+    const SpirvCodeBuffer&  code,
+    const std::string&      name);
+
+}
\ No newline at end of file
@@ -26,7 +26,24 @@ namespace dxvk {
     uint32_t decRef() {
       return --m_refCount;
     }
-    
+
+    /**
+     * \brief Increments reference count if non-zero
+     *
+     * Used to safely acquire a reference to an object
+     * that is only known by a raw pointer and may be
+     * in the process of being destroyed.
+     * \returns \c true if a reference was acquired
+     */
+    bool tryIncRef() {
+      uint32_t count = m_refCount.load();
+
+      while (count && !m_refCount.compare_exchange_weak(count, count + 1))
+        continue;
+
+      return count != 0;
+    }
+
   private:
     
     std::atomic<uint32_t> m_refCount = { 0u };
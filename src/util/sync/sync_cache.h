@@ -0,0 +1,160 @@
+#pragma once
+
+#include <atomic>
+#include <deque>
+#include <memory>
+#include <mutex>
+#include <utility>
+#include <vector>
+
+namespace dxvk::sync {
+
+  /**
+   * \brief Read-optimized concurrent cache
+   *
+   * Insert-only hash map with a lock-free lookup path,
+   * intended for caches that are read far more often
+   * than they are written to.
+   *
+   * Entries are never moved or removed, and are published
+   * to the bucket chains with release semantics, so that
+   * lookups do not need to take any locks. Inserts are
+   * serialized by a mutex. When the table grows, a new
+   * bucket array is published and the old one is kept
+   * alive until the cache is destroyed, so that readers
+   * which are still traversing it remain valid.
+   */
+  template<typename K, typename V, typename Hash, typename Eq>
+  class ConcurrentCache {
+    constexpr static size_t InitialBucketCount = 64;
+  public:
+
+    ConcurrentCache() {
+      m_tables.push_back(std::make_unique<Table>(InitialBucketCount));
+      m_table.store(m_tables.back().get());
+    }
+
+    ConcurrentCache             (const ConcurrentCache&) = delete;
+    ConcurrentCache& operator = (const ConcurrentCache&) = delete;
+
+    /**
+     * \brief Looks up an entry
+     *
+     * Lock-free. May miss entries that are being
+     * inserted concurrently, in which case callers
+     * are expected to fall back to \ref insert.
+     * \param [in] key The key to look up
+     * \returns Pointer to the value, or \c nullptr
+     */
+    const V* find(const K& key) const {
+      return lookup(m_table.load(std::memory_order_acquire),
+        key, Hash()(key));
+    }
+
+    /**
+     * \brief Inserts an entry
+     *
+     * If an entry with the same key already exists,
+     * the new value is discarded and the existing
+     * value is returned instead.
+     * \param [in] key The key
+     * \param [in] value The value to insert
+     * \returns Pointer to the value in the cache, and
+     *          \c true if the value was inserted
+     */
+    std::pair<const V*, bool> insert(const K& key, V&& value) {
+      std::lock_guard<std::mutex> lock(m_mutex);
+
+      const size_t hash  = Hash()(key);
+      Table*       table = m_table.load(std::memory_order_relaxed);
+
+      const V* existing = lookup(table, key, hash);
+
+      if (existing != nullptr)
+        return std::make_pair(existing, false);
+
+      Node* node = &m_nodes.emplace_back(key, std::move(value), hash);
+
+      if (m_nodes.size() > table->buckets.size())
+        grow(table);
+      else
+        link(table, node);
+
+      return std::make_pair(&node->value, true);
+    }
+
+    /**
+     * \brief Number of entries in the cache
+     * \returns Entry count
+     */
+    size_t size() const {
+      std::lock_guard<std::mutex> lock(m_mutex);
+      return m_nodes.size();
+    }
+
+  private:
+
+    struct Node {
+      Node(const K& k, V&& v, size_t h)
+      : key(k), value(std::move(v)), hash(h) { }
+
+      K       key;
+      V       value;
+      size_t  hash;
+    };
+
+    struct Link {
+      const Node* node;
+      const Link* next;
+    };
+
+    struct Table {
+      Table(size_t count)
+      : buckets(count) {
+        for (auto& bucket : buckets)
+          bucket.store(nullptr, std::memory_order_relaxed);
+      }
+
+      std::vector<std::atomic<const Link*>> buckets;
+    };
+
+    mutable std::mutex                  m_mutex;
+    std::atomic<Table*>                 m_table = { nullptr };
+
+    std::deque<Node>                    m_nodes;
+    std::deque<Link>                    m_links;
+    std::vector<std::unique_ptr<Table>> m_tables;
+
+    static const V* lookup(const Table* table, const K& key, size_t hash) {
+      const auto& bucket = table->buckets[hash & (table->buckets.size() - 1)];
+
+      for (const Link* l = bucket.load(std::memory_order_acquire); l != nullptr; l = l->next) {
+        if (l->node->hash == hash && Eq()(l->node->key, key))
+          return &l->node->value;
+      }
+
+      return nullptr;
+    }
+
+    void link(Table* table, const Node* node) {
+      auto& bucket = table->buckets[node->hash & (table->buckets.size() - 1)];
+
+      const Link* head = &m_links.emplace_back(Link {
+        node, bucket.load(std::memory_order_relaxed) });
+
+      bucket.store(head, std::memory_order_release);
+    }
+
+    void grow(const Table* table) {
+      m_tables.push_back(std::make_unique<Table>(table->buckets.size() * 2));
+      Table* newTable = m_tables.back().get();
+
+      for (const Node& node : m_nodes)
+        link(newTable, &node);
+
+      m_table.store(newTable, std::memory_order_release);
+    }
+
+  };
+
+}
@@ -0,0 +1,158 @@
+#pragma once
+
+#include <array>
+#include <atomic>
+#include <condition_variable>
+#include <mutex>
+
+#include "../thread.h"
+#include "../util_likely.h"
+
+namespace dxvk::sync {
+
+  /**
+   * \brief Single-producer single-consumer queue
+   *
+   * Bounded lock-free ring buffer. Exactly one thread
+   * may push items and exactly one thread may pop items
+   * at any given time. Blocking operations spin for a
+   * short while before parking the calling thread on a
+   * condition variable, so that the mutex is only ever
+   * touched when one side actually has to sleep.
+   *
+   * \tparam T Item type, must be default-constructible
+   * \tparam N Capacity, must be a power of two
+   */
+  template<typename T, uint32_t N>
+  class SpscQueue {
+    static_assert((N & (N - 1)) == 0, "Capacity must be a power of two");
+
+    constexpr static uint32_t SpinCount = 2000;
+  public:
+
+    SpscQueue() { }
+    ~SpscQueue() { }
+
+    SpscQueue             (const SpscQueue&) = delete;
+    SpscQueue& operator = (const SpscQueue&) = delete;
+
+    /**
+     * \brief Pushes an item
+     *
+     * Waits for the consumer to free up
+     * a slot if the queue is full.
+     * \param [in] item The item
+     */
+    void push(T&& item) {
+      uint32_t write = m_write.load(std::memory_order_relaxed);
+
+      if (unlikely(write - m_read.load(std::memory_order_acquire) == N)) {
+        wait(m_producerWaiting, [this, write] {
+          return write - m_read.load() != N;
+        });
+      }
+
+      m_items[write % N] = std::move(item);
+      m_write.store(write + 1);
+
+      // Pairs with the store in wait(), so that either
+      // the consumer sees the item or we see the flag
+      if (m_consumerWaiting.load())
+        wake();
+    }
+
+    /**
+     * \brief Pops an item
+     *
+     * Waits for an item to become available,
+     * or until \ref stop has been called.
+     * \param [out] item The item
+     * \returns \c false if the queue was stopped
+     */
+    bool pop(T& item) {
+      uint32_t read = m_read.load(std::memory_order_relaxed);
+
+      if (read == m_write.load(std::memory_order_acquire)) {
+        wait(m_consumerWaiting, [this, read] {
+          return read != m_write.load() || m_stopped.load();
+        });
+
+        if (read == m_write.load())
+          return false;
+      }
+
+      item = std::move(m_items[read % N]);
+      m_read.store(read + 1);
+
+      if (m_producerWaiting.load())
+        wake();
+
+      return true;
+    }
+
+    /**
+     * \brief Checks whether the queue is empty
+     *
+     * Only meaningful on the producer or
+     * the consumer thread.
+     * \returns \c true if no items are queued
+     */
+    bool empty() const {
+      return m_read.load() == m_write.load();
+    }
+
+    /**
+     * \brief Stops the queue
+     *
+     * Wakes up the consumer if it is waiting
+     * for items, and makes \ref pop return
+     * \c false once the queue is empty.
+     */
+    void stop() {
+      m_stopped.store(true);
+      wake();
+    }
+
+  private:
+
+    std::array<T, N>        m_items;
+
+    alignas(64)
+    std::atomic<uint32_t>   m_read  = { 0u };
+    alignas(64)
+    std::atomic<uint32_t>   m_write = { 0u };
+
+    alignas(64)
+    std::atomic<bool>       m_producerWaiting = { false };
+    std::atomic<bool>       m_consumerWaiting = { false };
+    std::atomic<bool>       m_stopped         = { false };
+
+    std::mutex              m_mutex;
+    std::condition_variable m_cond;
+
+    template<typename Pred>
+    void wait(std::atomic<bool>& waiting, const Pred& pred) {
+      for (uint32_t i = 0; i < SpinCount; i++) {
+        if (pred())
+          return;
+
+        if (i >= SpinCount / 2)
+          dxvk::this_thread::yield();
+      }
+
+      std::unique_lock<std::mutex> lock(m_mutex);
+      waiting.store(true);
+      m_cond.wait(lock, pred);
+      waiting.store(false);
+    }
+
+    void wake() {
+      // Taking the lock ensures that the waiting thread
+      // is either blocked or has yet to check its predicate
+      { std::lock_guard<std::mutex> lock(m_mutex); }
+      m_cond.notify_all();
+    }
+
+  };
+
+}
@@ -67,6 +67,20 @@ namespace dxvk::bit {
     #endif
   }
 
+  inline uint32_t lzcnt(uint64_t n) {
+    #if defined(_MSC_VER) && defined(_M_X64)
+    unsigned long idx;
+    return _BitScanReverse64(&idx, n) ? 63 - idx : 64;
+    #elif defined(__GNUC__)
+    return n != 0 ? __builtin_clzll(n) : 64;
+    #else
+    uint32_t r = 0;
+    while (r < 64 && !(n & (uint64_t(1) << (63 - r))))
+      r += 1;
+    return r;
+    #endif
+  }
+
   template<typename T>
   uint32_t pack(T& dst, uint32_t& shift, T src, uint32_t count) {
     constexpr uint32_t Bits = 8 * sizeof(T);
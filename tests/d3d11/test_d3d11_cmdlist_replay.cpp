@@ -0,0 +1,262 @@
+#include <array>
+#include <cstdlib>
+#include <cstring>
+#include <fstream>
+
+#include <d3d11.h>
+
+#include <windows.h>
+#include <windowsx.h>
+
+#include "../test_utils.h"
+
+using namespace dxvk;
+
+constexpr uint32_t IterationCount = 256;
+constexpr uint32_t ElementCount   = 16;
+
+Com<ID3D11Device>           g_d3d11Device;
+Com<ID3D11DeviceContext>    g_d3d11Context;
+
+/**
+ * \brief Test buffer with a UAV and a readback buffer
+ */
+struct TestBuffer {
+  Com<ID3D11Buffer>               buffer;
+  Com<ID3D11Buffer>               readback;
+  Com<ID3D11UnorderedAccessView>  view;
+};
+
+bool createTestBuffer(TestBuffer& result) {
+  D3D11_BUFFER_DESC bufferDesc;
+  bufferDesc.ByteWidth            = ElementCount * sizeof(uint32_t);
+  bufferDesc.Usage                = D3D11_USAGE_DEFAULT;
+  bufferDesc.BindFlags            = D3D11_BIND_UNORDERED_ACCESS;
+  bufferDesc.CPUAccessFlags       = 0;
+  bufferDesc.MiscFlags            = 0;
+  bufferDesc.StructureByteStride  = 0;
+
+  if (FAILED(g_d3d11Device->CreateBuffer(&bufferDesc, nullptr, &result.buffer)))
+    return false;
+
+  bufferDesc.Usage                = D3D11_USAGE_STAGING;
+  bufferDesc.BindFlags            = 0;
+  bufferDesc.CPUAccessFlags       = D3D11_CPU_ACCESS_READ;
+
+  if (FAILED(g_d3d11Device->CreateBuffer(&bufferDesc, nullptr, &result.readback)))
+    return false;
+
+  D3D11_UNORDERED_ACCESS_VIEW_DESC viewDesc;
+  viewDesc.Format                 = DXGI_FORMAT_R32_UINT;
+  viewDesc.ViewDimension          = D3D11_UAV_DIMENSION_BUFFER;
+  viewDesc.Buffer.FirstElement    = 0;
+  viewDesc.Buffer.NumElements     = ElementCount;
+  viewDesc.Buffer.Flags           = 0;
+
+  return SUCCEEDED(g_d3d11Device->CreateUnorderedAccessView(
+    result.buffer.ptr(), &viewDesc, &result.view));
+}
+
+
+bool checkTestBuffer(const TestBuffer& buffer, uint32_t expected) {
+  g_d3d11Context->CopyResource(buffer.readback.ptr(), buffer.buffer.ptr());
+
+  D3D11_MAPPED_SUBRESOURCE mappedResource;
+
+  if (FAILED(g_d3d11Context->Map(buffer.readback.ptr(), 0, D3D11_MAP_READ, 0, &mappedResource)))
+    return false;
+
+  std::array<uint32_t, ElementCount> data;
+  std::memcpy(data.data(), mappedResource.pData, sizeof(data));
+  g_d3d11Context->Unmap(buffer.readback.ptr(), 0);
+
+  for (uint32_t value : data) {
+    if (value != expected)
+      return false;
+  }
+
+  return true;
+}
+
+
+void clearTestBuffer(ID3D11DeviceContext* context, const TestBuffer& buffer, uint32_t value) {
+  const UINT values[4] = { value, value, value, value };
+  context->ClearUnorderedAccessViewUint(buffer.view.ptr(), values);
+}
+
+
+/**
+ * \brief Reads initial data from a replayed command list
+ *
+ * Creates a buffer and a texture with initial data without
+ * flushing the immediate context, and copies both to the
+ * test buffer and a staging texture in a command list.
+ * \returns \c true if the copies contain the initial data
+ */
+bool testInitialData(ID3D11DeviceContext* deferredContext, const TestBuffer& buffer, uint32_t value) {
+  std::array<uint32_t, ElementCount> data;
+  data.fill(value);
+
+  D3D11_SUBRESOURCE_DATA initialData;
+  initialData.pSysMem           = data.data();
+  initialData.SysMemPitch       = sizeof(data);
+  initialData.SysMemSlicePitch  = sizeof(data);
+
+  D3D11_BUFFER_DESC bufferDesc;
+  bufferDesc.ByteWidth            = sizeof(data);
+  bufferDesc.Usage                = D3D11_USAGE_DEFAULT;
+  bufferDesc.BindFlags            = D3D11_BIND_SHADER_RESOURCE;
+  bufferDesc.CPUAccessFlags       = 0;
+  bufferDesc.MiscFlags            = 0;
+  bufferDesc.StructureByteStride  = 0;
+
+  D3D11_TEXTURE2D_DESC textureDesc;
+  textureDesc.Width           = ElementCount;
+  textureDesc.Height          = 1;
+  textureDesc.MipLevels       = 1;
+  textureDesc.ArraySize       = 1;
+  textureDesc.Format          = DXGI_FORMAT_R32_UINT;
+  textureDesc.SampleDesc      = { 1, 0 };
+  textureDesc.Usage           = D3D11_USAGE_DEFAULT;
+  textureDesc.BindFlags       = D3D11_BIND_SHADER_RESOURCE;
+  textureDesc.CPUAccessFlags  = 0;
+  textureDesc.MiscFlags       = 0;
+
+  Com<ID3D11Buffer>     srcBuffer;
+  Com<ID3D11Texture2D>  srcTexture;
+  Com<ID3D11Texture2D>  dstTexture;
+
+  if (FAILED(g_d3d11Device->CreateBuffer(&bufferDesc, &initialData, &srcBuffer))
+   || FAILED(g_d3d11Device->CreateTexture2D(&textureDesc, &initialData, &srcTexture))) {
+    std::cerr << "Failed to create resources with initial data" << std::endl;
+    return false;
+  }
+
+  textureDesc.Usage           = D3D11_USAGE_STAGING;
+  textureDesc.BindFlags       = 0;
+  textureDesc.CPUAccessFlags  = D3D11_CPU_ACCESS_READ;
+
+  if (FAILED(g_d3d11Device->CreateTexture2D(&textureDesc, nullptr, &dstTexture))) {
+    std::cerr << "Failed to create staging texture" << std::endl;
+    return false;
+  }
+
+  Com<ID3D11CommandList> commandList;
+  deferredContext->CopyResource(buffer.buffer.ptr(), srcBuffer.ptr());
+  deferredContext->CopyResource(dstTexture.ptr(), srcTexture.ptr());
+
+  if (FAILED(deferredContext->FinishCommandList(FALSE, &commandList))) {
+    std::cerr << "Failed to finish command list" << std::endl;
+    return false;
+  }
+
+  g_d3d11Context->ExecuteCommandList(commandList.ptr(), FALSE);
+
+  if (!checkTestBuffer(buffer, value)) {
+    std::cerr << "Buffer initial data not visible to replayed command list" << std::endl;
+    return false;
+  }
+
+  D3D11_MAPPED_SUBRESOURCE mappedResource;
+
+  if (FAILED(g_d3d11Context->Map(dstTexture.ptr(), 0, D3D11_MAP_READ, 0, &mappedResource))) {
+    std::cerr << "Failed to map staging texture" << std::endl;
+    return false;
+  }
+
+  bool result = !std::memcmp(mappedResource.pData, data.data(), sizeof(data));
+  g_d3d11Context->Unmap(dstTexture.ptr(), 0);
+
+  if (!result)
+    std::cerr << "Texture initial data not visible to replayed command list" << std::endl;
+
+  return result;
+}
+
+
+int WINAPI WinMain(HINSTANCE hInstance,
+                   HINSTANCE hPrevInstance,
+                   LPSTR lpCmdLine,
+                   int nCmdShow) {
+  // Command lists are only recorded on worker
+  // threads if replay threads are enabled
+  if (!std::getenv("DXVK_CONFIG_FILE")) {
+    std::ofstream config("d3d11-cmdlist-replay.conf");
+    config << "d3d11.numReplayThreads = 4" << std::endl;
+    _putenv("DXVK_CONFIG_FILE=d3d11-cmdlist-replay.conf");
+  }
+
+  if (FAILED(D3D11CreateDevice(
+        nullptr, D3D_DRIVER_TYPE_HARDWARE,
+        nullptr, 0, nullptr, 0, D3D11_SDK_VERSION,
+        &g_d3d11Device, nullptr, &g_d3d11Context))) {
+    std::cerr << "Failed to create D3D11 device" << std::endl;
+    return 1;
+  }
+
+  std::array<Com<ID3D11DeviceContext>, 3> deferredContexts;
+
+  for (auto& context : deferredContexts) {
+    if (FAILED(g_d3d11Device->CreateDeferredContext(0, &context))) {
+      std::cerr << "Failed to create deferred context" << std::endl;
+      return 1;
+    }
+  }
+
+  std::array<TestBuffer, 3> buffers;
+
+  for (auto& buffer : buffers) {
+    if (!createTestBuffer(buffer)) {
+      std::cerr << "Failed to create test buffer" << std::endl;
+      return 1;
+    }
+  }
+
+  for (uint32_t i = 1; i <= IterationCount; i++) {
+    // Record a command list and execute it on two other
+    // deferred contexts, so that the resulting command
+    // lists share the nested command list's chunks
+    Com<ID3D11CommandList> nestedList;
+    clearTestBuffer(deferredContexts[0].ptr(), buffers[0], i);
+
+    if (FAILED(deferredContexts[0]->FinishCommandList(FALSE, &nestedList))) {
+      std::cerr << "Failed to finish nested command list" << std::endl;
+      return 1;
+    }
+
+    std::array<Com<ID3D11CommandList>, 2> commandLists;
+
+    for (uint32_t j = 0; j < commandLists.size(); j++) {
+      ID3D11DeviceContext* context = deferredContexts[j + 1].ptr();
+      context->ExecuteCommandList(nestedList.ptr(), FALSE);
+      clearTestBuffer(context, buffers[j + 1], i);
+
+      if (FAILED(context->FinishCommandList(FALSE, &commandLists[j]))) {
+        std::cerr << "Failed to finish command list" << std::endl;
+        return 1;
+      }
+    }
+
+    // Execute both command lists back to back, which
+    // would record them on different worker threads
+    for (const auto& commandList : commandLists)
+      g_d3d11Context->ExecuteCommandList(commandList.ptr(), FALSE);
+
+    for (uint32_t j = 0; j < buffers.size(); j++) {
+      if (!checkTestBuffer(buffers[j], i)) {
+        std::cerr << "Iteration " << i << ": Buffer " << j << " has unexpected contents" << std::endl;
+        return 1;
+      }
+    }
+  }
+
+  // Resources created since the last flush must be
+  // initialized before a replayed command list uses them
+  for (uint32_t i = 1; i <= IterationCount; i++) {
+    if (!testInitialData(deferredContexts[0].ptr(), buffers[0], i))
+      return 1;
+  }
+
+  std::cout << "Replayed " << IterationCount << " command lists" << std::endl;
+  return 0;
+}
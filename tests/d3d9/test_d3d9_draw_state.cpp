@@ -0,0 +1,459 @@
+#include <d3d9.h>
+
+#include <d3dcompiler.h>
+#include <tlhelp32.h>
+
+#include <chrono>
+#include <cwchar>
+
+#include "../test_utils.h"
+
+namespace dxvk {
+  Logger Logger::s_instance("d3d9-draw-state.log");
+}
+
+using namespace dxvk;
+
+struct Extent2D {
+  uint32_t w, h;
+};
+
+const std::string g_vertexShaderCode = R"(
+
+struct VS_INPUT {
+  float3 Position : POSITION;
+};
+
+struct VS_OUTPUT {
+  float4 Position : POSITION;
+};
+
+VS_OUTPUT main( VS_INPUT IN ) {
+  VS_OUTPUT OUT;
+  OUT.Position = float4(IN.Position, 1.0f);
+
+  return OUT;
+}
+
+)";
+
+const std::string g_pixelShaderCode = R"(
+
+struct VS_OUTPUT {
+  float4 Position : POSITION;
+};
+
+struct PS_OUTPUT {
+  float4 Colour   : COLOR;
+};
+
+PS_OUTPUT main( VS_OUTPUT IN ) {
+  PS_OUTPUT OUT;
+
+  OUT.Colour = float4(0.906f, 0.278f, 0.235f, 1.0f);
+
+  return OUT;
+}
+
+
+)";
+
+class DrawStateApp {
+
+  constexpr static uint32_t DrawsPerFrame  = 2000;
+  constexpr static uint32_t FramesPerSample = 100;
+
+  
+public:
+  
+  DrawStateApp(HINSTANCE instance, HWND window)
+  : m_window(window) {
+    HRESULT status = Direct3DCreate9Ex(D3D_SDK_VERSION, &m_d3d);
+
+    if (FAILED(status))
+      throw DxvkError("Failed to create D3D9 interface");
+
+    D3DPRESENT_PARAMETERS params;
+    getPresentParams(params);
+
+    status = m_d3d->CreateDeviceEx(
+      D3DADAPTER_DEFAULT,
+      D3DDEVTYPE_HAL,
+      m_window,
+      D3DCREATE_HARDWARE_VERTEXPROCESSING,
+      &params,
+      nullptr,
+      &m_device);
+    
+    if (FAILED(status))
+      throw DxvkError("Failed to create D3D9 device");
+
+    // Vertex Shader
+    {
+      Com<ID3DBlob> blob;
+
+      status = D3DCompile(
+        g_vertexShaderCode.data(),
+        g_vertexShaderCode.length(),
+        nullptr, nullptr, nullptr,
+        "main",
+        "vs_2_0",
+        0, 0, &blob,
+        nullptr);
+
+      if (FAILED(status))
+        throw DxvkError("Failed to compile vertex shader");
+
+      status = m_device->CreateVertexShader(reinterpret_cast<const DWORD*>(blob->GetBufferPointer()), &m_vs);
+
+      if (FAILED(status))
+        throw DxvkError("Failed to create vertex shader");
+    }
+
+    // Pixel Shader
+    {
+      Com<ID3DBlob> blob;
+
+      status = D3DCompile(
+        g_pixelShaderCode.data(),
+        g_pixelShaderCode.length(),
+        nullptr, nullptr, nullptr,
+        "main",
+        "ps_2_0",
+        0, 0, &blob,
+        nullptr);
+
+      if (FAILED(status))
+        throw DxvkError("Failed to compile pixel shader");
+
+      status = m_device->CreatePixelShader(reinterpret_cast<const DWORD*>(blob->GetBufferPointer()), &m_ps);
+
+      if (FAILED(status))
+        throw DxvkError("Failed to create pixel shader");
+    }
+
+    m_device->SetVertexShader(m_vs.ptr());
+    m_device->SetPixelShader(m_ps.ptr());
+
+    std::array<float, 9> vertices = {
+      0.0f, 0.5f, 0.0f,
+      0.5f, -0.5f, 0.0f,
+      -0.5f, -0.5f, 0.0f,
+    };
+
+    const size_t vbSize = vertices.size() * sizeof(float);
+
+    status = m_device->CreateVertexBuffer(vbSize, 0, 0, D3DPOOL_DEFAULT, &m_vb, nullptr);
+    if (FAILED(status))
+      throw DxvkError("Failed to create vertex buffer");
+
+    void* data = nullptr;
+    status = m_vb->Lock(0, 0, &data, 0);
+    if (FAILED(status))
+      throw DxvkError("Failed to lock vertex buffer");
+
+    std::memcpy(data, vertices.data(), vbSize);
+
+    status = m_vb->Unlock();
+    if (FAILED(status))
+      throw DxvkError("Failed to unlock vertex buffer");
+
+    m_device->SetStreamSource(0, m_vb.ptr(), 0, 3 * sizeof(float));
+
+    std::array<D3DVERTEXELEMENT9, 2> elements;
+
+    elements[0].Method = 0;
+    elements[0].Offset = 0;
+    elements[0].Stream = 0;
+    elements[0].Type = D3DDECLTYPE_FLOAT3;
+    elements[0].Usage = D3DDECLUSAGE_POSITION;
+    elements[0].UsageIndex = 0;
+
+    elements[1] = D3DDECL_END();
+
+    HRESULT result = m_device->CreateVertexDeclaration(elements.data(), &m_decl);
+    if (FAILED(result))
+      throw DxvkError("Failed to create vertex decl");
+
+    m_device->SetVertexDeclaration(m_decl.ptr());
+
+    m_csThread = findCsThread();
+
+    if (!m_csThread)
+      Logger::warn("CS thread not found, only reporting submission time");
+
+    m_csTime = getCsTime();
+  }
+
+  ~DrawStateApp() {
+    if (m_csThread)
+      CloseHandle(m_csThread);
+  }
+  
+  void run() {
+    this->adjustBackBuffer();
+
+    auto t0 = std::chrono::high_resolution_clock::now();
+
+    m_device->BeginScene();
+
+    m_device->Clear(
+      0,
+      nullptr,
+      D3DCLEAR_TARGET,
+      D3DCOLOR_RGBA(44, 62, 80, 0),
+      0.0f,
+      0);
+
+    // Change a handful of unrelated render states between
+    // each draw so that every draw has to flush pipeline
+    // state to the CS thread. This measures the per-draw
+    // overhead of the state emission path.
+    for (uint32_t i = 0; i < DrawsPerFrame; i++) {
+      m_device->SetRenderState(D3DRS_ALPHABLENDENABLE, i & 1);
+      m_device->SetRenderState(D3DRS_CULLMODE,         (i & 2) ? D3DCULL_NONE : D3DCULL_CCW);
+      m_device->SetRenderState(D3DRS_ZFUNC,            (i & 4) ? D3DCMP_LESSEQUAL : D3DCMP_ALWAYS);
+      m_device->SetRenderState(D3DRS_STENCILREF,       i & 0xff);
+      m_device->SetRenderState(D3DRS_BLENDFACTOR,      i);
+      m_device->SetRenderState(D3DRS_ALPHATESTENABLE,  (i & 8) != 0);
+
+      m_device->DrawPrimitive(D3DPT_TRIANGLELIST, 0, 1);
+    }
+
+    m_device->EndScene();
+
+    auto t1 = std::chrono::high_resolution_clock::now();
+
+    m_device->PresentEx(
+      nullptr,
+      nullptr,
+      nullptr,
+      nullptr,
+      0);
+
+    m_submitTime += t1 - t0;
+
+    if (++m_frameCount == FramesPerSample) {
+      constexpr uint64_t drawCount = FramesPerSample * DrawsPerFrame;
+
+      uint64_t submitNs = std::chrono::duration_cast<std::chrono::nanoseconds>(m_submitTime).count();
+      Logger::info(str::format("Submission: ", submitNs / drawCount, " ns per draw"));
+
+      if (m_csThread) {
+        uint64_t csTime = getCsTime();
+        uint64_t csNs = 100 * (csTime - m_csTime);
+        m_csTime = csTime;
+
+        Logger::info(str::format("CS thread:  ", csNs / drawCount, " ns per draw, ",
+          csNs / (1000 * FramesPerSample), " us per frame"));
+      }
+
+      m_submitTime = std::chrono::high_resolution_clock::duration::zero();
+      m_frameCount = 0;
+    }
+  }
+
+  /**
+   * \brief Finds the device's CS thread
+   *
+   * Looks up the thread named \c dxvk-cs in this
+   * process. The CS thread blocks while it has no
+   * work, so its CPU time is the time spent
+   * executing CS chunks.
+   * \returns Thread handle, or \c nullptr
+   */
+  static HANDLE findCsThread() {
+    using GetThreadDescriptionProc = HRESULT (WINAPI *) (HANDLE, PWSTR*);
+
+    HMODULE module = ::GetModuleHandleW(L"kernel32.dll");
+
+    if (module == nullptr)
+      return nullptr;
+
+    auto proc = reinterpret_cast<GetThreadDescriptionProc>(
+      ::GetProcAddress(module, "GetThreadDescription"));
+
+    if (proc == nullptr)
+      return nullptr;
+
+    HANDLE snapshot = ::CreateToolhelp32Snapshot(TH32CS_SNAPTHREAD, 0);
+
+    if (snapshot == INVALID_HANDLE_VALUE)
+      return nullptr;
+
+    THREADENTRY32 entry = { };
+    entry.dwSize = sizeof(entry);
+
+    HANDLE result = nullptr;
+
+    for (BOOL valid = ::Thread32First(snapshot, &entry); valid && !result;
+              valid = ::Thread32Next(snapshot, &entry)) {
+      if (entry.th32OwnerProcessID != ::GetCurrentProcessId())
+        continue;
+
+      HANDLE thread = ::OpenThread(THREAD_QUERY_LIMITED_INFORMATION, FALSE, entry.th32ThreadID);
+
+      if (thread == nullptr)
+        continue;
+
+      PWSTR name = nullptr;
+
+      if (SUCCEEDED((*proc)(thread, &name)) && name) {
+        if (!std::wcscmp(name, L"dxvk-cs"))
+          result = thread;
+
+        ::LocalFree(name);
+      }
+
+      if (result != thread)
+        ::CloseHandle(thread);
+    }
+
+    ::CloseHandle(snapshot);
+    return result;
+  }
+
+  /**
+   * \brief Queries CPU time of the CS thread
+   * \returns Kernel and user time, in 100ns units
+   */
+  uint64_t getCsTime() const {
+    FILETIME creationTime, exitTime, kernelTime, userTime;
+
+    if (!m_csThread || !::GetThreadTimes(m_csThread,
+        &creationTime, &exitTime, &kernelTime, &userTime))
+      return 0;
+
+    auto toU64 = [] (FILETIME time) {
+      return (uint64_t(time.dwHighDateTime) << 32) | time.dwLowDateTime;
+    };
+
+    return toU64(kernelTime) + toU64(userTime);
+  }
+  
+  void adjustBackBuffer() {
+    RECT windowRect = { 0, 0, 1024, 600 };
+    GetClientRect(m_window, &windowRect);
+
+    Extent2D newSize = {
+      static_cast<uint32_t>(windowRect.right - windowRect.left),
+      static_cast<uint32_t>(windowRect.bottom - windowRect.top),
+    };
+
+    if (m_windowSize.w != newSize.w
+     || m_windowSize.h != newSize.h) {
+      m_windowSize = newSize;
+
+      D3DPRESENT_PARAMETERS params;
+      getPresentParams(params);
+      HRESULT status = m_device->ResetEx(&params, nullptr);
+
+      if (FAILED(status))
+        throw DxvkError("Device reset failed");
+    }
+  }
+  
+  void getPresentParams(D3DPRESENT_PARAMETERS& params) {
+    params.AutoDepthStencilFormat = D3DFMT_UNKNOWN;
+    params.BackBufferCount = 1;
+    params.BackBufferFormat = D3DFMT_X8R8G8B8;
+    params.BackBufferWidth = m_windowSize.w;
+    params.BackBufferHeight = m_windowSize.h;
+    params.EnableAutoDepthStencil = FALSE;
+    params.Flags = 0;
+    params.FullScreen_RefreshRateInHz = 0;
+    params.hDeviceWindow = m_window;
+    params.MultiSampleQuality = 0;
+    params.MultiSampleType = D3DMULTISAMPLE_NONE;
+    params.PresentationInterval = D3DPRESENT_INTERVAL_DEFAULT;
+    params.SwapEffect = D3DSWAPEFFECT_DISCARD;
+    params.Windowed = TRUE;
+  }
+    
+private:
+  
+  HWND                          m_window;
+  Extent2D                      m_windowSize = { 1024, 600 };
+  
+  Com<IDirect3D9Ex>             m_d3d;
+  Com<IDirect3DDevice9Ex>       m_device;
+
+  Com<IDirect3DVertexShader9>   m_vs;
+  Com<IDirect3DPixelShader9>    m_ps;
+  Com<IDirect3DVertexBuffer9>   m_vb;
+  Com<IDirect3DVertexDeclaration9> m_decl;
+
+  HANDLE                        m_csThread = nullptr;
+  uint64_t                      m_csTime   = 0;
+
+  uint32_t                      m_frameCount = 0;
+
+  std::chrono::high_resolution_clock::duration m_submitTime
+    = std::chrono::high_resolution_clock::duration::zero();
+  
+};
+
+LRESULT CALLBACK WindowProc(HWND hWnd,
+                            UINT message,
+                            WPARAM wParam,
+                            LPARAM lParam);
+
+int WINAPI WinMain(HINSTANCE hInstance,
+                   HINSTANCE hPrevInstance,
+                   LPSTR lpCmdLine,
+                   int nCmdShow) {
+  HWND hWnd;
+  WNDCLASSEXW wc;
+  ZeroMemory(&wc, sizeof(WNDCLASSEX));
+  wc.cbSize = sizeof(WNDCLASSEX);
+  wc.style = CS_HREDRAW | CS_VREDRAW;
+  wc.lpfnWndProc = WindowProc;
+  wc.hInstance = hInstance;
+  wc.hCursor = LoadCursor(nullptr, IDC_ARROW);
+  wc.hbrBackground = (HBRUSH)COLOR_WINDOW;
+  wc.lpszClassName = L"WindowClass1";
+  RegisterClassExW(&wc);
+
+  hWnd = CreateWindowExW(0,
+    L"WindowClass1",
+    L"Our First Windowed Program",
+    WS_OVERLAPPEDWINDOW,
+    300, 300,
+    640, 480,
+    nullptr,
+    nullptr,
+    hInstance,
+    nullptr);
+  ShowWindow(hWnd, nCmdShow);
+
+  MSG msg;
+  
+  try {
+    DrawStateApp app(hInstance, hWnd);
+  
+    while (true) {
+      if (PeekMessage(&msg, nullptr, 0, 0, PM_REMOVE)) {
+        TranslateMessage(&msg);
+        DispatchMessage(&msg);
+        
+        if (msg.message == WM_QUIT)
+          return msg.wParam;
+      } else {
+        app.run();
+      }
+    }
+  } catch (const dxvk::DxvkError& e) {
+    Logger::err(e.message());
+    return msg.wParam;
+  }
+}
+
+LRESULT CALLBACK WindowProc(HWND hWnd, UINT message, WPARAM wParam, LPARAM lParam) {
+  switch (message) {
+    case WM_CLOSE:
+      PostQuitMessage(0);
+      return 0;
+  }
+
+  return DefWindowProc(hWnd, message, wParam, lParam);
+}
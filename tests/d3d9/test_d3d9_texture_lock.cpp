@@ -0,0 +1,320 @@
+#include <cstdlib>
+#include <fstream>
+
+#include <d3d9.h>
+
+#include "../test_utils.h"
+
+using namespace dxvk;
+
+struct Extent2D {
+  uint32_t w, h;
+};
+
+constexpr uint32_t TextureSize = 64;
+
+constexpr D3DCOLOR ClearColor  = D3DCOLOR_ARGB(255, 255,   0,   0);
+constexpr D3DCOLOR UpdateColor = D3DCOLOR_ARGB(255,   0, 255,   0);
+
+bool isInside(const RECT& rect, LONG x, LONG y) {
+  return x >= rect.left && x < rect.right
+      && y >= rect.top  && y < rect.bottom;
+}
+
+class TextureLockApp {
+  
+public:
+  
+  TextureLockApp(HINSTANCE instance, HWND window)
+  : m_window(window) {
+    // Managed textures are not read back on lock, and evicting
+    // the mapping buffer on unlock means that it is zeroed on
+    // the next lock. Uploading anything outside the locked
+    // rect would therefore overwrite previous contents.
+    if (!std::getenv("DXVK_CONFIG_FILE")) {
+      std::ofstream config("d3d9-texture-lock.conf");
+      config << "d3d9.evictManagedOnUnlock = True" << std::endl;
+      _putenv("DXVK_CONFIG_FILE=d3d9-texture-lock.conf");
+    }
+
+    // Managed textures are not supported on D3D9Ex devices
+    IDirect3D9* d3d = Direct3DCreate9(D3D_SDK_VERSION);
+
+    if (d3d == nullptr)
+      throw DxvkError("Failed to create D3D9 interface");
+
+    m_d3d = d3d;
+    d3d->Release();
+
+    D3DPRESENT_PARAMETERS params;
+    getPresentParams(params);
+
+    HRESULT status = m_d3d->CreateDevice(
+      D3DADAPTER_DEFAULT,
+      D3DDEVTYPE_HAL,
+      m_window,
+      D3DCREATE_HARDWARE_VERTEXPROCESSING,
+      &params,
+      &m_device);
+    
+    if (FAILED(status))
+      throw DxvkError("Failed to create D3D9 device");
+
+    RECT rects[] = {
+      {  8,  8, 16, 16 },
+      { 40,  4, 63, 30 },
+      {  0, 60, 64, 64 },
+    };
+
+    for (uint32_t i = 0; i < ARRAYSIZE(rects); i++)
+      testPartialUpdate(rects[i]);
+  }
+
+  void testPartialUpdate(const RECT& rect) {
+    Com<IDirect3DTexture9> texture;
+    HRESULT status = m_device->CreateTexture(TextureSize, TextureSize, 1,
+      0, D3DFMT_A8R8G8B8, D3DPOOL_MANAGED, &texture, nullptr);
+
+    if (FAILED(status))
+      throw DxvkError("Failed to create texture");
+
+    // The second lock starts with a zeroed mapping buffer, so
+    // texels outside the locked rect only keep their color if
+    // the unlock uploads nothing but the locked rect
+    fillRect(texture.ptr(), nullptr, 0, ClearColor);
+    fillRect(texture.ptr(), &rect, 0, UpdateColor);
+
+    Com<IDirect3DSurface9> readback = readTexture(texture.ptr());
+
+    D3DLOCKED_RECT lockedRect;
+
+    if (FAILED(readback->LockRect(&lockedRect, nullptr, D3DLOCK_READONLY)))
+      throw DxvkError("Failed to lock readback surface");
+
+    for (LONG y = 0; y < LONG(TextureSize); y++) {
+      auto row = reinterpret_cast<const D3DCOLOR*>(
+        reinterpret_cast<const uint8_t*>(lockedRect.pBits) + y * lockedRect.Pitch);
+
+      for (LONG x = 0; x < LONG(TextureSize); x++) {
+        D3DCOLOR expected = isInside(rect, x, y) ? UpdateColor : ClearColor;
+
+        if (row[x] != expected) {
+          readback->UnlockRect();
+          throw DxvkError(str::format("Texture lock: Mismatch at (", x, ",", y, "): ",
+            row[x], ", expected ", expected));
+        }
+      }
+    }
+
+    readback->UnlockRect();
+  }
+
+  Com<IDirect3DSurface9> readTexture(IDirect3DTexture9* texture) {
+    Com<IDirect3DSurface9> renderTarget;
+    Com<IDirect3DSurface9> readback;
+    Com<IDirect3DSurface9> backBuffer;
+
+    if (FAILED(m_device->CreateRenderTarget(TextureSize, TextureSize, D3DFMT_A8R8G8B8,
+          D3DMULTISAMPLE_NONE, 0, FALSE, &renderTarget, nullptr))
+     || FAILED(m_device->CreateOffscreenPlainSurface(TextureSize, TextureSize, D3DFMT_A8R8G8B8,
+          D3DPOOL_SYSTEMMEM, &readback, nullptr))
+     || FAILED(m_device->GetRenderTarget(0, &backBuffer)))
+      throw DxvkError("Failed to create readback surfaces");
+
+    // Managed textures cannot be copied directly, so
+    // draw the texture to a render target of equal size
+    struct Vertex {
+      float x, y, z, rhw;
+      float u, v;
+    };
+
+    const float size = float(TextureSize) - 0.5f;
+
+    const Vertex vertices[] = {
+      { -0.5f, -0.5f, 0.0f, 1.0f, 0.0f, 0.0f },
+      {  size, -0.5f, 0.0f, 1.0f, 1.0f, 0.0f },
+      { -0.5f,  size, 0.0f, 1.0f, 0.0f, 1.0f },
+      {  size,  size, 0.0f, 1.0f, 1.0f, 1.0f },
+    };
+
+    m_device->SetRenderTarget(0, renderTarget.ptr());
+    m_device->SetTexture(0, texture);
+    m_device->SetSamplerState(0, D3DSAMP_MINFILTER, D3DTEXF_POINT);
+    m_device->SetSamplerState(0, D3DSAMP_MAGFILTER, D3DTEXF_POINT);
+    m_device->SetTextureStageState(0, D3DTSS_COLOROP,   D3DTOP_SELECTARG1);
+    m_device->SetTextureStageState(0, D3DTSS_COLORARG1, D3DTA_TEXTURE);
+    m_device->SetTextureStageState(0, D3DTSS_ALPHAOP,   D3DTOP_SELECTARG1);
+    m_device->SetTextureStageState(0, D3DTSS_ALPHAARG1, D3DTA_TEXTURE);
+    m_device->SetRenderState(D3DRS_CULLMODE, D3DCULL_NONE);
+    m_device->SetRenderState(D3DRS_ZENABLE, D3DZB_FALSE);
+    m_device->SetFVF(D3DFVF_XYZRHW | D3DFVF_TEX1);
+
+    m_device->BeginScene();
+    m_device->DrawPrimitiveUP(D3DPT_TRIANGLESTRIP, 2, vertices, sizeof(Vertex));
+    m_device->EndScene();
+
+    m_device->SetTexture(0, nullptr);
+    m_device->SetRenderTarget(0, backBuffer.ptr());
+
+    if (FAILED(m_device->GetRenderTargetData(renderTarget.ptr(), readback.ptr())))
+      throw DxvkError("Failed to read back texture");
+
+    return readback;
+  }
+
+  void fillRect(IDirect3DTexture9* texture, const RECT* rect, DWORD flags, D3DCOLOR color) {
+    D3DLOCKED_RECT lockedRect;
+
+    if (FAILED(texture->LockRect(0, &lockedRect, rect, flags)))
+      throw DxvkError("Failed to lock texture");
+
+    LONG w = rect ? rect->right - rect->left : LONG(TextureSize);
+    LONG h = rect ? rect->bottom - rect->top : LONG(TextureSize);
+
+    for (LONG y = 0; y < h; y++) {
+      auto row = reinterpret_cast<D3DCOLOR*>(
+        reinterpret_cast<uint8_t*>(lockedRect.pBits) + y * lockedRect.Pitch);
+
+      for (LONG x = 0; x < w; x++)
+        row[x] = color;
+    }
+
+    if (FAILED(texture->UnlockRect(0)))
+      throw DxvkError("Failed to unlock texture");
+  }
+  
+  void run() {
+    this->adjustBackBuffer();
+
+    m_device->BeginScene();
+
+    m_device->Clear(
+      0,
+      nullptr,
+      D3DCLEAR_TARGET,
+      D3DCOLOR_RGBA(255, 50, 139, 0),
+      0.0f,
+      0);
+
+    m_device->EndScene();
+
+    m_device->Present(
+      nullptr,
+      nullptr,
+      nullptr,
+      nullptr);
+  }
+  
+  void adjustBackBuffer() {
+    RECT windowRect = { 0, 0, 1024, 600 };
+    GetClientRect(m_window, &windowRect);
+
+    Extent2D newSize = {
+      static_cast<uint32_t>(windowRect.right - windowRect.left),
+      static_cast<uint32_t>(windowRect.bottom - windowRect.top),
+    };
+
+    if (m_windowSize.w != newSize.w
+     || m_windowSize.h != newSize.h) {
+      m_windowSize = newSize;
+
+      D3DPRESENT_PARAMETERS params;
+      getPresentParams(params);
+      HRESULT status = m_device->Reset(&params);
+
+      if (FAILED(status))
+        throw DxvkError("Device reset failed");
+    }
+  }
+  
+  void getPresentParams(D3DPRESENT_PARAMETERS& params) {
+    params.AutoDepthStencilFormat = D3DFMT_UNKNOWN;
+    params.BackBufferCount = 1;
+    params.BackBufferFormat = D3DFMT_X8R8G8B8;
+    params.BackBufferWidth = m_windowSize.w;
+    params.BackBufferHeight = m_windowSize.h;
+    params.EnableAutoDepthStencil = FALSE;
+    params.Flags = 0;
+    params.FullScreen_RefreshRateInHz = 0;
+    params.hDeviceWindow = m_window;
+    params.MultiSampleQuality = 0;
+    params.MultiSampleType = D3DMULTISAMPLE_NONE;
+    params.PresentationInterval = D3DPRESENT_INTERVAL_DEFAULT;
+    params.SwapEffect = D3DSWAPEFFECT_DISCARD;
+    params.Windowed = TRUE;
+  }
+    
+private:
+  
+  HWND                          m_window;
+  Extent2D                      m_windowSize = { 1024, 600 };
+  
+  Com<IDirect3D9>               m_d3d;
+  Com<IDirect3DDevice9>         m_device;
+  
+};
+
+LRESULT CALLBACK WindowProc(HWND hWnd,
+                            UINT message,
+                            WPARAM wParam,
+                            LPARAM lParam);
+
+int WINAPI WinMain(HINSTANCE hInstance,
+                   HINSTANCE hPrevInstance,
+                   LPSTR lpCmdLine,
+                   int nCmdShow) {
+  HWND hWnd;
+  WNDCLASSEXW wc;
+  ZeroMemory(&wc, sizeof(WNDCLASSEX));
+  wc.cbSize = sizeof(WNDCLASSEX);
+  wc.style = CS_HREDRAW | CS_VREDRAW;
+  wc.lpfnWndProc = WindowProc;
+  wc.hInstance = hInstance;
+  wc.hCursor = LoadCursor(nullptr, IDC_ARROW);
+  wc.hbrBackground = (HBRUSH)COLOR_WINDOW;
+  wc.lpszClassName = L"WindowClass1";
+  RegisterClassExW(&wc);
+
+  hWnd = CreateWindowExW(0,
+    L"WindowClass1",
+    L"Our First Windowed Program",
+    WS_OVERLAPPEDWINDOW,
+    300, 300,
+    640, 480,
+    nullptr,
+    nullptr,
+    hInstance,
+    nullptr);
+  ShowWindow(hWnd, nCmdShow);
+
+  MSG msg;
+  
+  try {
+    TextureLockApp app(hInstance, hWnd);
+  
+    while (true) {
+      if (PeekMessage(&msg, nullptr, 0, 0, PM_REMOVE)) {
+        TranslateMessage(&msg);
+        DispatchMessage(&msg);
+        
+        if (msg.message == WM_QUIT)
+          return msg.wParam;
+      } else {
+        app.run();
+      }
+    }
+  } catch (const dxvk::DxvkError& e) {
+    std::cerr << e.message() << std::endl;
+    return msg.wParam;
+  }
+}
+
+LRESULT CALLBACK WindowProc(HWND hWnd, UINT message, WPARAM wParam, LPARAM lParam) {
+  switch (message) {
+    case WM_CLOSE:
+      PostQuitMessage(0);
+      return 0;
+  }
+
+  return DefWindowProc(hWnd, message, wParam, lParam);
+}
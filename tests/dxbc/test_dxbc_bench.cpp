@@ -0,0 +1,83 @@
+#include <chrono>
+#include <iterator>
+#include <fstream>
+
+#include "../../src/dxbc/dxbc_module.h"
+#include "../../src/dxvk/dxvk_shader.h"
+
+#include <shellapi.h>
+#include <windows.h>
+#include <windowsx.h>
+
+namespace dxvk {
+  Logger Logger::s_instance("dxbc-bench.log");
+}
+
+using namespace dxvk;
+
+using Clock = std::chrono::high_resolution_clock;
+
+constexpr uint32_t IterationCount = 16;
+
+std::vector<char> readFile(const std::string& fileName) {
+  std::ifstream ifile(fileName, std::ios::binary);
+  ifile.ignore(std::numeric_limits<std::streamsize>::max());
+  std::streamsize length = ifile.gcount();
+  ifile.clear();
+
+  ifile.seekg(0, std::ios_base::beg);
+  std::vector<char> result(length);
+  ifile.read(result.data(), length);
+  return result;
+}
+
+int WINAPI WinMain(HINSTANCE hInstance,
+                   HINSTANCE hPrevInstance,
+                   LPSTR lpCmdLine,
+                   int nCmdShow) {
+  int     argc = 0;
+  LPWSTR* argv = CommandLineToArgvW(
+    GetCommandLineW(), &argc);
+
+  if (argc < 2) {
+    Logger::err("Usage: dxbc-bench input.dxbc [input.dxbc...]");
+    return 1;
+  }
+
+  DxbcModuleInfo moduleInfo;
+  moduleInfo.options.useSubgroupOpsForAtomicCounters = true;
+  moduleInfo.options.useSubgroupOpsForEarlyDiscard = true;
+  moduleInfo.options.minSsboAlignment = 4;
+  moduleInfo.xfb = nullptr;
+
+  std::chrono::microseconds totalTime(0);
+
+  for (int i = 1; i < argc; i++) {
+    std::string fileName = str::fromws(argv[i]);
+
+    try {
+      std::vector<char> dxbcCode = readFile(fileName);
+
+      DxbcReader reader(dxbcCode.data(), dxbcCode.size());
+      DxbcModule module(reader);
+
+      auto t0 = Clock::now();
+
+      for (uint32_t j = 0; j < IterationCount; j++)
+        module.compile(moduleInfo, fileName);
+
+      auto t1 = Clock::now();
+      auto us = std::chrono::duration_cast<std::chrono::microseconds>(t1 - t0);
+      totalTime += us;
+
+      Logger::info(str::format(fileName, ": ", us.count() / IterationCount,
+        " us per translation (", dxbcCode.size(), " bytes)"));
+    } catch (const DxvkError& e) {
+      Logger::err(str::format(fileName, ": ", e.message()));
+    }
+  }
+
+  Logger::info(str::format("Total: ", totalTime.count() / IterationCount,
+    " us per translation of ", argc - 1, " shaders"));
+  return 0;
+}
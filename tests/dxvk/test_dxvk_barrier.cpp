@@ -0,0 +1,233 @@
+#include <chrono>
+#include <vector>
+
+#include "../../src/dxvk/dxvk_barrier.h"
+
+#include <windows.h>
+
+namespace dxvk {
+  Logger Logger::s_instance("dxvk-barrier-bench.log");
+}
+
+using namespace dxvk;
+
+using Clock = std::chrono::high_resolution_clock;
+
+constexpr uint32_t AccessCount = 1 << 20;
+
+/**
+ * \brief Linear barrier tracker
+ *
+ * Mirrors the dirty checks that the barrier
+ * set performed before using a hash table.
+ */
+class LinearBarrierSet {
+
+public:
+
+  LinearBarrierSet(DxvkCmdBuffer) { }
+
+  void accessBuffer(
+    const DxvkBufferSliceHandle&    bufSlice,
+          VkPipelineStageFlags      srcStages,
+          VkAccessFlags             srcAccess,
+          VkPipelineStageFlags      dstStages,
+          VkAccessFlags             dstAccess) {
+    DxvkAccessFlags access(DxvkAccess::Read);
+
+    if (srcAccess & VK_ACCESS_SHADER_WRITE_BIT)
+      access.set(DxvkAccess::Write);
+
+    m_slices.push_back({ bufSlice, access });
+  }
+
+  bool isBufferDirty(
+    const DxvkBufferSliceHandle&    bufSlice,
+          DxvkAccessFlags           bufAccess) {
+    bool result = false;
+
+    for (uint32_t i = 0; i < m_slices.size() && !result; i++) {
+      const DxvkBufferSliceHandle& dstSlice = m_slices[i].slice;
+
+      result = (bufSlice.handle == dstSlice.handle) && (bufAccess | m_slices[i].access).test(DxvkAccess::Write)
+            && (bufSlice.offset + bufSlice.length > dstSlice.offset)
+            && (bufSlice.offset < dstSlice.offset + dstSlice.length);
+    }
+
+    return result;
+  }
+
+  void reset() {
+    m_slices.resize(0);
+  }
+
+private:
+
+  struct Slice {
+    DxvkBufferSliceHandle slice;
+    DxvkAccessFlags       access;
+  };
+
+  std::vector<Slice> m_slices;
+
+};
+
+
+/**
+ * \brief Generates a synthetic access stream
+ *
+ * Each batch writes to \c sliceCount distinct buffer
+ * slices, spread across a smaller number of buffers,
+ * and ends with an access that conflicts with one of
+ * the previous writes, which flushes the barrier set.
+ */
+std::vector<DxvkBufferSliceHandle> generateStream(uint32_t sliceCount) {
+  std::vector<DxvkBufferSliceHandle> stream;
+  stream.reserve(AccessCount);
+
+  uint32_t bufferCount = std::max(sliceCount / 4, 1u);
+  uint32_t seed = 1;
+
+  while (stream.size() < AccessCount) {
+    for (uint32_t i = 0; i < sliceCount; i++) {
+      DxvkBufferSliceHandle slice;
+      slice.handle = VkBuffer(uintptr_t(64 * (1 + (i % bufferCount))));
+      slice.offset = 256 * (i / bufferCount);
+      slice.length = 256;
+      slice.mapPtr = nullptr;
+      stream.push_back(slice);
+    }
+
+    seed = seed * 1103515245u + 12345u;
+    stream.push_back(stream[stream.size() - 1 - (seed >> 16) % sliceCount]);
+  }
+
+  return stream;
+}
+
+
+template<typename BarrierSet>
+void runBenchmark(const char* name, uint32_t sliceCount) {
+  std::vector<DxvkBufferSliceHandle> stream = generateStream(sliceCount);
+
+  BarrierSet barriers(DxvkCmdBuffer::ExecBuffer);
+  uint32_t   flushes = 0;
+
+  auto t0 = Clock::now();
+
+  for (const auto& slice : stream) {
+    if (barriers.isBufferDirty(slice, DxvkAccess::Write)) {
+      barriers.reset();
+      flushes += 1;
+    }
+
+    barriers.accessBuffer(slice,
+      VK_PIPELINE_STAGE_COMPUTE_SHADER_BIT,
+      VK_ACCESS_SHADER_WRITE_BIT,
+      VK_PIPELINE_STAGE_COMPUTE_SHADER_BIT,
+      VK_ACCESS_SHADER_READ_BIT | VK_ACCESS_SHADER_WRITE_BIT);
+  }
+
+  auto t1 = Clock::now();
+  auto us = std::chrono::duration_cast<std::chrono::microseconds>(t1 - t0);
+
+  Logger::info(str::format(name, ", ", sliceCount, " slices: ",
+    us.count() / 1000, " ms (", uint64_t(stream.size()) * 1000 / std::max<uint64_t>(us.count(), 1),
+    " accesses/ms, ", flushes, " flushes)"));
+}
+
+
+/**
+ * \brief Checks that both barrier sets agree
+ *
+ * Feeds the same random sequence of partially overlapping
+ * reads and writes into both barrier sets, and checks that
+ * every dirty check returns the same result. Both sets are
+ * flushed whenever a conflict is found.
+ * \returns \c true if both sets behave identically
+ */
+bool verifyConsistency() {
+  LinearBarrierSet linear(DxvkCmdBuffer::ExecBuffer);
+  DxvkBarrierSet   hashed(DxvkCmdBuffer::ExecBuffer);
+
+  uint32_t linearFlushes = 0;
+  uint32_t hashedFlushes = 0;
+  uint32_t mismatches    = 0;
+
+  uint32_t seed = 1;
+
+  auto next = [&seed] () {
+    seed = seed * 1103515245u + 12345u;
+    return seed >> 16;
+  };
+
+  for (uint32_t i = 0; i < AccessCount / 16; i++) {
+    DxvkBufferSliceHandle slice;
+    slice.handle = VkBuffer(uintptr_t(64 * (1 + next() % 8)));
+    slice.offset = 16 * (next() % 256);
+    slice.length = 16 * (1 + next() % 32);
+    slice.mapPtr = nullptr;
+
+    bool isWrite = next() % 4 == 0;
+
+    DxvkAccessFlags access = isWrite
+      ? DxvkAccessFlags(DxvkAccess::Read, DxvkAccess::Write)
+      : DxvkAccessFlags(DxvkAccess::Read);
+
+    bool linearDirty = linear.isBufferDirty(slice, access);
+    bool hashedDirty = hashed.isBufferDirty(slice, access);
+
+    if (linearDirty != hashedDirty) {
+      if (!mismatches++) {
+        Logger::err(str::format("Access ", i, ": Linear set returned ", linearDirty,
+          ", hashed set returned ", hashedDirty));
+      }
+    }
+
+    if (linearDirty) {
+      linear.reset();
+      linearFlushes += 1;
+    }
+
+    if (hashedDirty) {
+      hashed.reset();
+      hashedFlushes += 1;
+    }
+
+    VkAccessFlags srcAccess = isWrite
+      ? VK_ACCESS_SHADER_WRITE_BIT
+      : VK_ACCESS_SHADER_READ_BIT;
+
+    linear.accessBuffer(slice,
+      VK_PIPELINE_STAGE_COMPUTE_SHADER_BIT, srcAccess,
+      VK_PIPELINE_STAGE_COMPUTE_SHADER_BIT, VK_ACCESS_SHADER_READ_BIT | VK_ACCESS_SHADER_WRITE_BIT);
+    hashed.accessBuffer(slice,
+      VK_PIPELINE_STAGE_COMPUTE_SHADER_BIT, srcAccess,
+      VK_PIPELINE_STAGE_COMPUTE_SHADER_BIT, VK_ACCESS_SHADER_READ_BIT | VK_ACCESS_SHADER_WRITE_BIT);
+  }
+
+  if (linearFlushes != hashedFlushes) {
+    Logger::err(str::format("Flush count mismatch: Linear ", linearFlushes,
+      ", hashed ", hashedFlushes));
+  }
+
+  Logger::info(str::format("Consistency check: ", mismatches, " mismatches, ",
+    hashedFlushes, " flushes"));
+  return !mismatches && linearFlushes == hashedFlushes;
+}
+
+
+int WINAPI WinMain(HINSTANCE hInstance,
+                   HINSTANCE hPrevInstance,
+                   LPSTR lpCmdLine,
+                   int nCmdShow) {
+  if (!verifyConsistency())
+    return 1;
+
+  for (uint32_t sliceCount : { 10u, 100u, 1000u }) {
+    runBenchmark<LinearBarrierSet>("Linear", sliceCount);
+    runBenchmark<DxvkBarrierSet>  ("Hashed", sliceCount);
+  }
+
+  return 0;
+}
@@ -0,0 +1,145 @@
+#include <algorithm>
+#include <chrono>
+#include <functional>
+#include <mutex>
+#include <unordered_map>
+#include <vector>
+
+#include "../../src/dxvk/dxvk_include.h"
+
+#include "../../src/util/thread.h"
+
+#include <windows.h>
+
+namespace dxvk {
+  Logger Logger::s_instance("dxvk-cache-bench.log");
+}
+
+using namespace dxvk;
+
+using Clock = std::chrono::high_resolution_clock;
+
+constexpr uint32_t ThreadCount   = 8;
+constexpr uint32_t KeyCount      = 4096;
+constexpr uint32_t LookupCount   = 1 << 20;
+
+/**
+ * \brief Simulates the cost of creating a cache entry
+ *
+ * Roughly approximates compiling a small shader
+ * or creating a sampler, which is the expensive
+ * part that happens outside of any lock.
+ */
+uint64_t createEntry(uint64_t key) {
+  uint64_t value = key;
+
+  for (uint32_t i = 0; i < 4096; i++)
+    value = value * 6364136223846793005ull + 1442695040888963407ull;
+
+  return value;
+}
+
+
+/**
+ * \brief Mutex-protected map
+ *
+ * Mirrors the locking scheme that the shader
+ * module set used before switching to the
+ * concurrent cache.
+ */
+class LockedCache {
+
+public:
+
+  uint64_t get(uint64_t key) {
+    { std::lock_guard<std::mutex> lock(m_mutex);
+
+      auto entry = m_map.find(key);
+      if (entry != m_map.end())
+        return entry->second;
+    }
+
+    uint64_t value = createEntry(key);
+
+    { std::lock_guard<std::mutex> lock(m_mutex);
+      return m_map.insert({ key, value }).first->second;
+    }
+  }
+
+private:
+
+  std::mutex                             m_mutex;
+  std::unordered_map<uint64_t, uint64_t> m_map;
+
+};
+
+
+class LockFreeCache {
+
+public:
+
+  uint64_t get(uint64_t key) {
+    const uint64_t* entry = m_cache.find(key);
+
+    if (entry != nullptr)
+      return *entry;
+
+    return *m_cache.insert(key, createEntry(key)).first;
+  }
+
+private:
+
+  sync::ConcurrentCache<uint64_t, uint64_t,
+    std::hash<uint64_t>, std::equal_to<uint64_t>> m_cache;
+
+};
+
+
+template<typename Cache>
+void runBenchmark(const char* name, uint32_t threadCount) {
+  Cache cache;
+
+  std::vector<dxvk::thread> threads;
+  std::atomic<uint64_t> checksum = { 0ull };
+
+  auto t0 = Clock::now();
+
+  for (uint32_t i = 0; i < threadCount; i++) {
+    threads.emplace_back([&cache, &checksum, i] {
+      uint64_t sum = 0;
+      uint32_t key = i * 7919;
+
+      // Walk the key space in a thread-specific order so
+      // that threads race on creating the same entries
+      for (uint32_t j = 0; j < LookupCount; j++) {
+        sum += cache.get(key % KeyCount);
+        key += 2654435761u;
+      }
+
+      checksum += sum;
+    });
+  }
+
+  for (auto& t : threads)
+    t.join();
+
+  auto t1 = Clock::now();
+  auto us = std::chrono::duration_cast<std::chrono::microseconds>(t1 - t0);
+
+  Logger::info(str::format(name, ", ", threadCount, " threads: ",
+    us.count() / 1000, " ms (", uint64_t(threadCount) * LookupCount * 1000 / std::max<uint64_t>(us.count(), 1),
+    " lookups/ms, checksum ", checksum.load(), ")"));
+}
+
+
+int WINAPI WinMain(HINSTANCE hInstance,
+                   HINSTANCE hPrevInstance,
+                   LPSTR lpCmdLine,
+                   int nCmdShow) {
+  for (uint32_t threadCount = 1; threadCount <= ThreadCount; threadCount *= 2) {
+    runBenchmark<LockedCache>  ("std::mutex + unordered_map", threadCount);
+    runBenchmark<LockFreeCache>("sync::ConcurrentCache     ", threadCount);
+  }
+
+  return 0;
+}
@@ -0,0 +1,162 @@
+#include <chrono>
+#include <condition_variable>
+#include <mutex>
+#include <queue>
+
+#include "../../src/dxvk/dxvk_include.h"
+
+#include "../../src/util/thread.h"
+#include "../../src/util/sync/sync_spsc.h"
+
+#include <windows.h>
+
+namespace dxvk {
+  Logger Logger::s_instance("dxvk-cs-queue-bench.log");
+}
+
+using namespace dxvk;
+
+using Clock = std::chrono::high_resolution_clock;
+
+constexpr uint32_t ThroughputCount = 1 << 22;
+constexpr uint32_t LatencyCount    = 1 << 14;
+
+/**
+ * \brief Mutex-protected queue
+ *
+ * Mirrors the hand-off that the CS thread
+ * used before switching to the SPSC queue.
+ */
+class MutexQueue {
+
+public:
+
+  void push(uint64_t&& item) {
+    { std::unique_lock<std::mutex> lock(m_mutex);
+      m_items.push(item);
+    }
+
+    m_condOnAdd.notify_one();
+  }
+
+  bool pop(uint64_t& item) {
+    std::unique_lock<std::mutex> lock(m_mutex);
+
+    m_condOnAdd.wait(lock, [this] {
+      return !m_items.empty() || m_stopped;
+    });
+
+    if (m_items.empty())
+      return false;
+
+    item = m_items.front();
+    m_items.pop();
+    return true;
+  }
+
+  void stop() {
+    { std::unique_lock<std::mutex> lock(m_mutex);
+      m_stopped = true;
+    }
+
+    m_condOnAdd.notify_one();
+  }
+
+private:
+
+  std::mutex              m_mutex;
+  std::condition_variable m_condOnAdd;
+  std::queue<uint64_t>    m_items;
+  bool                    m_stopped = false;
+
+};
+
+
+using SpscQueue = sync::SpscQueue<uint64_t, 256>;
+
+
+uint64_t getTimestamp() {
+  return std::chrono::duration_cast<std::chrono::nanoseconds>(
+    Clock::now().time_since_epoch()).count();
+}
+
+
+template<typename Queue>
+void runThroughputBenchmark(const char* name) {
+  Queue queue;
+
+  uint64_t sum = 0;
+
+  auto t0 = Clock::now();
+
+  dxvk::thread consumer([&queue, &sum] {
+    uint64_t item;
+
+    while (queue.pop(item))
+      sum += item;
+  });
+
+  for (uint32_t i = 0; i < ThroughputCount; i++)
+    queue.push(uint64_t(i));
+
+  queue.stop();
+  consumer.join();
+
+  auto t1 = Clock::now();
+  auto us = std::chrono::duration_cast<std::chrono::microseconds>(t1 - t0);
+
+  Logger::info(str::format(name, " throughput: ", us.count() / 1000, " ms (",
+    uint64_t(ThroughputCount) * 1000 / std::max<uint64_t>(us.count(), 1),
+    " items/ms, checksum ", sum, ")"));
+}
+
+
+template<typename Queue>
+void runLatencyBenchmark(const char* name, uint32_t intervalUs) {
+  Queue queue;
+
+  uint64_t totalNs = 0;
+  uint64_t maxNs   = 0;
+
+  dxvk::thread consumer([&queue, &totalNs, &maxNs] {
+    uint64_t timestamp;
+
+    while (queue.pop(timestamp)) {
+      uint64_t ns = getTimestamp() - timestamp;
+      totalNs += ns;
+      maxNs = std::max(maxNs, ns);
+    }
+  });
+
+  // Space out items so that the consumer runs out
+  // of work in between, like a CS thread would
+  for (uint32_t i = 0; i < LatencyCount; i++) {
+    auto next = Clock::now() + std::chrono::microseconds(intervalUs);
+    queue.push(getTimestamp());
+
+    while (Clock::now() < next)
+      continue;
+  }
+
+  queue.stop();
+  consumer.join();
+
+  Logger::info(str::format(name, " latency, ", intervalUs, " us interval: avg ",
+    totalNs / LatencyCount, " ns, max ", maxNs / 1000, " us"));
+}
+
+
+int WINAPI WinMain(HINSTANCE hInstance,
+                   HINSTANCE hPrevInstance,
+                   LPSTR lpCmdLine,
+                   int nCmdShow) {
+  runThroughputBenchmark<MutexQueue>("std::mutex + std::queue");
+  runThroughputBenchmark<SpscQueue> ("sync::SpscQueue        ");
+
+  for (uint32_t intervalUs : { 1u, 10u, 100u }) {
+    runLatencyBenchmark<MutexQueue>("std::mutex + std::queue", intervalUs);
+    runLatencyBenchmark<SpscQueue> ("sync::SpscQueue        ", intervalUs);
+  }
+
+  return 0;
+}
@@ -0,0 +1,263 @@
+#include <array>
+#include <chrono>
+#include <cstring>
+#include <vector>
+
+#include "../../src/dxvk/dxvk_descriptor.h"
+#include "../../src/dxvk/dxvk_limits.h"
+#include "../../src/dxvk/dxvk_pipelayout.h"
+
+#include <windows.h>
+
+namespace dxvk {
+  Logger Logger::s_instance("dxvk-descriptor-bench.log");
+}
+
+using namespace dxvk;
+
+using Clock = std::chrono::high_resolution_clock;
+
+constexpr uint32_t UpdateCount   = 1 << 18;
+constexpr uint32_t ResourceCount = 64;
+
+/**
+ * \brief Creates a fake Vulkan handle
+ *
+ * Non-dispatchable handles are 64-bit
+ * values on all platforms, so this works
+ * for both 32-bit and 64-bit builds.
+ */
+template<typename T>
+T fakeHandle(uint64_t value) {
+  T handle;
+  std::memcpy(&handle, &value, sizeof(handle));
+  return handle;
+}
+
+
+/**
+ * \brief Retrieves the value of a fake handle
+ */
+template<typename T>
+uint64_t handleValue(T handle) {
+  uint64_t value = 0;
+  std::memcpy(&value, &handle, sizeof(handle));
+  return value;
+}
+
+
+/**
+ * \brief Builds a typical graphics pipeline layout
+ *
+ * Roughly matches a D3D11 vertex and pixel shader
+ * pair, with constant buffers, samplers and shader
+ * resources grouped by stage like the D3D11 front
+ * end does it.
+ */
+std::vector<DxvkDescriptorSlot> getBindings() {
+  std::vector<DxvkDescriptorSlot> result;
+
+  auto add = [&result] (VkDescriptorType type, VkShaderStageFlags stages, uint32_t count) {
+    for (uint32_t i = 0; i < count; i++) {
+      DxvkDescriptorSlot slot;
+      slot.slot   = uint32_t(result.size());
+      slot.type   = type;
+      slot.view   = VK_IMAGE_VIEW_TYPE_2D;
+      slot.stages = stages;
+      slot.access = VK_ACCESS_SHADER_READ_BIT;
+      result.push_back(slot);
+    }
+  };
+
+  for (VkShaderStageFlags stage : { VK_SHADER_STAGE_VERTEX_BIT, VK_SHADER_STAGE_FRAGMENT_BIT }) {
+    add(VK_DESCRIPTOR_TYPE_UNIFORM_BUFFER_DYNAMIC, stage, 4);
+    add(VK_DESCRIPTOR_TYPE_SAMPLER,                stage, 4);
+    add(VK_DESCRIPTOR_TYPE_SAMPLED_IMAGE,          stage, 8);
+    add(VK_DESCRIPTOR_TYPE_UNIFORM_TEXEL_BUFFER,   stage, 1);
+  }
+
+  return result;
+}
+
+
+/**
+ * \brief Fills in descriptor info for a binding
+ *
+ * Mirrors what the context does for each
+ * binding when updating shader resources.
+ */
+void getDescriptor(
+  const DxvkDescriptorSlot&   binding,
+        uint32_t              resource,
+        DxvkDescriptorInfo&   info) {
+  switch (binding.type) {
+    case VK_DESCRIPTOR_TYPE_SAMPLER:
+      info.image.sampler     = fakeHandle<VkSampler>(0x1000 + resource);
+      info.image.imageView   = VK_NULL_HANDLE;
+      info.image.imageLayout = VK_IMAGE_LAYOUT_UNDEFINED;
+      break;
+
+    case VK_DESCRIPTOR_TYPE_SAMPLED_IMAGE:
+      info.image.sampler     = VK_NULL_HANDLE;
+      info.image.imageView   = fakeHandle<VkImageView>(0x2000 + resource);
+      info.image.imageLayout = VK_IMAGE_LAYOUT_SHADER_READ_ONLY_OPTIMAL;
+      break;
+
+    case VK_DESCRIPTOR_TYPE_UNIFORM_TEXEL_BUFFER:
+      info.texelBuffer = fakeHandle<VkBufferView>(0x3000 + resource);
+      break;
+
+    default:
+      info.buffer.buffer = fakeHandle<VkBuffer>(0x4000 + resource);
+      info.buffer.offset = 0;
+      info.buffer.range  = 256;
+  }
+}
+
+
+/**
+ * \brief Folds a descriptor into a checksum
+ *
+ * Reads back everything that was written for the
+ * descriptor type, the same way the driver would
+ * consume it. This keeps the compiler from removing
+ * stores that are not otherwise used.
+ */
+uint64_t foldDescriptor(
+        VkDescriptorType          type,
+  const VkDescriptorImageInfo*    pImageInfo,
+  const VkDescriptorBufferInfo*   pBufferInfo,
+  const VkBufferView*             pTexelBufferView) {
+  switch (type) {
+    case VK_DESCRIPTOR_TYPE_SAMPLER:
+    case VK_DESCRIPTOR_TYPE_SAMPLED_IMAGE:
+      return handleValue(pImageInfo->sampler)
+           + handleValue(pImageInfo->imageView)
+           + pImageInfo->imageLayout;
+
+    case VK_DESCRIPTOR_TYPE_UNIFORM_TEXEL_BUFFER:
+      return handleValue(*pTexelBufferView);
+
+    default:
+      return handleValue(pBufferInfo->buffer)
+           + pBufferInfo->offset
+           + pBufferInfo->range;
+  }
+}
+
+
+/**
+ * \brief Builds one write structure per binding
+ *
+ * This is what updating descriptor sets with
+ * vkUpdateDescriptorSets would look like.
+ */
+uint64_t packWrites(const std::vector<DxvkDescriptorSlot>& bindings, uint32_t seed) {
+  std::array<DxvkDescriptorInfo,   MaxNumActiveBindings> infos;
+  std::array<VkWriteDescriptorSet, MaxNumActiveBindings> writes;
+
+  VkDescriptorSet set = fakeHandle<VkDescriptorSet>(0x5000);
+
+  for (uint32_t i = 0; i < bindings.size(); i++) {
+    getDescriptor(bindings[i], (seed + i) % ResourceCount, infos[i]);
+
+    writes[i].sType            = VK_STRUCTURE_TYPE_WRITE_DESCRIPTOR_SET;
+    writes[i].pNext            = nullptr;
+    writes[i].dstSet           = set;
+    writes[i].dstBinding       = i;
+    writes[i].dstArrayElement  = 0;
+    writes[i].descriptorCount  = 1;
+    writes[i].descriptorType   = bindings[i].type;
+    writes[i].pImageInfo       = &infos[i].image;
+    writes[i].pBufferInfo      = &infos[i].buffer;
+    writes[i].pTexelBufferView = &infos[i].texelBuffer;
+  }
+
+  uint64_t result = 0;
+
+  for (uint32_t i = 0; i < bindings.size(); i++) {
+    result += handleValue(writes[i].dstSet)
+            + writes[i].dstBinding
+            + writes[i].descriptorCount
+            + foldDescriptor(writes[i].descriptorType,
+                writes[i].pImageInfo,
+                writes[i].pBufferInfo,
+                writes[i].pTexelBufferView);
+  }
+
+  return result;
+}
+
+
+/**
+ * \brief Packs descriptor infos for a template
+ *
+ * The packed array can be passed directly
+ * to vkUpdateDescriptorSetWithTemplate.
+ */
+uint64_t packInfos(const std::vector<DxvkDescriptorSlot>& bindings, uint32_t seed) {
+  std::array<DxvkDescriptorInfo, MaxNumActiveBindings> infos;
+
+  for (uint32_t i = 0; i < bindings.size(); i++)
+    getDescriptor(bindings[i], (seed + i) % ResourceCount, infos[i]);
+
+  uint64_t result = 0;
+
+  for (uint32_t i = 0; i < bindings.size(); i++) {
+    result += i + foldDescriptor(bindings[i].type,
+      &infos[i].image, &infos[i].buffer, &infos[i].texelBuffer);
+  }
+
+  return result;
+}
+
+
+/**
+ * \brief Packs descriptor infos and hashes them
+ *
+ * Additionally computes the key that is used
+ * to look up previously written descriptor sets.
+ */
+uint64_t packInfosAndHash(const std::vector<DxvkDescriptorSlot>& bindings, uint32_t seed) {
+  std::array<DxvkDescriptorInfo, MaxNumActiveBindings> infos;
+
+  for (uint32_t i = 0; i < bindings.size(); i++)
+    getDescriptor(bindings[i], (seed + i) % ResourceCount, infos[i]);
+
+  return DxvkDescriptorSetCache::hash(
+    fakeHandle<VkDescriptorSetLayout>(0x6000),
+    bindings.size(), infos.data());
+}
+
+
+template<typename Fn>
+void runBenchmark(const char* name, const std::vector<DxvkDescriptorSlot>& bindings, const Fn& fn) {
+  uint64_t checksum = 0;
+
+  auto t0 = Clock::now();
+
+  for (uint32_t i = 0; i < UpdateCount; i++)
+    checksum += fn(bindings, i);
+
+  auto t1 = Clock::now();
+  auto ns = std::chrono::duration_cast<std::chrono::nanoseconds>(t1 - t0);
+
+  Logger::info(str::format(name, ": ", ns.count() / UpdateCount,
+    " ns per set (", bindings.size(), " bindings, checksum ", checksum, ")"));
+}
+
+
+int WINAPI WinMain(HINSTANCE hInstance,
+                   HINSTANCE hPrevInstance,
+                   LPSTR lpCmdLine,
+                   int nCmdShow) {
+  auto bindings = getBindings();
+  auto entries  = DxvkPipelineLayout::getTemplateEntries(bindings.size(), bindings.data());
+
+  Logger::info(str::format("Template entries: ", entries.size(), " for ", bindings.size(), " bindings"));
+
+  runBenchmark("VkWriteDescriptorSet     ", bindings, packWrites);
+  runBenchmark("DxvkDescriptorInfo       ", bindings, packInfos);
+  runBenchmark("DxvkDescriptorInfo + hash", bindings, packInfosAndHash);
+  return 0;
+}
@@ -0,0 +1,140 @@
+#include <iterator>
+#include <map>
+#include <random>
+#include <vector>
+
+#include "../../src/dxvk/dxvk_memory_tlsf.h"
+
+#include <windows.h>
+
+namespace dxvk {
+  Logger Logger::s_instance("dxvk-memory-tlsf-test.log");
+}
+
+using namespace dxvk;
+
+constexpr VkDeviceSize HeapSize       = VkDeviceSize(16) << 20;
+constexpr uint32_t     IterationCount = 1 << 18;
+
+struct Allocation {
+  uint32_t      block;
+  VkDeviceSize  size;
+  VkDeviceSize  align;
+};
+
+
+/**
+ * \brief Checks a new allocation
+ *
+ * Validates alignment and size, and checks that the
+ * block does not overlap any live allocation. Live
+ * allocations are indexed by their offset.
+ * \returns \c true if the allocation is valid
+ */
+bool checkAllocation(
+  const DxvkTlsfAllocator&                      allocator,
+  const std::map<VkDeviceSize, Allocation>&     allocations,
+  const Allocation&                             allocation) {
+  VkDeviceSize offset = allocator.blockOffset(allocation.block);
+  VkDeviceSize length = allocator.blockLength(allocation.block);
+
+  if (offset % allocation.align) {
+    Logger::err(str::format("Block at ", offset, " not aligned to ", allocation.align));
+    return false;
+  }
+
+  if (length < allocation.size || offset + length > HeapSize) {
+    Logger::err(str::format("Block at ", offset, " has invalid length ", length,
+      ", requested ", allocation.size));
+    return false;
+  }
+
+  auto next = allocations.lower_bound(offset);
+
+  if (next != allocations.end() && next->first < offset + length) {
+    Logger::err(str::format("Block at ", offset, " overlaps block at ", next->first));
+    return false;
+  }
+
+  if (next != allocations.begin()) {
+    auto prev = std::prev(next);
+
+    if (prev->first + allocator.blockLength(prev->second.block) > offset) {
+      Logger::err(str::format("Block at ", offset, " overlaps block at ", prev->first));
+      return false;
+    }
+  }
+
+  return true;
+}
+
+
+int WINAPI WinMain(HINSTANCE hInstance,
+                   HINSTANCE hPrevInstance,
+                   LPSTR lpCmdLine,
+                   int nCmdShow) {
+  DxvkTlsfAllocator allocator(HeapSize);
+
+  std::map<VkDeviceSize, Allocation> allocations;
+  std::mt19937 rng(0x5eed);
+
+  VkDeviceSize usedSize = 0;
+  uint32_t     failedAllocs = 0;
+
+  for (uint32_t i = 0; i < IterationCount; i++) {
+    // Bias towards allocations until the heap is mostly
+    // full, so that some allocations are expected to fail
+    bool doFree = !allocations.empty()
+      && rng() % 100 < (usedSize > HeapSize * 7 / 8 ? 60u : 40u);
+
+    if (doFree) {
+      auto entry = allocations.begin();
+      std::advance(entry, rng() % allocations.size());
+
+      usedSize -= allocator.blockLength(entry->second.block);
+      allocator.free(entry->second.block);
+      allocations.erase(entry);
+    } else {
+      Allocation allocation;
+      allocation.size  = 1 + rng() % (rng() % 8 ? 4096 : 1 << 20);
+      allocation.align = VkDeviceSize(1) << (rng() % 17);
+      allocation.block = allocator.alloc(allocation.size, allocation.align);
+
+      if (allocation.block == DxvkTlsfAllocator::InvalidBlock) {
+        failedAllocs += 1;
+        continue;
+      }
+
+      if (!checkAllocation(allocator, allocations, allocation))
+        return 1;
+
+      usedSize += allocator.blockLength(allocation.block);
+      allocations.insert({ allocator.blockOffset(allocation.block), allocation });
+    }
+
+    if (allocator.freeSize() != HeapSize - usedSize) {
+      Logger::err(str::format("Iteration ", i, ": Free size is ", allocator.freeSize(),
+        ", expected ", HeapSize - usedSize));
+      return 1;
+    }
+  }
+
+  Logger::info(str::format(allocations.size(), " live allocations, ",
+    allocator.freeBlockCount(), " free blocks, ", failedAllocs, " failed allocations"));
+
+  // Freeing everything must coalesce all
+  // blocks back into a single free block
+  for (const auto& entry : allocations)
+    allocator.free(entry.second.block);
+
+  if (allocator.freeBlockCount() != 1
+   || allocator.freeSize() != HeapSize
+   || allocator.largestFreeBlock() != HeapSize) {
+    Logger::err(str::format("Heap not coalesced: ", allocator.freeBlockCount(), " free blocks, ",
+      allocator.freeSize(), " bytes free, largest block ", allocator.largestFreeBlock()));
+    return 1;
+  }
+
+  Logger::info("TLSF allocator test passed");
+  return 0;
+}
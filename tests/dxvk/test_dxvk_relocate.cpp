@@ -0,0 +1,149 @@
+#include <cstring>
+#include <vector>
+
+#include "../../src/dxvk/dxvk_context.h"
+#include "../../src/dxvk/dxvk_device.h"
+#include "../../src/dxvk/dxvk_instance.h"
+
+#include <windows.h>
+
+namespace dxvk {
+  Logger Logger::s_instance("dxvk-relocate-test.log");
+}
+
+using namespace dxvk;
+
+constexpr VkDeviceSize BufferSize = 1 << 16;
+
+/**
+ * \brief Reads back the contents of a buffer
+ *
+ * Copies the buffer into a host-visible staging
+ * buffer and waits for the device to go idle.
+ */
+std::vector<uint32_t> readBuffer(
+  const Rc<DxvkDevice>&   device,
+  const Rc<DxvkContext>&  context,
+  const Rc<DxvkBuffer>&   buffer) {
+  DxvkBufferCreateInfo info;
+  info.size   = buffer->info().size;
+  info.usage  = VK_BUFFER_USAGE_TRANSFER_DST_BIT;
+  info.stages = VK_PIPELINE_STAGE_HOST_BIT;
+  info.access = VK_ACCESS_HOST_READ_BIT;
+
+  Rc<DxvkBuffer> staging = device->createBuffer(info,
+    VK_MEMORY_PROPERTY_HOST_VISIBLE_BIT |
+    VK_MEMORY_PROPERTY_HOST_COHERENT_BIT);
+
+  context->copyBuffer(staging, 0, buffer, 0, info.size);
+  context->flushCommandList();
+  device->waitForIdle();
+
+  std::vector<uint32_t> result(info.size / sizeof(uint32_t));
+  std::memcpy(result.data(), staging->mapPtr(0), info.size);
+  return result;
+}
+
+
+bool checkBuffer(
+  const char*                   what,
+  const std::vector<uint32_t>&  expected,
+  const std::vector<uint32_t>&  actual) {
+  for (size_t i = 0; i < expected.size(); i++) {
+    if (expected[i] != actual[i]) {
+      Logger::err(str::format(what, ": Mismatch at dword ", i,
+        ": expected ", expected[i], ", got ", actual[i]));
+      return false;
+    }
+  }
+
+  return true;
+}
+
+
+int WINAPI WinMain(HINSTANCE hInstance,
+                   HINSTANCE hPrevInstance,
+                   LPSTR lpCmdLine,
+                   int nCmdShow) {
+  try {
+    Rc<DxvkInstance> instance = new DxvkInstance();
+    Rc<DxvkAdapter>  adapter  = instance->enumAdapters(0);
+
+    if (adapter == nullptr) {
+      Logger::err("No Vulkan adapter found");
+      return 1;
+    }
+
+    Rc<DxvkDevice> device = adapter->createDevice("DXVK test", DxvkDeviceFeatures());
+
+    // Mirror the front-ends, which upload initial data on
+    // a separate context and flush it before relocating
+    Rc<DxvkContext> initContext = device->createContext();
+    Rc<DxvkContext> context     = device->createContext();
+
+    initContext->beginRecording(device->createCommandList());
+    context->beginRecording(device->createCommandList());
+
+    DxvkBufferCreateInfo info;
+    info.size   = BufferSize;
+    info.usage  = VK_BUFFER_USAGE_TRANSFER_SRC_BIT
+                | VK_BUFFER_USAGE_TRANSFER_DST_BIT
+                | VK_BUFFER_USAGE_VERTEX_BUFFER_BIT;
+    info.stages = VK_PIPELINE_STAGE_TRANSFER_BIT
+                | VK_PIPELINE_STAGE_VERTEX_INPUT_BIT;
+    info.access = VK_ACCESS_TRANSFER_READ_BIT
+                | VK_ACCESS_TRANSFER_WRITE_BIT
+                | VK_ACCESS_VERTEX_ATTRIBUTE_READ_BIT;
+
+    Rc<DxvkBuffer> buffer = device->createBuffer(info,
+      VK_MEMORY_PROPERTY_DEVICE_LOCAL_BIT);
+
+    std::vector<uint32_t> expected(BufferSize / sizeof(uint32_t));
+
+    for (size_t i = 0; i < expected.size(); i++)
+      expected[i] = uint32_t(i * 2654435761u);
+
+    initContext->updateBuffer(buffer, 0, BufferSize, expected.data());
+    initContext->flushCommandList();
+
+    VkBuffer oldHandle = buffer->getSliceHandle().handle;
+    context->relocateBuffer(buffer);
+    VkBuffer newHandle = buffer->getSliceHandle().handle;
+
+    uint32_t failures = 0;
+
+    if (newHandle == oldHandle) {
+      Logger::err("Buffer was not relocated");
+      failures += 1;
+    }
+
+    if (buffer->info().usage != info.usage
+     || buffer->info().size  != info.size) {
+      Logger::err("Buffer properties changed after relocation");
+      failures += 1;
+    }
+
+    if (!checkBuffer("Relocated contents", expected, readBuffer(device, context, buffer)))
+      failures += 1;
+
+    // The relocated buffer must be usable like any other buffer,
+    // and writes must land in the new backing storage
+    std::vector<uint32_t> update(256, 0xdeadbeefu);
+    context->updateBuffer(buffer, 4096, update.size() * sizeof(uint32_t), update.data());
+    std::memcpy(&expected[4096 / sizeof(uint32_t)], update.data(), update.size() * sizeof(uint32_t));
+
+    if (!checkBuffer("Updated contents", expected, readBuffer(device, context, buffer)))
+      failures += 1;
+
+    if (buffer->getSliceHandle().handle != newHandle) {
+      Logger::err("Buffer was renamed by a regular update");
+      failures += 1;
+    }
+
+    Logger::info(failures ? "Relocation test failed" : "Relocation test passed");
+    return failures ? 1 : 0;
+  } catch (const DxvkError& e) {
+    Logger::err(e.message());
+    return 1;
+  }
+}
@@ -0,0 +1,160 @@
+#include <vector>
+
+#include "../../src/dxvk/dxvk_device.h"
+#include "../../src/dxvk/dxvk_instance.h"
+#include "../../src/spirv/spirv_module.h"
+
+#include <windows.h>
+
+namespace dxvk {
+  Logger Logger::s_instance("dxvk-shader-module-test.log");
+}
+
+using namespace dxvk;
+
+/**
+ * \brief Creates a vertex shader using uniform buffers
+ *
+ * The shader does not do anything, it only declares
+ * one uniform buffer for each of the given slots.
+ */
+Rc<DxvkShader> createShader(const std::vector<uint32_t>& slots) {
+  SpirvModule module;
+  module.enableCapability(spv::CapabilityShader);
+  module.setMemoryModel(spv::AddressingModelLogical, spv::MemoryModelGLSL450);
+
+  uint32_t vecType    = module.defVectorType(module.defFloatType(32), 4);
+  uint32_t structType = module.defStructTypeUnique(1, &vecType);
+  module.decorateBlock(structType);
+  module.memberDecorateOffset(structType, 0, 0);
+
+  uint32_t ptrType = module.defPointerType(structType, spv::StorageClassUniform);
+
+  std::vector<DxvkResourceSlot> resourceSlots;
+
+  for (uint32_t slot : slots) {
+    uint32_t varId = module.newVar(ptrType, spv::StorageClassUniform);
+    module.decorateDescriptorSet(varId, 0);
+    module.decorateBinding(varId, slot);
+
+    DxvkResourceSlot resource;
+    resource.slot   = slot;
+    resource.type   = VK_DESCRIPTOR_TYPE_UNIFORM_BUFFER;
+    resource.view   = VK_IMAGE_VIEW_TYPE_MAX_ENUM;
+    resource.access = VK_ACCESS_UNIFORM_READ_BIT;
+    resourceSlots.push_back(resource);
+  }
+
+  uint32_t voidType = module.defVoidType();
+  uint32_t funcId   = module.allocateId();
+
+  module.addEntryPoint(funcId, spv::ExecutionModelVertex, "main", 0, nullptr);
+  module.functionBegin(voidType, funcId,
+    module.defFunctionType(voidType, 0, nullptr),
+    spv::FunctionControlMaskNone);
+  module.opLabel(module.allocateId());
+  module.opReturn();
+  module.functionEnd();
+
+  DxvkShaderOptions options = { };
+  options.rasterizedStream = -1;
+
+  return new DxvkShader(VK_SHADER_STAGE_VERTEX_BIT,
+    resourceSlots.size(), resourceSlots.data(),
+    DxvkInterfaceSlots(), module.compile(),
+    options, DxvkShaderConstData());
+}
+
+
+/**
+ * \brief Defines a uniform buffer slot for another stage
+ */
+void defineFragmentSlot(DxvkDescriptorSlotMapping& mapping, uint32_t slot) {
+  DxvkResourceSlot resource;
+  resource.slot   = slot;
+  resource.type   = VK_DESCRIPTOR_TYPE_UNIFORM_BUFFER;
+  resource.view   = VK_IMAGE_VIEW_TYPE_MAX_ENUM;
+  resource.access = VK_ACCESS_UNIFORM_READ_BIT;
+  mapping.defineSlot(VK_SHADER_STAGE_FRAGMENT_BIT, resource);
+}
+
+
+VkShaderModule getModule(
+  const Rc<DxvkDevice>&             device,
+  const Rc<DxvkShader>&             shader,
+  const DxvkDescriptorSlotMapping&  mapping,
+        bool                        dualSrcBlend,
+        bool&                       cacheHit) {
+  DxvkShaderModuleCreateInfo info;
+  info.fsDualSrcBlend = dualSrcBlend;
+
+  return shader->createShaderModule(device->vkd(),
+    mapping, info, cacheHit).stageInfo(nullptr).module;
+}
+
+
+int WINAPI WinMain(HINSTANCE hInstance,
+                   HINSTANCE hPrevInstance,
+                   LPSTR lpCmdLine,
+                   int nCmdShow) {
+  try {
+    Rc<DxvkInstance> instance = new DxvkInstance();
+    Rc<DxvkAdapter>  adapter  = instance->enumAdapters(0);
+
+    if (adapter == nullptr) {
+      Logger::err("No Vulkan adapter found");
+      return 1;
+    }
+
+    Rc<DxvkDevice> device = adapter->createDevice("DXVK test", DxvkDeviceFeatures());
+    Rc<DxvkShader> shader = createShader({ 0, 1 });
+
+    // Build slot mappings the way graphics pipelines do. The first
+    // two only differ in slots used by other stages, so the vertex
+    // shader's binding IDs are the same. The third one assigns
+    // different binding IDs to the vertex shader's slots.
+    DxvkDescriptorSlotMapping mappingA;
+    shader->defineResourceSlots(mappingA);
+    defineFragmentSlot(mappingA, 2);
+
+    DxvkDescriptorSlotMapping mappingB;
+    shader->defineResourceSlots(mappingB);
+    defineFragmentSlot(mappingB, 3);
+
+    DxvkDescriptorSlotMapping mappingC;
+    defineFragmentSlot(mappingC, 2);
+    shader->defineResourceSlots(mappingC);
+
+    uint32_t failures = 0;
+    bool hitA, hitB, hitC, hitD;
+
+    VkShaderModule moduleA = getModule(device, shader, mappingA, false, hitA);
+    VkShaderModule moduleB = getModule(device, shader, mappingB, false, hitB);
+    VkShaderModule moduleC = getModule(device, shader, mappingC, false, hitC);
+
+    // The shader does not write to location 1,
+    // so dual-source blending must not matter
+    VkShaderModule moduleD = getModule(device, shader, mappingA, true, hitD);
+
+    if (hitA || moduleB != moduleA || !hitB) {
+      Logger::err("Identical binding IDs did not share a shader module");
+      failures += 1;
+    }
+
+    if (hitC || moduleC == moduleA) {
+      Logger::err("Different binding IDs shared a shader module");
+      failures += 1;
+    }
+
+    if (!hitD || moduleD != moduleA) {
+      Logger::err("Unused dual-source blending created a new shader module");
+      failures += 1;
+    }
+
+    Logger::info(failures ? "Shader module test failed" : "Shader module test passed");
+    return failures ? 1 : 0;
+  } catch (const DxvkError& e) {
+    Logger::err(e.message());
+    return 1;
+  }
+}
@@ -0,0 +1,189 @@
+#include <algorithm>
+#include <array>
+#include <chrono>
+#include <cstring>
+#include <fstream>
+#include <sstream>
+
+#include "../../src/spirv/spirv_compression.h"
+
+#include <shellapi.h>
+#include <windows.h>
+
+namespace dxvk {
+  Logger Logger::s_instance("dxvk-spirv-bench.log");
+}
+
+using namespace dxvk;
+
+using Clock = std::chrono::high_resolution_clock;
+
+constexpr uint32_t IterationCount = 256;
+
+struct CodecInfo {
+  SpirvCompressionCodec codec;
+  const char*           name;
+  size_t                totalSize;
+  Clock::duration       totalEncodeTime;
+  Clock::duration       totalDecodeTime;
+};
+
+double getThroughput(size_t bytes, Clock::duration time) {
+  auto us = std::chrono::duration_cast<std::chrono::microseconds>(time);
+  return us.count() ? double(bytes) / double(us.count()) : 0.0;
+}
+
+std::string serialize(const SpirvCompressedBuffer& buffer) {
+  std::ostringstream stream;
+  buffer.write(stream);
+  return stream.str();
+}
+
+bool matches(const SpirvCodeBuffer& a, const SpirvCodeBuffer& b) {
+  return a.dwords() == b.dwords()
+      && !std::memcmp(a.data(), b.data(), a.size());
+}
+
+int WINAPI WinMain(HINSTANCE hInstance,
+                   HINSTANCE hPrevInstance,
+                   LPSTR lpCmdLine,
+                   int nCmdShow) {
+  int     argc = 0;
+  LPWSTR* argv = CommandLineToArgvW(
+    GetCommandLineW(), &argc);
+
+  if (argc < 2) {
+    Logger::err("Usage: dxvk-spirv-bench input.spv [input.spv...]");
+    return 1;
+  }
+
+  std::array<CodecInfo, 2> codecs = {{
+    { SpirvCompressionCodec::Scalar, "scalar", 0, Clock::duration::zero(), Clock::duration::zero() },
+    { SpirvCompressionCodec::Ssse3,  "ssse3",  0, Clock::duration::zero(), Clock::duration::zero() },
+  }};
+
+  size_t totalSize = 0;
+  size_t totalCompressedSize = 0;
+
+  bool success = true;
+
+  for (int i = 1; i < argc; i++) {
+    std::string fileName = str::fromws(argv[i]);
+    std::ifstream ifile(fileName, std::ios::binary);
+
+    if (!ifile) {
+      Logger::err(str::format(fileName, ": Failed to open file"));
+      continue;
+    }
+
+    SpirvCodeBuffer code(ifile);
+
+    // All codecs must produce the same compressed data, and any
+    // codec must be able to decode what any other codec encoded
+    std::string reference = serialize(SpirvCompressedBuffer(code, SpirvCompressionCodec::Scalar));
+    bool valid = true;
+
+    for (const auto& encoder : codecs) {
+      if (!SpirvCompressedBuffer::isCodecSupported(encoder.codec))
+        continue;
+
+      SpirvCompressedBuffer compressed(code, encoder.codec);
+
+      if (serialize(compressed) != reference) {
+        Logger::err(str::format(fileName, ": ", encoder.name, " encoder output differs"));
+        valid = false;
+      }
+
+      for (const auto& decoder : codecs) {
+        if (!SpirvCompressedBuffer::isCodecSupported(decoder.codec))
+          continue;
+
+        if (!matches(compressed.decompress(decoder.codec), code)) {
+          Logger::err(str::format(fileName, ": ", decoder.name, " decoder failed on ",
+            encoder.name, " encoder output"));
+          valid = false;
+        }
+      }
+    }
+
+    // Serialized data must survive a round trip, and records
+    // with byte counts exceeding the payload must be rejected
+    SpirvCompressedBuffer deserialized;
+    std::istringstream stream(reference);
+
+    if (!deserialized.read(stream) || !matches(deserialized.decompress(), code)) {
+      Logger::err(str::format(fileName, ": Failed to read serialized data"));
+      valid = false;
+    }
+
+    size_t maskSize = sizeof(uint64_t) * ((code.dwords() + 31) / 32);
+    size_t codeSize = reference.size() - 3 * sizeof(uint32_t) - maskSize;
+
+    std::string corrupted = reference;
+    std::fill(corrupted.begin() + 3 * sizeof(uint32_t),
+      corrupted.begin() + 3 * sizeof(uint32_t) + (code.dwords() + 3) / 4, '\xff');
+    stream = std::istringstream(corrupted);
+
+    if (code.size() > codeSize && deserialized.read(stream)) {
+      Logger::err(str::format(fileName, ": Corrupted mask not detected"));
+      valid = false;
+    }
+
+    if (!valid) {
+      success = false;
+      continue;
+    }
+
+    size_t processedSize = code.size() * IterationCount;
+
+    totalSize           += code.size();
+    totalCompressedSize += reference.size();
+
+    std::string message = str::format(fileName, ": ", code.size(), " -> ", reference.size(), " bytes");
+
+    for (auto& codec : codecs) {
+      if (!SpirvCompressedBuffer::isCodecSupported(codec.codec))
+        continue;
+
+      auto t0 = Clock::now();
+
+      for (uint32_t j = 0; j < IterationCount; j++)
+        SpirvCompressedBuffer compressed(code, codec.codec);
+
+      auto t1 = Clock::now();
+
+      SpirvCompressedBuffer compressed(code, codec.codec);
+
+      for (uint32_t j = 0; j < IterationCount; j++)
+        valid &= compressed.decompress(codec.codec).dwords() == code.dwords();
+
+      auto t2 = Clock::now();
+
+      codec.totalSize       += code.size();
+      codec.totalEncodeTime += t1 - t0;
+      codec.totalDecodeTime += t2 - t1;
+
+      message += str::format(", ", codec.name,
+        " encode: ", uint32_t(getThroughput(processedSize, t1 - t0)), " MB/s",
+        " decode: ", uint32_t(getThroughput(processedSize, t2 - t1)), " MB/s");
+    }
+
+    Logger::info(message);
+  }
+
+  if (totalSize) {
+    Logger::info(str::format("Total: ", totalSize, " -> ", totalCompressedSize, " bytes (",
+      uint32_t(100.0 * double(totalCompressedSize) / double(totalSize)), "%)"));
+
+    for (const auto& codec : codecs) {
+      if (!codec.totalSize)
+        continue;
+
+      Logger::info(str::format("  ", codec.name, ": ",
+        "encode: ", uint32_t(getThroughput(codec.totalSize * IterationCount, codec.totalEncodeTime)), " MB/s, ",
+        "decode: ", uint32_t(getThroughput(codec.totalSize * IterationCount, codec.totalDecodeTime)), " MB/s"));
+    }
+  }
+
+  return success ? 0 : 1;
+}
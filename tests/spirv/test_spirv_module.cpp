@@ -0,0 +1,163 @@
+#include <random>
+#include <vector>
+
+#include "../../src/spirv/spirv_module.h"
+
+#include <windows.h>
+
+namespace dxvk {
+  Logger Logger::s_instance("spirv-module-test.log");
+}
+
+using namespace dxvk;
+
+constexpr uint32_t IterationCount = 1 << 14;
+
+/**
+ * \brief Checks whether an instruction declares a type or constant
+ *
+ * \param [in] op Opcode
+ * \param [out] idIndex Argument index of the result ID
+ * \returns \c true for deduplicated declarations
+ */
+bool isTypeConstDecl(spv::Op op, uint32_t& idIndex) {
+  switch (op) {
+    case spv::OpTypeVoid:
+    case spv::OpTypeBool:
+    case spv::OpTypeInt:
+    case spv::OpTypeFloat:
+    case spv::OpTypeVector:
+    case spv::OpTypeMatrix:
+    case spv::OpTypeArray:
+    case spv::OpTypeRuntimeArray:
+    case spv::OpTypeStruct:
+    case spv::OpTypePointer:
+      idIndex = 1;
+      return true;
+
+    case spv::OpConstantTrue:
+    case spv::OpConstantFalse:
+    case spv::OpConstant:
+    case spv::OpConstantComposite:
+      idIndex = 2;
+      return true;
+
+    default:
+      return false;
+  }
+}
+
+
+/**
+ * \brief Compares two declarations, ignoring the result ID
+ */
+bool isSameDecl(const SpirvInstruction& a, const SpirvInstruction& b, uint32_t idIndex) {
+  if (a.opCode() != b.opCode() || a.length() != b.length())
+    return false;
+
+  for (uint32_t i = 1; i < a.length(); i++) {
+    if (i != idIndex && a.arg(i) != b.arg(i))
+      return false;
+  }
+
+  return true;
+}
+
+
+/**
+ * \brief Looks up a declaration with a linear scan
+ *
+ * Finds the instruction declaring the given ID, and returns
+ * the ID of the first declaration with identical operands.
+ * This is what the type and constant lookup must return.
+ * \returns Expected ID, or 0 if \c id is not declared
+ */
+uint32_t findFirstDecl(SpirvCodeBuffer& code, uint32_t id) {
+  for (auto ins : code) {
+    uint32_t idIndex = 0;
+
+    if (!isTypeConstDecl(ins.opCode(), idIndex) || ins.arg(idIndex) != id)
+      continue;
+
+    for (auto ref : code) {
+      if (isSameDecl(ref, ins, idIndex))
+        return ref.arg(idIndex);
+    }
+  }
+
+  return 0;
+}
+
+
+int WINAPI WinMain(HINSTANCE hInstance,
+                   HINSTANCE hPrevInstance,
+                   LPSTR lpCmdLine,
+                   int nCmdShow) {
+  SpirvModule module;
+
+  std::mt19937 rng(0x5eed);
+
+  auto pick = [&rng] (const std::vector<uint32_t>& ids) {
+    return ids[rng() % ids.size()];
+  };
+
+  // Scalar types that composite types get built from
+  std::vector<uint32_t> scalarTypes = {
+    module.defIntType(32, 0),
+    module.defIntType(32, 1),
+    module.defFloatType(32),
+  };
+
+  std::vector<uint32_t> types = scalarTypes;
+  std::vector<uint32_t> results;
+
+  for (uint32_t i = 0; i < IterationCount; i++) {
+    uint32_t id = 0;
+    bool isType = false;
+
+    // Keep the value ranges small so that
+    // most declarations are requested repeatedly
+    switch (rng() % 10) {
+      case 0: id = module.defVectorType(pick(scalarTypes), 2 + rng() % 3); isType = true; break;
+      case 1: id = module.defPointerType(pick(types), rng() % 2 ? spv::StorageClassPrivate : spv::StorageClassFunction); break;
+      case 2: id = module.defArrayType(pick(types), module.constu32(1 + rng() % 4)); isType = true; break;
+      case 3: id = module.constu32(rng() % 64); break;
+      case 4: id = module.consti32(int32_t(rng() % 64) - 32); break;
+      case 5: id = module.constf32(float(rng() % 16) * 0.5f); break;
+      case 6: id = module.constBool(rng() % 2); break;
+      case 7: id = module.constvec4f32(float(rng() % 2), 1.0f, 0.0f, float(rng() % 2)); break;
+
+      // Unique declarations must not be returned by
+      // lookups if an equivalent one already exists
+      case 8: module.defArrayTypeUnique(pick(types), module.constu32(1 + rng() % 4)); break;
+      case 9: {
+        uint32_t member = pick(types);
+        module.defStructTypeUnique(1, &member);
+      } break;
+    }
+
+    if (id == 0)
+      continue;
+
+    results.push_back(id);
+
+    if (isType && types.size() < 64)
+      types.push_back(id);
+  }
+
+  SpirvCodeBuffer code = module.compile();
+
+  uint32_t failures = 0;
+
+  for (uint32_t id : results) {
+    uint32_t expected = findFirstDecl(code, id);
+
+    if (expected != id) {
+      Logger::err(str::format("ID ", id, ": Linear scan returned ", expected));
+      failures += 1;
+    }
+  }
+
+  Logger::info(str::format(results.size() - failures, " of ", results.size(), " lookups passed"));
+  return failures ? 1 : 0;
+}
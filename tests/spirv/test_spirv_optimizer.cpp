@@ -0,0 +1,483 @@
+#include <cstring>
+#include <fstream>
+#include <set>
+#include <sstream>
+#include <tuple>
+
+#include "../../src/dxbc/dxbc_module.h"
+#include "../../src/dxso/dxso_module.h"
+#include "../../src/dxvk/dxvk_shader.h"
+#include "../../src/spirv/spirv_module.h"
+#include "../../src/spirv/spirv_optimizer.h"
+
+#include <shellapi.h>
+#include <windows.h>
+#include <windowsx.h>
+
+namespace dxvk {
+  Logger Logger::s_instance("spirv-optimizer-test.log");
+}
+
+using namespace dxvk;
+
+using DecorationSet = std::multiset<std::tuple<uint32_t, uint32_t, uint32_t>>;
+
+/**
+ * \brief Finds the instruction that defines an ID
+ *
+ * Only considers instructions that have a result
+ * type, which covers everything the tests need.
+ * \returns Defining opcode, or \c OpNop
+ */
+spv::Op getDefinition(SpirvCodeBuffer& code, uint32_t id) {
+  for (auto ins : code) {
+    switch (ins.opCode()) {
+      case spv::OpConstant:
+      case spv::OpSpecConstant:
+      case spv::OpSpecConstantTrue:
+      case spv::OpSpecConstantFalse:
+      case spv::OpVariable:
+      case spv::OpLoad:
+      case spv::OpAccessChain:
+      case spv::OpFAdd:
+      case spv::OpSelect:
+      case spv::OpFunctionCall:
+        if (ins.arg(2) == id)
+          return ins.opCode();
+        break;
+
+      default:
+        break;
+    }
+  }
+
+  return spv::OpNop;
+}
+
+
+/**
+ * \brief Collects values stored to a pointer
+ */
+std::vector<uint32_t> getStoredValues(SpirvCodeBuffer& code, uint32_t pointer) {
+  std::vector<uint32_t> result;
+
+  for (auto ins : code) {
+    if (ins.opCode() == spv::OpStore && ins.arg(1) == pointer)
+      result.push_back(ins.arg(2));
+  }
+
+  return result;
+}
+
+
+/**
+ * \brief Checks whether any store writes a given value
+ */
+bool isValueStored(SpirvCodeBuffer& code, uint32_t value) {
+  for (auto ins : code) {
+    if (ins.opCode() == spv::OpStore && ins.arg(2) == value)
+      return true;
+  }
+
+  return false;
+}
+
+
+/**
+ * \brief Collects interface and resource decorations
+ *
+ * These are what the pipeline, and the binding ID
+ * patching done when creating shader modules, rely on.
+ */
+DecorationSet getDecorations(SpirvCodeBuffer& code) {
+  DecorationSet result;
+
+  for (auto ins : code) {
+    if (ins.opCode() != spv::OpDecorate || ins.length() < 4)
+      continue;
+
+    switch (spv::Decoration(ins.arg(2))) {
+      case spv::DecorationBinding:
+      case spv::DecorationDescriptorSet:
+      case spv::DecorationSpecId:
+      case spv::DecorationLocation:
+      case spv::DecorationBuiltIn:
+        result.insert({ ins.arg(1), ins.arg(2), ins.arg(3) });
+        break;
+
+      default:
+        break;
+    }
+  }
+
+  return result;
+}
+
+
+/**
+ * \brief Test shader builder
+ *
+ * Sets up a fragment shader entry point with a
+ * float output, so that the individual tests
+ * only need to emit the code they check.
+ */
+class TestShader {
+
+public:
+
+  TestShader() {
+    m_module.enableCapability(spv::CapabilityShader);
+    m_module.setMemoryModel(
+      spv::AddressingModelLogical,
+      spv::MemoryModelGLSL450);
+
+    floatType = m_module.defFloatType(32);
+    uintType  = m_module.defIntType(32, 0);
+    voidType  = m_module.defVoidType();
+    funcType  = m_module.defFunctionType(voidType, 0, nullptr);
+    entryId   = m_module.allocateId();
+  }
+
+  SpirvModule* operator -> () {
+    return &m_module;
+  }
+
+  uint32_t defOutput(uint32_t location) {
+    uint32_t ptrType = m_module.defPointerType(floatType, spv::StorageClassOutput);
+    uint32_t varId   = m_module.newVar(ptrType, spv::StorageClassOutput);
+    m_module.decorateLocation(varId, location);
+    m_interfaces.push_back(varId);
+    return varId;
+  }
+
+  uint32_t defInput(uint32_t type, uint32_t location) {
+    uint32_t ptrType = m_module.defPointerType(type, spv::StorageClassInput);
+    uint32_t varId   = m_module.newVar(ptrType, spv::StorageClassInput);
+    m_module.decorateLocation(varId, location);
+    m_module.decorate(varId, spv::DecorationFlat);
+    m_interfaces.push_back(varId);
+    return varId;
+  }
+
+  uint32_t beginFunction(uint32_t functionId) {
+    m_module.functionBegin(voidType, functionId,
+      funcType, spv::FunctionControlMaskNone);
+    m_module.opLabel(m_module.allocateId());
+    return functionId;
+  }
+
+  void endFunction() {
+    m_module.opReturn();
+    m_module.functionEnd();
+  }
+
+  SpirvCodeBuffer compile() {
+    m_module.addEntryPoint(entryId, spv::ExecutionModelFragment, "main",
+      m_interfaces.size(), m_interfaces.data());
+    m_module.setExecutionMode(entryId, spv::ExecutionModeOriginUpperLeft);
+    return m_module.compile();
+  }
+
+  uint32_t floatType = 0;
+  uint32_t uintType  = 0;
+  uint32_t voidType  = 0;
+  uint32_t funcType  = 0;
+  uint32_t entryId   = 0;
+
+private:
+
+  SpirvModule           m_module;
+  std::vector<uint32_t> m_interfaces;
+
+};
+
+
+/**
+ * \brief Dynamically indexed register arrays
+ *
+ * A store through a dynamic index may alias any
+ * element, so a previous store to a constant index
+ * must neither be forwarded nor removed.
+ */
+bool testDynamicIndexAliasing() {
+  TestShader shader;
+
+  uint32_t arrayType = shader->defArrayType(shader.floatType, shader->constu32(4));
+  uint32_t arrayPtr  = shader->defPointerType(arrayType, spv::StorageClassPrivate);
+  uint32_t floatPtr  = shader->defPointerType(shader.floatType, spv::StorageClassPrivate);
+
+  uint32_t arrayVar  = shader->newVar(arrayPtr, spv::StorageClassPrivate);
+  uint32_t indexVar  = shader.defInput(shader.uintType, 0);
+  uint32_t outputVar = shader.defOutput(0);
+
+  uint32_t oneId = shader->constf32(1.0f);
+  uint32_t twoId = shader->constf32(2.0f);
+
+  shader.beginFunction(shader.entryId);
+
+  uint32_t constIndex = shader->constu32(0);
+  uint32_t dynIndex   = shader->opLoad(shader.uintType, indexVar);
+
+  // r[0] = 1.0; r[i] = 2.0; o0 = r[0];
+  shader->opStore(shader->opAccessChain(floatPtr, arrayVar, 1, &constIndex), oneId);
+  shader->opStore(shader->opAccessChain(floatPtr, arrayVar, 1, &dynIndex),   twoId);
+  shader->opStore(outputVar, shader->opLoad(shader.floatType,
+    shader->opAccessChain(floatPtr, arrayVar, 1, &constIndex)));
+
+  shader.endFunction();
+
+  SpirvCodeBuffer code = SpirvOptimizer().optimize(shader.compile());
+  auto values = getStoredValues(code, outputVar);
+
+  return values.size() == 1
+      && getDefinition(code, values[0]) == spv::OpLoad
+      && isValueStored(code, oneId)
+      && isValueStored(code, twoId);
+}
+
+
+/**
+ * \brief Store, store, load within one block
+ *
+ * The load must return the second value, and
+ * the first store is dead.
+ */
+bool testStoreStoreLoad() {
+  TestShader shader;
+
+  uint32_t floatPtr  = shader->defPointerType(shader.floatType, spv::StorageClassFunction);
+  uint32_t aVar      = shader.defInput(shader.floatType, 0);
+  uint32_t bVar      = shader.defInput(shader.floatType, 1);
+  uint32_t outputVar = shader.defOutput(0);
+
+  shader.beginFunction(shader.entryId);
+
+  uint32_t tempVar = shader->newVar(floatPtr, spv::StorageClassFunction);
+
+  uint32_t aId = shader->opLoad(shader.floatType, aVar);
+  uint32_t bId = shader->opLoad(shader.floatType, bVar);
+
+  // t = a; t = b; o0 = t;
+  shader->opStore(tempVar, aId);
+  shader->opStore(tempVar, bId);
+  shader->opStore(outputVar, shader->opLoad(shader.floatType, tempVar));
+
+  shader.endFunction();
+
+  SpirvCodeBuffer code = SpirvOptimizer().optimize(shader.compile());
+  auto values = getStoredValues(code, outputVar);
+
+  return values.size() == 1
+      && values[0] == bId
+      && !isValueStored(code, aId);
+}
+
+
+/**
+ * \brief Loads across function calls
+ *
+ * Called functions may write private variables,
+ * so neither stored nor previously loaded values
+ * may be forwarded past a call.
+ */
+bool testFunctionCall() {
+  TestShader shader;
+
+  uint32_t floatPtr = shader->defPointerType(shader.floatType, spv::StorageClassPrivate);
+  uint32_t regVar   = shader->newVar(floatPtr, spv::StorageClassPrivate);
+  uint32_t out0Var  = shader.defOutput(0);
+  uint32_t out1Var  = shader.defOutput(1);
+
+  uint32_t oneId = shader->constf32(1.0f);
+  uint32_t twoId = shader->constf32(2.0f);
+
+  // void f() { r = 2.0; }
+  uint32_t functionId = shader.beginFunction(shader->allocateId());
+  shader->opStore(regVar, twoId);
+  shader.endFunction();
+
+  // r = 1.0; f(); o0 = r; f(); o1 = r + r;
+  shader.beginFunction(shader.entryId);
+  shader->opStore(regVar, oneId);
+  shader->opFunctionCall(shader.voidType, functionId, 0, nullptr);
+
+  uint32_t firstId = shader->opLoad(shader.floatType, regVar);
+  shader->opStore(out0Var, firstId);
+  shader->opFunctionCall(shader.voidType, functionId, 0, nullptr);
+
+  uint32_t secondId = shader->opLoad(shader.floatType, regVar);
+  shader->opStore(out1Var, shader->opFAdd(shader.floatType, secondId, secondId));
+  shader.endFunction();
+
+  SpirvCodeBuffer code = SpirvOptimizer().optimize(shader.compile());
+  auto out0 = getStoredValues(code, out0Var);
+  auto out1 = getStoredValues(code, out1Var);
+
+  return out0.size() == 1 && out0[0] == firstId
+      && out1.size() == 1 && getDefinition(code, out1[0]) == spv::OpFAdd
+      && getDefinition(code, firstId)  == spv::OpLoad
+      && getDefinition(code, secondId) == spv::OpLoad
+      && isValueStored(code, twoId);
+}
+
+
+/**
+ * \brief Resource and spec constant decorations
+ *
+ * Bindings and spec IDs must survive even if the
+ * decorated objects are not used, since pipeline
+ * layouts and binding patching depend on them.
+ */
+bool testDecorations() {
+  TestShader shader;
+
+  uint32_t structType = shader->defStructTypeUnique(1, &shader.floatType);
+  shader->decorateBlock(structType);
+  shader->memberDecorateOffset(structType, 0, 0);
+
+  uint32_t bufferPtr = shader->defPointerType(structType, spv::StorageClassUniform);
+  uint32_t memberPtr = shader->defPointerType(shader.floatType, spv::StorageClassUniform);
+
+  uint32_t usedBuffer   = shader->newVar(bufferPtr, spv::StorageClassUniform);
+  uint32_t unusedBuffer = shader->newVar(bufferPtr, spv::StorageClassUniform);
+
+  shader->decorateDescriptorSet(usedBuffer, 0);
+  shader->decorateBinding(usedBuffer, 5);
+  shader->decorateDescriptorSet(unusedBuffer, 0);
+  shader->decorateBinding(unusedBuffer, 6);
+
+  uint32_t usedSpec   = shader->specConstBool(false);
+  uint32_t unusedSpec = shader->specConst32(shader.uintType, 0);
+
+  shader->decorateSpecId(usedSpec, 3);
+  shader->decorateSpecId(unusedSpec, 4);
+
+  uint32_t outputVar = shader.defOutput(0);
+
+  shader.beginFunction(shader.entryId);
+
+  uint32_t memberIndex = shader->constu32(0);
+  uint32_t valueId = shader->opLoad(shader.floatType,
+    shader->opAccessChain(memberPtr, usedBuffer, 1, &memberIndex));
+
+  shader->opStore(outputVar, shader->opSelect(shader.floatType,
+    usedSpec, valueId, shader->constf32(0.0f)));
+
+  shader.endFunction();
+
+  SpirvCodeBuffer original  = shader.compile();
+  SpirvCodeBuffer optimized = SpirvOptimizer().optimize(original);
+
+  return getDecorations(optimized) == getDecorations(original)
+      && getDefinition(optimized, usedBuffer)   == spv::OpVariable
+      && getDefinition(optimized, unusedBuffer) == spv::OpVariable
+      && getDefinition(optimized, usedSpec)     == spv::OpSpecConstantFalse
+      && getDefinition(optimized, unusedSpec)   == spv::OpSpecConstant;
+}
+
+
+std::vector<char> readFile(const std::string& fileName) {
+  std::ifstream ifile(fileName, std::ios::binary);
+  ifile.ignore(std::numeric_limits<std::streamsize>::max());
+  std::streamsize length = ifile.gcount();
+  ifile.clear();
+
+  ifile.seekg(0, std::ios_base::beg);
+  std::vector<char> result(length);
+  ifile.read(result.data(), length);
+  return result;
+}
+
+
+/**
+ * \brief Translates a DXBC or DXSO shader
+ *
+ * The optimizer is disabled in the compilers
+ * so that the test can run it separately.
+ * \returns Unoptimized SPIR-V code
+ */
+SpirvCodeBuffer compileShader(const std::string& fileName, std::vector<char>& code) {
+  Rc<DxvkShader> shader;
+
+  if (code.size() >= 4 && !std::memcmp(code.data(), "DXBC", 4)) {
+    DxbcModuleInfo moduleInfo;
+    moduleInfo.options.useSubgroupOpsForAtomicCounters = true;
+    moduleInfo.options.useSubgroupOpsForEarlyDiscard = true;
+    moduleInfo.options.minSsboAlignment = 4;
+    moduleInfo.options.optimizeSpirv = false;
+    moduleInfo.xfb = nullptr;
+
+    DxbcReader reader(code.data(), code.size());
+    DxbcModule module(reader);
+    shader = module.compile(moduleInfo, fileName);
+  } else {
+    DxsoModuleInfo moduleInfo;
+    moduleInfo.options.strictConstantCopies = false;
+    moduleInfo.options.strictPow = true;
+    moduleInfo.options.optimizeSpirv = false;
+
+    DxsoReader reader(code.data());
+    DxsoModule module(reader);
+    DxsoAnalysisInfo analysis = module.analyze();
+    shader = module.compile(moduleInfo, fileName, analysis);
+  }
+
+  std::stringstream stream;
+  shader->dump(stream);
+  return SpirvCodeBuffer(stream);
+}
+
+
+int WINAPI WinMain(HINSTANCE hInstance,
+                   HINSTANCE hPrevInstance,
+                   LPSTR lpCmdLine,
+                   int nCmdShow) {
+  int     argc = 0;
+  LPWSTR* argv = CommandLineToArgvW(
+    GetCommandLineW(), &argc);
+
+  uint32_t failures = 0;
+
+  const std::pair<const char*, bool (*)()> tests[] = {
+    { "Dynamic index aliasing", &testDynamicIndexAliasing },
+    { "Store, store, load",     &testStoreStoreLoad       },
+    { "Function calls",         &testFunctionCall         },
+    { "Decorations",            &testDecorations          },
+  };
+
+  for (const auto& test : tests) {
+    bool passed = test.second();
+    failures += passed ? 0 : 1;
+
+    if (passed)
+      Logger::info(str::format(test.first, ": OK"));
+    else
+      Logger::err(str::format(test.first, ": Failed"));
+  }
+
+  // Shaders given on the command line are checked for
+  // decorations, which must not change when optimizing
+  for (int i = 1; i < argc; i++) {
+    std::string fileName = str::fromws(argv[i]);
+
+    try {
+      std::vector<char> code = readFile(fileName);
+
+      SpirvCodeBuffer original  = compileShader(fileName, code);
+      SpirvCodeBuffer optimized = SpirvOptimizer().optimize(original);
+
+      if (getDecorations(optimized) != getDecorations(original)) {
+        Logger::err(str::format(fileName, ": Decorations changed"));
+        failures += 1;
+      } else {
+        Logger::info(str::format(fileName, ": OK (",
+          original.size(), " -> ", optimized.size(), " bytes)"));
+      }
+    } catch (const DxvkError& e) {
+      Logger::err(str::format(fileName, ": ", e.message()));
+      failures += 1;
+    }
+  }
+
+  return failures ? 1 : 0;
+}